@@ -0,0 +1,180 @@
+//! Benchmarks for concurrent health state updates
+//!
+//! Several threads feed passing detection results for 8 devices into one
+//! `GpuHealthManager`, next to the same updates behind a single write lock
+//! with a UUID String key per lookup as a baseline. Before timing, a counting allocator checks that
+//! the steady-state `process_result` path does not allocate. `transition`
+//! is timed on its own, flipping one device between HEALTHY and SUSPECTED.
+
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::RwLock;
+use std::time::{Duration, Instant};
+
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+use gdnd_core::detection::{DetectionLevel, DetectionResult, Finding, FindingType};
+use gdnd_core::device::DeviceId;
+use gdnd_core::state_machine::HealthEvent;
+use gdnd_core::{GpuHealthManager, HealthState};
+
+struct CountingAlloc;
+
+static ALLOCATIONS: AtomicUsize = AtomicUsize::new(0);
+
+unsafe impl GlobalAlloc for CountingAlloc {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        System.alloc(layout)
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        System.dealloc(ptr, layout)
+    }
+}
+
+#[global_allocator]
+static GLOBAL: CountingAlloc = CountingAlloc;
+
+const DEVICES: u32 = 8;
+const THREADS: &[usize] = &[1, 4, 8];
+
+fn results() -> Vec<DetectionResult> {
+    (0..DEVICES)
+        .map(|index| {
+            let device = DeviceId {
+                index,
+                uuid: Some(format!("GPU-{:08x}-bench", index)),
+                name: "Bench GPU".to_string(),
+            };
+            DetectionResult::pass(device, DetectionLevel::L1Passive)
+        })
+        .collect()
+}
+
+/// The store before sharding: one lock and a String key per lookup around
+/// the same state machine
+struct GlobalLock {
+    keys: RwLock<HashMap<String, usize>>,
+    manager: GpuHealthManager,
+}
+
+impl GlobalLock {
+    fn new() -> Self {
+        Self {
+            keys: RwLock::new(HashMap::new()),
+            manager: GpuHealthManager::new(3, vec![31, 43, 48, 79]),
+        }
+    }
+
+    fn process_result(&self, result: &DetectionResult) {
+        let key = result
+            .device
+            .uuid
+            .clone()
+            .unwrap_or_else(|| format!("gpu-{}", result.device.index));
+        let mut keys = self.keys.write().unwrap();
+        *keys.entry(key).or_default() += 1;
+        criterion::black_box(self.manager.process_result(result));
+    }
+}
+
+/// Run `iters` results per thread, each thread starting at its own device
+fn run_threads(
+    threads: usize,
+    iters: u64,
+    results: &[DetectionResult],
+    f: impl Fn(&DetectionResult) + Sync,
+) -> Duration {
+    let start = Instant::now();
+    std::thread::scope(|scope| {
+        for thread in 0..threads {
+            let f = &f;
+            scope.spawn(move || {
+                for i in 0..iters as usize {
+                    f(&results[(thread + i) % results.len()]);
+                }
+            });
+        }
+    });
+    start.elapsed()
+}
+
+fn check_no_allocations(manager: &GpuHealthManager, results: &[DetectionResult]) {
+    for result in results {
+        manager.process_result(result);
+    }
+    let before = ALLOCATIONS.load(Ordering::Relaxed);
+    for _ in 0..1000 {
+        for result in results {
+            criterion::black_box(manager.process_result(result));
+        }
+    }
+    let allocations = ALLOCATIONS.load(Ordering::Relaxed) - before;
+    println!(
+        "health_state: {} allocations in 8000 process_result calls",
+        allocations
+    );
+    assert_eq!(allocations, 0, "process_result allocated on the hot path");
+}
+
+fn bench_process_result(c: &mut Criterion) {
+    let results = results();
+    let manager = GpuHealthManager::new(3, vec![31, 43, 48, 79]);
+    check_no_allocations(&manager, &results);
+    let baseline = GlobalLock::new();
+
+    let mut group = c.benchmark_group("health_state");
+    for &threads in THREADS {
+        group.throughput(Throughput::Elements(threads as u64));
+        group.bench_with_input(
+            BenchmarkId::new("sharded", threads),
+            &threads,
+            |b, &threads| {
+                b.iter_custom(|iters| {
+                    run_threads(threads, iters, &results, |r| {
+                        criterion::black_box(manager.process_result(r));
+                    })
+                })
+            },
+        );
+        group.bench_with_input(
+            BenchmarkId::new("global_lock", threads),
+            &threads,
+            |b, &threads| {
+                b.iter_custom(|iters| {
+                    run_threads(threads, iters, &results, |r| baseline.process_result(r))
+                })
+            },
+        );
+    }
+    group.finish();
+}
+
+fn bench_transition(c: &mut Criterion) {
+    let results = results();
+    let device = &results[0].device;
+    let manager = GpuHealthManager::new(3, vec![31, 43, 48, 79]);
+    let findings = vec![Finding::new(
+        FindingType::NonFatalXid(13),
+        "Graphics SM Warp Exception".to_string(),
+        false,
+    )];
+
+    let mut group = c.benchmark_group("health_state");
+    group.throughput(Throughput::Elements(2));
+    group.bench_function("transition", |b| {
+        b.iter(|| {
+            let failed = HealthEvent::CheckFailed {
+                findings: findings.clone(),
+            };
+            criterion::black_box(manager.transition(device, failed));
+            criterion::black_box(manager.transition(device, HealthEvent::CheckPassed));
+        })
+    });
+    group.finish();
+    assert_eq!(manager.state(device), Some(HealthState::Healthy));
+}
+
+criterion_group!(benches, bench_process_result, bench_transition);
+criterion_main!(benches);
@@ -0,0 +1,94 @@
+//! Benchmarks for XID scanning over kernel log dumps
+//!
+//! Writes a synthetic `/dev/kmsg` dump (64 MiB by default, override with
+//! `GDND_BENCH_KMSG_MB`) of typical driver and network chatter with an NVIDIA
+//! XID record every 1000 records spread over 8 GPUs, then measures a cold
+//! `KmsgReader` poll of the whole dump, as after a restart with no cursor.
+
+use std::collections::HashMap;
+use std::fs::File;
+use std::io::{BufWriter, Write};
+use std::path::Path;
+
+use criterion::{criterion_group, criterion_main, Criterion, Throughput};
+use gdnd_core::device::{KmsgReader, PciAddress};
+
+/// One XID record per this many records
+const XID_EVERY: u64 = 1000;
+
+const BUSES: [&str; 8] = ["1b", "3b", "5e", "86", "af", "b1", "d8", "db"];
+
+const CHATTER: &[&str] = &[
+    "mlx5_core 0000:5e:00.0 eth0: Link up",
+    "nvidia-nvlink: Nvlink Core is being initialized, major device number 508",
+    "IPv6: ADDRCONF(NETDEV_CHANGE): cali4f2a9c1e3b7: link becomes ready",
+    "EXT4-fs (nvme0n1p1): re-mounted. Opts: (null). Quota mode: none.",
+    "audit: type=1400 audit(1700000000.123:42): apparmor=\"STATUS\" operation=\"profile_load\"",
+];
+
+fn dump_mb() -> u64 {
+    std::env::var("GDND_BENCH_KMSG_MB")
+        .ok()
+        .and_then(|v| v.parse().ok())
+        .unwrap_or(64)
+}
+
+/// Write `mb` megabytes of kmsg records to `path`
+fn write_dump(path: &Path, mb: u64) -> u64 {
+    let mut out = BufWriter::with_capacity(1 << 20, File::create(path).unwrap());
+    let limit = mb << 20;
+    let mut written = 0;
+    let mut seq = 0u64;
+    while written < limit {
+        let timestamp = 5_000_000_000 + seq * 1000;
+        let line = if seq % XID_EVERY == 0 {
+            let bus = BUSES[(seq / XID_EVERY) as usize % BUSES.len()];
+            format!(
+                "4,{seq},{timestamp},-;NVRM: Xid (PCI:0000:{bus}:00): 79, pid=1234, name=python, GPU has fallen off the bus.\n SUBSYSTEM=pci\n DEVICE=+pci:0000:{bus}:00.0\n"
+            )
+        } else {
+            format!(
+                "6,{seq},{timestamp},-;{}\n",
+                CHATTER[seq as usize % CHATTER.len()]
+            )
+        };
+        out.write_all(line.as_bytes()).unwrap();
+        written += line.len() as u64;
+        seq += 1;
+    }
+    out.flush().unwrap();
+    written
+}
+
+fn devices() -> HashMap<PciAddress, u32> {
+    BUSES
+        .iter()
+        .enumerate()
+        .map(|(index, bus)| {
+            let address = PciAddress::parse(&format!("0000:{}:00", bus)).unwrap();
+            (address, index as u32)
+        })
+        .collect()
+}
+
+fn bench_scan(c: &mut Criterion) {
+    let path = std::env::temp_dir().join(format!("gdnd-bench-kmsg-{}", std::process::id()));
+    let bytes = write_dump(&path, dump_mb());
+    let devices = devices();
+
+    let mut group = c.benchmark_group("kmsg_scan");
+    group.sample_size(10);
+    group.throughput(Throughput::Bytes(bytes));
+    group.bench_function("cold_poll", |b| {
+        b.iter(|| {
+            let reader = KmsgReader::open(&path, None, devices.clone()).unwrap();
+            criterion::black_box(reader.poll().unwrap())
+        })
+    });
+    group.finish();
+
+    let _ = std::fs::remove_file(&path);
+}
+
+criterion_group!(benches, bench_scan);
+criterion_main!(benches);
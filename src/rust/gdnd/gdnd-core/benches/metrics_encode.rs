@@ -0,0 +1,88 @@
+//! Benchmarks for Prometheus metric updates and scrape encoding
+//!
+//! Measures the per-sweep `MetricsRegistry` updates an L1 sweep makes for
+//! every device on a 16-device node (full `DeviceMetrics` export through
+//! pre-bound handles), and encoding the full registry to the text
+//! exposition format as a scrape does.
+
+use criterion::{criterion_group, criterion_main, Criterion, Throughput};
+use gdnd_core::detection::DetectionLevel;
+use gdnd_core::device::{DeviceId, DeviceMetrics, EccErrors};
+use gdnd_core::metrics::MetricsRegistry;
+use gdnd_core::state_machine::HealthState;
+
+const DEVICES: u32 = 16;
+
+fn devices() -> Vec<DeviceId> {
+    (0..DEVICES)
+        .map(|index| DeviceId {
+            index,
+            uuid: Some(format!("GPU-{:08x}-bench", index)),
+            name: "Bench GPU".to_string(),
+        })
+        .collect()
+}
+
+fn telemetry() -> DeviceMetrics {
+    DeviceMetrics {
+        temperature: 61,
+        memory_temperature: None,
+        gpu_utilization: 87,
+        memory_utilization: 40,
+        power_usage: 280,
+        power_limit: 400,
+        memory_total: 80 << 30,
+        memory_used: 42 << 30,
+        memory_free: 38 << 30,
+        pcie_tx: Some(1_200_000),
+        pcie_rx: Some(900_000),
+        ecc_errors: EccErrors::default(),
+        timestamp: chrono::Utc::now(),
+    }
+}
+
+/// The updates one L1 sweep makes for a device
+fn update(metrics: &MetricsRegistry, device: &DeviceId, telemetry: &DeviceMetrics) {
+    metrics.observe_device_metrics(device, telemetry);
+    metrics.set_gpu_status(device, HealthState::Healthy);
+    metrics.observe_check_duration(DetectionLevel::L1Passive, device, 0.004);
+}
+
+fn bench_metrics(c: &mut Criterion) {
+    let metrics = MetricsRegistry::new();
+    let devices = devices();
+    let telemetry = telemetry();
+    metrics.set_gpu_count(devices.len() as i64);
+    metrics.register_devices(&devices);
+    for device in &devices {
+        update(&metrics, device, &telemetry);
+        metrics.observe_check_duration(DetectionLevel::L2Active, device, 1.2);
+        metrics.set_l2_probe_deadline(device, 30.0);
+    }
+
+    let mut group = c.benchmark_group("metrics");
+    group.throughput(Throughput::Elements(devices.len() as u64));
+    group.bench_function("sweep_update", |b| {
+        b.iter(|| {
+            for device in &devices {
+                update(&metrics, device, &telemetry);
+            }
+        })
+    });
+    group.finish();
+
+    let mut group = c.benchmark_group("metrics");
+    group.bench_function("encode", |b| {
+        b.iter(|| {
+            criterion::black_box(
+                prometheus::TextEncoder::new()
+                    .encode_to_string(&prometheus::gather())
+                    .unwrap(),
+            )
+        })
+    });
+    group.finish();
+}
+
+criterion_group!(benches, bench_metrics);
+criterion_main!(benches);
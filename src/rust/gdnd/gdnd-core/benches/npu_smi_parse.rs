@@ -0,0 +1,81 @@
+//! Benchmarks for parsing recorded `npu-smi info` output
+//!
+//! Runs the single-pass parser over every fixture in `testdata/npu-smi/`
+//! (8 and 16 NPUs, several npu-smi versions and boards), next to the
+//! per-line regex matching it replaced as a baseline.
+
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+use gdnd_core::device::parse_info;
+use regex::Regex;
+
+const FIXTURES: &[&str] = &[
+    "910a-8npu-22.0.txt",
+    "910b-8npu-24.1.txt",
+    "310p-8npu-23.0.txt",
+    "910b-16npu-23.0.txt",
+];
+
+/// The regex matching used before the single-pass parser
+struct RegexParser {
+    device: Regex,
+    chip: Regex,
+    metrics: Regex,
+}
+
+impl RegexParser {
+    fn new() -> Self {
+        Self {
+            device: Regex::new(r"\|\s*(\d+)\s+(\S+)\s+\|\s*(\w+)\s+\|").unwrap(),
+            chip: Regex::new(r"\|\s*(\d+)\s+\|\s*([0-9a-fA-F:\.]+)\s+\|").unwrap(),
+            metrics: Regex::new(r"\|\s*(\d+)\s+\S+\s+\|\s*\w+\s+\|\s*(\d+\.?\d*)\s+(\d+)\s+")
+                .unwrap(),
+        }
+    }
+
+    /// Returns (devices, chips) matched, so the work is not optimized away
+    fn parse(&self, output: &str) -> (usize, usize) {
+        let mut devices = 0;
+        let mut chips = 0;
+        for line in output.lines() {
+            if let Some(caps) = self.device.captures(line) {
+                let _ = (
+                    caps[1].to_string(),
+                    caps[2].to_string(),
+                    caps[3].to_string(),
+                );
+                devices += 1;
+            }
+            if let Some(caps) = self.metrics.captures(line) {
+                let _: Option<f64> = caps[2].parse().ok();
+            }
+            if let Some(caps) = self.chip.captures(line) {
+                let _ = caps[2].to_string();
+                chips += 1;
+            }
+        }
+        (devices, chips)
+    }
+}
+
+fn bench_parse(c: &mut Criterion) {
+    let dir = concat!(env!("CARGO_MANIFEST_DIR"), "/testdata/npu-smi");
+    let regex = RegexParser::new();
+
+    let mut group = c.benchmark_group("npu_smi_parse");
+    for name in FIXTURES {
+        let output = std::fs::read_to_string(format!("{dir}/{name}")).unwrap();
+        group.throughput(Throughput::Bytes(output.len() as u64));
+        group.bench_with_input(
+            BenchmarkId::new("single_pass", name),
+            &output,
+            |b, output| b.iter(|| parse_info(output).count()),
+        );
+        group.bench_with_input(BenchmarkId::new("regex", name), &output, |b, output| {
+            b.iter(|| regex.parse(output))
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(benches, bench_parse);
+criterion_main!(benches);
@@ -0,0 +1,71 @@
+//! Benchmarks for an Ascend L1 sweep against recorded npu-smi output
+//!
+//! A stand-in npu-smi script replays a recorded table from `testdata/`, so each
+//! query still pays for a process spawn. The sweep lists devices, then
+//! collects metrics, errors and zombie processes for all 16 NPUs
+//! concurrently, once with the per-sweep snapshot cache and once with
+//! caching disabled (one npu-smi launch per query).
+
+use std::os::unix::fs::PermissionsExt;
+use std::path::PathBuf;
+use std::time::Duration;
+
+use criterion::{criterion_group, criterion_main, Criterion};
+use gdnd_core::device::{AscendDevice, DeviceInterface};
+
+fn fake_npu_smi(dir: &PathBuf) -> PathBuf {
+    let fixtures = concat!(env!("CARGO_MANIFEST_DIR"), "/testdata");
+    let script = dir.join("npu-smi");
+    std::fs::create_dir_all(dir).unwrap();
+    std::fs::write(
+        &script,
+        format!("#!/bin/sh\ncat {fixtures}/npu-smi/910b-16npu-23.0.txt\n"),
+    )
+    .unwrap();
+    std::fs::set_permissions(&script, std::fs::Permissions::from_mode(0o755)).unwrap();
+    script
+}
+
+async fn sweep(device: &AscendDevice) {
+    let devices = device.list_devices().await.unwrap();
+    let checks = devices.iter().map(|d| async move {
+        device.get_metrics(d).await.unwrap();
+        device.get_xid_errors(d).await.unwrap();
+        device.check_zombie_processes(d).await.unwrap();
+    });
+    futures::future::join_all(checks).await;
+}
+
+fn bench_sweep(c: &mut Criterion) {
+    let dir = std::env::temp_dir().join(format!("gdnd-bench-npu-smi-{}", std::process::id()));
+    let script = fake_npu_smi(&dir);
+    let runtime = tokio::runtime::Runtime::new().unwrap();
+    let device = |ttl: Duration| {
+        AscendDevice::with_config(
+            script.display().to_string(),
+            "/nonexistent/npu-check".to_string(),
+            dir.join("slog"),
+            vec![1001, 1002, 1005, 1007, 1008],
+        )
+        .unwrap()
+        .with_snapshot_ttl(ttl)
+    };
+
+    let mut group = c.benchmark_group("npu_smi_sweep");
+    group.sample_size(20);
+
+    // Each iteration is a new sweep, so the cache starts cold every time
+    group.bench_function("snapshot", |b| {
+        b.iter(|| runtime.block_on(sweep(&device(Duration::from_secs(5)))))
+    });
+    group.bench_function("uncached", |b| {
+        let device = device(Duration::ZERO);
+        b.iter(|| runtime.block_on(sweep(&device)))
+    });
+    group.finish();
+
+    std::fs::remove_dir_all(&dir).unwrap();
+}
+
+criterion_group!(benches, bench_sweep);
+criterion_main!(benches);
@@ -0,0 +1,158 @@
+//! Benchmarks for a full detection cycle as device count grows
+//!
+//! A `MockDevice` with simulated per-call latency is wired through the L1,
+//! L2 and L3 detectors, the health manager and a no-op isolation executor,
+//! exactly as the daemon assembles them. One cycle is the daemon's own
+//! pipeline, `run`, driven for an hour of virtual time on a paused tokio
+//! clock and then shut down: per-device actors, permits, state watchers and
+//! all. Simulated latencies elapse instantly, so the figures are the
+//! scheduling and detection overhead itself. Before timing, each node size
+//! reports per-cycle CPU time, allocations and voluntary context switches.
+//! The paused clock needs a single-threaded runtime, so lock contention
+//! between workers is not exercised.
+
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::Arc;
+use std::time::{Duration, Instant};
+
+use anyhow::Result;
+use criterion::{criterion_group, criterion_main, BatchSize, BenchmarkId, Criterion, Throughput};
+use gdnd_core::detection::{L1PassiveDetector, L2ActiveDetector, L3PcieDetector};
+use gdnd_core::device::MockDevice;
+use gdnd_core::metrics::MetricsRegistry;
+use gdnd_core::scheduler::{DetectionScheduler, IsolationExecutor};
+use gdnd_core::state_machine::{GpuHealthManager, StateTransition};
+use tokio::sync::watch;
+
+struct CountingAlloc;
+
+static ALLOCATIONS: AtomicUsize = AtomicUsize::new(0);
+
+unsafe impl GlobalAlloc for CountingAlloc {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        System.alloc(layout)
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        System.dealloc(ptr, layout)
+    }
+}
+
+#[global_allocator]
+static GLOBAL: CountingAlloc = CountingAlloc;
+
+const DEVICE_COUNTS: &[u32] = &[8, 64, 256];
+const FATAL_XIDS: [u32; 4] = [31, 43, 48, 79];
+/// Per metrics/XID/zombie query
+const QUERY_LATENCY: Duration = Duration::from_micros(200);
+/// Per active check and PCIe test
+const CHECK_LATENCY: Duration = Duration::from_millis(2);
+/// Virtual time the pipeline runs per cycle: 120 L1, 12 L2 and 1 L3 sweeps
+const CYCLE: Duration = Duration::from_secs(3600);
+/// Cycles averaged for the per-cycle resource report
+const REPORT_CYCLES: u32 = 10;
+
+struct NoopExecutor;
+
+#[async_trait::async_trait]
+impl IsolationExecutor for NoopExecutor {
+    async fn execute(&self, _transition: &StateTransition) -> Result<()> {
+        Ok(())
+    }
+}
+
+fn scheduler(devices: u32) -> Arc<DetectionScheduler<NoopExecutor>> {
+    let device =
+        Arc::new(MockDevice::with_device_count(devices).with_latency(QUERY_LATENCY, CHECK_LATENCY));
+    let scheduler = DetectionScheduler::new(
+        L1PassiveDetector::new(device.clone(), 85, FATAL_XIDS.to_vec()),
+        L2ActiveDetector::new(
+            device.clone(),
+            "/nonexistent/gpu-check".to_string(),
+            Duration::from_secs(30),
+        ),
+        Arc::new(GpuHealthManager::new(3, FATAL_XIDS.to_vec())),
+        Arc::new(NoopExecutor),
+        Arc::new(MetricsRegistry::new()),
+        Duration::from_secs(30),
+        Duration::from_secs(300),
+    )
+    .with_l3(L3PcieDetector::new(device), Duration::from_secs(3600));
+    Arc::new(scheduler)
+}
+
+/// Run the actor pipeline for one cycle of virtual time, then shut it down
+async fn cycle(scheduler: Arc<DetectionScheduler<NoopExecutor>>) {
+    let (shutdown_tx, shutdown_rx) = watch::channel(false);
+    let pipeline = tokio::spawn(scheduler.run(shutdown_rx));
+    tokio::time::sleep(CYCLE).await;
+    shutdown_tx.send(true).unwrap();
+    pipeline.await.unwrap().unwrap();
+}
+
+/// Single-threaded runtime whose clock only moves when every task waits
+fn paused_runtime() -> tokio::runtime::Runtime {
+    tokio::runtime::Builder::new_current_thread()
+        .enable_time()
+        .start_paused(true)
+        .build()
+        .unwrap()
+}
+
+/// Process CPU time and voluntary context switches so far
+fn usage() -> (Duration, i64) {
+    let mut usage: libc::rusage = unsafe { std::mem::zeroed() };
+    unsafe { libc::getrusage(libc::RUSAGE_SELF, &mut usage) };
+    let time = |tv: libc::timeval| {
+        Duration::from_secs(tv.tv_sec as u64) + Duration::from_micros(tv.tv_usec as u64)
+    };
+    (time(usage.ru_utime) + time(usage.ru_stime), usage.ru_nvcsw)
+}
+
+fn report(runtime: &tokio::runtime::Runtime, devices: u32) {
+    let schedulers: Vec<_> = (0..REPORT_CYCLES).map(|_| scheduler(devices)).collect();
+
+    let (cpu_before, switches_before) = usage();
+    let allocations_before = ALLOCATIONS.load(Ordering::Relaxed);
+    let start = Instant::now();
+    for scheduler in schedulers {
+        runtime.block_on(cycle(scheduler));
+    }
+    let elapsed = start.elapsed();
+    let allocations = ALLOCATIONS.load(Ordering::Relaxed) - allocations_before;
+    let (cpu_after, switches_after) = usage();
+
+    println!(
+        "scheduler_scale/{}: per cycle {:?} wall, {:?} cpu, {} allocations, {} voluntary context switches",
+        devices,
+        elapsed / REPORT_CYCLES,
+        (cpu_after - cpu_before) / REPORT_CYCLES,
+        allocations / REPORT_CYCLES as usize,
+        (switches_after - switches_before) / REPORT_CYCLES as i64
+    );
+}
+
+fn bench_cycle(c: &mut Criterion) {
+    let runtime = paused_runtime();
+
+    let mut group = c.benchmark_group("scheduler_scale");
+    group.sample_size(10);
+    for &devices in DEVICE_COUNTS {
+        report(&runtime, devices);
+
+        group.throughput(Throughput::Elements(devices as u64));
+        group.bench_with_input(BenchmarkId::new("run", devices), &devices, |b, &devices| {
+            b.iter_batched(
+                || scheduler(devices),
+                |scheduler| runtime.block_on(cycle(scheduler)),
+                BatchSize::PerIteration,
+            )
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(benches, bench_cycle);
+criterion_main!(benches);
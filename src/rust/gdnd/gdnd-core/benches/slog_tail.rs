@@ -0,0 +1,120 @@
+//! Benchmarks for Ascend device-os log tailing
+//!
+//! Builds a synthetic slog corpus and measures a cold scan of the whole
+//! corpus and the steady-state cost of picking up a freshly appended
+//! megabyte. The corpus is 8 MiB by default; set `GDND_BENCH_SLOG_MB` (e.g.
+//! to 2048) for a production-sized device-os log directory.
+
+use std::fs::{self, File, OpenOptions};
+use std::io::{BufWriter, Write};
+use std::path::{Path, PathBuf};
+
+use criterion::{criterion_group, criterion_main, Criterion, Throughput};
+use gdnd_core::device::SlogTailer;
+
+/// Size of each synthetic log file
+const FILE_MB: u64 = 256;
+
+/// One error line per this many info lines
+const ERROR_EVERY: u64 = 100_000;
+
+fn corpus_mb() -> u64 {
+    std::env::var("GDND_BENCH_SLOG_MB")
+        .ok()
+        .and_then(|v| v.parse().ok())
+        .unwrap_or(8)
+}
+
+/// Write `mb` megabytes of log lines to `path`
+fn write_log(path: &Path, mb: u64) -> u64 {
+    let mut out = BufWriter::with_capacity(1 << 20, File::create(path).unwrap());
+    let limit = mb << 20;
+    let mut written = 0u64;
+    let mut line = 0u64;
+    while written < limit {
+        let text = if line % ERROR_EVERY == ERROR_EVERY - 1 {
+            format!(
+                "[ERROR] DRV(2381,hbm):2024-03-18-09:41:{:02}.512.331 [hbm.c:88] HBM multi-bit error addr=0x{:x}\n",
+                line % 60,
+                line
+            )
+        } else {
+            format!(
+                "[INFO] TSCH(2381,tsch):2024-03-18-09:41:{:02}.512.331 [task.c:1021] stream {} task {} completed, sq head {}\n",
+                line % 60,
+                line % 64,
+                line,
+                line % 1024
+            )
+        };
+        out.write_all(text.as_bytes()).unwrap();
+        written += text.len() as u64;
+        line += 1;
+    }
+    out.flush().unwrap();
+    written
+}
+
+/// Build the corpus under a temporary slog root, returning its total size
+fn build_corpus(root: &Path) -> u64 {
+    let dir = root.join("device-os-0");
+    let _ = fs::remove_dir_all(root);
+    fs::create_dir_all(&dir).unwrap();
+
+    let mut remaining = corpus_mb();
+    let mut total = 0;
+    let mut file = 0;
+    while remaining > 0 {
+        let mb = remaining.min(FILE_MB);
+        total += write_log(&dir.join(format!("device-os_{}.log", file)), mb);
+        remaining -= mb;
+        file += 1;
+    }
+    total
+}
+
+fn bench_slog_tail(c: &mut Criterion) {
+    let root: PathBuf =
+        std::env::temp_dir().join(format!("gdnd-bench-slog-{}", std::process::id()));
+    let total = build_corpus(&root);
+
+    let mut group = c.benchmark_group("slog_tail");
+    group.sample_size(10);
+
+    group.throughput(Throughput::Bytes(total));
+    group.bench_function("cold_scan", |b| {
+        b.iter(|| SlogTailer::new(root.clone()).poll(0))
+    });
+
+    // A tailer that has caught up only reads what is appended
+    let tailer = SlogTailer::new(root.clone());
+    tailer.poll(0);
+    let live = root.join("device-os-0").join("device-os_live.log");
+    File::create(&live).unwrap();
+    let chunk = {
+        let path = root.join("chunk.log");
+        write_log(&path, 1);
+        let data = fs::read(&path).unwrap();
+        fs::remove_file(&path).unwrap();
+        data
+    };
+
+    group.throughput(Throughput::Bytes(chunk.len() as u64));
+    group.bench_function("append_1mb", |b| {
+        b.iter(|| {
+            OpenOptions::new()
+                .append(true)
+                .open(&live)
+                .unwrap()
+                .write_all(&chunk)
+                .unwrap();
+            tailer.poll(0)
+        })
+    });
+    group.finish();
+
+    fs::remove_dir_all(&root).unwrap();
+}
+
+criterion_group!(benches, bench_slog_tail);
+criterion_main!(benches);
@@ -0,0 +1,1014 @@
+//! Performance Baseline Store
+//!
+//! Keeps rolling per-device baselines of probe measurements (phase timings,
+//! bandwidth figures) so that slow degradation is caught even while every
+//! individual check still "passes".
+//!
+//! Each (device, metric) pair tracks:
+//! - EWMA mean and variance (for sudden-regression z-scores)
+//! - p50 / p99 over a fixed window of recent samples
+//! - A reference median frozen once the baseline is established (for drift),
+//!   re-based to the current level each time drift is reported so a single
+//!   step change is reported once rather than on every sample
+//!
+//! The store is a fixed-size binary file memory-mapped into the daemon, so
+//! updates are plain memory writes and baselines survive daemon restarts.
+//! Reopening it with a different capacity carries the records over, keeping
+//! the most recently updated ones when shrinking.
+
+use std::collections::HashMap;
+use std::fs::{File, OpenOptions};
+use std::io::{self, Read};
+use std::path::{Path, PathBuf};
+use std::sync::Mutex;
+
+use chrono::Utc;
+use thiserror::Error;
+use tracing::{debug, info, warn};
+
+use crate::device::DeviceId;
+
+/// File magic identifying a baseline store
+const MAGIC: &[u8; 8] = b"GDNDBASE";
+/// On-disk format version
+const VERSION: u32 = 1;
+/// Header size in bytes
+const HEADER_SIZE: usize = 64;
+/// Number of recent samples kept per record for quantiles
+const WINDOW: usize = 64;
+/// Maximum key (device UUID) length in bytes
+const KEY_LEN: usize = 64;
+/// Maximum metric name length in bytes
+const METRIC_LEN: usize = 32;
+
+// Record layout (little endian)
+const OFF_KEY: usize = 0;
+const OFF_METRIC: usize = OFF_KEY + KEY_LEN;
+const OFF_COUNT: usize = OFF_METRIC + METRIC_LEN;
+const OFF_RING_POS: usize = OFF_COUNT + 4;
+const OFF_EWMA: usize = OFF_RING_POS + 4;
+const OFF_EWMA_VAR: usize = OFF_EWMA + 8;
+const OFF_REFERENCE: usize = OFF_EWMA_VAR + 8;
+const OFF_UPDATED: usize = OFF_REFERENCE + 8;
+const OFF_RING: usize = OFF_UPDATED + 8;
+/// Size of a single record in bytes
+const RECORD_SIZE: usize = OFF_RING + WINDOW * 4;
+
+/// Default number of records the store can hold
+pub const DEFAULT_CAPACITY: usize = 512;
+
+/// Errors that can occur when opening the baseline store
+#[derive(Debug, Error)]
+pub enum BaselineError {
+    /// IO error
+    #[error("IO error: {0}")]
+    IoError(#[from] io::Error),
+
+    /// Invalid store parameters
+    #[error("Invalid baseline store: {0}")]
+    Invalid(String),
+}
+
+/// Regression detection configuration
+#[derive(Debug, Clone)]
+pub struct BaselineConfig {
+    /// EWMA smoothing factor (0 < alpha <= 1)
+    pub ewma_alpha: f64,
+    /// Samples required before a baseline is considered established
+    pub min_samples: u32,
+    /// Robust z-score above which a single sample is a regression
+    pub z_threshold: f64,
+    /// Minimum relative change for a sample to count as a regression
+    pub min_change: f64,
+    /// EWMA/reference ratio at which slow drift is reported
+    pub drift_ratio: f64,
+}
+
+impl Default for BaselineConfig {
+    fn default() -> Self {
+        Self {
+            ewma_alpha: 0.1,
+            min_samples: 10,
+            z_threshold: 4.0,
+            min_change: 0.25,
+            drift_ratio: 2.0,
+        }
+    }
+}
+
+/// Snapshot of the baseline for one device metric
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct Baseline {
+    /// Number of samples folded into the baseline
+    pub count: u32,
+    /// Exponentially weighted moving average
+    pub ewma: f64,
+    /// Exponentially weighted standard deviation
+    pub stddev: f64,
+    /// Median of the recent sample window
+    pub p50: f64,
+    /// 99th percentile of the recent sample window
+    pub p99: f64,
+    /// Median frozen when the baseline was established, re-based after
+    /// each reported drift (0 = not yet)
+    pub reference: f64,
+}
+
+/// Kind of regression detected
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum RegressionKind {
+    /// A single sample far outside the recent distribution
+    Sudden {
+        /// Deviation from the EWMA in standard deviations
+        z_score: f64,
+    },
+    /// The moving average drifted away from the established reference
+    Drift {
+        /// Degradation factor relative to the reference (>1 = worse)
+        ratio: f64,
+    },
+}
+
+/// A statistically significant regression of a probe measurement
+#[derive(Debug, Clone, PartialEq)]
+pub struct Regression {
+    /// Metric name
+    pub metric: String,
+    /// Sample that triggered the regression
+    pub value: f64,
+    /// Baseline the sample was compared against
+    pub baseline: Baseline,
+    /// Kind of regression
+    pub kind: RegressionKind,
+}
+
+impl std::fmt::Display for Regression {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        match self.kind {
+            RegressionKind::Sudden { z_score } => write!(
+                f,
+                "{} regressed: {:.3} vs baseline ewma {:.3} (p50 {:.3}, p99 {:.3}, z={:.1})",
+                self.metric,
+                self.value,
+                self.baseline.ewma,
+                self.baseline.p50,
+                self.baseline.p99,
+                z_score
+            ),
+            RegressionKind::Drift { ratio } => write!(
+                f,
+                "{} drifted {:.1}x from reference {:.3} (ewma {:.3}, p99 {:.3})",
+                self.metric, ratio, self.baseline.reference, self.baseline.ewma, self.baseline.p99
+            ),
+        }
+    }
+}
+
+/// Evaluate a new sample against an established baseline
+///
+/// Returns `None` while the baseline is still warming up or the sample is
+/// within the expected range.
+pub fn evaluate(
+    metric: &str,
+    baseline: &Baseline,
+    value: f64,
+    higher_is_better: bool,
+    config: &BaselineConfig,
+) -> Option<Regression> {
+    if baseline.count < config.min_samples || baseline.ewma <= 0.0 {
+        return None;
+    }
+
+    // Signed degradation: positive means "worse than usual"
+    let degradation = if higher_is_better {
+        baseline.ewma - value
+    } else {
+        value - baseline.ewma
+    };
+    // Floor the spread so perfectly stable metrics don't turn noise into huge z-scores
+    let sigma = baseline
+        .stddev
+        .max(baseline.ewma * config.min_change / config.z_threshold);
+    let z_score = degradation / sigma;
+
+    if z_score >= config.z_threshold && degradation >= baseline.ewma * config.min_change {
+        return Some(Regression {
+            metric: metric.to_string(),
+            value,
+            baseline: *baseline,
+            kind: RegressionKind::Sudden { z_score },
+        });
+    }
+
+    if baseline.reference > 0.0 {
+        let ratio = if higher_is_better {
+            baseline.reference / baseline.ewma
+        } else {
+            baseline.ewma / baseline.reference
+        };
+        if ratio >= config.drift_ratio {
+            return Some(Regression {
+                metric: metric.to_string(),
+                value,
+                baseline: *baseline,
+                kind: RegressionKind::Drift { ratio },
+            });
+        }
+    }
+
+    None
+}
+
+/// Memory-mapped region backed by a file
+struct MappedRegion {
+    ptr: *mut u8,
+    len: usize,
+    _file: File,
+}
+
+// SAFETY: the mapping is exclusively owned and only accessed through `&mut`
+// or behind the store mutex.
+unsafe impl Send for MappedRegion {}
+
+impl MappedRegion {
+    fn open(path: &Path, len: usize) -> io::Result<Self> {
+        if let Some(parent) = path.parent() {
+            std::fs::create_dir_all(parent)?;
+        }
+
+        let file = OpenOptions::new()
+            .read(true)
+            .write(true)
+            .create(true)
+            .truncate(false)
+            .open(path)?;
+        if file.metadata()?.len() != len as u64 {
+            file.set_len(len as u64)?;
+        }
+
+        // SAFETY: mapping a regular file we just sized to `len` bytes.
+        let ptr = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                len,
+                libc::PROT_READ | libc::PROT_WRITE,
+                libc::MAP_SHARED,
+                std::os::unix::io::AsRawFd::as_raw_fd(&file),
+                0,
+            )
+        };
+        if ptr == libc::MAP_FAILED {
+            return Err(io::Error::last_os_error());
+        }
+
+        Ok(Self {
+            ptr: ptr as *mut u8,
+            len,
+            _file: file,
+        })
+    }
+
+    fn as_slice(&self) -> &[u8] {
+        // SAFETY: ptr/len describe a live mapping owned by self.
+        unsafe { std::slice::from_raw_parts(self.ptr, self.len) }
+    }
+
+    fn as_mut_slice(&mut self) -> &mut [u8] {
+        // SAFETY: ptr/len describe a live mapping owned by self.
+        unsafe { std::slice::from_raw_parts_mut(self.ptr, self.len) }
+    }
+
+    fn flush(&self) {
+        // SAFETY: ptr/len describe a live mapping owned by self.
+        unsafe {
+            libc::msync(self.ptr as *mut libc::c_void, self.len, libc::MS_ASYNC);
+        }
+    }
+}
+
+impl Drop for MappedRegion {
+    fn drop(&mut self) {
+        // SAFETY: unmapping the region created in `open`.
+        unsafe {
+            libc::msync(self.ptr as *mut libc::c_void, self.len, libc::MS_SYNC);
+            libc::munmap(self.ptr as *mut libc::c_void, self.len);
+        }
+    }
+}
+
+/// Storage backing the record table
+enum Backing {
+    /// File-backed shared mapping (persistent)
+    Mapped(MappedRegion),
+    /// Heap buffer (non-persistent, for tests or when no path is configured)
+    Heap(Vec<u8>),
+}
+
+impl Backing {
+    fn bytes(&self) -> &[u8] {
+        match self {
+            Backing::Mapped(region) => region.as_slice(),
+            Backing::Heap(buf) => buf,
+        }
+    }
+
+    fn bytes_mut(&mut self) -> &mut [u8] {
+        match self {
+            Backing::Mapped(region) => region.as_mut_slice(),
+            Backing::Heap(buf) => buf,
+        }
+    }
+}
+
+/// Record table with an in-memory index
+struct Table {
+    backing: Backing,
+    capacity: usize,
+    /// Number of occupied slots
+    records: usize,
+    /// Slots found so far by device index and metric; checked against the
+    /// stored key on use, since another board may take over an index
+    index: HashMap<(u32, &'static str), usize>,
+}
+
+impl Table {
+    fn new(backing: Backing, capacity: usize) -> Self {
+        let mut table = Self {
+            backing,
+            capacity,
+            records: 0,
+            index: HashMap::new(),
+        };
+
+        if table.header_valid() {
+            table.records = (0..capacity)
+                .filter(|&slot| table.record(slot)[OFF_KEY] != 0)
+                .count();
+        } else {
+            let bytes = table.backing.bytes();
+            if &bytes[0..8] == MAGIC && !layout_matches(bytes) {
+                warn!(
+                    version = read_u32(bytes, 8),
+                    record_size = read_u32(bytes, 12),
+                    "Baseline store has an incompatible layout, discarding its records"
+                );
+            }
+            table.format();
+        }
+        table
+    }
+
+    fn header_valid(&self) -> bool {
+        let bytes = self.backing.bytes();
+        layout_matches(bytes) && read_u32(bytes, 16) == self.capacity as u32
+    }
+
+    fn format(&mut self) {
+        let capacity = self.capacity as u32;
+        let bytes = self.backing.bytes_mut();
+        bytes.fill(0);
+        bytes[0..8].copy_from_slice(MAGIC);
+        write_u32(bytes, 8, VERSION);
+        write_u32(bytes, 12, RECORD_SIZE as u32);
+        write_u32(bytes, 16, capacity);
+        self.records = 0;
+        self.index.clear();
+    }
+
+    /// Carry over the records of a store created with another capacity
+    ///
+    /// Expects a freshly formatted table. When there are more records than
+    /// slots, the least recently updated ones are dropped.
+    fn migrate(&mut self, previous: &[u8]) {
+        let mut records: Vec<&[u8]> = previous
+            .chunks_exact(RECORD_SIZE)
+            .filter(|record| record[OFF_KEY] != 0)
+            .collect();
+        records.sort_by_key(|record| std::cmp::Reverse(read_i64(record, OFF_UPDATED)));
+
+        let kept = records.len().min(self.capacity);
+        for (slot, record) in records[..kept].iter().enumerate() {
+            self.record_mut(slot).copy_from_slice(record);
+        }
+        self.records = kept;
+
+        let from = previous.len() / RECORD_SIZE;
+        let dropped = records.len() - kept;
+        if dropped > 0 {
+            warn!(
+                from = from,
+                to = self.capacity,
+                kept = kept,
+                dropped = dropped,
+                "Baseline store shrunk, dropped least recently updated records"
+            );
+        } else {
+            info!(
+                from = from,
+                to = self.capacity,
+                kept = kept,
+                "Baseline store resized"
+            );
+        }
+    }
+
+    fn record(&self, slot: usize) -> &[u8] {
+        let start = HEADER_SIZE + slot * RECORD_SIZE;
+        &self.backing.bytes()[start..start + RECORD_SIZE]
+    }
+
+    fn record_mut(&mut self, slot: usize) -> &mut [u8] {
+        let start = HEADER_SIZE + slot * RECORD_SIZE;
+        &mut self.backing.bytes_mut()[start..start + RECORD_SIZE]
+    }
+
+    /// Whether a slot holds the record of a device metric
+    fn holds(&self, slot: usize, device: &DeviceId, metric: &str) -> bool {
+        let record = self.record(slot);
+        let key = read_str(&record[OFF_KEY..OFF_KEY + KEY_LEN]);
+        !key.is_empty()
+            && key_matches(key, device)
+            && read_str(&record[OFF_METRIC..OFF_METRIC + METRIC_LEN])
+                == truncated(metric, METRIC_LEN - 1)
+    }
+
+    /// Find the slot of a device metric, if it has a record
+    ///
+    /// A cached slot is checked and used directly; otherwise the table is
+    /// scanned once and the result cached.
+    fn find(&mut self, device: &DeviceId, metric: &'static str) -> Option<usize> {
+        if let Some(&slot) = self.index.get(&(device.index, metric)) {
+            if self.holds(slot, device, metric) {
+                return Some(slot);
+            }
+        }
+        let slot = (0..self.capacity).find(|&slot| self.holds(slot, device, metric))?;
+        self.index.insert((device.index, metric), slot);
+        Some(slot)
+    }
+
+    /// Find or allocate the slot for a device metric
+    fn slot_for(&mut self, device: &DeviceId, metric: &'static str) -> usize {
+        if let Some(slot) = self.find(device, metric) {
+            return slot;
+        }
+
+        // Prefer a free slot, otherwise evict the least recently updated record
+        let slot = (0..self.capacity)
+            .find(|&slot| self.record(slot)[OFF_KEY] == 0)
+            .unwrap_or_else(|| {
+                (0..self.capacity)
+                    .min_by_key(|&slot| read_i64(self.record(slot), OFF_UPDATED))
+                    .unwrap_or(0)
+            });
+
+        let record = self.record(slot);
+        if record[OFF_KEY] != 0 {
+            let old_key = read_str(&record[OFF_KEY..OFF_KEY + KEY_LEN]);
+            let old_metric = read_str(&record[OFF_METRIC..OFF_METRIC + METRIC_LEN]);
+            debug!(
+                key = old_key,
+                metric = old_metric,
+                "Evicting baseline record"
+            );
+            self.index.retain(|_, cached| *cached != slot);
+        } else {
+            self.records += 1;
+        }
+
+        let key = device
+            .uuid
+            .clone()
+            .unwrap_or_else(|| format!("gpu-{}", device.index));
+        let record = self.record_mut(slot);
+        record.fill(0);
+        write_str(&mut record[OFF_KEY..OFF_KEY + KEY_LEN], &key);
+        write_str(&mut record[OFF_METRIC..OFF_METRIC + METRIC_LEN], metric);
+        self.index.insert((device.index, metric), slot);
+        slot
+    }
+}
+
+/// Per-device performance baseline store
+pub struct BaselineStore {
+    table: Mutex<Table>,
+    config: BaselineConfig,
+    path: Option<PathBuf>,
+}
+
+impl BaselineStore {
+    /// Open (or create) a persistent store at `path`
+    pub fn open<P: AsRef<Path>>(path: P, config: BaselineConfig) -> Result<Self, BaselineError> {
+        Self::open_with_capacity(path, DEFAULT_CAPACITY, config)
+    }
+
+    /// Open (or create) a persistent store holding up to `capacity` records
+    pub fn open_with_capacity<P: AsRef<Path>>(
+        path: P,
+        capacity: usize,
+        config: BaselineConfig,
+    ) -> Result<Self, BaselineError> {
+        if capacity == 0 {
+            return Err(BaselineError::Invalid("capacity must be > 0".to_string()));
+        }
+
+        let path = path.as_ref();
+        // Read before mapping: sizing the file for the new capacity would cut
+        // off the tail of a larger store
+        let previous = records_to_migrate(path, capacity);
+        let region = MappedRegion::open(path, HEADER_SIZE + capacity * RECORD_SIZE)?;
+        let mut table = Table::new(Backing::Mapped(region), capacity);
+        if let Some(previous) = previous {
+            table.migrate(&previous);
+        }
+        info!(
+            path = ?path,
+            records = table.records,
+            capacity = capacity,
+            "Opened performance baseline store"
+        );
+
+        Ok(Self {
+            table: Mutex::new(table),
+            config,
+            path: Some(path.to_path_buf()),
+        })
+    }
+
+    /// Create a non-persistent in-memory store
+    pub fn in_memory(config: BaselineConfig) -> Self {
+        let capacity = DEFAULT_CAPACITY;
+        let backing = Backing::Heap(vec![0; HEADER_SIZE + capacity * RECORD_SIZE]);
+        Self {
+            table: Mutex::new(Table::new(backing, capacity)),
+            config,
+            path: None,
+        }
+    }
+
+    /// Path of the backing file, if persistent
+    pub fn path(&self) -> Option<&Path> {
+        self.path.as_deref()
+    }
+
+    /// Get the regression detection configuration
+    pub fn config(&self) -> &BaselineConfig {
+        &self.config
+    }
+
+    /// Number of tracked (device, metric) records
+    pub fn len(&self) -> usize {
+        self.table.lock().unwrap_or_else(|e| e.into_inner()).records
+    }
+
+    /// Whether the store holds no records
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Get the current baseline for a device metric
+    pub fn get(&self, device: &DeviceId, metric: &'static str) -> Option<Baseline> {
+        let mut table = self.table.lock().unwrap_or_else(|e| e.into_inner());
+        let slot = table.find(device, metric)?;
+        Some(read_baseline(table.record(slot)))
+    }
+
+    /// Record a sample and report a regression against the prior baseline
+    ///
+    /// The sample is always folded into the baseline afterwards; slow drift
+    /// stays visible through the frozen reference median. Reporting a drift
+    /// acknowledges it: the reference moves to the current EWMA, so only a
+    /// further drift of the same ratio is reported again.
+    pub fn record(
+        &self,
+        device: &DeviceId,
+        metric: &'static str,
+        value: f64,
+        higher_is_better: bool,
+    ) -> Option<Regression> {
+        if !value.is_finite() || value < 0.0 {
+            return None;
+        }
+
+        let mut table = self.table.lock().unwrap_or_else(|e| e.into_inner());
+        let slot = table.slot_for(device, metric);
+
+        let prior = read_baseline(table.record(slot));
+        let regression = evaluate(metric, &prior, value, higher_is_better, &self.config);
+
+        fold_sample(table.record_mut(slot), value, &self.config);
+        if matches!(
+            regression,
+            Some(Regression {
+                kind: RegressionKind::Drift { .. },
+                ..
+            })
+        ) {
+            rebase(table.record_mut(slot));
+        }
+
+        if let Backing::Mapped(region) = &table.backing {
+            region.flush();
+        }
+
+        if let Some(ref r) = regression {
+            warn!(device = %device, regression = %r, "Performance regression detected");
+        }
+        regression
+    }
+
+    /// Record a censored sample: the true value is at least `value`
+    ///
+    /// Used for probes cut off at their deadline. The sample widens the
+    /// distribution but is not evaluated as a regression itself.
+    pub fn record_censored(&self, device: &DeviceId, metric: &'static str, value: f64) {
+        if !value.is_finite() || value < 0.0 {
+            return;
+        }
+
+        let mut table = self.table.lock().unwrap_or_else(|e| e.into_inner());
+        let slot = table.slot_for(device, metric);
+        fold_sample(table.record_mut(slot), value, &self.config);
+
+        if let Backing::Mapped(region) = &table.backing {
+            region.flush();
+        }
+    }
+}
+
+/// Whether a stored key belongs to a device (its UUID, or "gpu-N" without)
+fn key_matches(key: &str, device: &DeviceId) -> bool {
+    match &device.uuid {
+        Some(uuid) => key == truncated(uuid, KEY_LEN - 1),
+        None => key.strip_prefix("gpu-").and_then(|n| n.parse().ok()) == Some(device.index),
+    }
+}
+
+/// Whether a header describes a store with this version and record layout
+fn layout_matches(header: &[u8]) -> bool {
+    &header[0..8] == MAGIC
+        && read_u32(header, 8) == VERSION
+        && read_u32(header, 12) == RECORD_SIZE as u32
+}
+
+/// Records of an existing store at `path` sized for another capacity
+fn records_to_migrate(path: &Path, capacity: usize) -> Option<Vec<u8>> {
+    let mut file = File::open(path).ok()?;
+    let mut header = [0; HEADER_SIZE];
+    file.read_exact(&mut header).ok()?;
+    let previous = read_u32(&header, 16) as usize;
+    if !layout_matches(&header) || previous == capacity {
+        return None;
+    }
+    let mut records = vec![0; previous * RECORD_SIZE];
+    file.read_exact(&mut records).ok()?;
+    Some(records)
+}
+
+/// Fold a new sample into a record
+fn fold_sample(record: &mut [u8], value: f64, config: &BaselineConfig) {
+    let count = read_u32(record, OFF_COUNT);
+    let mut ewma = read_f64(record, OFF_EWMA);
+    let mut var = read_f64(record, OFF_EWMA_VAR);
+
+    if count == 0 {
+        ewma = value;
+        var = 0.0;
+    } else {
+        let diff = value - ewma;
+        let incr = config.ewma_alpha * diff;
+        ewma += incr;
+        var = (1.0 - config.ewma_alpha) * (var + diff * incr);
+    }
+
+    let pos = read_u32(record, OFF_RING_POS) as usize % WINDOW;
+    write_f32(record, OFF_RING + pos * 4, value as f32);
+    write_u32(record, OFF_RING_POS, ((pos + 1) % WINDOW) as u32);
+
+    let count = count.saturating_add(1);
+    write_u32(record, OFF_COUNT, count);
+    write_f64(record, OFF_EWMA, ewma);
+    write_f64(record, OFF_EWMA_VAR, var);
+    write_i64(record, OFF_UPDATED, Utc::now().timestamp());
+
+    // Freeze the reference once the baseline is established
+    if count == config.min_samples.max(1) {
+        let window = read_window(record, count);
+        write_f64(record, OFF_REFERENCE, quantile(&window, 0.5));
+    }
+}
+
+/// Move a record's drift reference to its current moving average
+fn rebase(record: &mut [u8]) {
+    let ewma = read_f64(record, OFF_EWMA);
+    write_f64(record, OFF_REFERENCE, ewma);
+}
+
+fn read_window(record: &[u8], count: u32) -> Vec<f64> {
+    let len = (count as usize).min(WINDOW);
+    (0..len)
+        .map(|i| read_f32(record, OFF_RING + i * 4) as f64)
+        .collect()
+}
+
+fn read_baseline(record: &[u8]) -> Baseline {
+    let count = read_u32(record, OFF_COUNT);
+    let window = read_window(record, count);
+    Baseline {
+        count,
+        ewma: read_f64(record, OFF_EWMA),
+        stddev: read_f64(record, OFF_EWMA_VAR).max(0.0).sqrt(),
+        p50: quantile(&window, 0.5),
+        p99: quantile(&window, 0.99),
+        reference: read_f64(record, OFF_REFERENCE),
+    }
+}
+
+/// Nearest-rank quantile of an unsorted sample set
+fn quantile(samples: &[f64], q: f64) -> f64 {
+    if samples.is_empty() {
+        return 0.0;
+    }
+    let mut sorted = samples.to_vec();
+    sorted.sort_by(|a, b| a.total_cmp(b));
+    let rank = (q * sorted.len() as f64).ceil() as usize;
+    sorted[rank.clamp(1, sorted.len()) - 1]
+}
+
+fn read_u32(buf: &[u8], off: usize) -> u32 {
+    u32::from_le_bytes(buf[off..off + 4].try_into().unwrap())
+}
+
+fn write_u32(buf: &mut [u8], off: usize, value: u32) {
+    buf[off..off + 4].copy_from_slice(&value.to_le_bytes());
+}
+
+fn read_i64(buf: &[u8], off: usize) -> i64 {
+    i64::from_le_bytes(buf[off..off + 8].try_into().unwrap())
+}
+
+fn write_i64(buf: &mut [u8], off: usize, value: i64) {
+    buf[off..off + 8].copy_from_slice(&value.to_le_bytes());
+}
+
+fn read_f64(buf: &[u8], off: usize) -> f64 {
+    f64::from_le_bytes(buf[off..off + 8].try_into().unwrap())
+}
+
+fn write_f64(buf: &mut [u8], off: usize, value: f64) {
+    buf[off..off + 8].copy_from_slice(&value.to_le_bytes());
+}
+
+fn read_f32(buf: &[u8], off: usize) -> f32 {
+    f32::from_le_bytes(buf[off..off + 4].try_into().unwrap())
+}
+
+fn write_f32(buf: &mut [u8], off: usize, value: f32) {
+    buf[off..off + 4].copy_from_slice(&value.to_le_bytes());
+}
+
+fn read_str(buf: &[u8]) -> &str {
+    let end = buf.iter().position(|&b| b == 0).unwrap_or(buf.len());
+    std::str::from_utf8(&buf[..end]).unwrap_or("")
+}
+
+fn write_str(buf: &mut [u8], value: &str) {
+    let value = truncated(value, buf.len() - 1);
+    buf[..value.len()].copy_from_slice(value.as_bytes());
+}
+
+/// Longest prefix of `value` within `max` bytes, cut on a char boundary so
+/// stored keys stay valid UTF-8
+fn truncated(value: &str, max: usize) -> &str {
+    let mut len = value.len().min(max);
+    while !value.is_char_boundary(len) {
+        len -= 1;
+    }
+    &value[..len]
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn test_device(index: u32) -> DeviceId {
+        DeviceId {
+            index,
+            uuid: Some(format!("GPU-BASELINE-{}", index)),
+            name: "Test GPU".to_string(),
+        }
+    }
+
+    fn temp_path(name: &str) -> PathBuf {
+        std::env::temp_dir().join(format!("gdnd-baseline-{}-{}.bin", name, std::process::id()))
+    }
+
+    #[test]
+    fn test_warmup_never_regresses() {
+        let store = BaselineStore::in_memory(BaselineConfig::default());
+        let device = test_device(0);
+
+        for i in 0..9 {
+            let value = if i == 8 { 1000.0 } else { 10.0 };
+            assert!(store
+                .record(&device, "l2.kernel_ms", value, false)
+                .is_none());
+        }
+    }
+
+    #[test]
+    fn test_sudden_regression() {
+        let store = BaselineStore::in_memory(BaselineConfig::default());
+        let device = test_device(0);
+
+        for i in 0..20 {
+            let value = 10.0 + (i % 3) as f64 * 0.1;
+            assert!(store
+                .record(&device, "l2.kernel_ms", value, false)
+                .is_none());
+        }
+
+        let regression = store.record(&device, "l2.kernel_ms", 30.0, false).unwrap();
+        assert!(matches!(regression.kind, RegressionKind::Sudden { .. }));
+        assert_eq!(regression.metric, "l2.kernel_ms");
+
+        // Faster than usual is never a regression for a latency metric
+        assert!(store.record(&device, "l2.kernel_ms", 2.0, false).is_none());
+    }
+
+    #[test]
+    fn test_bandwidth_regression() {
+        let store = BaselineStore::in_memory(BaselineConfig::default());
+        let device = test_device(0);
+
+        for _ in 0..20 {
+            store.record(&device, "l3.h2d_gbps", 24.0, true);
+        }
+
+        assert!(store.record(&device, "l3.h2d_gbps", 26.0, true).is_none());
+        assert!(store.record(&device, "l3.h2d_gbps", 6.0, true).is_some());
+    }
+
+    #[test]
+    fn test_slow_drift_detected() {
+        let config = BaselineConfig::default();
+        let store = BaselineStore::in_memory(config.clone());
+        let device = test_device(0);
+
+        for _ in 0..config.min_samples {
+            store.record(&device, "l2.kernel_ms", 10.0, false);
+        }
+
+        // Creep upwards slowly enough that no single sample is an outlier
+        let mut value = 10.0;
+        let mut drift = None;
+        for _ in 0..500 {
+            value *= 1.01;
+            if let Some(r) = store.record(&device, "l2.kernel_ms", value, false) {
+                drift = Some(r);
+                break;
+            }
+        }
+
+        let drift = drift.expect("drift should eventually be reported");
+        assert!(matches!(drift.kind, RegressionKind::Drift { ratio } if ratio >= 2.0));
+
+        // Reported once: the reference follows the new level
+        let reference = store.get(&device, "l2.kernel_ms").unwrap().reference;
+        assert!(reference >= 20.0);
+        for _ in 0..50 {
+            assert!(store
+                .record(&device, "l2.kernel_ms", value, false)
+                .is_none());
+        }
+    }
+
+    #[test]
+    fn test_quantiles() {
+        let store = BaselineStore::in_memory(BaselineConfig::default());
+        let device = test_device(0);
+
+        for i in 1..=100 {
+            store.record(&device, "l2.total_ms", i as f64, false);
+        }
+
+        // Window holds the last 64 samples: 37..=100
+        let baseline = store.get(&device, "l2.total_ms").unwrap();
+        assert_eq!(baseline.count, 100);
+        assert_eq!(baseline.p50, 68.0);
+        assert_eq!(baseline.p99, 100.0);
+    }
+
+    #[test]
+    fn test_devices_isolated() {
+        let store = BaselineStore::in_memory(BaselineConfig::default());
+        store.record(&test_device(0), "l2.total_ms", 10.0, false);
+        store.record(&test_device(1), "l2.total_ms", 20.0, false);
+
+        assert_eq!(store.len(), 2);
+        assert_eq!(
+            store.get(&test_device(0), "l2.total_ms").unwrap().ewma,
+            10.0
+        );
+        assert_eq!(
+            store.get(&test_device(1), "l2.total_ms").unwrap().ewma,
+            20.0
+        );
+    }
+
+    #[test]
+    fn test_survives_reopen() {
+        let path = temp_path("reopen");
+        let _ = std::fs::remove_file(&path);
+        let device = test_device(0);
+
+        {
+            let store = BaselineStore::open(&path, BaselineConfig::default()).unwrap();
+            for _ in 0..15 {
+                store.record(&device, "l2.kernel_ms", 10.0, false);
+            }
+        }
+
+        let store = BaselineStore::open(&path, BaselineConfig::default()).unwrap();
+        let baseline = store.get(&device, "l2.kernel_ms").unwrap();
+        assert_eq!(baseline.count, 15);
+        assert_eq!(baseline.reference, 10.0);
+        assert!(store.record(&device, "l2.kernel_ms", 40.0, false).is_some());
+
+        drop(store);
+        let _ = std::fs::remove_file(&path);
+    }
+
+    #[test]
+    fn test_replaced_device_starts_fresh() {
+        let store = BaselineStore::in_memory(BaselineConfig::default());
+        let device = test_device(0);
+        store.record(&device, "l2.total_ms", 10.0, false);
+
+        let replacement = DeviceId {
+            uuid: Some("GPU-BASELINE-REPLACED".to_string()),
+            ..device.clone()
+        };
+        assert!(store.get(&replacement, "l2.total_ms").is_none());
+        store.record(&replacement, "l2.total_ms", 20.0, false);
+        assert_eq!(store.get(&replacement, "l2.total_ms").unwrap().ewma, 20.0);
+        assert_eq!(store.get(&device, "l2.total_ms").unwrap().ewma, 10.0);
+
+        let unnamed = DeviceId {
+            uuid: None,
+            ..device
+        };
+        store.record(&unnamed, "l2.total_ms", 30.0, false);
+        assert_eq!(store.get(&unnamed, "l2.total_ms").unwrap().ewma, 30.0);
+        assert_eq!(store.len(), 3);
+    }
+
+    #[test]
+    fn test_resize_carries_records_over() {
+        let path = temp_path("resize");
+        let _ = std::fs::remove_file(&path);
+        let config = BaselineConfig::default();
+
+        {
+            let store = BaselineStore::open_with_capacity(&path, 4, config.clone()).unwrap();
+            for index in 0..3 {
+                store.record(&test_device(index), "l2.total_ms", index as f64, false);
+            }
+        }
+
+        // Growing keeps every record
+        {
+            let store = BaselineStore::open_with_capacity(&path, 8, config.clone()).unwrap();
+            assert_eq!(store.len(), 3);
+            assert_eq!(store.get(&test_device(2), "l2.total_ms").unwrap().ewma, 2.0);
+        }
+
+        // Shrinking keeps as many as fit
+        let store = BaselineStore::open_with_capacity(&path, 2, config).unwrap();
+        assert_eq!(store.len(), 2);
+        let kept = (0..3)
+            .filter(|&index| store.get(&test_device(index), "l2.total_ms").is_some())
+            .count();
+        assert_eq!(kept, 2);
+
+        drop(store);
+        let _ = std::fs::remove_file(&path);
+    }
+
+    #[test]
+    fn test_eviction_when_full() {
+        let path = temp_path("evict");
+        let _ = std::fs::remove_file(&path);
+        let store = BaselineStore::open_with_capacity(&path, 2, BaselineConfig::default()).unwrap();
+
+        store.record(&test_device(0), "a", 1.0, false);
+        store.record(&test_device(1), "a", 1.0, false);
+        store.record(&test_device(2), "a", 1.0, false);
+
+        assert_eq!(store.len(), 2);
+        assert!(store.get(&test_device(2), "a").is_some());
+
+        drop(store);
+        let _ = std::fs::remove_file(&path);
+    }
+}
@@ -5,19 +5,39 @@
 //! - XID error scanning (from dmesg)
 //! - Zombie process detection (D state processes)
 //! - ECC error monitoring
+//!
+//! Metrics samples can also feed a [`WorkloadTracker`] used to gate L2 probes,
+//! and are exported to Prometheus when a [`MetricsRegistry`] is attached.
+//!
+//! With an [`InventoryCache`], devices that disappear from the inventory are
+//! reported as fallen off the bus before anything else is queried.
 
 use std::sync::Arc;
 
+use futures::stream::{self, Stream, StreamExt};
+use tokio::sync::mpsc;
 use tracing::{debug, trace, warn};
 
-use super::{DetectionLevel, DetectionResult, Finding, FindingType};
-use crate::device::{DeviceError, DeviceId, DeviceInterface};
+use super::{
+    DetectionLevel, DetectionResult, Finding, FindingType, SweepItem, WorkloadTracker,
+    DEFAULT_CONCURRENCY,
+};
+use crate::device::{
+    DeviceError, DeviceEvent, DeviceId, DeviceInterface, InventoryCache, ProbeMeasurement,
+    XidError,
+};
+use crate::metrics::MetricsRegistry;
+use crate::overhead;
 
 /// L1 Passive Detector
 pub struct L1PassiveDetector {
     device: Arc<dyn DeviceInterface>,
     temperature_threshold: u32,
     fatal_xids: Vec<u32>,
+    workload: Option<Arc<WorkloadTracker>>,
+    inventory: Option<Arc<InventoryCache>>,
+    telemetry: Option<Arc<MetricsRegistry>>,
+    concurrency: usize,
 }
 
 impl L1PassiveDetector {
@@ -31,12 +51,106 @@ impl L1PassiveDetector {
             device,
             temperature_threshold,
             fatal_xids,
+            workload: None,
+            inventory: None,
+            telemetry: None,
+            concurrency: DEFAULT_CONCURRENCY,
+        }
+    }
+
+    /// Set the maximum number of devices checked concurrently
+    pub fn with_concurrency(mut self, concurrency: usize) -> Self {
+        self.concurrency = concurrency.max(1);
+        self
+    }
+
+    /// Maximum number of devices checked concurrently
+    pub fn concurrency(&self) -> usize {
+        self.concurrency
+    }
+
+    /// Feed utilization samples into a workload tracker
+    pub fn with_workload(mut self, workload: Arc<WorkloadTracker>) -> Self {
+        self.workload = Some(workload);
+        self
+    }
+
+    /// Export the device telemetry collected by each check
+    pub fn with_metrics(mut self, metrics: Arc<MetricsRegistry>) -> Self {
+        self.telemetry = Some(metrics);
+        self
+    }
+
+    /// Report devices missing from a cached inventory as fallen off the bus
+    ///
+    /// The inventory should wrap the same device interface.
+    pub fn with_inventory(mut self, inventory: Arc<InventoryCache>) -> Self {
+        self.inventory = Some(inventory);
+        self
+    }
+
+    /// List the devices this detector checks
+    pub async fn list_devices(&self) -> Result<Vec<DeviceId>, DeviceError> {
+        self.device.list_devices().await
+    }
+
+    /// Subscribe to driver error events, if the device provides them
+    pub async fn subscribe_events(&self) -> Option<mpsc::Receiver<DeviceEvent>> {
+        self.device.subscribe_events().await
+    }
+
+    /// Turn a driver event into a detection result for its device
+    pub fn event_result(&self, device: DeviceId, event: &DeviceEvent) -> DetectionResult {
+        let finding = match event {
+            DeviceEvent::Xid(xid) => self.xid_finding(&device, xid),
+            DeviceEvent::DoubleBitEcc { .. } => {
+                warn!(device = %device, "Double-bit ECC error event");
+                Finding::double_bit_ecc(1)
+            }
+        };
+        DetectionResult::fail(device, DetectionLevel::L1Passive, vec![finding])
+    }
+
+    /// Classify an XID error against the fatal list
+    fn xid_finding(&self, device: &DeviceId, xid: &XidError) -> Finding {
+        if xid.is_fatal(&self.fatal_xids) {
+            warn!(
+                device = %device,
+                xid = xid.code,
+                message = %xid.message,
+                "Fatal XID error detected"
+            );
+            Finding::fatal_xid(xid.code, &xid.message)
+        } else {
+            debug!(
+                device = %device,
+                xid = xid.code,
+                "Non-fatal XID error"
+            );
+            Finding::new(
+                FindingType::NonFatalXid(xid.code),
+                xid.message.clone(),
+                false,
+            )
         }
     }
 
     /// Run passive detection on a single device
     pub async fn detect(&self, device: &DeviceId) -> Result<DetectionResult, DeviceError> {
         let mut findings = Vec::new();
+        let mut measurements = Vec::new();
+
+        // 0. A device that is no longer enumerated cannot answer queries
+        if let Some(ref inventory) = self.inventory {
+            if !inventory.is_present(device).await {
+                warn!(device = %device, "Device has fallen off the bus");
+                return Ok(DetectionResult::fail(
+                    device.clone(),
+                    DetectionLevel::L1Passive,
+                    vec![Finding::fallen_off_bus(device)],
+                ));
+            }
+        }
 
         // 1. Check metrics (temperature, ECC errors)
         match self.device.get_metrics(device).await {
@@ -48,6 +162,16 @@ impl L1PassiveDetector {
                     mem_util = metrics.memory_utilization,
                     "Device metrics"
                 );
+                measurements.push(ProbeMeasurement::new(
+                    "temperature_c",
+                    metrics.temperature as f64,
+                ));
+                if let Some(ref workload) = self.workload {
+                    workload.observe(device, &metrics);
+                }
+                if let Some(ref telemetry) = self.telemetry {
+                    telemetry.observe_device_metrics(device, &metrics);
+                }
 
                 // Check temperature
                 if metrics.temperature > self.temperature_threshold {
@@ -83,26 +207,7 @@ impl L1PassiveDetector {
         match self.device.get_xid_errors(device).await {
             Ok(xid_errors) => {
                 for xid in xid_errors {
-                    if xid.is_fatal(&self.fatal_xids) {
-                        warn!(
-                            device = %device,
-                            xid = xid.code,
-                            message = %xid.message,
-                            "Fatal XID error detected"
-                        );
-                        findings.push(Finding::fatal_xid(xid.code, &xid.message));
-                    } else {
-                        debug!(
-                            device = %device,
-                            xid = xid.code,
-                            "Non-fatal XID error"
-                        );
-                        findings.push(Finding::new(
-                            FindingType::NonFatalXid(xid.code),
-                            xid.message.clone(),
-                            false,
-                        ));
-                    }
+                    findings.push(self.xid_finding(device, &xid));
                 }
             }
             Err(e) => {
@@ -124,26 +229,39 @@ impl L1PassiveDetector {
         }
 
         // Determine overall result
-        if findings.is_empty() {
-            Ok(DetectionResult::pass(device.clone(), DetectionLevel::L1Passive))
+        let result = if findings.is_empty() {
+            DetectionResult::pass(device.clone(), DetectionLevel::L1Passive)
         } else {
-            Ok(DetectionResult::fail(
-                device.clone(),
-                DetectionLevel::L1Passive,
-                findings,
-            ))
-        }
+            DetectionResult::fail(device.clone(), DetectionLevel::L1Passive, findings)
+        };
+        Ok(result.with_measurements(measurements))
     }
 
-    /// Run detection on all devices
-    pub async fn detect_all(&self) -> Result<Vec<DetectionResult>, DeviceError> {
+    /// Start a concurrent sweep over all devices
+    ///
+    /// Up to `concurrency` devices are checked at once; results are yielded
+    /// as they complete.
+    pub async fn sweep(&self) -> Result<impl Stream<Item = SweepItem> + '_, DeviceError> {
         let devices = self.device.list_devices().await?;
-        let mut results = Vec::with_capacity(devices.len());
+        Ok(stream::iter(devices)
+            .map(move |device| async move {
+                let (result, usage) = overhead::measure(self.detect(&device)).await;
+                (device, result, usage)
+            })
+            .buffer_unordered(self.concurrency.max(1)))
+    }
 
-        for device in &devices {
-            let result = self.detect(device).await?;
-            results.push(result);
-        }
+    /// Run detection on all devices
+    pub async fn detect_all(&self) -> Result<Vec<DetectionResult>, DeviceError> {
+        let mut results = self
+            .sweep()
+            .await?
+            .map(|(_, result, _)| result)
+            .collect::<Vec<_>>()
+            .await
+            .into_iter()
+            .collect::<Result<Vec<_>, _>>()?;
+        results.sort_by_key(|r| r.device.index);
 
         Ok(results)
     }
@@ -210,4 +328,26 @@ mod tests {
             .iter()
             .any(|f| matches!(f.finding_type, FindingType::ZombieProcess)));
     }
+
+    #[tokio::test]
+    async fn test_l1_detect_fallen_off_bus() {
+        let mock = Arc::new(MockDevice::with_device_count(4));
+        let inventory = Arc::new(InventoryCache::new(mock.clone(), Vec::new()));
+        let detector = L1PassiveDetector::new(inventory.clone(), 85, vec![31, 43, 48, 79])
+            .with_inventory(inventory.clone());
+
+        let devices = detector.list_devices().await.unwrap();
+        mock.detach_device(3).await;
+        inventory.invalidate();
+
+        let result = detector.detect(&devices[3]).await.unwrap();
+        assert!(result.has_fatal_finding());
+        assert_eq!(result.findings[0].finding_type, FindingType::FallenOffBus);
+        assert!(detector.detect(&devices[0]).await.unwrap().passed);
+
+        // The lost device stays in the sweep
+        let results = detector.detect_all().await.unwrap();
+        assert_eq!(results.len(), 4);
+        assert!(!results[3].passed);
+    }
 }
@@ -10,10 +10,21 @@
 
 use std::sync::Arc;
 
+use futures::stream::{self, Stream, StreamExt};
 use tracing::{debug, info, warn};
 
-use super::{DetectionLevel, DetectionResult, Finding, FindingType};
+use super::{
+    probe_measurements, record_baseline, DetectionLevel, DetectionResult, Finding, FindingType,
+    SweepItem,
+};
+use crate::baseline::BaselineStore;
 use crate::device::{DeviceError, DeviceId, DeviceInterface};
+use crate::overhead;
+
+/// Bandwidth tests run one device at a time by default: concurrent tests
+/// share the host's PCIe root complexes and memory bandwidth, so they would
+/// measure each other rather than the link
+pub const DEFAULT_L3_CONCURRENCY: usize = 1;
 
 /// L3 PCIe bandwidth test configuration
 #[derive(Debug, Clone)]
@@ -40,6 +51,8 @@ impl Default for L3PcieConfig {
 pub struct L3PcieDetector {
     device: Arc<dyn DeviceInterface>,
     config: L3PcieConfig,
+    baseline: Option<Arc<BaselineStore>>,
+    concurrency: usize,
 }
 
 impl L3PcieDetector {
@@ -48,12 +61,36 @@ impl L3PcieDetector {
         Self {
             device,
             config: L3PcieConfig::default(),
+            baseline: None,
+            concurrency: DEFAULT_L3_CONCURRENCY,
         }
     }
 
     /// Create a new L3 PCIe detector with custom config
     pub fn with_config(device: Arc<dyn DeviceInterface>, config: L3PcieConfig) -> Self {
-        Self { device, config }
+        Self {
+            device,
+            config,
+            baseline: None,
+            concurrency: DEFAULT_L3_CONCURRENCY,
+        }
+    }
+
+    /// Set the maximum number of devices checked concurrently
+    pub fn with_concurrency(mut self, concurrency: usize) -> Self {
+        self.concurrency = concurrency.max(1);
+        self
+    }
+
+    /// Maximum number of devices checked concurrently
+    pub fn concurrency(&self) -> usize {
+        self.concurrency
+    }
+
+    /// Track bandwidth figures against a per-device performance baseline
+    pub fn with_baseline(mut self, baseline: Arc<BaselineStore>) -> Self {
+        self.baseline = Some(baseline);
+        self
     }
 
     /// Check if PCIe testing is supported
@@ -61,6 +98,11 @@ impl L3PcieDetector {
         self.device.supports_pcie_test()
     }
 
+    /// Whether every device would be skipped (unsupported and skip enabled)
+    pub fn skips_all(&self) -> bool {
+        !self.is_supported() && self.config.skip_if_unsupported
+    }
+
     /// Run PCIe bandwidth test on a single device
     pub async fn detect(&self, device: &DeviceId) -> Result<DetectionResult, DeviceError> {
         // Check if PCIe test is supported
@@ -94,7 +136,14 @@ impl L3PcieDetector {
                 duration = ?result.duration,
                 "L3 PCIe bandwidth test passed"
             );
-            Ok(DetectionResult::pass(device.clone(), DetectionLevel::L3Pcie))
+
+            let measurements = probe_measurements(&result);
+            let findings = self.baseline.as_ref().map_or_else(Vec::new, |store| {
+                record_baseline(store, device, DetectionLevel::L3Pcie, &measurements)
+            });
+            Ok(DetectionResult::pass(device.clone(), DetectionLevel::L3Pcie)
+                .with_advisories(findings)
+                .with_measurements(measurements))
         } else {
             let error_msg = result
                 .error
@@ -118,20 +167,37 @@ impl L3PcieDetector {
         }
     }
 
-    /// Run detection on all devices
-    pub async fn detect_all(&self) -> Result<Vec<DetectionResult>, DeviceError> {
-        if !self.is_supported() && self.config.skip_if_unsupported {
+    /// Start a concurrent sweep over all devices
+    ///
+    /// Up to `concurrency` devices are checked at once; results are yielded
+    /// as they complete.
+    pub async fn sweep(&self) -> Result<impl Stream<Item = SweepItem> + '_, DeviceError> {
+        let devices = if self.skips_all() {
             debug!("PCIe test not supported, skipping all devices");
-            return Ok(Vec::new());
-        }
+            Vec::new()
+        } else {
+            self.device.list_devices().await?
+        };
 
-        let devices = self.device.list_devices().await?;
-        let mut results = Vec::with_capacity(devices.len());
+        Ok(stream::iter(devices)
+            .map(move |device| async move {
+                let (result, usage) = overhead::measure(self.detect(&device)).await;
+                (device, result, usage)
+            })
+            .buffer_unordered(self.concurrency.max(1)))
+    }
 
-        for device in &devices {
-            let result = self.detect(device).await?;
-            results.push(result);
-        }
+    /// Run detection on all devices
+    pub async fn detect_all(&self) -> Result<Vec<DetectionResult>, DeviceError> {
+        let mut results = self
+            .sweep()
+            .await?
+            .map(|(_, result, _)| result)
+            .collect::<Vec<_>>()
+            .await
+            .into_iter()
+            .collect::<Result<Vec<_>, _>>()?;
+        results.sort_by_key(|r| r.device.index);
 
         Ok(results)
     }
@@ -148,6 +214,8 @@ mod tests {
         let detector = L3PcieDetector::new(mock);
 
         assert!(detector.is_supported());
+        // Bandwidth tests are serialized unless configured otherwise
+        assert_eq!(detector.concurrency(), 1);
     }
 
     #[tokio::test]
@@ -4,18 +4,40 @@
 //! - L1: Passive detection (NVML queries, XID scans)
 //! - L2: Active micro-detection (CUDA matrix multiply)
 //! - L3: PCIe bandwidth testing (optional)
+//!
+//! Sweeps can additionally be cross-checked against peer devices on the
+//! same node (see [`PeerAnalyzer`]), and L2 probes can be gated on device
+//! load (see [`WorkloadTracker`]).
 
 mod l1_passive;
 mod l2_active;
 mod l3_pcie;
+mod peer;
+mod workload;
 
 pub use l1_passive::L1PassiveDetector;
-pub use l2_active::L2ActiveDetector;
-pub use l3_pcie::{L3PcieConfig, L3PcieDetector};
+pub use l2_active::{AdaptiveTimeoutConfig, L2ActiveDetector};
+pub use l3_pcie::{L3PcieConfig, L3PcieDetector, DEFAULT_L3_CONCURRENCY};
+pub use peer::{PeerAnalysisConfig, PeerAnalyzer};
+pub use workload::{ProbeDecision, SkipReason, WorkloadConfig, WorkloadTracker};
+
+use std::collections::HashMap;
+use std::sync::RwLock;
 
+use once_cell::sync::Lazy;
 use serde::{Deserialize, Serialize};
+use tracing::warn;
+
+/// Default number of devices a detector checks concurrently
+pub const DEFAULT_CONCURRENCY: usize = 8;
 
-use crate::device::DeviceId;
+/// A single device's outcome within a concurrent sweep, with what its
+/// check cost
+pub type SweepItem = (DeviceId, Result<DetectionResult, DeviceError>, CheckUsage);
+
+use crate::baseline::{BaselineStore, Regression};
+use crate::device::{CheckResult, DeviceError, DeviceId, ProbeMeasurement};
+use crate::overhead::CheckUsage;
 
 /// Result from a detection check
 #[derive(Debug, Clone, Serialize, Deserialize)]
@@ -26,8 +48,11 @@ pub struct DetectionResult {
     pub level: DetectionLevel,
     /// Whether the check passed
     pub passed: bool,
-    /// Detailed findings
+    /// Detailed findings; on a passing result they are advisory only
     pub findings: Vec<Finding>,
+    /// Values observed during the check (temperature, probe timings, bandwidth)
+    #[serde(default)]
+    pub measurements: Vec<ProbeMeasurement>,
 }
 
 impl DetectionResult {
@@ -38,6 +63,7 @@ impl DetectionResult {
             level,
             passed: true,
             findings: Vec::new(),
+            measurements: Vec::new(),
         }
     }
 
@@ -48,17 +74,113 @@ impl DetectionResult {
             level,
             passed: false,
             findings,
+            measurements: Vec::new(),
         }
     }
 
+    /// Attach advisory findings
+    ///
+    /// On a passing result they are logged and exported but never count
+    /// toward isolation.
+    pub fn with_advisories(mut self, findings: Vec<Finding>) -> Self {
+        self.findings.extend(findings);
+        self
+    }
+
+    /// Attach observed values
+    pub fn with_measurements(mut self, measurements: Vec<ProbeMeasurement>) -> Self {
+        self.measurements = measurements;
+        self
+    }
+
     /// Check if any finding is fatal
     pub fn has_fatal_finding(&self) -> bool {
         self.findings.iter().any(|f| f.is_fatal)
     }
 }
 
+/// Collect the measurements of a passing probe
+///
+/// The probe's wall-clock duration is reported as "total_ms" and replaces
+/// any total the probe printed itself.
+pub(crate) fn probe_measurements(result: &CheckResult) -> Vec<ProbeMeasurement> {
+    let mut measurements = Vec::with_capacity(result.measurements.len() + 1);
+    measurements.push(ProbeMeasurement::new(
+        "total_ms",
+        result.duration.as_secs_f64() * 1000.0,
+    ));
+    measurements.extend(
+        result
+            .measurements
+            .iter()
+            .filter(|m| m.name != "total_ms")
+            .cloned(),
+    );
+    measurements
+}
+
+/// Fold probe measurements into the device baseline
+///
+/// Metrics are namespaced by detection level (e.g. "l2.kernel_ms").
+/// Regressions come back as advisory findings: a probe that completed is
+/// slower, not broken.
+pub(crate) fn record_baseline(
+    store: &BaselineStore,
+    device: &DeviceId,
+    level: DetectionLevel,
+    measurements: &[ProbeMeasurement],
+) -> Vec<Finding> {
+    measurements
+        .iter()
+        .filter_map(|m| {
+            let metric = metric_name(level, &m.name)?;
+            store.record(device, metric, m.value, m.higher_is_better())
+        })
+        .map(|r| Finding::performance_regression(&r))
+        .collect()
+}
+
+/// Distinct metric names kept per level before new ones are dropped
+const MAX_METRIC_NAMES: usize = 256;
+
+/// Interned metric names, by level and probe-reported name
+static METRIC_NAMES: Lazy<RwLock<HashMap<DetectionLevel, HashMap<Box<str>, &'static str>>>> =
+    Lazy::new(|| RwLock::new(HashMap::new()));
+
+/// Level-qualified metric name (e.g. "l2.kernel_ms"), interned
+///
+/// Probes report a small fixed set of metrics, so each name is allocated
+/// once and can key per-check state without allocating. Returns `None` for
+/// new names once a level has `MAX_METRIC_NAMES` of them.
+pub(crate) fn metric_name(level: DetectionLevel, name: &str) -> Option<&'static str> {
+    {
+        let names = METRIC_NAMES.read().unwrap_or_else(|e| e.into_inner());
+        if let Some(&interned) = names.get(&level).and_then(|names| names.get(name)) {
+            return Some(interned);
+        }
+    }
+
+    let mut names = METRIC_NAMES.write().unwrap_or_else(|e| e.into_inner());
+    let names = names.entry(level).or_default();
+    if let Some(&interned) = names.get(name) {
+        return Some(interned);
+    }
+    if names.len() >= MAX_METRIC_NAMES {
+        warn!(level = %level, metric = name, "Too many distinct probe metrics, ignoring");
+        return None;
+    }
+    let prefix = match level {
+        DetectionLevel::L1Passive => "l1",
+        DetectionLevel::L2Active => "l2",
+        DetectionLevel::L3Pcie => "l3",
+    };
+    let interned: &'static str = Box::leak(format!("{}.{}", prefix, name).into_boxed_str());
+    names.insert(name.into(), interned);
+    Some(interned)
+}
+
 /// Detection level
-#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash, Serialize, Deserialize)]
 pub enum DetectionLevel {
     /// L1: Passive detection
     L1Passive,
@@ -135,6 +257,27 @@ impl Finding {
         }
     }
 
+    /// Create a performance regression finding (non-fatal)
+    pub fn performance_regression(regression: &Regression) -> Self {
+        Self {
+            finding_type: FindingType::PerformanceRegression,
+            message: regression.to_string(),
+            is_fatal: false,
+        }
+    }
+
+    /// Create a peer outlier finding (non-fatal)
+    pub fn peer_outlier(metric: &str, value: f64, median: f64, peers: usize, z_score: f64) -> Self {
+        Self {
+            finding_type: FindingType::PeerOutlier,
+            message: format!(
+                "{} {:.3} is an outlier against {} peers (median {:.3}, robust z={:.1})",
+                metric, value, peers, median, z_score
+            ),
+            is_fatal: false,
+        }
+    }
+
     /// Create a double-bit ECC error finding
     pub fn double_bit_ecc(count: u64) -> Self {
         Self {
@@ -143,6 +286,19 @@ impl Finding {
             is_fatal: true,
         }
     }
+
+    /// Create a finding for a device that is no longer enumerated
+    pub fn fallen_off_bus(device: &DeviceId) -> Self {
+        Self {
+            finding_type: FindingType::FallenOffBus,
+            message: format!(
+                "Device {} ({}) has fallen off the bus",
+                device,
+                device.uuid.as_deref().unwrap_or("no UUID")
+            ),
+            is_fatal: true,
+        }
+    }
 }
 
 /// Types of findings
@@ -164,4 +320,10 @@ pub enum FindingType {
     DoubleBitEcc,
     /// PCIe degradation
     PcieDegradation,
+    /// Probe performance regressed against the device's own baseline
+    PerformanceRegression,
+    /// Device lags behind identical peers on the same node
+    PeerOutlier,
+    /// Device disappeared from the device inventory
+    FallenOffBus,
 }
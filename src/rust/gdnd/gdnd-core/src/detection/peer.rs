@@ -0,0 +1,479 @@
+//! Peer-relative Outlier Detection
+//!
+//! Identical devices on one node should report near-identical probe
+//! timings and bandwidth. After each sweep, every device's measurements are
+//! compared against the node median for the same model using a robust
+//! z-score (median / MAD), and laggards get an advisory `PeerOutlier`
+//! finding: it is logged and exported, but the check still passes and the
+//! device's health state is left alone.
+//!
+//! In synchronous data-parallel training one slow device throttles all of
+//! them, so a device that is merely "slower than its siblings" matters even
+//! when it passes every absolute threshold.
+//!
+//! Only measurements that reflect the device itself are compared. Metrics
+//! that follow the workload (temperature) are skipped, which leaves L1 with
+//! nothing to compare, so only L2 and L3 results are analyzed. With a
+//! workload tracker attached, devices under load are left out entirely: a
+//! probe sharing the device with a job is slow because of the job.
+
+use std::collections::HashMap;
+use std::sync::{Arc, Mutex};
+
+use tracing::warn;
+
+use super::{metric_name, DetectionLevel, DetectionResult, Finding, WorkloadTracker};
+use crate::device::{DeviceId, ProbeMeasurement};
+
+/// Scale factor making MAD a consistent estimator of the standard deviation
+const MAD_SCALE: f64 = 1.4826;
+
+/// Measurements driven by the workload rather than the device
+const LOAD_DEPENDENT_METRICS: &[&str] = &["temperature_c"];
+
+/// Peer analysis configuration
+#[derive(Debug, Clone)]
+pub struct PeerAnalysisConfig {
+    /// Minimum number of identical devices needed for a comparison
+    pub min_peers: usize,
+    /// Robust z-score above which a device is an outlier
+    pub z_threshold: f64,
+    /// Minimum relative deviation from the median (0.2 = 20%)
+    pub min_deviation: f64,
+    /// GPU or memory utilization (%) at or above which a device is too
+    /// loaded to compare
+    pub busy_utilization: u32,
+}
+
+impl Default for PeerAnalysisConfig {
+    fn default() -> Self {
+        Self {
+            min_peers: 4,
+            z_threshold: 3.5,
+            min_deviation: 0.2,
+            busy_utilization: 10,
+        }
+    }
+}
+
+/// Compares devices of the same model against each other
+pub struct PeerAnalyzer {
+    config: PeerAnalysisConfig,
+    workload: Option<Arc<WorkloadTracker>>,
+    /// Latest value per (device index, level-qualified metric)
+    latest: Mutex<HashMap<(u32, &'static str), Sample>>,
+}
+
+/// Latest compared value of one device metric
+struct Sample {
+    /// Device model, peers must match it
+    model: String,
+    value: f64,
+}
+
+impl PeerAnalyzer {
+    /// Create a new peer analyzer
+    pub fn new(config: PeerAnalysisConfig) -> Self {
+        Self {
+            config,
+            workload: None,
+            latest: Mutex::new(HashMap::new()),
+        }
+    }
+
+    /// Leave devices under load out of the comparison
+    pub fn with_workload(mut self, workload: Arc<WorkloadTracker>) -> Self {
+        self.workload = Some(workload);
+        self
+    }
+
+    /// Get the analyzer configuration
+    pub fn config(&self) -> &PeerAnalysisConfig {
+        &self.config
+    }
+
+    /// Whether a device is under too much load to compare
+    fn is_loaded(&self, device: &DeviceId) -> bool {
+        self.workload.as_ref().is_some_and(|w| {
+            w.utilization(device)
+                .is_some_and(|u| u >= self.config.busy_utilization)
+        })
+    }
+
+    /// Flag peer outliers within a sweep
+    ///
+    /// Passing outliers get an advisory `PeerOutlier` finding; `passed` is
+    /// never changed. Returns the number of devices flagged.
+    pub fn analyze(&self, results: &mut [DetectionResult]) -> usize {
+        // (model, metric) -> [(result index, value, higher_is_better)]
+        let mut groups: HashMap<(&str, &str), Vec<(usize, f64, bool)>> = HashMap::new();
+        for (i, result) in results.iter().enumerate() {
+            if !self.covers(result.level) || self.is_loaded(&result.device) {
+                continue;
+            }
+            for m in result.measurements.iter().filter(|m| compares(&m.name)) {
+                groups
+                    .entry((result.device.name.as_str(), m.name.as_str()))
+                    .or_default()
+                    .push((i, m.value, m.higher_is_better()));
+            }
+        }
+
+        let mut findings: Vec<(usize, Finding)> = Vec::new();
+        for ((_, metric), samples) in &groups {
+            let values: Vec<f64> = samples.iter().map(|&(_, v, _)| v).collect();
+            for &(index, value, higher_is_better) in samples {
+                if !results[index].passed {
+                    continue;
+                }
+                if let Some(finding) = self.evaluate(metric, value, higher_is_better, &values) {
+                    warn!(
+                        device = %results[index].device,
+                        level = %results[index].level,
+                        message = %finding.message,
+                        "Device is an outlier against its peers"
+                    );
+                    findings.push((index, finding));
+                }
+            }
+        }
+
+        let mut flagged = vec![false; results.len()];
+        for (index, finding) in findings {
+            results[index].findings.push(finding);
+            flagged[index] = true;
+        }
+        flagged.into_iter().filter(|&f| f).count()
+    }
+
+    /// Whether results of a detection level are compared
+    ///
+    /// L1 only measures temperature, which follows the workload.
+    pub fn covers(&self, level: DetectionLevel) -> bool {
+        level != DetectionLevel::L1Passive
+    }
+
+    /// Record a result and compare it against the latest values of its peers
+    ///
+    /// Only the compared measurement values are kept, per device and metric,
+    /// so a check costs one pass over the latest samples. Only a passing
+    /// `result` is flagged, with an advisory finding. A device under load is
+    /// neither compared nor used as a peer until it is idle again. Returns
+    /// whether the device is an outlier.
+    pub fn compare_latest(&self, result: &mut DetectionResult) -> bool {
+        if !self.covers(result.level) {
+            return false;
+        }
+
+        let device = &result.device;
+        let groups: Vec<(&ProbeMeasurement, Vec<f64>)> = {
+            let mut latest = self.latest.lock().unwrap_or_else(|e| e.into_inner());
+            if self.is_loaded(device) {
+                latest.retain(|&(index, _), _| index != device.index);
+                return false;
+            }
+
+            result
+                .measurements
+                .iter()
+                .filter(|m| compares(&m.name))
+                .filter_map(|m| {
+                    let metric = metric_name(result.level, &m.name)?;
+                    match latest.get_mut(&(device.index, metric)) {
+                        Some(sample) if sample.model == device.name => sample.value = m.value,
+                        _ => {
+                            let sample = Sample {
+                                model: device.name.clone(),
+                                value: m.value,
+                            };
+                            latest.insert((device.index, metric), sample);
+                        }
+                    }
+                    let values = latest
+                        .iter()
+                        .filter(|(&(_, peer_metric), peer)| {
+                            peer_metric == metric && peer.model == device.name
+                        })
+                        .map(|(_, peer)| peer.value)
+                        .collect();
+                    Some((m, values))
+                })
+                .collect()
+        };
+        if !result.passed {
+            return false;
+        }
+
+        let mut findings = Vec::new();
+        for (m, values) in groups {
+            if let Some(finding) = self.evaluate(&m.name, m.value, m.higher_is_better(), &values) {
+                warn!(
+                    device = %result.device,
+                    level = %result.level,
+                    message = %finding.message,
+                    "Device is an outlier against its peers"
+                );
+                findings.push(finding);
+            }
+        }
+
+        if findings.is_empty() {
+            return false;
+        }
+        result.findings.extend(findings);
+        true
+    }
+
+    /// Forget the latest values of devices that are no longer listed
+    pub fn retain_devices(&self, devices: &[DeviceId]) {
+        let mut latest = self.latest.lock().unwrap_or_else(|e| e.into_inner());
+        latest.retain(|&(index, _), _| devices.iter().any(|d| d.index == index));
+    }
+
+    /// Evaluate one value against the values of its group (itself included)
+    fn evaluate(
+        &self,
+        metric: &str,
+        value: f64,
+        higher_is_better: bool,
+        values: &[f64],
+    ) -> Option<Finding> {
+        if values.len() < self.config.min_peers.max(3) {
+            return None;
+        }
+
+        let center = median(values);
+        let deviations: Vec<f64> = values.iter().map(|v| (v - center).abs()).collect();
+        // Floor the spread so identical peers don't turn noise into outliers
+        let spread = (median(&deviations) * MAD_SCALE)
+            .max(center.abs() * self.config.min_deviation / self.config.z_threshold);
+        if spread <= 0.0 {
+            return None;
+        }
+
+        // Signed lag: positive means "worse than the peers"
+        let lag = if higher_is_better {
+            center - value
+        } else {
+            value - center
+        };
+        let z_score = lag / spread;
+
+        (z_score >= self.config.z_threshold && lag >= center.abs() * self.config.min_deviation)
+            .then(|| Finding::peer_outlier(metric, value, center, values.len() - 1, z_score))
+    }
+}
+
+impl Default for PeerAnalyzer {
+    fn default() -> Self {
+        Self::new(PeerAnalysisConfig::default())
+    }
+}
+
+/// Whether a measurement is compared across peers
+fn compares(metric: &str) -> bool {
+    !LOAD_DEPENDENT_METRICS.contains(&metric)
+}
+
+/// Median of an unsorted sample set
+fn median(values: &[f64]) -> f64 {
+    let mut sorted = values.to_vec();
+    sorted.sort_by(|a, b| a.total_cmp(b));
+    let mid = sorted.len() / 2;
+    if sorted.len() % 2 == 0 {
+        (sorted[mid - 1] + sorted[mid]) / 2.0
+    } else {
+        sorted[mid]
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::detection::FindingType;
+    use crate::device::{DeviceMetrics, EccErrors};
+    use chrono::Utc;
+
+    fn sweep(name: &str, metric: &str, values: &[f64]) -> Vec<DetectionResult> {
+        values
+            .iter()
+            .enumerate()
+            .map(|(i, &v)| {
+                let device = DeviceId {
+                    index: i as u32,
+                    uuid: Some(format!("GPU-PEER-{}", i)),
+                    name: name.to_string(),
+                };
+                DetectionResult::pass(device, DetectionLevel::L2Active)
+                    .with_measurements(vec![ProbeMeasurement::new(metric, v)])
+            })
+            .collect()
+    }
+
+    #[test]
+    fn test_slow_device_flagged() {
+        let analyzer = PeerAnalyzer::default();
+        let mut results = sweep(
+            "H100",
+            "kernel_ms",
+            &[4.0, 4.1, 3.9, 4.0, 4.2, 4.0, 9.5, 4.1],
+        );
+
+        assert_eq!(analyzer.analyze(&mut results), 1);
+        // Advisory only: the check still passes
+        assert!(results.iter().all(|r| r.passed));
+        assert!(!results[6].has_fatal_finding());
+        assert_eq!(
+            results[6].findings[0].finding_type,
+            FindingType::PeerOutlier
+        );
+        assert!(results
+            .iter()
+            .enumerate()
+            .all(|(i, r)| i == 6 || r.findings.is_empty()));
+    }
+
+    #[test]
+    fn test_fast_device_not_flagged() {
+        let analyzer = PeerAnalyzer::default();
+        let mut results = sweep("H100", "kernel_ms", &[4.0, 4.1, 3.9, 4.0, 1.0]);
+
+        assert_eq!(analyzer.analyze(&mut results), 0);
+    }
+
+    #[test]
+    fn test_low_bandwidth_flagged() {
+        let analyzer = PeerAnalyzer::default();
+        let mut results = sweep("910B", "h2d_gbps", &[24.0, 24.5, 23.8, 11.0, 24.1]);
+
+        assert_eq!(analyzer.analyze(&mut results), 1);
+        assert!(results[3].passed);
+        assert_eq!(results[3].findings.len(), 1);
+    }
+
+    #[test]
+    fn test_small_spread_tolerated() {
+        let analyzer = PeerAnalyzer::default();
+        // Identical peers plus one 10% slower: within min_deviation
+        let mut results = sweep("H100", "kernel_ms", &[4.0, 4.0, 4.0, 4.0, 4.4]);
+
+        assert_eq!(analyzer.analyze(&mut results), 0);
+    }
+
+    #[test]
+    fn test_too_few_peers() {
+        let analyzer = PeerAnalyzer::default();
+        let mut results = sweep("H100", "kernel_ms", &[4.0, 4.0, 40.0]);
+
+        assert_eq!(analyzer.analyze(&mut results), 0);
+    }
+
+    #[test]
+    fn test_models_compared_separately() {
+        let analyzer = PeerAnalyzer::default();
+        let mut results = sweep("A100", "kernel_ms", &[8.0, 8.1, 7.9, 8.0]);
+        results.extend(sweep("H100", "kernel_ms", &[4.0, 4.1, 3.9, 4.0]));
+
+        assert_eq!(analyzer.analyze(&mut results), 0);
+    }
+
+    #[test]
+    fn test_analyze_one_against_latest_peers() {
+        let analyzer = PeerAnalyzer::default();
+        let mut results = sweep("H100", "kernel_ms", &[4.0, 4.1, 3.9, 4.0, 9.5]);
+        let mut flagged: Vec<bool> = results
+            .iter_mut()
+            .map(|r| analyzer.compare_latest(r))
+            .collect();
+
+        // The slow device came last, once its peers were known
+        assert_eq!(flagged, [false, false, false, false, true]);
+        assert!(results[4].passed);
+        assert_eq!(
+            results[4].findings[0].finding_type,
+            FindingType::PeerOutlier
+        );
+
+        // Its next check replaces the old value instead of adding one
+        results[4].measurements[0].value = 4.1;
+        results[4].findings.clear();
+        flagged = results
+            .iter_mut()
+            .map(|r| analyzer.compare_latest(r))
+            .collect();
+        assert!(flagged.iter().all(|&f| !f));
+    }
+
+    #[test]
+    fn test_departed_devices_pruned() {
+        let analyzer = PeerAnalyzer::default();
+        let mut results = sweep("H100", "kernel_ms", &[4.0, 4.1, 3.9, 4.0, 9.5]);
+        for result in &mut results {
+            analyzer.compare_latest(result);
+        }
+        assert!(!results[4].findings.is_empty());
+
+        // Devices 2 and 3 left: too few peers remain to compare against
+        let listed: Vec<DeviceId> = [0, 1, 4]
+            .iter()
+            .map(|&i| results[i].device.clone())
+            .collect();
+        analyzer.retain_devices(&listed);
+        results[4].findings.clear();
+        assert!(!analyzer.compare_latest(&mut results[4]));
+    }
+
+    #[test]
+    fn test_l1_results_not_compared() {
+        let analyzer = PeerAnalyzer::default();
+        let mut results = sweep("H100", "kernel_ms", &[4.0, 4.1, 3.9, 4.0, 9.5]);
+        for result in &mut results {
+            result.level = DetectionLevel::L1Passive;
+        }
+
+        assert_eq!(analyzer.analyze(&mut results), 0);
+        assert!(results.iter_mut().all(|r| !analyzer.compare_latest(r)));
+    }
+
+    #[test]
+    fn test_load_dependent_metrics_skipped() {
+        let analyzer = PeerAnalyzer::default();
+        let mut results = sweep("H100", "temperature_c", &[45.0, 46.0, 44.0, 45.0, 80.0]);
+
+        assert_eq!(analyzer.analyze(&mut results), 0);
+    }
+
+    #[test]
+    fn test_loaded_devices_skipped() {
+        let workload = Arc::new(WorkloadTracker::default());
+        let analyzer = PeerAnalyzer::default().with_workload(Arc::clone(&workload));
+        let mut results = sweep("H100", "kernel_ms", &[4.0, 4.1, 3.9, 4.0, 9.5]);
+        let metrics = |gpu_utilization| DeviceMetrics {
+            temperature: 50,
+            memory_temperature: None,
+            gpu_utilization,
+            memory_utilization: 0,
+            power_usage: 300,
+            power_limit: 700,
+            memory_total: 80 << 30,
+            memory_used: 0,
+            memory_free: 80 << 30,
+            pcie_tx: None,
+            pcie_rx: None,
+            ecc_errors: EccErrors::default(),
+            timestamp: Utc::now(),
+        };
+        for result in &results {
+            workload.observe(&result.device, &metrics(0));
+        }
+
+        // The slow probe shared the device with a job
+        workload.observe(&results[4].device, &metrics(95));
+        assert_eq!(analyzer.analyze(&mut results), 0);
+        assert!(results.iter_mut().all(|r| !analyzer.compare_latest(r)));
+
+        // Once idle again it is compared as usual
+        workload.observe(&results[4].device, &metrics(0));
+        assert!(analyzer.compare_latest(&mut results[4]));
+    }
+}
@@ -0,0 +1,338 @@
+//! Workload-aware L2 Probe Gating
+//!
+//! A device running flat out is evidently alive, and that is exactly when
+//! an active probe costs running jobs the most and tells us the least. L1
+//! samples feed a per-device activity tracker which the scheduler consults
+//! before each L2 probe:
+//! - Busy devices have their probe skipped, up to a maximum deferral
+//! - Devices holding memory but showing no kernel activity for a long time
+//!   ("suspiciously silent") are probed early
+//!
+//! Ages are measured on tokio's clock, so deferrals play out on the virtual
+//! clock of a trace replay just as they would in the daemon.
+
+use std::collections::HashMap;
+use std::fmt;
+use std::sync::Mutex;
+use std::time::Duration;
+
+use tokio::time::Instant;
+
+use crate::device::{DeviceId, DeviceMetrics};
+
+/// Workload-aware probing configuration
+#[derive(Debug, Clone)]
+pub struct WorkloadConfig {
+    /// GPU utilization (%) at or above which a device counts as busy
+    pub busy_utilization: u32,
+    /// Memory controller utilization (%) at or above which a device counts as busy
+    pub busy_memory_utilization: u32,
+    /// Longest a busy device may go without an L2 probe
+    pub max_deferral: Duration,
+    /// Activity samples older than this are ignored
+    pub max_sample_age: Duration,
+    /// How long an allocated device may stay at 0% utilization before it is
+    /// probed early
+    pub silent_after: Duration,
+    /// Fraction of device memory in use for a device to count as allocated
+    pub allocated_memory_fraction: f64,
+}
+
+impl Default for WorkloadConfig {
+    fn default() -> Self {
+        Self {
+            busy_utilization: 90,
+            busy_memory_utilization: 90,
+            max_deferral: Duration::from_secs(600),
+            max_sample_age: Duration::from_secs(90),
+            silent_after: Duration::from_secs(600),
+            allocated_memory_fraction: 0.05,
+        }
+    }
+}
+
+/// Why an L2 probe was skipped
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum SkipReason {
+    /// GPU utilization above the busy threshold
+    ComputeBusy,
+    /// Memory controller utilization above the busy threshold
+    MemoryBusy,
+}
+
+impl SkipReason {
+    /// Metric label for this reason
+    pub fn as_str(&self) -> &'static str {
+        match self {
+            SkipReason::ComputeBusy => "compute_busy",
+            SkipReason::MemoryBusy => "memory_busy",
+        }
+    }
+}
+
+impl fmt::Display for SkipReason {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.write_str(self.as_str())
+    }
+}
+
+/// Whether to run a scheduled L2 probe
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum ProbeDecision {
+    /// Run the probe
+    Run,
+    /// Skip this probe
+    Skip(SkipReason),
+}
+
+/// Latest observed activity for one device
+#[derive(Debug, Clone)]
+struct Activity {
+    gpu_utilization: u32,
+    memory_utilization: u32,
+    sampled_at: Instant,
+    /// Start of the current allocated-but-idle stretch
+    silent_since: Option<Instant>,
+    last_probe: Option<Instant>,
+}
+
+/// Tracks per-device activity and gates L2 probes on it
+pub struct WorkloadTracker {
+    config: WorkloadConfig,
+    devices: Mutex<HashMap<u32, Activity>>,
+}
+
+impl WorkloadTracker {
+    /// Create a new workload tracker
+    pub fn new(config: WorkloadConfig) -> Self {
+        Self {
+            config,
+            devices: Mutex::new(HashMap::new()),
+        }
+    }
+
+    /// Get the tracker configuration
+    pub fn config(&self) -> &WorkloadConfig {
+        &self.config
+    }
+
+    /// Record an activity sample from L1 metrics
+    pub fn observe(&self, device: &DeviceId, metrics: &DeviceMetrics) {
+        self.observe_at(device, metrics, Instant::now());
+    }
+
+    /// Decide whether a scheduled L2 probe should run
+    pub fn decide(&self, device: &DeviceId) -> ProbeDecision {
+        self.decide_at(device, Instant::now())
+    }
+
+    /// Whether a device has held memory at 0% utilization long enough to
+    /// warrant an early probe
+    ///
+    /// Returns true at most once per `silent_after` while the device stays
+    /// silent, as long as each early probe is recorded.
+    pub fn is_silent(&self, device: &DeviceId) -> bool {
+        self.is_silent_at(device, Instant::now())
+    }
+
+    /// Record that an L2 probe ran on a device
+    pub fn record_probe(&self, device: &DeviceId) {
+        self.record_probe_at(device, Instant::now());
+    }
+
+    /// Highest of GPU and memory controller utilization (%) from a fresh
+    /// sample, or None if the device has no recent sample
+    pub fn utilization(&self, device: &DeviceId) -> Option<u32> {
+        self.utilization_at(device, Instant::now())
+    }
+
+    fn observe_at(&self, device: &DeviceId, metrics: &DeviceMetrics, now: Instant) {
+        let allocated = metrics.memory_total > 0
+            && metrics.memory_used as f64 / metrics.memory_total as f64
+                >= self.config.allocated_memory_fraction;
+        let idle = allocated && metrics.gpu_utilization == 0;
+
+        let mut devices = self.devices.lock().unwrap_or_else(|e| e.into_inner());
+        let activity = devices.entry(device.index).or_insert(Activity {
+            gpu_utilization: 0,
+            memory_utilization: 0,
+            sampled_at: now,
+            silent_since: None,
+            last_probe: None,
+        });
+        activity.gpu_utilization = metrics.gpu_utilization;
+        activity.memory_utilization = metrics.memory_utilization;
+        activity.sampled_at = now;
+        activity.silent_since = if idle {
+            Some(activity.silent_since.unwrap_or(now))
+        } else {
+            None
+        };
+    }
+
+    fn decide_at(&self, device: &DeviceId, now: Instant) -> ProbeDecision {
+        let devices = self.devices.lock().unwrap_or_else(|e| e.into_inner());
+        let Some(activity) = devices.get(&device.index) else {
+            return ProbeDecision::Run;
+        };
+
+        // Stale samples say nothing about current load
+        if now.duration_since(activity.sampled_at) > self.config.max_sample_age {
+            return ProbeDecision::Run;
+        }
+        // Busy or not, never go longer than max_deferral without a probe
+        let overdue = activity
+            .last_probe
+            .map_or(true, |t| now.duration_since(t) >= self.config.max_deferral);
+        if overdue {
+            return ProbeDecision::Run;
+        }
+
+        if activity.gpu_utilization >= self.config.busy_utilization {
+            ProbeDecision::Skip(SkipReason::ComputeBusy)
+        } else if activity.memory_utilization >= self.config.busy_memory_utilization {
+            ProbeDecision::Skip(SkipReason::MemoryBusy)
+        } else {
+            ProbeDecision::Run
+        }
+    }
+
+    fn is_silent_at(&self, device: &DeviceId, now: Instant) -> bool {
+        let devices = self.devices.lock().unwrap_or_else(|e| e.into_inner());
+        let Some(activity) = devices.get(&device.index) else {
+            return false;
+        };
+        let Some(since) = activity.silent_since else {
+            return false;
+        };
+
+        now.duration_since(since) >= self.config.silent_after
+            && activity
+                .last_probe
+                .map_or(true, |t| now.duration_since(t) >= self.config.silent_after)
+    }
+
+    fn utilization_at(&self, device: &DeviceId, now: Instant) -> Option<u32> {
+        let devices = self.devices.lock().unwrap_or_else(|e| e.into_inner());
+        let activity = devices.get(&device.index)?;
+        (now.duration_since(activity.sampled_at) <= self.config.max_sample_age)
+            .then(|| activity.gpu_utilization.max(activity.memory_utilization))
+    }
+
+    fn record_probe_at(&self, device: &DeviceId, now: Instant) {
+        let mut devices = self.devices.lock().unwrap_or_else(|e| e.into_inner());
+        if let Some(activity) = devices.get_mut(&device.index) {
+            activity.last_probe = Some(now);
+        }
+    }
+}
+
+impl Default for WorkloadTracker {
+    fn default() -> Self {
+        Self::new(WorkloadConfig::default())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::device::EccErrors;
+    use chrono::Utc;
+
+    fn device() -> DeviceId {
+        DeviceId {
+            index: 0,
+            uuid: Some("GPU-WORKLOAD".to_string()),
+            name: "H100".to_string(),
+        }
+    }
+
+    fn metrics(gpu_utilization: u32, memory_utilization: u32, memory_used: u64) -> DeviceMetrics {
+        DeviceMetrics {
+            temperature: 50,
+            memory_temperature: None,
+            gpu_utilization,
+            memory_utilization,
+            power_usage: 300,
+            power_limit: 700,
+            memory_total: 80 << 30,
+            memory_used,
+            memory_free: (80 << 30) - memory_used,
+            pcie_tx: None,
+            pcie_rx: None,
+            ecc_errors: EccErrors::default(),
+            timestamp: Utc::now(),
+        }
+    }
+
+    #[test]
+    fn test_busy_device_skipped_until_overdue() {
+        let tracker = WorkloadTracker::default();
+        let gpu = device();
+        let start = Instant::now();
+
+        // Never probed: always run first
+        tracker.observe_at(&gpu, &metrics(100, 60, 70 << 30), start);
+        assert_eq!(tracker.decide_at(&gpu, start), ProbeDecision::Run);
+        tracker.record_probe_at(&gpu, start);
+
+        let later = start + Duration::from_secs(60);
+        tracker.observe_at(&gpu, &metrics(100, 60, 70 << 30), later);
+        assert_eq!(
+            tracker.decide_at(&gpu, later),
+            ProbeDecision::Skip(SkipReason::ComputeBusy)
+        );
+
+        let overdue = start + Duration::from_secs(600);
+        tracker.observe_at(&gpu, &metrics(100, 60, 70 << 30), overdue);
+        assert_eq!(tracker.decide_at(&gpu, overdue), ProbeDecision::Run);
+    }
+
+    #[test]
+    fn test_memory_busy_and_stale_samples() {
+        let tracker = WorkloadTracker::default();
+        let gpu = device();
+        let start = Instant::now();
+        tracker.observe_at(&gpu, &metrics(40, 95, 70 << 30), start);
+        tracker.record_probe_at(&gpu, start);
+
+        let soon = start + Duration::from_secs(30);
+        assert_eq!(
+            tracker.decide_at(&gpu, soon),
+            ProbeDecision::Skip(SkipReason::MemoryBusy)
+        );
+        // Without fresh samples the device is probed as usual
+        let stale = start + Duration::from_secs(120);
+        assert_eq!(tracker.decide_at(&gpu, stale), ProbeDecision::Run);
+        assert_eq!(tracker.utilization_at(&gpu, soon), Some(95));
+        assert_eq!(tracker.utilization_at(&gpu, stale), None);
+    }
+
+    #[test]
+    fn test_silent_device() {
+        let tracker = WorkloadTracker::default();
+        let gpu = device();
+        let start = Instant::now();
+
+        // Idle but nothing allocated: just an empty device
+        tracker.observe_at(&gpu, &metrics(0, 0, 0), start);
+        let later = start + Duration::from_secs(900);
+        tracker.observe_at(&gpu, &metrics(0, 0, 0), later);
+        assert!(!tracker.is_silent_at(&gpu, later));
+
+        // Allocated and idle for longer than silent_after
+        tracker.observe_at(&gpu, &metrics(0, 0, 40 << 30), start);
+        let silent = start + Duration::from_secs(600);
+        tracker.observe_at(&gpu, &metrics(0, 0, 40 << 30), silent);
+        assert!(tracker.is_silent_at(&gpu, silent));
+
+        // One early probe per silent_after
+        tracker.record_probe_at(&gpu, silent);
+        assert!(!tracker.is_silent_at(&gpu, silent + Duration::from_secs(60)));
+        assert!(tracker.is_silent_at(&gpu, silent + Duration::from_secs(600)));
+
+        // Any kernel activity resets the stretch
+        tracker.observe_at(&gpu, &metrics(5, 1, 40 << 30), silent);
+        assert!(!tracker.is_silent_at(&gpu, silent + Duration::from_secs(600)));
+    }
+}
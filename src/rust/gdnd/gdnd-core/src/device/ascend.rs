@@ -1,19 +1,41 @@
 //! Huawei Ascend NPU device implementation
 //!
 //! Uses npu-smi command line tool and device-os logs for NPU monitoring.
+//! Processes holding `/dev/davinciN` open are found with one shared /proc scan.
+//!
+//! Devices are indexed by the logic ID npu-smi and AscendCL use, while
+//! `/dev/davinciN` is numbered by physical ID. The two are mapped through
+//! DCMI (npu-collect); without it they are assumed equal, which holds for
+//! the default enumeration of single-chip cards.
 
+use std::collections::HashMap;
 use std::path::PathBuf;
+use std::sync::Arc;
 use std::time::Duration;
 
 use async_trait::async_trait;
 use chrono::Utc;
-use regex::Regex;
-use tracing::{debug, trace, warn};
+use tracing::{debug, warn};
 
 use super::{
-    CheckResult, DeviceError, DeviceId, DeviceInterface, DeviceMetrics, DeviceType, EccErrors,
-    XidError,
+    parse_probe_measurements, CheckResult, DeviceError, DeviceId, DeviceInterface, DeviceMetrics,
+    DeviceType, EccErrors, ProcScanner, XidError, ASCEND_NODE_PREFIX, DEFAULT_PROC_ROOT,
+    DEFAULT_ZOMBIE_THRESHOLD,
+};
+use super::dcmi::{
+    DcmiCollector, DcmiRecord, DEFAULT_COLLECTOR_PATH, VALID_AICORE, VALID_ECC, VALID_HBM,
+    VALID_HEALTH, VALID_PHY_ID, VALID_POWER, VALID_TEMPERATURE,
 };
+use super::npu_smi::parse_info;
+use super::slog::SlogTailer;
+use super::snapshot::SnapshotCache;
+use crate::overhead;
+
+/// How long one npu-smi query result is shared across devices
+const DEFAULT_SNAPSHOT_TTL: Duration = Duration::from_secs(5);
+
+/// How often the resident npu-collect helper samples all NPUs
+const DEFAULT_COLLECT_INTERVAL: Duration = Duration::from_secs(5);
 
 /// Ascend NPU error codes
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
@@ -114,27 +136,53 @@ struct NpuMetricsInfo {
     hbm_total: u64,
 }
 
+/// Parsed `npu-smi info` output, shared by every device
+#[derive(Debug, Default)]
+struct NpuSnapshot {
+    devices: Vec<NpuDeviceInfo>,
+    metrics: HashMap<u32, NpuMetricsInfo>,
+}
+
 /// Huawei Ascend NPU device implementation
 pub struct AscendDevice {
     /// Path to npu-smi binary
     npu_smi_path: String,
     /// Path to npu-check binary
     npu_check_path: String,
-    /// Path to NPU log directory
-    log_dir: PathBuf,
+    /// Incremental reader for the NPU log directory
+    logs: Arc<SlogTailer>,
     /// Fatal error codes for custom configuration
     fatal_error_codes: Vec<u32>,
+    /// Latest `npu-smi info` snapshot
+    info: SnapshotCache<NpuSnapshot>,
+    /// Device-file holders, scanned once per cycle for all NPUs
+    procs: Arc<ProcScanner>,
+    /// Time in D state before a holder is reported as a zombie
+    zombie_threshold: Duration,
+    /// DCMI telemetry, preferred over npu-smi when available
+    collector: Option<Arc<DcmiCollector>>,
 }
 
 impl AscendDevice {
     /// Create a new Ascend device interface with default paths
+    ///
+    /// Telemetry comes from npu-collect (DCMI) when it is installed.
     pub fn new() -> Result<Self, DeviceError> {
-        Self::with_config(
+        let device = Self::with_config(
             "/usr/local/bin/npu-smi".to_string(),
             "/usr/local/bin/npu-check".to_string(),
             PathBuf::from("/var/log/npu/slog"),
             vec![1001, 1002, 1005, 1007, 1008],
-        )
+        )?;
+
+        if std::path::Path::new(DEFAULT_COLLECTOR_PATH).exists() {
+            Ok(device.with_collector(
+                PathBuf::from(DEFAULT_COLLECTOR_PATH),
+                DEFAULT_COLLECT_INTERVAL,
+            ))
+        } else {
+            Ok(device)
+        }
     }
 
     /// Create a new Ascend device interface with custom configuration
@@ -155,11 +203,39 @@ impl AscendDevice {
         Ok(Self {
             npu_smi_path,
             npu_check_path,
-            log_dir,
+            logs: Arc::new(SlogTailer::new(log_dir)),
             fatal_error_codes,
+            info: SnapshotCache::new(DEFAULT_SNAPSHOT_TTL),
+            procs: Arc::new(ProcScanner::new(DEFAULT_PROC_ROOT, ASCEND_NODE_PREFIX)),
+            zombie_threshold: DEFAULT_ZOMBIE_THRESHOLD,
+            collector: None,
         })
     }
 
+    /// Read metrics and health through a resident npu-collect helper
+    pub fn with_collector(mut self, path: PathBuf, interval: Duration) -> Self {
+        self.collector = Some(Arc::new(DcmiCollector::new(path, interval)));
+        self
+    }
+
+    /// Set how long npu-smi results are reused (zero disables caching)
+    pub fn with_snapshot_ttl(mut self, ttl: Duration) -> Self {
+        self.info = SnapshotCache::new(ttl);
+        self
+    }
+
+    /// Scan a different procfs root for `/dev/davinciN` holders
+    pub fn with_proc_root(mut self, root: PathBuf) -> Self {
+        self.procs = Arc::new(ProcScanner::new(root, ASCEND_NODE_PREFIX));
+        self
+    }
+
+    /// Set how long a holder must stay in D state to count as a zombie
+    pub fn with_zombie_threshold(mut self, threshold: Duration) -> Self {
+        self.zombie_threshold = threshold;
+        self
+    }
+
     /// Check if an error code is configured as fatal
     ///
     /// This uses the configured fatal_error_codes list, allowing custom
@@ -175,6 +251,7 @@ impl AscendDevice {
 
     /// Execute npu-smi command with arguments
     async fn run_npu_smi(&self, args: &[&str]) -> Result<String, DeviceError> {
+        overhead::record_spawn();
         let output = tokio::process::Command::new(&self.npu_smi_path)
             .args(args)
             .output()
@@ -192,205 +269,121 @@ impl AscendDevice {
         Ok(String::from_utf8_lossy(&output.stdout).to_string())
     }
 
-    /// Parse npu-smi info output to get device list
-    ///
-    /// Example output format:
-    /// ```text
-    /// +------------------------------------------------------------------------------------------------+
-    /// | npu-smi 23.0.0                   Version: 23.0.0                                               |
-    /// +---------------------------+---------------+----------------------------------------------------+
-    /// | NPU     Name              | Health        | Power(W)    Temp(C)           Hugepages-Usage(page)|
-    /// | Chip                      | Bus-Id        | AICore(%)   Memory-Usage(MB)   HBM-Usage(MB)       |
-    /// +===========================+===============+====================================================+
-    /// | 0       910B3             | OK            | 112.5       37         0 / 0                       |
-    /// | 0                         | 0000:C1:00.0  | 6           0 / 0              33551 / 65536       |
-    /// +===========================+===============+====================================================+
-    /// ```
-    fn parse_device_list(&self, output: &str) -> Result<Vec<NpuDeviceInfo>, DeviceError> {
-        let mut devices = Vec::new();
-
-        // Match device lines: "| 0       910B3             | OK            |"
-        let device_regex =
-            Regex::new(r"\|\s*(\d+)\s+(\S+)\s+\|\s*(\w+)\s+\|").unwrap();
-        // Match chip lines: "| 0                         | 0000:C1:00.0  |"
-        let chip_regex =
-            Regex::new(r"\|\s*(\d+)\s+\|\s*([0-9a-fA-F:\.]+)\s+\|").unwrap();
-
-        let lines: Vec<&str> = output.lines().collect();
-        let mut i = 0;
-
-        while i < lines.len() {
-            let line = lines[i];
-
-            // Try to match device line
-            if let Some(cap) = device_regex.captures(line) {
-                let index: u32 = cap[1].parse().unwrap_or(0);
-                let name = cap[2].to_string();
-                let health = cap[3].to_string();
-
-                // Try to get bus_id from next line
-                let bus_id = if i + 1 < lines.len() {
-                    chip_regex
-                        .captures(lines[i + 1])
-                        .map(|c| c[2].to_string())
-                } else {
-                    None
-                };
-
-                devices.push(NpuDeviceInfo {
-                    index,
-                    name,
-                    health,
-                    bus_id,
-                });
-
-                i += 2; // Skip chip line
-                continue;
-            }
-
-            i += 1;
+    /// Parse npu-smi info output into the device list and per-NPU metrics
+    fn parse_snapshot(output: &str) -> NpuSnapshot {
+        let mut snapshot = NpuSnapshot::default();
+        for row in parse_info(output) {
+            snapshot.metrics.insert(
+                row.index,
+                NpuMetricsInfo {
+                    temperature: row.temperature.unwrap_or(0),
+                    power: row.power.unwrap_or(0.0) as u32,
+                    aicore_util: row.aicore_util.unwrap_or(0),
+                    hbm_used: row.hbm_used_mb.unwrap_or(0) * 1024 * 1024, // MB to bytes
+                    hbm_total: row.hbm_total_mb.unwrap_or(0) * 1024 * 1024,
+                },
+            );
+            snapshot.devices.push(NpuDeviceInfo {
+                index: row.index,
+                name: row.name.to_string(),
+                health: row.health.to_string(),
+                bus_id: row.bus_id.map(str::to_string),
+            });
         }
-
-        Ok(devices)
+        snapshot
     }
 
-    /// Parse npu-smi info output to get device metrics
-    ///
-    /// Extracts: Power(W), Temp(C), AICore(%), HBM-Usage(MB)
-    fn parse_device_metrics(&self, output: &str, device_index: u32) -> NpuMetricsInfo {
-        let mut metrics = NpuMetricsInfo::default();
-
-        // Match the main device line with metrics
-        // "| 0       910B3             | OK            | 112.5       37         0 / 0"
-        let main_regex = Regex::new(
-            r"\|\s*(\d+)\s+\S+\s+\|\s*\w+\s+\|\s*(\d+\.?\d*)\s+(\d+)\s+",
-        )
-        .unwrap();
+    /// Get the current `npu-smi info` snapshot, querying at most once per TTL
+    async fn info_snapshot(&self) -> Result<Arc<NpuSnapshot>, DeviceError> {
+        self.info
+            .get_or_refresh(|| async {
+                let output = self.run_npu_smi(&["info"]).await?;
+                Ok(Self::parse_snapshot(&output))
+            })
+            .await
+    }
 
-        // Match the chip line with AICore and HBM
-        // "| 0                         | 0000:C1:00.0  | 6           0 / 0              33551 / 65536"
-        let chip_regex = Regex::new(
-            r"\|\s*(\d+)\s+\|\s*[0-9a-fA-F:\.]+\s+\|\s*(\d+)\s+\d+\s*/\s*\d+\s+(\d+)\s*/\s*(\d+)",
-        )
-        .unwrap();
+    /// Latest DCMI record for an NPU, if the collector has fresh data
+    fn dcmi_record(&self, device_index: u32) -> Option<DcmiRecord> {
+        self.collector.as_ref()?.record(device_index)
+    }
 
-        for line in output.lines() {
-            // Try main line
-            if let Some(cap) = main_regex.captures(line) {
-                if cap[1].parse::<u32>().unwrap_or(u32::MAX) == device_index {
-                    metrics.power = cap[2].parse::<f64>().unwrap_or(0.0) as u32;
-                    metrics.temperature = cap[3].parse().unwrap_or(0);
-                }
-            }
+    /// N in /dev/davinciN for an NPU: its physical ID when DCMI reports one
+    fn node_number(record: Option<&DcmiRecord>, device_index: u32) -> u32 {
+        record
+            .filter(|r| r.has(VALID_PHY_ID))
+            .map_or(device_index, |r| r.phy_id)
+    }
 
-            // Try chip line
-            if let Some(cap) = chip_regex.captures(line) {
-                if cap[1].parse::<u32>().unwrap_or(u32::MAX) == device_index {
-                    metrics.aicore_util = cap[2].parse().unwrap_or(0);
-                    metrics.hbm_used = cap[3].parse::<u64>().unwrap_or(0) * 1024 * 1024; // MB to bytes
-                    metrics.hbm_total = cap[4].parse::<u64>().unwrap_or(0) * 1024 * 1024;
+    /// Build device metrics from a DCMI record
+    fn dcmi_metrics(record: &DcmiRecord) -> DeviceMetrics {
+        let (hbm_total, hbm_used) = if record.has(VALID_HBM) {
+            (record.hbm_total, record.hbm_used)
+        } else {
+            (0, 0)
+        };
+        DeviceMetrics {
+            temperature: if record.has(VALID_TEMPERATURE) {
+                record.temperature.max(0) as u32
+            } else {
+                0
+            },
+            memory_temperature: record
+                .has(VALID_HBM)
+                .then(|| record.hbm_temperature.max(0) as u32),
+            gpu_utilization: if record.has(VALID_AICORE) {
+                record.aicore_util
+            } else {
+                0
+            },
+            memory_utilization: if hbm_total > 0 {
+                ((hbm_used as f64 / hbm_total as f64) * 100.0) as u32
+            } else {
+                0
+            },
+            power_usage: if record.has(VALID_POWER) {
+                record.power_mw / 1000
+            } else {
+                0
+            },
+            power_limit: 0,
+            memory_total: hbm_total,
+            memory_used: hbm_used,
+            memory_free: hbm_total.saturating_sub(hbm_used),
+            pcie_tx: None,
+            pcie_rx: None,
+            ecc_errors: if record.has(VALID_ECC) {
+                EccErrors {
+                    single_bit: record.ecc_single as u64,
+                    double_bit: record.ecc_double as u64,
+                    single_bit_aggregate: record.ecc_single_total as u64,
+                    double_bit_aggregate: record.ecc_double_total as u64,
                 }
-            }
+            } else {
+                EccErrors::default()
+            },
+            timestamp: Utc::now(),
         }
+    }
 
-        metrics
+    /// Map DCMI health (0 ok, 1 minor, 2 major, 3 critical) to an error
+    fn dcmi_health_to_error(&self, health: u32) -> Option<AscendErrorCode> {
+        match health {
+            0 => self.health_to_error("OK"),
+            1 => self.health_to_error("WARNING"),
+            2 => self.health_to_error("ERROR"),
+            _ => self.health_to_error("FAULT"),
+        }
     }
 
-    /// Parse device-os logs for errors
+    /// Collect errors appended to device-os logs since the last check
     ///
     /// Log path: /var/log/npu/slog/device-os-{id}/
     async fn parse_device_logs(&self, device_index: u32) -> Vec<XidError> {
-        let log_path = self.log_dir.join(format!("device-os-{}", device_index));
-
-        if !log_path.exists() {
-            debug!(
-                path = ?log_path,
-                "Device log directory not found"
-            );
-            return Vec::new();
-        }
-
-        // Error patterns to match in logs
-        let error_patterns = [
-            (r"\[ERROR\].*HBM.*error", 1001u32),
-            (r"\[ERROR\].*AICore.*hang", 1002),
-            (r"\[ERROR\].*temperature", 1003),
-            (r"\[ERROR\].*PCIe.*link", 1005),
-            (r"\[ERROR\].*device.*lost", 1007),
-            (r"\[ERROR\].*ECC.*uncorrectable", 1008),
-            (r"ErrCode=(\d+)", 0), // Generic error code pattern
-        ];
-
-        let mut errors = Vec::new();
-
-        // Read recent log files
-        let mut entries = match tokio::fs::read_dir(&log_path).await {
-            Ok(entries) => entries,
-            Err(e) => {
-                debug!(error = %e, "Failed to read log directory");
-                return Vec::new();
-            }
-        };
-
-        while let Ok(Some(entry)) = entries.next_entry().await {
-            let path = entry.path();
-            if !path.is_file() {
-                continue;
-            }
-
-            // Only process recent log files (last 24h)
-            if let Ok(metadata) = entry.metadata().await {
-                if let Ok(modified) = metadata.modified() {
-                    let age = std::time::SystemTime::now()
-                        .duration_since(modified)
-                        .unwrap_or(Duration::MAX);
-                    if age > Duration::from_secs(86400) {
-                        continue;
-                    }
-                }
-            }
-
-            // Read and parse log file
-            if let Ok(content) = tokio::fs::read_to_string(&path).await {
-                for (pattern, default_code) in &error_patterns {
-                    let re = match Regex::new(pattern) {
-                        Ok(re) => re,
-                        Err(_) => continue,
-                    };
-
-                    for cap in re.captures_iter(&content) {
-                        let code = if *default_code == 0 {
-                            // Extract code from capture group
-                            cap.get(1)
-                                .and_then(|m| m.as_str().parse().ok())
-                                .unwrap_or(9999)
-                        } else {
-                            *default_code
-                        };
-
-                        let error_code = AscendErrorCode::from_code(code);
-                        errors.push(XidError {
-                            code,
-                            message: error_code.description().to_string(),
-                            timestamp: Utc::now(),
-                            device_index,
-                        });
-                    }
-                }
-            }
-        }
-
-        // Deduplicate by error code
-        errors.sort_by_key(|e| e.code);
-        errors.dedup_by_key(|e| e.code);
-
-        trace!(
-            device_index = device_index,
-            count = errors.len(),
-            "Found Ascend errors in logs"
-        );
-
-        errors
+        let logs = Arc::clone(&self.logs);
+        tokio::task::spawn_blocking(move || logs.poll(device_index))
+            .await
+            .unwrap_or_default()
     }
 
     /// Check if health status indicates an error
@@ -407,25 +400,34 @@ impl AscendDevice {
 #[async_trait]
 impl DeviceInterface for AscendDevice {
     async fn list_devices(&self) -> Result<Vec<DeviceId>, DeviceError> {
-        let output = self.run_npu_smi(&["info"]).await?;
-        let devices = self.parse_device_list(&output)?;
+        let snapshot = self.info_snapshot().await?;
 
-        Ok(devices
-            .into_iter()
+        Ok(snapshot
+            .devices
+            .iter()
             .map(|d| DeviceId {
                 index: d.index,
-                uuid: d.bus_id, // Use bus_id as UUID equivalent
+                uuid: d.bus_id.clone(), // Use bus_id as UUID equivalent
                 name: format!("Ascend {}", d.name),
             })
             .collect())
     }
 
     async fn get_metrics(&self, device: &DeviceId) -> Result<DeviceMetrics, DeviceError> {
-        let output = self.run_npu_smi(&["info"]).await?;
-        let metrics = self.parse_device_metrics(&output, device.index);
+        if let Some(record) = self.dcmi_record(device.index) {
+            return Ok(Self::dcmi_metrics(&record));
+        }
+
+        let snapshot = self.info_snapshot().await?;
+        let metrics = snapshot
+            .metrics
+            .get(&device.index)
+            .cloned()
+            .unwrap_or_default();
 
         Ok(DeviceMetrics {
             temperature: metrics.temperature,
+            memory_temperature: None,
             gpu_utilization: metrics.aicore_util,
             memory_utilization: if metrics.hbm_total > 0 {
                 ((metrics.hbm_used as f64 / metrics.hbm_total as f64) * 100.0) as u32
@@ -448,11 +450,22 @@ impl DeviceInterface for AscendDevice {
         // Get errors from device logs
         let mut errors = self.parse_device_logs(device.index).await;
 
-        // Also check npu-smi health status
-        let output = self.run_npu_smi(&["info"]).await?;
-        let devices = self.parse_device_list(&output)?;
+        // Also check health status, from DCMI when available
+        if let Some(record) = self.dcmi_record(device.index).filter(|r| r.has(VALID_HEALTH)) {
+            if let Some(error_code) = self.dcmi_health_to_error(record.health) {
+                errors.push(XidError {
+                    code: error_code as u32,
+                    message: error_code.description().to_string(),
+                    timestamp: Utc::now(),
+                    device_index: device.index,
+                });
+            }
+            return Ok(errors);
+        }
 
-        for d in devices {
+        let snapshot = self.info_snapshot().await?;
+
+        for d in &snapshot.devices {
             if d.index == device.index {
                 if let Some(error_code) = self.health_to_error(&d.health) {
                     errors.push(XidError {
@@ -470,37 +483,21 @@ impl DeviceInterface for AscendDevice {
     }
 
     async fn check_zombie_processes(&self, device: &DeviceId) -> Result<Vec<u32>, DeviceError> {
-        // Use npu-smi info -t usages to get process list
-        let output = match self.run_npu_smi(&["info", "-t", "usages"]).await {
-            Ok(output) => output,
-            Err(_) => return Ok(Vec::new()),
-        };
-
-        // Parse PIDs from output
-        // Format varies, look for PID patterns
-        let pid_regex = Regex::new(r"\bPID[:\s]+(\d+)").unwrap();
-        let pids: Vec<u32> = pid_regex
-            .captures_iter(&output)
-            .filter_map(|cap| cap[1].parse().ok())
-            .collect();
+        // Find processes stuck in D state holding /dev/davinciN open
+        let node = self.device_node(device);
+        let scan = self.procs.scan().await?;
 
         let mut zombie_pids = Vec::new();
-
-        for pid in pids {
-            // Check process state in /proc
-            let stat_path = format!("/proc/{}/stat", pid);
-            if let Ok(stat) = tokio::fs::read_to_string(&stat_path).await {
-                let parts: Vec<&str> = stat.split_whitespace().collect();
-                if parts.len() > 2 {
-                    let state = parts[2];
-                    if state == "D" {
-                        warn!(pid = pid, device = %device, "Found zombie NPU process");
-                        zombie_pids.push(pid);
-                    }
-                }
-            }
+        for holder in scan.stuck_holders(node, self.zombie_threshold) {
+            warn!(
+                pid = holder.pid,
+                comm = %holder.comm,
+                d_state_for = ?holder.d_state_for,
+                device = %device,
+                "Found zombie NPU process"
+            );
+            zombie_pids.push(holder.pid);
         }
-
         Ok(zombie_pids)
     }
 
@@ -512,11 +509,13 @@ impl DeviceInterface for AscendDevice {
         let start = std::time::Instant::now();
 
         // Run npu-check binary with timeout
+        overhead::record_spawn();
         let result = tokio::time::timeout(
             timeout,
             tokio::process::Command::new(&self.npu_check_path)
                 .arg("-d")
                 .arg(device.index.to_string())
+                .arg("-m")
                 .output(),
         )
         .await;
@@ -526,8 +525,10 @@ impl DeviceInterface for AscendDevice {
         match result {
             Ok(Ok(output)) => {
                 if output.status.success() {
+                    let measurements =
+                        parse_probe_measurements(&String::from_utf8_lossy(&output.stdout));
                     debug!(device = %device, duration = ?duration, "Ascend active check passed");
-                    Ok(CheckResult::success(duration))
+                    Ok(CheckResult::success(duration).with_measurements(measurements))
                 } else {
                     let error = String::from_utf8_lossy(&output.stderr).to_string();
                     warn!(device = %device, error = %error, "Ascend active check failed");
@@ -546,7 +547,7 @@ impl DeviceInterface for AscendDevice {
             Err(_) => {
                 // Timeout
                 warn!(device = %device, timeout = ?timeout, "Ascend active check timed out");
-                Ok(CheckResult::timeout(timeout))
+                Err(DeviceError::Timeout(timeout))
             }
         }
     }
@@ -555,6 +556,14 @@ impl DeviceInterface for AscendDevice {
         DeviceType::Ascend
     }
 
+    fn device_node(&self, device: &DeviceId) -> u32 {
+        Self::node_number(self.dcmi_record(device.index).as_ref(), device.index)
+    }
+
+    fn proc_scanner(&self) -> Option<Arc<ProcScanner>> {
+        Some(Arc::clone(&self.procs))
+    }
+
     fn supports_pcie_test(&self) -> bool {
         true
     }
@@ -563,10 +572,12 @@ impl DeviceInterface for AscendDevice {
         // Run npu-check with PCIe test flag
         let start = std::time::Instant::now();
 
+        overhead::record_spawn();
         let result = tokio::process::Command::new(&self.npu_check_path)
             .arg("-d")
             .arg(device.index.to_string())
             .arg("--pcie-test")
+            .arg("-m")
             .output()
             .await;
 
@@ -575,7 +586,9 @@ impl DeviceInterface for AscendDevice {
         match result {
             Ok(output) => {
                 if output.status.success() {
-                    Ok(CheckResult::success(duration))
+                    let measurements =
+                        parse_probe_measurements(&String::from_utf8_lossy(&output.stdout));
+                    Ok(CheckResult::success(duration).with_measurements(measurements))
                 } else {
                     let error = String::from_utf8_lossy(&output.stderr).to_string();
                     Ok(CheckResult::failure(duration, error, output.status.code()))
@@ -598,6 +611,20 @@ impl DeviceInterface for AscendDevice {
 mod tests {
     use super::*;
 
+    /// A device with default paths and no DCMI collector
+    fn test_device() -> AscendDevice {
+        AscendDevice {
+            npu_smi_path: "/usr/local/bin/npu-smi".to_string(),
+            npu_check_path: "/usr/local/bin/npu-check".to_string(),
+            logs: Arc::new(SlogTailer::new(PathBuf::from("/var/log/npu/slog"))),
+            fatal_error_codes: vec![1001, 1002, 1007, 1008],
+            info: SnapshotCache::new(DEFAULT_SNAPSHOT_TTL),
+            procs: Arc::new(ProcScanner::new(DEFAULT_PROC_ROOT, ASCEND_NODE_PREFIX)),
+            zombie_threshold: DEFAULT_ZOMBIE_THRESHOLD,
+            collector: None,
+        }
+    }
+
     #[test]
     fn test_ascend_error_codes() {
         assert_eq!(AscendErrorCode::from_code(1001), AscendErrorCode::HbmError);
@@ -618,12 +645,7 @@ mod tests {
 
     #[test]
     fn test_fatal_error_codes_config() {
-        let device = AscendDevice {
-            npu_smi_path: "/usr/local/bin/npu-smi".to_string(),
-            npu_check_path: "/usr/local/bin/npu-check".to_string(),
-            log_dir: PathBuf::from("/var/log/npu/slog"),
-            fatal_error_codes: vec![1001, 1002, 1007, 1008],
-        };
+        let device = test_device();
 
         // Test is_error_fatal method
         assert!(device.is_error_fatal(1001)); // HbmError
@@ -654,15 +676,7 @@ mod tests {
 +===========================+===============+====================================================+
 "#;
 
-        // Create a mock device to test parsing
-        let device = AscendDevice {
-            npu_smi_path: "/usr/local/bin/npu-smi".to_string(),
-            npu_check_path: "/usr/local/bin/npu-check".to_string(),
-            log_dir: PathBuf::from("/var/log/npu/slog"),
-            fatal_error_codes: vec![1001, 1002, 1007, 1008],
-        };
-
-        let devices = device.parse_device_list(sample_output).unwrap();
+        let devices = AscendDevice::parse_snapshot(sample_output).devices;
         assert_eq!(devices.len(), 2);
         assert_eq!(devices[0].index, 0);
         assert_eq!(devices[0].name, "910B3");
@@ -680,14 +694,7 @@ mod tests {
 | 0                         | 0000:C1:00.0  | 6           0 / 0              33551 / 65536       |
 "#;
 
-        let device = AscendDevice {
-            npu_smi_path: "/usr/local/bin/npu-smi".to_string(),
-            npu_check_path: "/usr/local/bin/npu-check".to_string(),
-            log_dir: PathBuf::from("/var/log/npu/slog"),
-            fatal_error_codes: vec![1001, 1002, 1007, 1008],
-        };
-
-        let metrics = device.parse_device_metrics(sample_output, 0);
+        let metrics = AscendDevice::parse_snapshot(sample_output).metrics[&0].clone();
         assert_eq!(metrics.temperature, 37);
         assert_eq!(metrics.power, 112);
         assert_eq!(metrics.aicore_util, 6);
@@ -697,12 +704,7 @@ mod tests {
 
     #[test]
     fn test_health_status_mapping() {
-        let device = AscendDevice {
-            npu_smi_path: "/usr/local/bin/npu-smi".to_string(),
-            npu_check_path: "/usr/local/bin/npu-check".to_string(),
-            log_dir: PathBuf::from("/var/log/npu/slog"),
-            fatal_error_codes: vec![1001, 1002, 1007, 1008],
-        };
+        let device = test_device();
 
         assert!(device.health_to_error("OK").is_none());
         assert_eq!(
@@ -718,4 +720,110 @@ mod tests {
             Some(AscendErrorCode::DeviceLost)
         );
     }
+
+    #[tokio::test]
+    async fn test_sweep_shares_one_npu_smi_query() {
+        use std::os::unix::fs::PermissionsExt;
+
+        let dir = std::env::temp_dir().join(format!("gdnd-npu-smi-{}", std::process::id()));
+        std::fs::create_dir_all(&dir).unwrap();
+        let calls = dir.join("calls");
+        let script = dir.join("npu-smi");
+        let fixtures = concat!(env!("CARGO_MANIFEST_DIR"), "/testdata");
+        std::fs::write(
+            &script,
+            format!(
+                "#!/bin/sh\necho $* >> {calls}\ncat {fixtures}/npu-smi/910b-16npu-23.0.txt\n",
+                calls = calls.display(),
+            ),
+        )
+        .unwrap();
+        std::fs::set_permissions(&script, std::fs::Permissions::from_mode(0o755)).unwrap();
+
+        let device = AscendDevice::with_config(
+            script.display().to_string(),
+            "/nonexistent/npu-check".to_string(),
+            dir.join("slog"),
+            vec![1001, 1002, 1007, 1008],
+        )
+        .unwrap()
+        .with_proc_root(dir.join("proc"));
+        std::fs::create_dir_all(dir.join("proc")).unwrap();
+
+        let devices = device.list_devices().await.unwrap();
+        assert_eq!(devices.len(), 16);
+        let sweeps = devices.iter().map(|d| async {
+            let metrics = device.get_metrics(d).await.unwrap();
+            let errors = device.get_xid_errors(d).await.unwrap();
+            device.check_zombie_processes(d).await.unwrap();
+            (metrics, errors)
+        });
+        let results = futures::future::join_all(sweeps).await;
+
+        assert_eq!(results[1].0.temperature, 36);
+        assert_eq!(results[1].0.gpu_utilization, 7);
+        assert_eq!(results[15].0.memory_used, 35000 * 1024 * 1024);
+        assert_eq!(results[5].1.len(), 1); // Warning health
+        assert!(results[0].1.is_empty());
+
+        let calls = std::fs::read_to_string(&calls).unwrap();
+        assert_eq!(calls.lines().filter(|l| *l == "info").count(), 1);
+        assert_eq!(calls.lines().count(), 1);
+
+        std::fs::remove_dir_all(&dir).unwrap();
+    }
+
+    #[test]
+    fn test_dcmi_metrics_and_health() {
+        let device = test_device();
+
+        let record = DcmiRecord {
+            logic_id: 2,
+            valid: VALID_HEALTH | VALID_TEMPERATURE | VALID_HBM | VALID_ECC,
+            health: 3,
+            temperature: 61,
+            hbm_temperature: 48,
+            power_mw: 250_000,
+            aicore_util: 40,
+            hbm_total: 64 << 30,
+            hbm_used: 16 << 30,
+            ecc_single: 4,
+            ecc_double: 1,
+            ecc_single_total: 30,
+            ecc_double_total: 2,
+            ..Default::default()
+        };
+        let metrics = AscendDevice::dcmi_metrics(&record);
+        assert_eq!(metrics.temperature, 61);
+        assert_eq!(metrics.memory_utilization, 25);
+        assert_eq!(metrics.memory_free, 48 << 30);
+        assert_eq!(metrics.memory_temperature, Some(48));
+        assert_eq!(metrics.ecc_errors.single_bit, 4);
+        assert_eq!(metrics.ecc_errors.double_bit, 1);
+        assert_eq!(metrics.ecc_errors.single_bit_aggregate, 30);
+        assert_eq!(metrics.ecc_errors.double_bit_aggregate, 2);
+        // Fields DCMI did not report stay zero
+        assert_eq!(metrics.power_usage, 0);
+        assert_eq!(metrics.gpu_utilization, 0);
+
+        assert!(device.dcmi_health_to_error(0).is_none());
+        assert_eq!(
+            device.dcmi_health_to_error(1),
+            Some(AscendErrorCode::OverTemperature)
+        );
+        assert_eq!(
+            device.dcmi_health_to_error(3),
+            Some(AscendErrorCode::DeviceLost)
+        );
+
+        // Device nodes follow the physical ID once DCMI reports it
+        assert_eq!(AscendDevice::node_number(Some(&record), 2), 2);
+        let mapped = DcmiRecord {
+            valid: record.valid | VALID_PHY_ID,
+            phy_id: 5,
+            ..record
+        };
+        assert_eq!(AscendDevice::node_number(Some(&mapped), 2), 5);
+        assert_eq!(AscendDevice::node_number(None, 2), 2);
+    }
 }
@@ -0,0 +1,355 @@
+//! DCMI telemetry from the npu-collect helper
+//!
+//! npu-collect reads every NPU through the DCMI C API in one pass and, with
+//! `-i`, stays resident writing one binary frame per pass to stdout.
+//! `DcmiCollector` keeps the helper running, decodes frames as they arrive
+//! and serves the latest record per NPU. When the helper is missing, has
+//! exited or its data is stale, callers fall back to npu-smi.
+//!
+//! Frame layout (little-endian), see npu-check/npu_collect.cpp:
+//! - header, 16 bytes: magic "GDNC", u16 version, u16 record count,
+//!   u64 unix time in milliseconds
+//! - one 72-byte record per chip
+
+use std::collections::HashMap;
+use std::path::PathBuf;
+use std::process::Stdio;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::{Arc, Mutex, RwLock};
+use std::time::{Duration, Instant};
+
+use tokio::io::{AsyncRead, AsyncReadExt};
+use tracing::{debug, info, warn};
+
+use crate::overhead;
+
+/// Default npu-collect install path
+pub const DEFAULT_COLLECTOR_PATH: &str = "/usr/local/bin/npu-collect";
+
+const FRAME_MAGIC: u32 = 0x434E_4447;
+const FRAME_VERSION: u16 = 2;
+const HEADER_SIZE: usize = 16;
+const RECORD_SIZE: usize = 72;
+
+/// Minimum time between helper restarts
+const RESTART_BACKOFF: Duration = Duration::from_secs(30);
+
+/// Record field groups DCMI reported successfully
+pub const VALID_HEALTH: u32 = 1 << 0;
+pub const VALID_TEMPERATURE: u32 = 1 << 1;
+pub const VALID_POWER: u32 = 1 << 2;
+pub const VALID_AICORE: u32 = 1 << 3;
+pub const VALID_HBM: u32 = 1 << 4;
+pub const VALID_ECC: u32 = 1 << 5;
+pub const VALID_PHY_ID: u32 = 1 << 6;
+
+/// Telemetry for one NPU chip
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct DcmiRecord {
+    /// Logic ID (the NPU index used by npu-smi and AscendCL)
+    pub logic_id: u32,
+    pub card_id: u16,
+    pub chip_id: u16,
+    /// `VALID_*` flags
+    pub valid: u32,
+    /// 0 ok, 1 minor, 2 major, 3 critical
+    pub health: u32,
+    /// Chip temperature in Celsius
+    pub temperature: i32,
+    /// HBM temperature in Celsius
+    pub hbm_temperature: i32,
+    pub power_mw: u32,
+    /// AI Core utilization percentage
+    pub aicore_util: u32,
+    /// HBM size in bytes
+    pub hbm_total: u64,
+    /// HBM used in bytes
+    pub hbm_used: u64,
+    /// HBM single-bit ECC errors since driver load
+    pub ecc_single: u32,
+    /// HBM double-bit ECC errors since driver load
+    pub ecc_double: u32,
+    /// HBM double-bit ECC errors over the device lifetime
+    pub ecc_double_total: u32,
+    /// HBM bandwidth utilization percentage
+    pub hbm_bandwidth_util: u32,
+    /// Physical ID, the N in /dev/davinciN
+    pub phy_id: u32,
+    /// HBM single-bit ECC errors over the device lifetime
+    pub ecc_single_total: u32,
+}
+
+impl DcmiRecord {
+    /// Decode a record from its wire format
+    pub fn decode(buf: &[u8; RECORD_SIZE]) -> Self {
+        let u16_at = |o: usize| u16::from_le_bytes([buf[o], buf[o + 1]]);
+        let u32_at = |o: usize| u32::from_le_bytes(buf[o..o + 4].try_into().unwrap());
+        let u64_at = |o: usize| u64::from_le_bytes(buf[o..o + 8].try_into().unwrap());
+        Self {
+            logic_id: u32_at(0),
+            card_id: u16_at(4),
+            chip_id: u16_at(6),
+            valid: u32_at(8),
+            health: u32_at(12),
+            temperature: u32_at(16) as i32,
+            hbm_temperature: u32_at(20) as i32,
+            power_mw: u32_at(24),
+            aicore_util: u32_at(28),
+            hbm_total: u64_at(32),
+            hbm_used: u64_at(40),
+            ecc_single: u32_at(48),
+            ecc_double: u32_at(52),
+            ecc_double_total: u32_at(56),
+            hbm_bandwidth_util: u32_at(60),
+            phy_id: u32_at(64),
+            ecc_single_total: u32_at(68),
+        }
+    }
+
+    /// Whether DCMI reported the given field group
+    pub fn has(&self, flag: u32) -> bool {
+        self.valid & flag != 0
+    }
+}
+
+/// Read one frame from the helper
+async fn read_frame<R: AsyncRead + Unpin>(reader: &mut R) -> std::io::Result<Vec<DcmiRecord>> {
+    let mut header = [0u8; HEADER_SIZE];
+    reader.read_exact(&mut header).await?;
+
+    let magic = u32::from_le_bytes(header[0..4].try_into().unwrap());
+    let version = u16::from_le_bytes([header[4], header[5]]);
+    if magic != FRAME_MAGIC || version != FRAME_VERSION {
+        return Err(std::io::Error::new(
+            std::io::ErrorKind::InvalidData,
+            format!("unexpected frame header {:#x} v{}", magic, version),
+        ));
+    }
+
+    let count = u16::from_le_bytes([header[6], header[7]]) as usize;
+    let mut records = Vec::with_capacity(count);
+    let mut buf = [0u8; RECORD_SIZE];
+    for _ in 0..count {
+        reader.read_exact(&mut buf).await?;
+        records.push(DcmiRecord::decode(&buf));
+    }
+    Ok(records)
+}
+
+/// Latest frame received from the helper
+struct Frame {
+    received: Instant,
+    records: HashMap<u32, DcmiRecord>,
+}
+
+/// Keeps a resident npu-collect running and serves its latest records
+pub struct DcmiCollector {
+    path: PathBuf,
+    interval: Duration,
+    latest: Arc<RwLock<Option<Frame>>>,
+    running: Arc<AtomicBool>,
+    last_start: Mutex<Option<Instant>>,
+}
+
+impl DcmiCollector {
+    /// Create a collector for the helper at `path`, sampling every `interval`
+    ///
+    /// The helper is started on first use.
+    pub fn new(path: PathBuf, interval: Duration) -> Self {
+        Self {
+            path,
+            interval,
+            latest: Arc::new(RwLock::new(None)),
+            running: Arc::new(AtomicBool::new(false)),
+            last_start: Mutex::new(None),
+        }
+    }
+
+    /// Latest record for an NPU, or None without fresh data
+    pub fn record(&self, logic_id: u32) -> Option<DcmiRecord> {
+        self.ensure_running();
+
+        let latest = self.latest.read().unwrap_or_else(|e| e.into_inner());
+        let frame = latest.as_ref()?;
+        if frame.received.elapsed() > self.interval * 3 {
+            return None;
+        }
+        frame.records.get(&logic_id).cloned()
+    }
+
+    /// Start (or restart) the helper if it is not running
+    fn ensure_running(&self) {
+        if self.running.load(Ordering::Acquire) {
+            return;
+        }
+        let Ok(runtime) = tokio::runtime::Handle::try_current() else {
+            return;
+        };
+        {
+            let mut last_start = self.last_start.lock().unwrap_or_else(|e| e.into_inner());
+            if last_start.is_some_and(|t| t.elapsed() < RESTART_BACKOFF) {
+                return;
+            }
+            *last_start = Some(Instant::now());
+        }
+
+        let _guard = runtime.enter();
+        overhead::record_spawn();
+        let mut child = match tokio::process::Command::new(&self.path)
+            .arg("-i")
+            .arg(self.interval.as_millis().max(1).to_string())
+            .stdin(Stdio::null())
+            .stdout(Stdio::piped())
+            .kill_on_drop(true)
+            .spawn()
+        {
+            Ok(child) => child,
+            Err(e) => {
+                debug!(path = ?self.path, error = %e, "npu-collect unavailable, using npu-smi");
+                return;
+            }
+        };
+        let Some(mut stdout) = child.stdout.take() else {
+            return;
+        };
+
+        info!(path = ?self.path, interval = ?self.interval, "Started npu-collect");
+        self.running.store(true, Ordering::Release);
+        let latest = Arc::clone(&self.latest);
+        let running = Arc::clone(&self.running);
+        runtime.spawn(async move {
+            let error = loop {
+                match read_frame(&mut stdout).await {
+                    Ok(records) => {
+                        let records = records.into_iter().map(|r| (r.logic_id, r)).collect();
+                        *latest.write().unwrap_or_else(|e| e.into_inner()) = Some(Frame {
+                            received: Instant::now(),
+                            records,
+                        });
+                    }
+                    Err(e) => break e,
+                }
+            };
+
+            warn!(error = %error, "npu-collect stopped, falling back to npu-smi");
+            let _ = child.kill().await;
+            *latest.write().unwrap_or_else(|e| e.into_inner()) = None;
+            running.store(false, Ordering::Release);
+        });
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::os::unix::fs::PermissionsExt;
+
+    fn encode_frame(records: &[DcmiRecord]) -> Vec<u8> {
+        let mut out = Vec::new();
+        out.extend_from_slice(&FRAME_MAGIC.to_le_bytes());
+        out.extend_from_slice(&FRAME_VERSION.to_le_bytes());
+        out.extend_from_slice(&(records.len() as u16).to_le_bytes());
+        out.extend_from_slice(&1_700_000_000_000u64.to_le_bytes());
+        for r in records {
+            out.extend_from_slice(&r.logic_id.to_le_bytes());
+            out.extend_from_slice(&r.card_id.to_le_bytes());
+            out.extend_from_slice(&r.chip_id.to_le_bytes());
+            out.extend_from_slice(&r.valid.to_le_bytes());
+            out.extend_from_slice(&r.health.to_le_bytes());
+            out.extend_from_slice(&r.temperature.to_le_bytes());
+            out.extend_from_slice(&r.hbm_temperature.to_le_bytes());
+            out.extend_from_slice(&r.power_mw.to_le_bytes());
+            out.extend_from_slice(&r.aicore_util.to_le_bytes());
+            out.extend_from_slice(&r.hbm_total.to_le_bytes());
+            out.extend_from_slice(&r.hbm_used.to_le_bytes());
+            out.extend_from_slice(&r.ecc_single.to_le_bytes());
+            out.extend_from_slice(&r.ecc_double.to_le_bytes());
+            out.extend_from_slice(&r.ecc_double_total.to_le_bytes());
+            out.extend_from_slice(&r.hbm_bandwidth_util.to_le_bytes());
+            out.extend_from_slice(&r.phy_id.to_le_bytes());
+            out.extend_from_slice(&r.ecc_single_total.to_le_bytes());
+        }
+        out
+    }
+
+    fn record(logic_id: u32) -> DcmiRecord {
+        DcmiRecord {
+            logic_id,
+            card_id: logic_id as u16,
+            valid: VALID_HEALTH | VALID_TEMPERATURE | VALID_HBM | VALID_ECC | VALID_PHY_ID,
+            health: 3,
+            temperature: -5,
+            hbm_temperature: 52,
+            power_mw: 101_500,
+            aicore_util: 27,
+            hbm_total: 64 << 30,
+            hbm_used: 20 << 30,
+            ecc_double: 2,
+            ecc_single_total: 9,
+            phy_id: 7 - logic_id,
+            ..Default::default()
+        }
+    }
+
+    #[tokio::test]
+    async fn test_read_frame() {
+        let records = vec![record(0), record(7)];
+        let bytes = encode_frame(&records);
+        assert_eq!(bytes.len(), HEADER_SIZE + 2 * RECORD_SIZE);
+
+        let decoded = read_frame(&mut bytes.as_slice()).await.unwrap();
+        assert_eq!(decoded, records);
+        assert!(decoded[1].has(VALID_ECC));
+        assert!(!decoded[1].has(VALID_POWER));
+
+        let mut corrupt = bytes.clone();
+        corrupt[0] = 0;
+        assert!(read_frame(&mut corrupt.as_slice()).await.is_err());
+        // Truncated frames are an error, not a short read
+        assert!(read_frame(&mut &bytes[..40]).await.is_err());
+    }
+
+    #[tokio::test]
+    async fn test_resident_helper() {
+        let dir = std::env::temp_dir().join(format!("gdnd-npu-collect-{}", std::process::id()));
+        std::fs::create_dir_all(&dir).unwrap();
+        let frame = dir.join("frame.bin");
+        std::fs::write(&frame, encode_frame(&[record(3)])).unwrap();
+        let script = dir.join("npu-collect");
+        std::fs::write(
+            &script,
+            format!(
+                "#!/bin/sh\nwhile :; do cat {}; sleep 0.05; done\n",
+                frame.display()
+            ),
+        )
+        .unwrap();
+        std::fs::set_permissions(&script, std::fs::Permissions::from_mode(0o755)).unwrap();
+
+        let collector = DcmiCollector::new(script, Duration::from_millis(50));
+        assert!(collector.record(3).is_none());
+
+        let mut found = None;
+        for _ in 0..100 {
+            tokio::time::sleep(Duration::from_millis(20)).await;
+            found = collector.record(3);
+            if found.is_some() {
+                break;
+            }
+        }
+        assert_eq!(found, Some(record(3)));
+        assert!(collector.record(4).is_none());
+
+        std::fs::remove_dir_all(&dir).unwrap();
+    }
+
+    #[tokio::test]
+    async fn test_missing_helper() {
+        let collector = DcmiCollector::new(
+            PathBuf::from("/nonexistent/npu-collect"),
+            Duration::from_secs(1),
+        );
+        assert!(collector.record(0).is_none());
+        assert!(!collector.running.load(Ordering::Acquire));
+    }
+}
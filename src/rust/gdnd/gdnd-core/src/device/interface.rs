@@ -3,12 +3,16 @@
 //! Defines the core abstraction for GPU/NPU device operations.
 
 use std::fmt;
+use std::sync::Arc;
 use std::time::Duration;
 
 use async_trait::async_trait;
 use chrono::{DateTime, Utc};
 use serde::{Deserialize, Serialize};
 use thiserror::Error;
+use tokio::sync::mpsc;
+
+use super::ProcScanner;
 
 /// Device type enumeration
 #[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize, Default)]
@@ -55,6 +59,9 @@ impl fmt::Display for DeviceId {
 pub struct DeviceMetrics {
     /// GPU temperature in Celsius
     pub temperature: u32,
+    /// Memory (HBM) temperature in Celsius (if available)
+    #[serde(default)]
+    pub memory_temperature: Option<u32>,
     /// GPU utilization percentage (0-100)
     pub gpu_utilization: u32,
     /// Memory utilization percentage (0-100)
@@ -82,10 +89,16 @@ pub struct DeviceMetrics {
 /// ECC error counts
 #[derive(Debug, Clone, Default, Serialize, Deserialize)]
 pub struct EccErrors {
-    /// Single-bit correctable errors
+    /// Single-bit correctable errors since the last driver load
     pub single_bit: u64,
-    /// Double-bit uncorrectable errors
+    /// Double-bit uncorrectable errors since the last driver load
     pub double_bit: u64,
+    /// Single-bit correctable errors over the device lifetime
+    #[serde(default)]
+    pub single_bit_aggregate: u64,
+    /// Double-bit uncorrectable errors over the device lifetime
+    #[serde(default)]
+    pub double_bit_aggregate: u64,
 }
 
 /// XID error from GPU
@@ -108,6 +121,82 @@ impl XidError {
     }
 }
 
+/// Asynchronous error event reported by the driver
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub enum DeviceEvent {
+    /// XID error
+    Xid(XidError),
+    /// Double-bit (uncorrectable) ECC error
+    DoubleBitEcc {
+        /// Device index that generated the error
+        device_index: u32,
+        /// Timestamp when the event was received
+        timestamp: DateTime<Utc>,
+    },
+}
+
+impl DeviceEvent {
+    /// Index of the device the event belongs to
+    pub fn device_index(&self) -> u32 {
+        match self {
+            DeviceEvent::Xid(xid) => xid.device_index,
+            DeviceEvent::DoubleBitEcc { device_index, .. } => *device_index,
+        }
+    }
+
+    /// Short event kind used as a metric label
+    pub fn kind(&self) -> &'static str {
+        match self {
+            DeviceEvent::Xid(_) => "xid",
+            DeviceEvent::DoubleBitEcc { .. } => "double_bit_ecc",
+        }
+    }
+}
+
+/// Prefix of machine-readable measurement lines printed by the check binaries
+const PROBE_METRIC_PREFIX: &str = "GDND_METRIC ";
+
+/// A named measurement reported by a check binary (phase timing or bandwidth)
+#[derive(Debug, Clone, PartialEq, Serialize, Deserialize)]
+pub struct ProbeMeasurement {
+    /// Measurement name (e.g. "kernel_ms", "h2d_gbps")
+    pub name: String,
+    /// Measured value
+    pub value: f64,
+}
+
+impl ProbeMeasurement {
+    /// Create a new measurement
+    pub fn new(name: impl Into<String>, value: f64) -> Self {
+        Self {
+            name: name.into(),
+            value,
+        }
+    }
+
+    /// Whether larger values are better (bandwidth) rather than worse (latency)
+    pub fn higher_is_better(&self) -> bool {
+        self.name.ends_with("_gbps")
+    }
+}
+
+/// Parse `GDND_METRIC <name> <value>` lines from check binary output
+///
+/// Lines that do not carry the prefix or fail to parse are ignored, so
+/// regular verbose output can be mixed in freely.
+pub fn parse_probe_measurements(output: &str) -> Vec<ProbeMeasurement> {
+    output
+        .lines()
+        .filter_map(|line| line.trim().strip_prefix(PROBE_METRIC_PREFIX))
+        .filter_map(|rest| {
+            let mut parts = rest.split_whitespace();
+            let name = parts.next()?;
+            let value = parts.next()?.parse::<f64>().ok()?;
+            value.is_finite().then(|| ProbeMeasurement::new(name, value))
+        })
+        .collect()
+}
+
 /// Result of an active check operation
 #[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct CheckResult {
@@ -119,6 +208,9 @@ pub struct CheckResult {
     pub error: Option<String>,
     /// Exit code from check binary (if applicable)
     pub exit_code: Option<i32>,
+    /// Measurements reported by the check binary (phase timings, bandwidth)
+    #[serde(default)]
+    pub measurements: Vec<ProbeMeasurement>,
 }
 
 impl CheckResult {
@@ -129,6 +221,7 @@ impl CheckResult {
             duration,
             error: None,
             exit_code: Some(0),
+            measurements: Vec::new(),
         }
     }
 
@@ -139,17 +232,14 @@ impl CheckResult {
             duration,
             error: Some(error),
             exit_code,
+            measurements: Vec::new(),
         }
     }
 
-    /// Create a timeout check result
-    pub fn timeout(timeout: Duration) -> Self {
-        Self {
-            passed: false,
-            duration: timeout,
-            error: Some("Check timed out".to_string()),
-            exit_code: None,
-        }
+    /// Attach measurements reported by the check binary
+    pub fn with_measurements(mut self, measurements: Vec<ProbeMeasurement>) -> Self {
+        self.measurements = measurements;
+        self
     }
 }
 
@@ -206,7 +296,8 @@ pub trait DeviceInterface: Send + Sync {
     /// Run an active check on the device
     ///
     /// This typically involves running a small computation to verify
-    /// the device is responsive and functioning correctly.
+    /// the device is responsive and functioning correctly. A check cut off
+    /// at `timeout` returns `DeviceError::Timeout`.
     async fn run_active_check(
         &self,
         device: &DeviceId,
@@ -216,6 +307,22 @@ pub trait DeviceInterface: Send + Sync {
     /// Get the device type
     fn device_type(&self) -> DeviceType;
 
+    /// Number of the device's node under /dev (N in /dev/nvidiaN)
+    ///
+    /// Defaults to the device index; backends whose node numbering differs
+    /// override it.
+    fn device_node(&self, device: &DeviceId) -> u32 {
+        device.index
+    }
+
+    /// Scanner tracking how long device holders have been in D state
+    ///
+    /// Shared with self-healing so it judges zombies by the same history as
+    /// the zombie check. None for backends that do not scan /proc.
+    fn proc_scanner(&self) -> Option<Arc<ProcScanner>> {
+        None
+    }
+
     /// Check if PCIe bandwidth test is supported
     fn supports_pcie_test(&self) -> bool {
         false
@@ -225,6 +332,14 @@ pub trait DeviceInterface: Send + Sync {
     async fn run_pcie_test(&self, _device: &DeviceId) -> Result<CheckResult, DeviceError> {
         Err(DeviceError::Other("PCIe test not supported".to_string()))
     }
+
+    /// Subscribe to driver error events (XID, ECC) on all devices
+    ///
+    /// Returns None when the device has no event source, in which case
+    /// `get_xid_errors` keeps polling. The stream ends when the source fails.
+    async fn subscribe_events(&self) -> Option<mpsc::Receiver<DeviceEvent>> {
+        None
+    }
 }
 
 #[cfg(test)]
@@ -274,9 +389,22 @@ mod tests {
         );
         assert!(!failure.passed);
         assert!(failure.error.is_some());
+    }
 
-        let timeout = CheckResult::timeout(Duration::from_secs(5));
-        assert!(!timeout.passed);
-        assert!(timeout.error.as_ref().unwrap().contains("timed out"));
+    #[test]
+    fn test_parse_probe_measurements() {
+        let output = "GPU Check: Testing device 0 with 5s timeout\n\
+                      GDND_METRIC init_ms 120.500\n\
+                      GDND_METRIC kernel_ms 0.042\n\
+                      GDND_METRIC h2d_gbps 24.100\n\
+                      GDND_METRIC broken\n\
+                      GDND_METRIC nan_ms NaN\n\
+                      GPU check passed successfully\n";
+
+        let measurements = parse_probe_measurements(output);
+        assert_eq!(measurements.len(), 3);
+        assert_eq!(measurements[0], ProbeMeasurement::new("init_ms", 120.5));
+        assert!(!measurements[1].higher_is_better());
+        assert!(measurements[2].higher_is_better());
     }
 }
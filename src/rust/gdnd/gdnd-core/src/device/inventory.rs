@@ -0,0 +1,323 @@
+//! Cached device inventory
+//!
+//! Enumerating devices is expensive on some backends (an npu-smi launch on
+//! Ascend, per-device NVML queries on NVIDIA) while the inventory itself
+//! almost never changes. `InventoryCache` wraps a device interface and keeps
+//! the last enumeration until something suggests it is stale:
+//!
+//! - the entries of the watched sysfs directories change (PCI hotplug,
+//!   driver bind/unbind, module reload)
+//! - `invalidate` is called, e.g. after a healing action
+//! - the inventory is older than the maximum age
+//!
+//! Devices are keyed by UUID (bus ID on Ascend). A device that was
+//! enumerated before but is missing after a refresh is kept in the
+//! inventory as lost, so the sweep still visits it and L1 can report it
+//! as fallen off the bus instead of it silently dropping out.
+//!
+//! The watched directories are listed on a blocking thread, at most once
+//! per `FINGERPRINT_INTERVAL`, so the per-device presence checks of an L1
+//! sweep share one listing. The maximum age is measured on tokio's clock,
+//! so a trace replay re-enumerates on its virtual clock.
+
+use std::collections::hash_map::DefaultHasher;
+use std::hash::{Hash, Hasher};
+use std::path::PathBuf;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::Arc;
+use std::time::Duration;
+
+use async_trait::async_trait;
+use tokio::sync::{mpsc, Mutex};
+use tokio::time::Instant;
+use tracing::{debug, warn};
+
+use super::{
+    CheckResult, DeviceError, DeviceEvent, DeviceId, DeviceInterface, DeviceMetrics, DeviceType,
+    ProcScanner, XidError,
+};
+
+/// Re-enumerate at least this often even without a sysfs change
+pub const DEFAULT_INVENTORY_MAX_AGE: Duration = Duration::from_secs(300);
+
+/// Shortest interval between listings of the watched directories
+const FINGERPRINT_INTERVAL: Duration = Duration::from_secs(5);
+
+/// sysfs directories whose entries change on hotplug or driver reload
+pub fn default_watch_paths(device_type: DeviceType) -> Vec<PathBuf> {
+    let mut paths = vec![PathBuf::from("/sys/bus/pci/devices")];
+    match device_type {
+        DeviceType::Nvidia => paths.push(PathBuf::from("/sys/bus/pci/drivers/nvidia")),
+        DeviceType::Ascend => {
+            paths.push(PathBuf::from("/sys/bus/pci/drivers/devdrv_device_driver"))
+        }
+        DeviceType::Auto => {}
+    }
+    paths
+}
+
+/// Stable identity of a device across enumerations
+fn device_key(device: &DeviceId) -> String {
+    match &device.uuid {
+        Some(uuid) => uuid.clone(),
+        None => format!("{}:{}", device.index, device.name),
+    }
+}
+
+#[derive(Default)]
+struct Inventory {
+    /// Devices found by the last enumeration
+    present: Vec<DeviceId>,
+    /// Devices enumerated earlier but missing since
+    lost: Vec<DeviceId>,
+    /// Watched directory fingerprint and time of the last enumeration
+    taken: Option<(u64, Instant)>,
+    /// Latest watched directory fingerprint and when it was taken
+    checked: Option<(u64, Instant)>,
+}
+
+/// Device interface decorator that caches `list_devices`
+pub struct InventoryCache {
+    inner: Arc<dyn DeviceInterface>,
+    watch: Arc<[PathBuf]>,
+    max_age: Duration,
+    invalidated: AtomicBool,
+    inventory: Mutex<Inventory>,
+}
+
+impl InventoryCache {
+    /// Wrap a device interface, watching the given sysfs directories
+    pub fn new(inner: Arc<dyn DeviceInterface>, watch: Vec<PathBuf>) -> Self {
+        Self {
+            inner,
+            watch: watch.into(),
+            max_age: DEFAULT_INVENTORY_MAX_AGE,
+            invalidated: AtomicBool::new(false),
+            inventory: Mutex::new(Inventory::default()),
+        }
+    }
+
+    /// Set how long an unchanged inventory is trusted
+    pub fn with_max_age(mut self, max_age: Duration) -> Self {
+        self.max_age = max_age;
+        self
+    }
+
+    /// Force re-enumeration on the next query
+    pub fn invalidate(&self) {
+        self.invalidated.store(true, Ordering::SeqCst);
+    }
+
+    /// Whether a device is still enumerated
+    ///
+    /// Revalidates the inventory first. Enumeration failures are not
+    /// treated as the device being gone.
+    pub async fn is_present(&self, device: &DeviceId) -> bool {
+        if let Err(e) = self.list_devices().await {
+            debug!(device = %device, error = %e, "Inventory refresh failed");
+            return true;
+        }
+        let key = device_key(device);
+        let inventory = self.inventory.lock().await;
+        !inventory.lost.iter().any(|d| device_key(d) == key)
+    }
+
+    /// Devices that have disappeared from the inventory
+    pub async fn lost_devices(&self) -> Vec<DeviceId> {
+        self.inventory.lock().await.lost.clone()
+    }
+
+    /// Fingerprint of the watched directories, re-listed when it is older
+    /// than `FINGERPRINT_INTERVAL`
+    async fn fingerprint(&self, inventory: &mut Inventory) -> u64 {
+        if let Some((fingerprint, at)) = inventory.checked {
+            if at.elapsed() < FINGERPRINT_INTERVAL {
+                return fingerprint;
+            }
+        }
+        let fingerprint = if self.watch.is_empty() {
+            0
+        } else {
+            let watch = Arc::clone(&self.watch);
+            // A failed listing reads as a change, forcing a re-enumeration
+            tokio::task::spawn_blocking(move || fingerprint(&watch))
+                .await
+                .unwrap_or(u64::MAX)
+        };
+        inventory.checked = Some((fingerprint, Instant::now()));
+        fingerprint
+    }
+}
+
+/// Hash of the watched directory listings
+fn fingerprint(watch: &[PathBuf]) -> u64 {
+    let mut hasher = DefaultHasher::new();
+    for path in watch {
+        path.hash(&mut hasher);
+        match std::fs::read_dir(path) {
+            Ok(entries) => {
+                let mut names: Vec<_> = entries
+                    .filter_map(|e| e.ok().map(|e| e.file_name()))
+                    .collect();
+                names.sort();
+                names.hash(&mut hasher);
+            }
+            // A missing driver directory (module unloaded) is a state too
+            Err(_) => 0u8.hash(&mut hasher),
+        }
+    }
+    hasher.finish()
+}
+
+#[async_trait]
+impl DeviceInterface for InventoryCache {
+    async fn list_devices(&self) -> Result<Vec<DeviceId>, DeviceError> {
+        // Holding the lock across enumeration makes concurrent callers share it
+        let mut inventory = self.inventory.lock().await;
+        let fingerprint = self.fingerprint(&mut inventory).await;
+        let fresh = inventory.taken.is_some_and(|(taken_fp, taken_at)| {
+            taken_fp == fingerprint && taken_at.elapsed() < self.max_age
+        });
+
+        if !fresh || self.invalidated.swap(false, Ordering::SeqCst) {
+            let present = match self.inner.list_devices().await {
+                Ok(present) => present,
+                Err(e) => {
+                    // Keep the old inventory and retry on the next query
+                    self.invalidate();
+                    return Err(e);
+                }
+            };
+
+            let keys: Vec<String> = present.iter().map(device_key).collect();
+            let previous = std::mem::take(&mut inventory.present);
+            inventory.lost.retain(|d| !keys.contains(&device_key(d)));
+            for device in previous {
+                if !keys.contains(&device_key(&device)) {
+                    warn!(device = %device, uuid = ?device.uuid, "Device missing from inventory");
+                    inventory.lost.push(device);
+                }
+            }
+
+            debug!(
+                devices = present.len(),
+                lost = inventory.lost.len(),
+                "Device inventory refreshed"
+            );
+            inventory.present = present;
+            inventory.taken = Some((fingerprint, Instant::now()));
+        }
+
+        let mut devices: Vec<DeviceId> = inventory
+            .present
+            .iter()
+            .chain(&inventory.lost)
+            .cloned()
+            .collect();
+        devices.sort_by_key(|d| d.index);
+        Ok(devices)
+    }
+
+    async fn get_metrics(&self, device: &DeviceId) -> Result<DeviceMetrics, DeviceError> {
+        self.inner.get_metrics(device).await
+    }
+
+    async fn get_xid_errors(&self, device: &DeviceId) -> Result<Vec<XidError>, DeviceError> {
+        self.inner.get_xid_errors(device).await
+    }
+
+    async fn check_zombie_processes(&self, device: &DeviceId) -> Result<Vec<u32>, DeviceError> {
+        self.inner.check_zombie_processes(device).await
+    }
+
+    async fn run_active_check(
+        &self,
+        device: &DeviceId,
+        timeout: Duration,
+    ) -> Result<CheckResult, DeviceError> {
+        self.inner.run_active_check(device, timeout).await
+    }
+
+    fn device_type(&self) -> DeviceType {
+        self.inner.device_type()
+    }
+
+    fn device_node(&self, device: &DeviceId) -> u32 {
+        self.inner.device_node(device)
+    }
+
+    fn proc_scanner(&self) -> Option<Arc<ProcScanner>> {
+        self.inner.proc_scanner()
+    }
+
+    fn supports_pcie_test(&self) -> bool {
+        self.inner.supports_pcie_test()
+    }
+
+    async fn run_pcie_test(&self, device: &DeviceId) -> Result<CheckResult, DeviceError> {
+        self.inner.run_pcie_test(device).await
+    }
+
+    async fn subscribe_events(&self) -> Option<mpsc::Receiver<DeviceEvent>> {
+        self.inner.subscribe_events().await
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::device::MockDevice;
+
+    fn cache(mock: &Arc<MockDevice>, watch: Vec<PathBuf>) -> InventoryCache {
+        InventoryCache::new(Arc::clone(mock) as Arc<dyn DeviceInterface>, watch)
+    }
+
+    #[tokio::test(start_paused = true)]
+    async fn test_inventory_is_cached_until_sysfs_changes() {
+        let dir = std::env::temp_dir().join(format!("gdnd-inventory-{}", std::process::id()));
+        std::fs::create_dir_all(&dir).unwrap();
+        std::fs::write(dir.join("0000:01:00.0"), "").unwrap();
+
+        let mock = Arc::new(MockDevice::with_device_count(4));
+        let inventory = cache(&mock, vec![dir.clone()]);
+
+        for _ in 0..3 {
+            assert_eq!(inventory.list_devices().await.unwrap().len(), 4);
+        }
+        assert_eq!(mock.list_count.load(Ordering::SeqCst), 1);
+
+        // Hotplug shows up as a new entry under the watched directory, once
+        // the directory is listed again
+        std::fs::write(dir.join("0000:02:00.0"), "").unwrap();
+        inventory.list_devices().await.unwrap();
+        assert_eq!(mock.list_count.load(Ordering::SeqCst), 1);
+        tokio::time::advance(FINGERPRINT_INTERVAL).await;
+        inventory.list_devices().await.unwrap();
+        assert_eq!(mock.list_count.load(Ordering::SeqCst), 2);
+
+        inventory.invalidate();
+        inventory.list_devices().await.unwrap();
+        assert_eq!(mock.list_count.load(Ordering::SeqCst), 3);
+
+        std::fs::remove_dir_all(&dir).unwrap();
+    }
+
+    #[tokio::test]
+    async fn test_missing_device_is_kept_as_lost() {
+        let mock = Arc::new(MockDevice::with_device_count(4));
+        let inventory = cache(&mock, Vec::new());
+        let devices = inventory.list_devices().await.unwrap();
+
+        mock.detach_device(2).await;
+        assert!(inventory.is_present(&devices[2]).await);
+
+        inventory.invalidate();
+        assert!(!inventory.is_present(&devices[2]).await);
+        assert!(inventory.is_present(&devices[1]).await);
+
+        // Still listed, so the sweep keeps reporting it
+        let listed = inventory.list_devices().await.unwrap();
+        assert_eq!(listed.len(), 4);
+        assert_eq!(inventory.lost_devices().await, vec![devices[2].clone()]);
+    }
+}
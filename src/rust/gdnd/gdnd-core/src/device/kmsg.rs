@@ -0,0 +1,517 @@
+//! Incremental kernel log reader
+//!
+//! Tails `/dev/kmsg` from a persisted sequence number so every kernel
+//! message is parsed exactly once, across polls and daemon restarts.
+//! NVIDIA XID records are attributed to a device by PCI bus ID,
+//! deduplicated, and queued per device until collected. The persisted
+//! position only moves past a record once its XIDs have been collected, so
+//! a restart in between re-reads them rather than losing them.
+//!
+//! Record format (see Documentation/ABI/testing/dev-kmsg):
+//! `<prio>,<seq>,<timestamp_us>,<flags>[,...];<message>`, optionally
+//! followed by continuation lines starting with a space.
+
+use std::collections::HashMap;
+use std::fs::{self, File, OpenOptions};
+use std::io::{self, Read};
+use std::os::unix::fs::OpenOptionsExt;
+use std::path::{Path, PathBuf};
+use std::sync::Mutex;
+use std::time::Duration;
+
+use chrono::{DateTime, Utc};
+use once_cell::sync::Lazy;
+use regex::Regex;
+use tracing::{debug, warn};
+
+use super::XidError;
+
+/// Kernel log device
+pub const DEFAULT_KMSG_PATH: &str = "/dev/kmsg";
+
+/// Where the last processed sequence number is persisted
+pub const DEFAULT_CURSOR_PATH: &str = "/var/lib/gdnd/kmsg.cursor";
+
+/// Identifies the current boot; sequence numbers restart on reboot
+const BOOT_ID_PATH: &str = "/proc/sys/kernel/random/boot_id";
+
+/// Repeats of the same XID on the same device within this window of the
+/// last reported one are dropped
+const DEFAULT_DEDUP_WINDOW: Duration = Duration::from_secs(60);
+
+/// Uncollected XIDs kept per device
+const MAX_PENDING_PER_DEVICE: usize = 256;
+
+/// NVIDIA XID log line: `NVRM: Xid (PCI:0000:3b:00): 79, pid=..., ...`
+static XID_REGEX: Lazy<Regex> =
+    Lazy::new(|| Regex::new(r"NVRM: Xid \(PCI:([0-9a-fA-F:.]+)\): (\d+),").unwrap());
+
+/// PCI address of a device (function number ignored)
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct PciAddress {
+    domain: u32,
+    bus: u8,
+    device: u8,
+}
+
+impl PciAddress {
+    /// Parse `domain:bus:device[.function]` as printed by the driver or NVML
+    ///
+    /// Accepts both `0000:3b:00` (kernel log) and `00000000:3B:00.0` (NVML).
+    pub fn parse(s: &str) -> Option<Self> {
+        let mut parts = s.trim().split(':');
+        let domain = u32::from_str_radix(parts.next()?, 16).ok()?;
+        let bus = u8::from_str_radix(parts.next()?, 16).ok()?;
+        let device = parts.next()?.split('.').next()?;
+        let device = u8::from_str_radix(device, 16).ok()?;
+        if parts.next().is_some() {
+            return None;
+        }
+        Some(Self {
+            domain,
+            bus,
+            device,
+        })
+    }
+}
+
+/// A single kernel log record
+#[derive(Debug, Clone, PartialEq)]
+struct KmsgRecord<'a> {
+    seq: u64,
+    timestamp_us: u64,
+    message: &'a str,
+}
+
+/// Parse a record header line; continuation lines yield None
+fn parse_record(line: &str) -> Option<KmsgRecord<'_>> {
+    if line.starts_with(' ') {
+        return None;
+    }
+    let (header, message) = line.split_once(';')?;
+    let mut fields = header.split(',');
+    let _prio = fields.next()?;
+    let seq = fields.next()?.parse().ok()?;
+    let timestamp_us = fields.next()?.parse().ok()?;
+    Some(KmsgRecord {
+        seq,
+        timestamp_us,
+        message,
+    })
+}
+
+/// Extract the PCI address and XID code from a kernel message
+fn parse_xid(message: &str) -> Option<(PciAddress, u32)> {
+    let cap = XID_REGEX.captures(message)?;
+    Some((PciAddress::parse(&cap[1])?, cap[2].parse().ok()?))
+}
+
+/// Mutable reader state
+struct ReaderState {
+    file: File,
+    /// Bytes of a record split across reads
+    partial: Vec<u8>,
+    /// Last processed sequence number
+    cursor: Option<u64>,
+    /// Last sequence number persisted to the cursor file
+    saved: Option<u64>,
+    /// Timestamp of the last reported record per (device index, XID code)
+    last_reported: HashMap<(u32, u32), u64>,
+    /// Uncollected XIDs per device index, with their record sequence numbers
+    pending: HashMap<u32, Vec<(u64, XidError)>>,
+}
+
+impl ReaderState {
+    /// Last sequence number whose XIDs have all been collected
+    fn consumed(&self) -> Option<u64> {
+        let oldest = self
+            .pending
+            .values()
+            .filter_map(|xids| xids.first())
+            .map(|&(seq, _)| seq)
+            .min();
+        match oldest {
+            Some(seq) => seq.checked_sub(1),
+            None => self.cursor,
+        }
+    }
+}
+
+/// Shared incremental reader for kernel XID records
+pub struct KmsgReader {
+    cursor_path: Option<PathBuf>,
+    boot_id: String,
+    boot_time: DateTime<Utc>,
+    devices: HashMap<PciAddress, u32>,
+    dedup_window: Duration,
+    state: Mutex<ReaderState>,
+}
+
+impl KmsgReader {
+    /// Open a kernel log (or fixture file) for incremental reading
+    ///
+    /// `devices` maps PCI addresses to device indices. Records up to the
+    /// sequence number saved at `cursor_path` for the current boot are
+    /// skipped.
+    pub fn open(
+        path: impl AsRef<Path>,
+        cursor_path: Option<PathBuf>,
+        devices: HashMap<PciAddress, u32>,
+    ) -> io::Result<Self> {
+        let file = OpenOptions::new()
+            .read(true)
+            .custom_flags(libc::O_NONBLOCK)
+            .open(path)?;
+
+        let boot_id = fs::read_to_string(BOOT_ID_PATH)
+            .map(|id| id.trim().to_string())
+            .unwrap_or_default();
+        let cursor = cursor_path
+            .as_deref()
+            .and_then(|p| load_cursor(p, &boot_id));
+
+        Ok(Self {
+            cursor_path,
+            boot_id,
+            boot_time: boot_time(),
+            devices,
+            dedup_window: DEFAULT_DEDUP_WINDOW,
+            state: Mutex::new(ReaderState {
+                file,
+                partial: Vec::new(),
+                cursor,
+                saved: cursor,
+                last_reported: HashMap::new(),
+                pending: HashMap::new(),
+            }),
+        })
+    }
+
+    /// Set the window within which repeated XIDs are dropped
+    pub fn with_dedup_window(mut self, window: Duration) -> Self {
+        self.dedup_window = window;
+        self
+    }
+
+    /// Last processed sequence number
+    pub fn cursor(&self) -> Option<u64> {
+        self.lock().cursor
+    }
+
+    /// Read all records appended since the last poll
+    ///
+    /// Returns the number of new XIDs queued.
+    pub fn poll(&self) -> io::Result<usize> {
+        let mut state = self.lock();
+        let mut queued = 0;
+        let mut buf = [0u8; 8192];
+
+        loop {
+            match state.file.read(&mut buf) {
+                Ok(0) => break,
+                Ok(n) => {
+                    state.partial.extend_from_slice(&buf[..n]);
+                    queued += self.drain_lines(&mut state);
+                }
+                Err(e) if e.kind() == io::ErrorKind::WouldBlock => break,
+                Err(e) if e.kind() == io::ErrorKind::Interrupted => continue,
+                // The ring buffer wrapped past our position; reading resumes
+                // at the oldest available record
+                Err(e) if e.raw_os_error() == Some(libc::EPIPE) => {
+                    warn!("Kernel log records were overwritten before they were read");
+                    state.partial.clear();
+                }
+                Err(e) => return Err(e),
+            }
+        }
+
+        self.persist(&mut state);
+        Ok(queued)
+    }
+
+    /// Collect the XIDs queued for a device
+    pub fn take(&self, device_index: u32) -> Vec<XidError> {
+        let mut state = self.lock();
+        let Some(xids) = state.pending.remove(&device_index) else {
+            return Vec::new();
+        };
+        self.persist(&mut state);
+        xids.into_iter().map(|(_, xid)| xid).collect()
+    }
+
+    /// Save the position up to which every XID has been collected
+    fn persist(&self, state: &mut ReaderState) {
+        let consumed = state.consumed();
+        if consumed == state.saved {
+            return;
+        }
+        if let (Some(path), Some(seq)) = (&self.cursor_path, consumed) {
+            if let Err(e) = save_cursor(path, &self.boot_id, seq) {
+                warn!(path = %path.display(), error = %e, "Failed to persist kmsg cursor");
+                return;
+            }
+        }
+        state.saved = consumed;
+    }
+
+    fn lock(&self) -> std::sync::MutexGuard<'_, ReaderState> {
+        self.state.lock().unwrap_or_else(|e| e.into_inner())
+    }
+
+    /// Process every complete line in the partial buffer
+    fn drain_lines(&self, state: &mut ReaderState) -> usize {
+        let Some(end) = state.partial.iter().rposition(|&b| b == b'\n') else {
+            return 0;
+        };
+        let complete: Vec<u8> = state.partial.drain(..=end).collect();
+        let text = String::from_utf8_lossy(&complete);
+
+        let mut queued = 0;
+        for record in text.lines().filter_map(parse_record) {
+            if state.cursor.is_some_and(|cursor| record.seq <= cursor) {
+                continue;
+            }
+            state.cursor = Some(record.seq);
+
+            if let Some((address, code)) = parse_xid(record.message) {
+                queued += self.queue_xid(state, &record, address, code);
+            }
+        }
+        queued
+    }
+
+    /// Attribute an XID to its device and queue it unless it is a repeat
+    fn queue_xid(
+        &self,
+        state: &mut ReaderState,
+        record: &KmsgRecord<'_>,
+        address: PciAddress,
+        code: u32,
+    ) -> usize {
+        let Some(&device_index) = self.devices.get(&address) else {
+            // Not one of our devices (or a board the map missed): reporting it
+            // on every device would isolate the whole node
+            warn!(
+                pci = ?address,
+                xid = code,
+                seq = record.seq,
+                "XID for unknown PCI address, not attributed to any device"
+            );
+            return 0;
+        };
+
+        let window_us = self.dedup_window.as_micros() as u64;
+        let last = state.last_reported.get(&(device_index, code));
+        if last.is_some_and(|&t| record.timestamp_us.saturating_sub(t) < window_us) {
+            debug!(
+                device = device_index,
+                xid = code,
+                seq = record.seq,
+                "Dropping repeated XID"
+            );
+            return 0;
+        }
+        state
+            .last_reported
+            .insert((device_index, code), record.timestamp_us);
+
+        let pending = state.pending.entry(device_index).or_default();
+        if pending.len() >= MAX_PENDING_PER_DEVICE {
+            pending.remove(0);
+        }
+        let timestamp = self.boot_time + chrono::Duration::microseconds(record.timestamp_us as i64);
+        pending.push((
+            record.seq,
+            XidError {
+                code,
+                message: record.message.to_string(),
+                timestamp,
+                device_index,
+            },
+        ));
+        1
+    }
+}
+
+/// Wall-clock time of boot, as used by kmsg timestamps
+fn boot_time() -> DateTime<Utc> {
+    let mut ts = libc::timespec {
+        tv_sec: 0,
+        tv_nsec: 0,
+    };
+    // SAFETY: clock_gettime only writes to the provided timespec
+    let uptime = if unsafe { libc::clock_gettime(libc::CLOCK_MONOTONIC, &mut ts) } == 0 {
+        chrono::Duration::seconds(ts.tv_sec as i64)
+            + chrono::Duration::nanoseconds(ts.tv_nsec as i64)
+    } else {
+        chrono::Duration::zero()
+    };
+    Utc::now() - uptime
+}
+
+/// Load the saved sequence number if it belongs to the current boot
+fn load_cursor(path: &Path, boot_id: &str) -> Option<u64> {
+    let content = fs::read_to_string(path).ok()?;
+    let (saved_boot, seq) = content.trim().split_once(' ')?;
+    if saved_boot != boot_id {
+        debug!("Kernel log cursor is from a previous boot, reading from the start");
+        return None;
+    }
+    seq.parse().ok()
+}
+
+/// Atomically persist the sequence number
+fn save_cursor(path: &Path, boot_id: &str, seq: u64) -> io::Result<()> {
+    let tmp = path.with_extension("tmp");
+    fs::write(&tmp, format!("{} {}\n", boot_id, seq))?;
+    fs::rename(&tmp, path)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const FIXTURE: &str = concat!(env!("CARGO_MANIFEST_DIR"), "/testdata/kmsg.txt");
+
+    fn fixture_devices() -> HashMap<PciAddress, u32> {
+        HashMap::from([
+            (PciAddress::parse("00000000:3B:00.0").unwrap(), 0),
+            (PciAddress::parse("00000000:86:00.0").unwrap(), 1),
+        ])
+    }
+
+    fn temp_path(name: &str) -> PathBuf {
+        std::env::temp_dir().join(format!("gdnd-kmsg-{}-{}", name, std::process::id()))
+    }
+
+    #[test]
+    fn test_parse_pci_address() {
+        assert_eq!(
+            PciAddress::parse("0000:3b:00"),
+            PciAddress::parse("00000000:3B:00.0")
+        );
+        assert_ne!(
+            PciAddress::parse("0000:3b:00"),
+            PciAddress::parse("0000:86:00")
+        );
+        assert!(PciAddress::parse("3b:00").is_none());
+        assert!(PciAddress::parse("zz:3b:00").is_none());
+    }
+
+    #[test]
+    fn test_parse_record() {
+        let record =
+            parse_record("4,1202,5123500000,-;NVRM: Xid (PCI:0000:3b:00): 79, pid=1").unwrap();
+        assert_eq!(record.seq, 1202);
+        assert_eq!(record.timestamp_us, 5123500000);
+        assert_eq!(parse_xid(record.message).unwrap().1, 79);
+        assert!(parse_record(" DEVICE=+pci:0000:3b:00.0").is_none());
+        assert!(parse_xid("eth0: link up").is_none());
+    }
+
+    #[test]
+    fn test_fixture_attributed_and_deduplicated() {
+        let reader = KmsgReader::open(FIXTURE, None, fixture_devices()).unwrap();
+
+        assert_eq!(reader.poll().unwrap(), 3);
+        assert_eq!(reader.cursor(), Some(1206));
+
+        // The back-to-back XID 79 is reported once, on the right device
+        let gpu0: Vec<u32> = reader.take(0).iter().map(|x| x.code).collect();
+        assert_eq!(gpu0, vec![79]);
+        // Repeats further apart than the window are separate events
+        let gpu1: Vec<u32> = reader.take(1).iter().map(|x| x.code).collect();
+        assert_eq!(gpu1, vec![13, 13]);
+
+        // Nothing is re-reported
+        assert_eq!(reader.poll().unwrap(), 0);
+        assert!(reader.take(0).is_empty());
+    }
+
+    #[test]
+    fn test_cursor_survives_restart() {
+        let log = temp_path("log");
+        let cursor = temp_path("cursor");
+        let _ = fs::remove_file(&cursor);
+        fs::copy(FIXTURE, &log).unwrap();
+
+        let reader = KmsgReader::open(&log, Some(cursor.clone()), fixture_devices()).unwrap();
+        assert_eq!(reader.poll().unwrap(), 3);
+        reader.take(0);
+        reader.take(1);
+        drop(reader);
+
+        // A new record appended while the daemon was down
+        let mut content = fs::read_to_string(&log).unwrap();
+        content.push_str("4,1207,5300000000,-;NVRM: Xid (PCI:0000:3b:00): 48, pid=7, DBE\n");
+        fs::write(&log, content).unwrap();
+
+        let reader = KmsgReader::open(&log, Some(cursor.clone()), fixture_devices()).unwrap();
+        assert_eq!(reader.poll().unwrap(), 1);
+        let xids = reader.take(0);
+        assert_eq!(xids.len(), 1);
+        assert_eq!(xids[0].code, 48);
+        assert!(reader.take(1).is_empty());
+
+        fs::remove_file(&log).unwrap();
+        fs::remove_file(&cursor).unwrap();
+    }
+
+    #[test]
+    fn test_uncollected_xids_reread_after_restart() {
+        let cursor = temp_path("uncollected");
+        let _ = fs::remove_file(&cursor);
+
+        let reader = KmsgReader::open(FIXTURE, Some(cursor.clone()), fixture_devices()).unwrap();
+        assert_eq!(reader.poll().unwrap(), 3);
+        // Only device 0 collected before the restart
+        assert_eq!(reader.take(0).len(), 1);
+        drop(reader);
+
+        let reader = KmsgReader::open(FIXTURE, Some(cursor.clone()), fixture_devices()).unwrap();
+        assert_eq!(reader.poll().unwrap(), 2);
+        assert!(reader.take(0).is_empty());
+        assert_eq!(reader.take(1).len(), 2);
+        assert_eq!(load_cursor(&cursor, &reader.boot_id), Some(1206));
+
+        fs::remove_file(&cursor).unwrap();
+    }
+
+    #[test]
+    fn test_steady_repeats_reported_once_per_window() {
+        let log = temp_path("repeats");
+        // XID 13 every 30s for two minutes, against a 60s window
+        let content: String = (0..5)
+            .map(|i| {
+                format!(
+                    "4,{},{},-;NVRM: Xid (PCI:0000:86:00): 13, pid=1, SM Warp Exception\n",
+                    100 + i,
+                    i * 30_000_000
+                )
+            })
+            .collect();
+        fs::write(&log, content).unwrap();
+
+        let reader = KmsgReader::open(&log, None, fixture_devices()).unwrap();
+        assert_eq!(reader.poll().unwrap(), 3);
+        let seconds: Vec<i64> = reader
+            .take(1)
+            .iter()
+            .map(|x| (x.timestamp - reader.boot_time).num_seconds())
+            .collect();
+        assert_eq!(seconds, vec![0, 60, 120]);
+
+        fs::remove_file(&log).unwrap();
+    }
+
+    #[test]
+    fn test_unknown_pci_address_not_attributed() {
+        let devices = HashMap::from([(PciAddress::parse("0000:3b:00").unwrap(), 0)]);
+        let reader = KmsgReader::open(FIXTURE, None, devices).unwrap();
+        assert_eq!(reader.poll().unwrap(), 1);
+
+        // Device 86:00 is not in the map, so its XIDs are not pinned on device 0
+        let codes: Vec<u32> = reader.take(0).iter().map(|x| x.code).collect();
+        assert_eq!(codes, vec![79]);
+    }
+}
@@ -1,20 +1,26 @@
 //! Mock device implementation for testing
 
+use std::collections::HashMap;
 use std::sync::atomic::{AtomicBool, AtomicU32, Ordering};
+use std::sync::Mutex;
 use std::time::Duration;
 
 use async_trait::async_trait;
 use chrono::Utc;
-use tokio::sync::RwLock;
+use tokio::sync::{mpsc, RwLock};
 
 use super::{
-    CheckResult, DeviceError, DeviceId, DeviceInterface, DeviceMetrics, DeviceType, EccErrors,
-    XidError,
+    CheckResult, DeviceError, DeviceEvent, DeviceId, DeviceInterface, DeviceMetrics, DeviceType,
+    EccErrors, ProbeMeasurement, XidError,
 };
 
 /// Mock device for testing
 pub struct MockDevice {
     devices: Vec<DeviceId>,
+    /// Indices of devices that have fallen off the bus
+    detached: RwLock<Vec<u32>>,
+    /// Number of device enumerations
+    pub list_count: AtomicU32,
     /// Configurable failure simulation
     pub fail_active_check: AtomicBool,
     /// Configurable PCIe test failure simulation
@@ -23,8 +29,22 @@ pub struct MockDevice {
     xid_errors: RwLock<Vec<XidError>>,
     /// Simulated temperature
     pub temperature: AtomicU32,
+    /// Simulated GPU utilization
+    pub gpu_utilization: AtomicU32,
+    /// Number of active checks run
+    pub active_check_count: AtomicU32,
     /// Simulated zombie PIDs
     zombie_pids: RwLock<Vec<u32>>,
+    /// Simulated probe measurements reported by passing active checks
+    active_check_measurements: RwLock<Vec<ProbeMeasurement>>,
+    /// Simulated event stream, taken by the first subscriber
+    events: Mutex<Option<mpsc::Receiver<DeviceEvent>>>,
+    /// Device node numbers that differ from the device index
+    device_nodes: Mutex<HashMap<u32, u32>>,
+    /// Simulated latency of each metrics, XID and zombie query
+    query_latency: Duration,
+    /// Simulated duration of active checks and PCIe tests, if overridden
+    check_latency: Option<Duration>,
 }
 
 impl MockDevice {
@@ -45,11 +65,35 @@ impl MockDevice {
 
         Self {
             devices,
+            detached: RwLock::new(Vec::new()),
+            list_count: AtomicU32::new(0),
             fail_active_check: AtomicBool::new(false),
             fail_pcie_test: AtomicBool::new(false),
             xid_errors: RwLock::new(Vec::new()),
             temperature: AtomicU32::new(45),
+            gpu_utilization: AtomicU32::new(25),
+            active_check_count: AtomicU32::new(0),
             zombie_pids: RwLock::new(Vec::new()),
+            active_check_measurements: RwLock::new(Vec::new()),
+            events: Mutex::new(None),
+            device_nodes: Mutex::new(HashMap::new()),
+            query_latency: Duration::ZERO,
+            check_latency: None,
+        }
+    }
+
+    /// Simulate per-call latency: `query` for each metrics, XID and zombie
+    /// query, `check` for each active check and PCIe test
+    pub fn with_latency(mut self, query: Duration, check: Duration) -> Self {
+        self.query_latency = query;
+        self.check_latency = Some(check);
+        self
+    }
+
+    /// Wait out the simulated query latency
+    async fn query_delay(&self) {
+        if !self.query_latency.is_zero() {
+            tokio::time::sleep(self.query_latency).await;
         }
     }
 
@@ -85,6 +129,11 @@ impl MockDevice {
         self.temperature.store(temp, Ordering::SeqCst);
     }
 
+    /// Set simulated GPU utilization
+    pub fn set_gpu_utilization(&self, util: u32) {
+        self.gpu_utilization.store(util, Ordering::SeqCst);
+    }
+
     /// Add simulated zombie PID
     pub async fn add_zombie_pid(&self, pid: u32) {
         let mut pids = self.zombie_pids.write().await;
@@ -96,6 +145,34 @@ impl MockDevice {
         let mut pids = self.zombie_pids.write().await;
         pids.clear();
     }
+
+    /// Set simulated probe measurements for passing active checks
+    pub async fn set_active_check_measurements(&self, measurements: Vec<ProbeMeasurement>) {
+        let mut current = self.active_check_measurements.write().await;
+        *current = measurements;
+    }
+
+    /// Simulate a device whose /dev node number differs from its index
+    pub fn set_device_node(&self, index: u32, node: u32) {
+        self.device_nodes.lock().unwrap().insert(index, node);
+    }
+
+    /// Simulate a device falling off the bus (no longer enumerated)
+    pub async fn detach_device(&self, index: u32) {
+        self.detached.write().await.push(index);
+    }
+
+    /// Simulate a device being enumerated again (hotplug, driver reload)
+    pub async fn attach_device(&self, index: u32) {
+        self.detached.write().await.retain(|&i| i != index);
+    }
+
+    /// Enable simulated driver events, returning the sending side
+    pub fn enable_events(&self) -> mpsc::Sender<DeviceEvent> {
+        let (tx, rx) = mpsc::channel(16);
+        *self.events.lock().unwrap() = Some(rx);
+        tx
+    }
 }
 
 impl Default for MockDevice {
@@ -107,10 +184,18 @@ impl Default for MockDevice {
 #[async_trait]
 impl DeviceInterface for MockDevice {
     async fn list_devices(&self) -> Result<Vec<DeviceId>, DeviceError> {
-        Ok(self.devices.clone())
+        self.list_count.fetch_add(1, Ordering::SeqCst);
+        let detached = self.detached.read().await;
+        Ok(self
+            .devices
+            .iter()
+            .filter(|d| !detached.contains(&d.index))
+            .cloned()
+            .collect())
     }
 
     async fn get_metrics(&self, device: &DeviceId) -> Result<DeviceMetrics, DeviceError> {
+        self.query_delay().await;
         if device.index >= self.devices.len() as u32 {
             return Err(DeviceError::DeviceNotFound(format!(
                 "Device {} not found",
@@ -120,7 +205,8 @@ impl DeviceInterface for MockDevice {
 
         Ok(DeviceMetrics {
             temperature: self.temperature.load(Ordering::SeqCst),
-            gpu_utilization: 25,
+            memory_temperature: None,
+            gpu_utilization: self.gpu_utilization.load(Ordering::SeqCst),
             memory_utilization: 30,
             power_usage: 150,
             power_limit: 300,
@@ -135,6 +221,7 @@ impl DeviceInterface for MockDevice {
     }
 
     async fn get_xid_errors(&self, device: &DeviceId) -> Result<Vec<XidError>, DeviceError> {
+        self.query_delay().await;
         let errors = self.xid_errors.read().await;
         Ok(errors
             .iter()
@@ -144,6 +231,7 @@ impl DeviceInterface for MockDevice {
     }
 
     async fn check_zombie_processes(&self, _device: &DeviceId) -> Result<Vec<u32>, DeviceError> {
+        self.query_delay().await;
         let pids = self.zombie_pids.read().await;
         Ok(pids.clone())
     }
@@ -151,19 +239,27 @@ impl DeviceInterface for MockDevice {
     async fn run_active_check(
         &self,
         _device: &DeviceId,
-        _timeout: Duration,
+        timeout: Duration,
     ) -> Result<CheckResult, DeviceError> {
-        // Simulate some processing time
-        tokio::time::sleep(Duration::from_millis(10)).await;
+        self.active_check_count.fetch_add(1, Ordering::SeqCst);
+
+        // Simulate some processing time, cut off at the deadline
+        let duration = self.check_latency.unwrap_or(Duration::from_millis(10));
+        if duration > timeout {
+            tokio::time::sleep(timeout).await;
+            return Err(DeviceError::Timeout(timeout));
+        }
+        tokio::time::sleep(duration).await;
 
         if self.fail_active_check.load(Ordering::SeqCst) {
             Ok(CheckResult::failure(
-                Duration::from_millis(10),
+                duration,
                 "Mock active check failure".to_string(),
                 Some(1),
             ))
         } else {
-            Ok(CheckResult::success(Duration::from_millis(10)))
+            let measurements = self.active_check_measurements.read().await.clone();
+            Ok(CheckResult::success(duration).with_measurements(measurements))
         }
     }
 
@@ -171,22 +267,32 @@ impl DeviceInterface for MockDevice {
         DeviceType::Nvidia // Mock as NVIDIA for testing
     }
 
+    fn device_node(&self, device: &DeviceId) -> u32 {
+        let nodes = self.device_nodes.lock().unwrap();
+        nodes.get(&device.index).copied().unwrap_or(device.index)
+    }
+
+    async fn subscribe_events(&self) -> Option<mpsc::Receiver<DeviceEvent>> {
+        self.events.lock().unwrap().take()
+    }
+
     fn supports_pcie_test(&self) -> bool {
         true
     }
 
     async fn run_pcie_test(&self, _device: &DeviceId) -> Result<CheckResult, DeviceError> {
         // Simulate PCIe test
-        tokio::time::sleep(Duration::from_millis(100)).await;
+        let duration = self.check_latency.unwrap_or(Duration::from_millis(100));
+        tokio::time::sleep(duration).await;
 
         if self.fail_pcie_test.load(Ordering::SeqCst) {
             Ok(CheckResult::failure(
-                Duration::from_millis(100),
+                duration,
                 "PCIe bandwidth degradation detected: 4.5 GB/s (expected 12+ GB/s)".to_string(),
                 Some(1),
             ))
         } else {
-            Ok(CheckResult::success(Duration::from_millis(100)))
+            Ok(CheckResult::success(duration))
         }
     }
 }
@@ -234,6 +340,21 @@ mod tests {
         assert!(result.passed);
     }
 
+    #[tokio::test(start_paused = true)]
+    async fn test_mock_latency() {
+        let mock = MockDevice::with_device_count(3)
+            .with_latency(Duration::from_millis(5), Duration::from_millis(50));
+        let devices = mock.list_devices().await.unwrap();
+        let start = tokio::time::Instant::now();
+        mock.get_metrics(&devices[2]).await.unwrap();
+        assert_eq!(start.elapsed(), Duration::from_millis(5));
+        let result = mock
+            .run_active_check(&devices[2], Duration::from_secs(5))
+            .await
+            .unwrap();
+        assert_eq!(result.duration, Duration::from_millis(50));
+    }
+
     #[tokio::test]
     async fn test_mock_active_check_fail() {
         let mock = MockDevice::new();
@@ -3,32 +3,57 @@
 //! Provides a unified interface for different GPU/NPU devices.
 
 mod ascend;
+mod dcmi;
 mod interface;
+mod inventory;
+mod kmsg;
 mod mock;
+mod npu_smi;
 mod nvidia;
+mod procscan;
+mod slog;
+mod snapshot;
+mod trace;
 
 pub use ascend::AscendDevice;
+pub use dcmi::{DcmiCollector, DcmiRecord, DEFAULT_COLLECTOR_PATH};
 pub use interface::*;
+pub use inventory::{default_watch_paths, InventoryCache, DEFAULT_INVENTORY_MAX_AGE};
+pub use kmsg::{KmsgReader, PciAddress, DEFAULT_CURSOR_PATH, DEFAULT_KMSG_PATH};
 pub use mock::MockDevice;
+pub use npu_smi::{parse_info, NpuInfoRow, NpuInfoRows};
 pub use nvidia::NvidiaDevice;
+pub use procscan::{
+    device_node_prefix, holds_device, scan_once, DeviceHolder, ProcScan, ProcScanner,
+    ASCEND_NODE_PREFIX, DEFAULT_PROC_ROOT, DEFAULT_ZOMBIE_THRESHOLD, NVIDIA_NODE_PREFIX,
+};
+pub use slog::SlogTailer;
+pub use trace::{Trace, TraceEntry, TraceRecorder, TraceReplay, TraceResponse};
 
 use std::sync::Arc;
+use std::time::Duration;
 
 /// Create a device interface based on the device type
+///
+/// Device holders stuck in D state for `zombie_threshold` are reported as
+/// zombie processes.
 pub async fn create_device_interface(
     device_type: DeviceType,
+    zombie_threshold: Duration,
 ) -> Result<Arc<dyn DeviceInterface>, DeviceError> {
+    let nvidia = || NvidiaDevice::new().map(|d| d.with_zombie_threshold(zombie_threshold));
+    let ascend = || AscendDevice::new().map(|d| d.with_zombie_threshold(zombie_threshold));
     match device_type {
         DeviceType::Auto => {
             // Try NVIDIA first, then Ascend, then fall back to mock
-            match NvidiaDevice::new() {
+            match nvidia() {
                 Ok(device) => {
                     tracing::info!("Auto-detected NVIDIA device");
                     Ok(Arc::new(device))
                 }
                 Err(nvidia_err) => {
                     tracing::debug!(error = %nvidia_err, "NVIDIA device not available, trying Ascend");
-                    match AscendDevice::new() {
+                    match ascend() {
                         Ok(device) => {
                             tracing::info!("Auto-detected Ascend NPU device");
                             Ok(Arc::new(device))
@@ -46,11 +71,11 @@ pub async fn create_device_interface(
             }
         }
         DeviceType::Nvidia => {
-            let device = NvidiaDevice::new()?;
+            let device = nvidia()?;
             Ok(Arc::new(device))
         }
         DeviceType::Ascend => {
-            let device = AscendDevice::new()?;
+            let device = ascend()?;
             Ok(Arc::new(device))
         }
     }
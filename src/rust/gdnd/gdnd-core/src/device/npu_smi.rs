@@ -0,0 +1,226 @@
+//! Single-pass parser for `npu-smi info` tables
+//!
+//! Yields one row per NPU with its list entry and metrics, borrowing every
+//! string from the input. Cells are found by splitting on `|`, so column
+//! widths and spacing differences between npu-smi versions do not matter.
+//!
+//! ```text
+//! | NPU     Name              | Health        | Power(W)    Temp(C)           Hugepages-Usage(page)|
+//! | Chip                      | Bus-Id        | AICore(%)   Memory-Usage(MB)   HBM-Usage(MB)       |
+//! +===========================+===============+====================================================+
+//! | 0       910B3             | OK            | 112.5       37         0 / 0                       |
+//! | 0                         | 0000:C1:00.0  | 6           0 / 0              33551 / 65536       |
+//! ```
+//!
+//! Boards without HBM (310P) report device memory in the Memory-Usage
+//! column, which is used instead. Only the first chip row of a card is
+//! read, and parsing stops at the process table that newer versions append.
+
+/// One NPU from `npu-smi info`
+#[derive(Debug, Clone, Default, PartialEq)]
+pub struct NpuInfoRow<'a> {
+    /// NPU index
+    pub index: u32,
+    /// Device name (e.g. "910B3")
+    pub name: &'a str,
+    /// Health status (OK, Warning, Alarm, Critical, ...)
+    pub health: &'a str,
+    /// Bus ID of the first chip (e.g. "0000:C1:00.0")
+    pub bus_id: Option<&'a str>,
+    /// Power draw in W (None when npu-smi reports NA)
+    pub power: Option<f64>,
+    /// Temperature in Celsius
+    pub temperature: Option<u32>,
+    /// AI Core utilization percentage
+    pub aicore_util: Option<u32>,
+    /// HBM (or device memory) used in MB
+    pub hbm_used_mb: Option<u64>,
+    /// HBM (or device memory) total in MB
+    pub hbm_total_mb: Option<u64>,
+}
+
+/// Iterator over the NPUs in `npu-smi info` output
+pub struct NpuInfoRows<'a> {
+    lines: std::str::Lines<'a>,
+    pending: Option<NpuInfoRow<'a>>,
+    done: bool,
+}
+
+/// Parse `npu-smi info` output
+pub fn parse_info(output: &str) -> NpuInfoRows<'_> {
+    NpuInfoRows {
+        lines: output.lines(),
+        pending: None,
+        done: false,
+    }
+}
+
+/// Split a table line into its three cells
+fn cells(line: &str) -> Option<(&str, &str, &str)> {
+    let inner = line.trim().strip_prefix('|')?;
+    let mut cells = inner.split('|').map(str::trim);
+    Some((cells.next()?, cells.next()?, cells.next()?))
+}
+
+/// Parse "<index> <name>" from the first cell of a device row
+fn device_cell(cell: &str) -> Option<(u32, &str)> {
+    let mut parts = cell.split_whitespace();
+    let index = parts.next()?.parse().ok()?;
+    let name = parts.next()?;
+    // A chip row's second column is a device number, not a name
+    if name.bytes().all(|b| b.is_ascii_digit()) {
+        return None;
+    }
+    Some((index, name))
+}
+
+/// Whether a first cell is a chip row ("<chip> [<device>]")
+fn is_chip_cell(cell: &str) -> bool {
+    !cell.is_empty()
+        && cell
+            .split_whitespace()
+            .all(|p| p.bytes().all(|b| b.is_ascii_digit()))
+}
+
+/// Numbers in a usage cell, with "a / b", "a/ b" and "a/b" all read as two
+fn numbers(cell: &str) -> impl Iterator<Item = Option<u64>> + '_ {
+    cell.split(|c: char| c.is_whitespace() || c == '/')
+        .filter(|t| !t.is_empty())
+        .map(|t| t.parse().ok())
+}
+
+impl<'a> NpuInfoRows<'a> {
+    fn fill_chip(row: &mut NpuInfoRow<'a>, bus_id: &'a str, usage: &'a str) {
+        row.bus_id = Some(bus_id);
+        let mut values = numbers(usage);
+        row.aicore_util = values.next().flatten().map(|v| v as u32);
+        let rest: [Option<u64>; 4] = [
+            values.next().flatten(),
+            values.next().flatten(),
+            values.next().flatten(),
+            values.next().flatten(),
+        ];
+        (row.hbm_used_mb, row.hbm_total_mb) = match rest {
+            // Memory-Usage then HBM-Usage
+            [_, _, Some(used), Some(total)] => (Some(used), Some(total)),
+            // No HBM column: device memory
+            [Some(used), Some(total), None, None] => (Some(used), Some(total)),
+            _ => (None, None),
+        };
+    }
+}
+
+impl<'a> Iterator for NpuInfoRows<'a> {
+    type Item = NpuInfoRow<'a>;
+
+    fn next(&mut self) -> Option<NpuInfoRow<'a>> {
+        while !self.done {
+            let Some(line) = self.lines.next() else {
+                self.done = true;
+                break;
+            };
+            let Some((first, second, third)) = cells(line) else {
+                continue;
+            };
+
+            // Process table header: nothing after it describes devices
+            if second.starts_with("Process") {
+                self.done = true;
+                break;
+            }
+
+            if let Some((index, name)) = device_cell(first) {
+                let mut values = third.split_whitespace();
+                let row = NpuInfoRow {
+                    index,
+                    name,
+                    health: second.split_whitespace().next().unwrap_or(""),
+                    power: values.next().and_then(|v| v.parse().ok()),
+                    temperature: values.next().and_then(|v| v.parse().ok()),
+                    ..Default::default()
+                };
+                if let Some(previous) = self.pending.replace(row) {
+                    return Some(previous);
+                }
+                continue;
+            }
+
+            if is_chip_cell(first) && second.contains(':') {
+                if let Some(mut row) = self.pending.take() {
+                    Self::fill_chip(&mut row, second, third);
+                    return Some(row);
+                }
+            }
+        }
+        self.pending.take()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn fixture(name: &str) -> String {
+        let path = format!("{}/testdata/npu-smi/{}", env!("CARGO_MANIFEST_DIR"), name);
+        std::fs::read_to_string(path).unwrap()
+    }
+
+    #[test]
+    fn test_parse_910b() {
+        let output = fixture("910b-8npu-24.1.txt");
+        let rows: Vec<_> = parse_info(&output).collect();
+        // The process table after the devices is not parsed as devices
+        assert_eq!(rows.len(), 8);
+
+        assert_eq!(
+            rows[3],
+            NpuInfoRow {
+                index: 3,
+                name: "910B3",
+                health: "OK",
+                bus_id: Some("0000:02:00.0"),
+                power: Some(98.3),
+                temperature: Some(38),
+                aicore_util: Some(21),
+                hbm_used_mb: Some(61226),
+                hbm_total_mb: Some(65536),
+            }
+        );
+        assert_eq!(rows[6].health, "Warning");
+    }
+
+    #[test]
+    fn test_parse_across_versions() {
+        for (name, count) in [
+            ("910a-8npu-22.0.txt", 8),
+            ("910b-8npu-24.1.txt", 8),
+            ("310p-8npu-23.0.txt", 8),
+        ] {
+            let output = fixture(name);
+            let rows: Vec<_> = parse_info(&output).collect();
+            assert_eq!(rows.len(), count, "{}", name);
+            for (i, row) in rows.iter().enumerate() {
+                assert_eq!(row.index as usize, i, "{}", name);
+                assert!(row.bus_id.is_some(), "{}", name);
+                assert!(row.hbm_total_mb.is_some_and(|t| t > 0), "{}", name);
+            }
+        }
+
+        // 310P: power is NA and device memory stands in for HBM
+        let output = fixture("310p-8npu-23.0.txt");
+        let row = parse_info(&output).next().unwrap();
+        assert_eq!(row.power, None);
+        assert_eq!(row.hbm_used_mb, Some(1656));
+        assert_eq!(row.hbm_total_mb, Some(21527));
+    }
+
+    #[test]
+    fn test_device_without_chip_row() {
+        let output = "| 0       910B3  | OK  | 90.0  40  0 / 0 |\n\
+                      | 1       910B3  | OK  | 91.0  41  0 / 0 |\n";
+        let rows: Vec<_> = parse_info(output).collect();
+        assert_eq!(rows.len(), 2);
+        assert_eq!(rows[0].bus_id, None);
+        assert_eq!(rows[1].temperature, Some(41));
+    }
+}
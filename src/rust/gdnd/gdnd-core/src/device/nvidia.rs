@@ -1,22 +1,67 @@
 //! NVIDIA GPU device implementation
 //!
 //! Uses NVML (NVIDIA Management Library) for GPU monitoring.
+//!
+//! XID and double-bit ECC errors are delivered by an NVML event set on a
+//! dedicated thread. The kernel log is tailed incrementally as well, both as
+//! a fallback for devices that could not register for events and to keep its
+//! cursor current.
+//!
+//! Device handles (with name, UUID and power limit) are resolved once and
+//! reused; ECC and PCIe byte counters are read in one batched field-value
+//! query per cycle, and PCIe throughput is derived from successive samples.
+//! Processes holding `/dev/nvidiaN` open are found with one shared /proc scan.
 
-use std::sync::Arc;
-use std::time::Duration;
+use std::collections::{HashMap, HashSet};
+use std::path::PathBuf;
+use std::sync::{Arc, Mutex, RwLock};
+use std::time::{Duration, Instant};
 
 use async_trait::async_trait;
 use chrono::Utc;
+use nvml_wrapper::bitmasks::event::EventTypes;
 use nvml_wrapper::enum_wrappers::device::TemperatureSensor;
-use nvml_wrapper::Nvml;
+use nvml_wrapper::enums::device::SampleValue;
+use nvml_wrapper::error::NvmlError;
+use nvml_wrapper::structs::device::FieldId;
+use nvml_wrapper::sys_exports::field_id::{
+    NVML_FI_DEV_ECC_DBE_AGG_TOTAL, NVML_FI_DEV_ECC_DBE_VOL_TOTAL, NVML_FI_DEV_ECC_SBE_AGG_TOTAL,
+    NVML_FI_DEV_ECC_SBE_VOL_TOTAL, NVML_FI_DEV_PCIE_COUNT_RX_BYTES,
+    NVML_FI_DEV_PCIE_COUNT_TX_BYTES,
+};
+use nvml_wrapper::{Device, Nvml};
 use once_cell::sync::OnceCell;
-use regex::Regex;
-use tracing::{debug, trace, warn};
+use tokio::sync::{mpsc, oneshot};
+use tracing::{debug, info, trace, warn};
 
 use super::{
-    CheckResult, DeviceError, DeviceId, DeviceInterface, DeviceMetrics, DeviceType, EccErrors,
-    XidError,
+    parse_probe_measurements, CheckResult, DeviceError, DeviceEvent, DeviceId, DeviceInterface,
+    DeviceMetrics, DeviceType, EccErrors, KmsgReader, PciAddress, ProcScanner, XidError,
+    DEFAULT_CURSOR_PATH, DEFAULT_KMSG_PATH, DEFAULT_PROC_ROOT, DEFAULT_ZOMBIE_THRESHOLD,
+    NVIDIA_NODE_PREFIX,
 };
+use crate::overhead;
+
+/// Event types the listener registers for
+const WATCHED_EVENTS: EventTypes =
+    EventTypes::CRITICAL_XID_ERROR.union(EventTypes::DOUBLE_BIT_ECC_ERROR);
+
+/// How long a single event wait blocks before checking for shutdown
+const EVENT_WAIT_TIMEOUT_MS: u32 = 1000;
+
+/// Buffered events between the NVML thread and the scheduler
+const EVENT_CHANNEL_CAPACITY: usize = 256;
+
+/// Counters read per cycle: ECC in `EccErrors` field order, then PCIe
+/// TX and RX bytes
+const COUNTER_FIELDS: [FieldId; 6] = [
+    FieldId(NVML_FI_DEV_ECC_SBE_VOL_TOTAL),
+    FieldId(NVML_FI_DEV_ECC_DBE_VOL_TOTAL),
+    FieldId(NVML_FI_DEV_ECC_SBE_AGG_TOTAL),
+    FieldId(NVML_FI_DEV_ECC_DBE_AGG_TOTAL),
+    FieldId(NVML_FI_DEV_PCIE_COUNT_TX_BYTES),
+    FieldId(NVML_FI_DEV_PCIE_COUNT_RX_BYTES),
+];
 
 /// Global NVML instance
 static NVML: OnceCell<Arc<Nvml>> = OnceCell::new();
@@ -30,10 +75,58 @@ fn get_nvml() -> Result<&'static Arc<Nvml>, DeviceError> {
     })
 }
 
+/// A resolved NVML device handle and its static properties
+struct GpuHandle {
+    device: Device<'static>,
+    name: String,
+    uuid: Option<String>,
+    /// Power management limit in W
+    power_limit: u32,
+    /// N in /dev/nvidiaN (differs from the NVML index on some systems)
+    minor_number: u32,
+    /// Previous PCIe byte counters, for throughput
+    pcie_bytes: Mutex<Option<PcieBytes>>,
+}
+
+/// Cumulative PCIe byte counters at one point in time
+#[derive(Debug, Clone, Copy)]
+struct PcieBytes {
+    at: Instant,
+    tx: u64,
+    rx: u64,
+}
+
+impl PcieBytes {
+    /// TX and RX throughput in KB/s since an earlier sample
+    ///
+    /// None if no time passed or a counter went backwards (driver reload).
+    fn throughput_since(&self, earlier: &PcieBytes) -> Option<(u32, u32)> {
+        let secs = self.at.checked_duration_since(earlier.at)?.as_secs_f64();
+        if secs <= 0.0 {
+            return None;
+        }
+        let rate = |now: u64, then: u64| {
+            now.checked_sub(then)
+                .map(|bytes| (bytes as f64 / 1024.0 / secs).min(u32::MAX as f64) as u32)
+        };
+        Some((rate(self.tx, earlier.tx)?, rate(self.rx, earlier.rx)?))
+    }
+}
+
 /// NVIDIA GPU device implementation
 pub struct NvidiaDevice {
     nvml: &'static Arc<Nvml>,
     gpu_check_path: String,
+    /// Device handles by index, resolved on first use
+    handles: RwLock<HashMap<u32, Arc<GpuHandle>>>,
+    /// Devices whose XIDs the NVML event listener is currently delivering
+    event_devices: Arc<RwLock<HashSet<u32>>>,
+    /// Shared kernel log reader (None if /dev/kmsg is unreadable)
+    kmsg: Option<KmsgReader>,
+    /// Device-file holders, scanned once per cycle for all GPUs
+    procs: Arc<ProcScanner>,
+    /// Time in D state before a holder is reported as a zombie
+    zombie_threshold: Duration,
 }
 
 impl NvidiaDevice {
@@ -45,11 +138,115 @@ impl NvidiaDevice {
     /// Create a new NVIDIA device interface with custom gpu-check path
     pub fn with_gpu_check_path(gpu_check_path: String) -> Result<Self, DeviceError> {
         let nvml = get_nvml()?;
+        let kmsg = match KmsgReader::open(
+            DEFAULT_KMSG_PATH,
+            Some(PathBuf::from(DEFAULT_CURSOR_PATH)),
+            pci_device_map(nvml),
+        ) {
+            Ok(reader) => Some(reader),
+            Err(e) => {
+                warn!(error = %e, "Cannot read kernel log, XIDs limited to NVML events");
+                None
+            }
+        };
+
         Ok(Self {
             nvml,
             gpu_check_path,
+            handles: RwLock::new(HashMap::new()),
+            event_devices: Arc::new(RwLock::new(HashSet::new())),
+            kmsg,
+            procs: Arc::new(ProcScanner::new(DEFAULT_PROC_ROOT, NVIDIA_NODE_PREFIX)),
+            zombie_threshold: DEFAULT_ZOMBIE_THRESHOLD,
         })
     }
+
+    /// Set how long a holder must stay in D state to count as a zombie
+    pub fn with_zombie_threshold(mut self, threshold: Duration) -> Self {
+        self.zombie_threshold = threshold;
+        self
+    }
+}
+
+impl NvidiaDevice {
+    /// Get the cached handle for a device, resolving it on first use
+    fn handle(&self, index: u32) -> Result<Arc<GpuHandle>, NvmlError> {
+        if let Some(handle) = self.handles.read().unwrap_or_else(|e| e.into_inner()).get(&index) {
+            return Ok(Arc::clone(handle));
+        }
+
+        let nvml: &'static Nvml = self.nvml;
+        let device = nvml.device_by_index(index)?;
+        let handle = Arc::new(GpuHandle {
+            name: device.name()?,
+            uuid: device.uuid().ok(),
+            power_limit: device.power_management_limit().unwrap_or(0) / 1000, // mW to W
+            minor_number: device.minor_number().unwrap_or(index),
+            pcie_bytes: Mutex::new(None),
+            device,
+        });
+        self.handles
+            .write()
+            .unwrap_or_else(|e| e.into_inner())
+            .insert(index, Arc::clone(&handle));
+        Ok(handle)
+    }
+
+    /// Drop a cached handle so the next query resolves it again
+    fn evict(&self, index: u32) {
+        self.handles
+            .write()
+            .unwrap_or_else(|e| e.into_inner())
+            .remove(&index);
+    }
+}
+
+/// Read ECC and PCIe byte counters with one field-value query
+///
+/// PCIe counters are None on drivers without the byte count fields.
+fn read_counters(device: &Device) -> (EccErrors, Option<PcieBytes>) {
+    let mut counts: [Option<u64>; 6] = [None; 6];
+    match device.field_values_for(&COUNTER_FIELDS) {
+        Ok(samples) => {
+            for sample in samples.into_iter().flatten() {
+                let Some(slot) = COUNTER_FIELDS.iter().position(|f| *f == sample.field) else {
+                    continue;
+                };
+                counts[slot] = match sample.value {
+                    Ok(SampleValue::U64(v)) => Some(v),
+                    Ok(SampleValue::U32(v)) => Some(v as u64),
+                    Ok(SampleValue::I64(v)) => Some(v.max(0) as u64),
+                    // Disabled or not supported on this board
+                    _ => None,
+                };
+            }
+        }
+        Err(e) => trace!(error = %e, "Counter field values unavailable"),
+    }
+
+    let ecc = EccErrors {
+        single_bit: counts[0].unwrap_or(0),
+        double_bit: counts[1].unwrap_or(0),
+        single_bit_aggregate: counts[2].unwrap_or(0),
+        double_bit_aggregate: counts[3].unwrap_or(0),
+    };
+    let pcie = counts[4].zip(counts[5]).map(|(tx, rx)| PcieBytes {
+        at: Instant::now(),
+        tx,
+        rx,
+    });
+    (ecc, pcie)
+}
+
+/// Map each device's PCI address to its NVML index
+fn pci_device_map(nvml: &Nvml) -> HashMap<PciAddress, u32> {
+    let count = nvml.device_count().unwrap_or(0);
+    (0..count)
+        .filter_map(|index| {
+            let pci = nvml.device_by_index(index).ok()?.pci_info().ok()?;
+            Some((PciAddress::parse(&pci.bus_id)?, index))
+        })
+        .collect()
 }
 
 #[async_trait]
@@ -60,35 +257,35 @@ impl DeviceInterface for NvidiaDevice {
             .device_count()
             .map_err(|e| DeviceError::QueryError(e.to_string()))?;
 
-        let mut devices = Vec::with_capacity(count as usize);
-
-        for i in 0..count {
-            let device = self
-                .nvml
-                .device_by_index(i)
-                .map_err(|e| DeviceError::QueryError(e.to_string()))?;
-
-            let name = device
-                .name()
-                .map_err(|e| DeviceError::QueryError(e.to_string()))?;
-
-            let uuid = device.uuid().ok();
-
-            devices.push(DeviceId {
+        Ok(enumerate(count, |i| {
+            self.handle(i).map(|handle| DeviceId {
                 index: i,
-                uuid,
-                name,
-            });
-        }
-
-        Ok(devices)
+                uuid: handle.uuid.clone(),
+                name: handle.name.clone(),
+            })
+        }))
     }
 
     async fn get_metrics(&self, device: &DeviceId) -> Result<DeviceMetrics, DeviceError> {
-        let nvml_device = self
-            .nvml
-            .device_by_index(device.index)
+        let handle = self
+            .handle(device.index)
             .map_err(|e| DeviceError::DeviceNotFound(e.to_string()))?;
+        let nvml_device = &handle.device;
+
+        // Memory
+        let memory_info = match nvml_device.memory_info() {
+            Ok(info) => info,
+            Err(e) => {
+                // The handle may be stale (e.g. after a GPU reset)
+                if matches!(e, NvmlError::GpuLost) {
+                    self.evict(device.index);
+                }
+                return Err(DeviceError::QueryError(format!(
+                    "Failed to get memory info: {}",
+                    e
+                )));
+            }
+        };
 
         // Temperature
         let temperature = nvml_device
@@ -103,67 +300,54 @@ impl DeviceInterface for NvidiaDevice {
 
         // Power
         let power_usage = nvml_device.power_usage().unwrap_or(0) / 1000; // mW to W
-        let power_limit = nvml_device
-            .power_management_limit()
-            .unwrap_or(0)
-            / 1000;
 
-        // Memory
-        let memory_info = nvml_device.memory_info().map_err(|e| {
-            DeviceError::QueryError(format!("Failed to get memory info: {}", e))
-        })?;
-
-        // PCIe throughput
-        let pcie_tx = nvml_device.pcie_throughput(nvml_wrapper::enum_wrappers::device::PcieUtilCounter::Send).ok();
-        let pcie_rx = nvml_device.pcie_throughput(nvml_wrapper::enum_wrappers::device::PcieUtilCounter::Receive).ok();
-
-        // ECC errors - simplify handling as API varies by version
-        // For now, just return default. Full ECC support can be added later.
-        let ecc_errors = EccErrors::default();
+        // Volatile and aggregate ECC counters and PCIe bytes in one query
+        let (ecc_errors, pcie_bytes) = read_counters(nvml_device);
+        let pcie = pcie_bytes.and_then(|now| {
+            let mut last = handle.pcie_bytes.lock().unwrap_or_else(|e| e.into_inner());
+            last.replace(now)
+                .and_then(|earlier| now.throughput_since(&earlier))
+        });
 
         Ok(DeviceMetrics {
             temperature,
+            memory_temperature: None,
             gpu_utilization,
             memory_utilization,
             power_usage,
-            power_limit,
+            power_limit: handle.power_limit,
             memory_total: memory_info.total,
             memory_used: memory_info.used,
             memory_free: memory_info.free,
-            pcie_tx,
-            pcie_rx,
+            // From byte counters rather than nvmlDeviceGetPcieThroughput,
+            // which blocks ~20ms per read; None until the second sample
+            pcie_tx: pcie.map(|(tx, _)| tx),
+            pcie_rx: pcie.map(|(_, rx)| rx),
             ecc_errors,
             timestamp: Utc::now(),
         })
     }
 
     async fn get_xid_errors(&self, device: &DeviceId) -> Result<Vec<XidError>, DeviceError> {
-        // Parse dmesg for NVIDIA XID errors
-        // Format: NVRM: Xid (PCI:0000:xx:xx.0): XX, ...
-        let output = tokio::process::Command::new("dmesg")
-            .arg("-T")
-            .output()
-            .await
-            .map_err(DeviceError::IoError)?;
-
-        if !output.status.success() {
-            debug!("dmesg command failed, skipping XID scan");
+        let Some(kmsg) = &self.kmsg else {
             return Ok(Vec::new());
-        }
+        };
 
-        let dmesg = String::from_utf8_lossy(&output.stdout);
-        let xid_regex = Regex::new(r"NVRM: Xid \(PCI:([^)]+)\): (\d+),").unwrap();
-
-        let mut errors = Vec::new();
-        for cap in xid_regex.captures_iter(&dmesg) {
-            if let Ok(code) = cap[2].parse::<u32>() {
-                errors.push(XidError {
-                    code,
-                    message: get_xid_description(code),
-                    timestamp: Utc::now(), // Ideally parse from dmesg timestamp
-                    device_index: device.index,
-                });
-            }
+        // One shared reader: whichever device polls first picks up new
+        // records for all of them
+        if let Err(e) = kmsg.poll() {
+            debug!(error = %e, "Failed to read kernel log");
+        }
+        let errors = kmsg.take(device.index);
+
+        // Already delivered by the event listener
+        let delivered = self
+            .event_devices
+            .read()
+            .unwrap_or_else(|e| e.into_inner())
+            .contains(&device.index);
+        if delivered {
+            return Ok(Vec::new());
         }
 
         trace!(device = %device, count = errors.len(), "Found XID errors");
@@ -171,40 +355,22 @@ impl DeviceInterface for NvidiaDevice {
     }
 
     async fn check_zombie_processes(&self, device: &DeviceId) -> Result<Vec<u32>, DeviceError> {
-        // Find processes in D state (uninterruptible sleep) that are using GPU
-        let output = tokio::process::Command::new("nvidia-smi")
-            .args(["--query-compute-apps=pid", "--format=csv,noheader,nounits"])
-            .args(["-i", &device.index.to_string()])
-            .output()
-            .await
-            .map_err(DeviceError::IoError)?;
-
-        if !output.status.success() {
-            return Ok(Vec::new());
-        }
-
-        let pids: Vec<u32> = String::from_utf8_lossy(&output.stdout)
-            .lines()
-            .filter_map(|line| line.trim().parse().ok())
-            .collect();
+        // Find processes stuck in D state (uninterruptible sleep) holding the
+        // GPU open
+        let minor = self.device_node(device);
+        let scan = self.procs.scan().await?;
 
         let mut zombie_pids = Vec::new();
-
-        for pid in pids {
-            // Check process state
-            let stat_path = format!("/proc/{}/stat", pid);
-            if let Ok(stat) = tokio::fs::read_to_string(&stat_path).await {
-                let parts: Vec<&str> = stat.split_whitespace().collect();
-                if parts.len() > 2 {
-                    let state = parts[2];
-                    if state == "D" {
-                        warn!(pid = pid, device = %device, "Found zombie GPU process");
-                        zombie_pids.push(pid);
-                    }
-                }
-            }
+        for holder in scan.stuck_holders(minor, self.zombie_threshold) {
+            warn!(
+                pid = holder.pid,
+                comm = %holder.comm,
+                d_state_for = ?holder.d_state_for,
+                device = %device,
+                "Found zombie GPU process"
+            );
+            zombie_pids.push(holder.pid);
         }
-
         Ok(zombie_pids)
     }
 
@@ -216,11 +382,13 @@ impl DeviceInterface for NvidiaDevice {
         let start = std::time::Instant::now();
 
         // Run gpu-check binary with timeout
+        overhead::record_spawn();
         let result = tokio::time::timeout(
             timeout,
             tokio::process::Command::new(&self.gpu_check_path)
                 .arg("-d")
                 .arg(device.index.to_string())
+                .arg("-m")
                 .output(),
         )
         .await;
@@ -230,8 +398,10 @@ impl DeviceInterface for NvidiaDevice {
         match result {
             Ok(Ok(output)) => {
                 if output.status.success() {
+                    let measurements =
+                        parse_probe_measurements(&String::from_utf8_lossy(&output.stdout));
                     debug!(device = %device, duration = ?duration, "Active check passed");
-                    Ok(CheckResult::success(duration))
+                    Ok(CheckResult::success(duration).with_measurements(measurements))
                 } else {
                     let error = String::from_utf8_lossy(&output.stderr).to_string();
                     warn!(device = %device, error = %error, "Active check failed");
@@ -250,7 +420,7 @@ impl DeviceInterface for NvidiaDevice {
             Err(_) => {
                 // Timeout
                 warn!(device = %device, timeout = ?timeout, "Active check timed out");
-                Ok(CheckResult::timeout(timeout))
+                Err(DeviceError::Timeout(timeout))
             }
         }
     }
@@ -259,6 +429,15 @@ impl DeviceInterface for NvidiaDevice {
         DeviceType::Nvidia
     }
 
+    fn device_node(&self, device: &DeviceId) -> u32 {
+        self.handle(device.index)
+            .map_or(device.index, |handle| handle.minor_number)
+    }
+
+    fn proc_scanner(&self) -> Option<Arc<ProcScanner>> {
+        Some(Arc::clone(&self.procs))
+    }
+
     fn supports_pcie_test(&self) -> bool {
         true
     }
@@ -267,6 +446,7 @@ impl DeviceInterface for NvidiaDevice {
         // Run bandwidth test using cuda-samples bandwidthTest if available
         let start = std::time::Instant::now();
 
+        overhead::record_spawn();
         let result = tokio::process::Command::new("bandwidthTest")
             .arg("--device")
             .arg(device.index.to_string())
@@ -295,6 +475,159 @@ impl DeviceInterface for NvidiaDevice {
             }
         }
     }
+
+    async fn subscribe_events(&self) -> Option<mpsc::Receiver<DeviceEvent>> {
+        let nvml: &'static Nvml = self.nvml;
+        let (tx, rx) = mpsc::channel(EVENT_CHANNEL_CAPACITY);
+        let (ready_tx, ready_rx) = oneshot::channel();
+        let event_devices = Arc::clone(&self.event_devices);
+
+        // nvmlEventSetWait blocks, so it gets its own thread
+        let spawned = std::thread::Builder::new()
+            .name("gdnd-nvml-events".to_string())
+            .spawn(move || watch_events(nvml, tx, ready_tx, event_devices));
+        if let Err(e) = spawned {
+            warn!(error = %e, "Failed to start NVML event listener, polling dmesg for XIDs");
+            return None;
+        }
+
+        match ready_rx.await {
+            Ok(registered) if registered > 0 => {
+                info!(devices = registered, "Listening for NVML XID/ECC events");
+                Some(rx)
+            }
+            _ => {
+                info!("NVML events not supported, polling dmesg for XIDs");
+                None
+            }
+        }
+    }
+}
+
+/// NVML event listener thread
+///
+/// Registers every device for XID and double-bit ECC events, reports the
+/// number of registered devices through `ready`, then forwards events until
+/// the receiver is dropped or waiting fails. `event_devices` holds the
+/// registered indices while events flow; the others keep polling the
+/// kernel log.
+fn watch_events(
+    nvml: &'static Nvml,
+    tx: mpsc::Sender<DeviceEvent>,
+    ready: oneshot::Sender<u32>,
+    event_devices: Arc<RwLock<HashSet<u32>>>,
+) {
+    let mut set = match nvml.create_event_set() {
+        Ok(set) => set,
+        Err(e) => {
+            debug!(error = %e, "Failed to create NVML event set");
+            let _ = ready.send(0);
+            return;
+        }
+    };
+
+    let mut registered = HashSet::new();
+    for index in 0..nvml.device_count().unwrap_or(0) {
+        let Ok(device) = nvml.device_by_index(index) else {
+            continue;
+        };
+        match device.register_events(WATCHED_EVENTS, set) {
+            Ok(updated) => {
+                set = updated;
+                registered.insert(index);
+            }
+            Err(e) => {
+                debug!(device = index, error = %e.error, "Device does not support NVML events");
+                let Some(source) = e.source else {
+                    let _ = ready.send(0);
+                    return;
+                };
+                set = source;
+            }
+        }
+    }
+
+    let count = registered.len() as u32;
+    if count == 0 {
+        let _ = ready.send(0);
+        return;
+    }
+    *event_devices.write().unwrap_or_else(|e| e.into_inner()) = registered;
+    if ready.send(count).is_err() {
+        event_devices.write().unwrap_or_else(|e| e.into_inner()).clear();
+        return;
+    }
+
+    while !tx.is_closed() {
+        match set.wait(EVENT_WAIT_TIMEOUT_MS) {
+            Ok(data) => {
+                let Ok(device_index) = data.device.index() else {
+                    continue;
+                };
+                let Some(event) = to_device_event(device_index, data.event_type, data.event_data)
+                else {
+                    continue;
+                };
+                trace!(device = device_index, event = ?event, "NVML event");
+                if tx.blocking_send(event).is_err() {
+                    break;
+                }
+            }
+            Err(NvmlError::Timeout) => {}
+            Err(e) => {
+                warn!(error = %e, "NVML event wait failed, falling back to dmesg polling");
+                break;
+            }
+        }
+    }
+
+    event_devices.write().unwrap_or_else(|e| e.into_inner()).clear();
+}
+
+/// Convert a raw NVML event into a device event
+fn to_device_event(
+    device_index: u32,
+    event_type: EventTypes,
+    event_data: Option<u64>,
+) -> Option<DeviceEvent> {
+    let timestamp = Utc::now();
+    if event_type.contains(EventTypes::CRITICAL_XID_ERROR) {
+        // For XID events the event data carries the XID code
+        let code = event_data.unwrap_or(0) as u32;
+        Some(DeviceEvent::Xid(XidError {
+            code,
+            message: get_xid_description(code),
+            timestamp,
+            device_index,
+        }))
+    } else if event_type.contains(EventTypes::DOUBLE_BIT_ECC_ERROR) {
+        Some(DeviceEvent::DoubleBitEcc {
+            device_index,
+            timestamp,
+        })
+    } else {
+        None
+    }
+}
+
+/// Resolve each enumerated index, leaving out the ones that fail
+///
+/// A GPU that has fallen off the bus can still count towards the device
+/// count while its handle no longer resolves. Skipping it instead of failing
+/// the whole listing lets the inventory report it as lost.
+fn enumerate<E: std::fmt::Display>(
+    count: u32,
+    mut resolve: impl FnMut(u32) -> Result<DeviceId, E>,
+) -> Vec<DeviceId> {
+    (0..count)
+        .filter_map(|index| match resolve(index) {
+            Ok(device) => Some(device),
+            Err(e) => {
+                warn!(index = index, error = %e, "Failed to resolve GPU, leaving it out");
+                None
+            }
+        })
+        .collect()
 }
 
 /// Get human-readable description for XID error codes
@@ -334,4 +667,60 @@ mod tests {
         assert!(get_xid_description(79).contains("fallen off"));
         assert!(get_xid_description(9999).contains("Unknown"));
     }
+
+    #[test]
+    fn test_to_device_event() {
+        match to_device_event(3, EventTypes::CRITICAL_XID_ERROR, Some(79)) {
+            Some(DeviceEvent::Xid(xid)) => {
+                assert_eq!(xid.code, 79);
+                assert_eq!(xid.device_index, 3);
+            }
+            other => panic!("unexpected event: {:?}", other),
+        }
+        assert!(matches!(
+            to_device_event(1, EventTypes::DOUBLE_BIT_ECC_ERROR, None),
+            Some(DeviceEvent::DoubleBitEcc { device_index: 1, .. })
+        ));
+        assert!(to_device_event(0, EventTypes::PSTATE_CHANGE, None).is_none());
+    }
+
+    #[test]
+    fn test_enumerate_skips_unresolvable_devices() {
+        let devices = enumerate(4, |index| {
+            if index == 2 {
+                return Err(NvmlError::GpuLost);
+            }
+            Ok(DeviceId {
+                index,
+                uuid: Some(format!("GPU-{}", index)),
+                name: "H100".to_string(),
+            })
+        });
+        let indices: Vec<u32> = devices.iter().map(|d| d.index).collect();
+        assert_eq!(indices, [0, 1, 3]);
+    }
+
+    #[test]
+    fn test_pcie_throughput() {
+        let earlier = PcieBytes {
+            at: Instant::now(),
+            tx: 1 << 20,
+            rx: 0,
+        };
+        let later = PcieBytes {
+            at: earlier.at + Duration::from_secs(2),
+            tx: 5 << 20,
+            rx: 2 << 20,
+        };
+        assert_eq!(later.throughput_since(&earlier), Some((2048, 1024)));
+
+        // Counters reset with the driver
+        let reset = PcieBytes {
+            at: later.at + Duration::from_secs(2),
+            tx: 0,
+            rx: 0,
+        };
+        assert_eq!(reset.throughput_since(&later), None);
+        assert_eq!(earlier.throughput_since(&later), None);
+    }
 }
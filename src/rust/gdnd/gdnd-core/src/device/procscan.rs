@@ -0,0 +1,346 @@
+//! Single-pass /proc scan for accelerator device-file holders
+//!
+//! Instead of asking the vendor tool which processes use each device (one
+//! nvidia-smi / npu-smi launch per device, and no answer at all while the
+//! driver is wedged), walk `/proc/*/fd` once, map open `/dev/nvidiaN` or
+//! `/dev/davinciN` handles to device numbers, and read each holder's state
+//! from `/proc/<pid>/stat`. One scan answers every device in a cycle.
+//!
+//! How long a process has been in D state is tracked across scans, keyed by
+//! PID and start time so a reused PID starts over. Short D-state waits are
+//! routine I/O, so only holders stuck past a threshold count as zombies.
+
+use std::collections::HashMap;
+use std::path::{Path, PathBuf};
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant};
+
+use super::snapshot::SnapshotCache;
+use super::{DeviceError, DeviceType};
+
+/// Default procfs mount point
+pub const DEFAULT_PROC_ROOT: &str = "/proc";
+
+/// NVIDIA GPU device nodes: /dev/nvidiaN
+pub const NVIDIA_NODE_PREFIX: &str = "nvidia";
+
+/// Ascend NPU device nodes: /dev/davinciN
+pub const ASCEND_NODE_PREFIX: &str = "davinci";
+
+/// Device node prefix for a device type
+pub fn device_node_prefix(device_type: DeviceType) -> Option<&'static str> {
+    match device_type {
+        DeviceType::Nvidia => Some(NVIDIA_NODE_PREFIX),
+        DeviceType::Ascend => Some(ASCEND_NODE_PREFIX),
+        DeviceType::Auto => None,
+    }
+}
+
+/// How long one scan is shared across devices
+const DEFAULT_SCAN_TTL: Duration = Duration::from_secs(2);
+
+/// Default time in D state before a device holder counts as a zombie
+pub const DEFAULT_ZOMBIE_THRESHOLD: Duration = Duration::from_secs(60);
+
+/// A process holding a device file open
+#[derive(Debug, Clone, PartialEq)]
+pub struct DeviceHolder {
+    /// Process ID
+    pub pid: u32,
+    /// Command name from /proc/<pid>/stat
+    pub comm: String,
+    /// Process state letter (R, S, D, Z, ...)
+    pub state: char,
+    /// Time seen continuously in D state, if in D state now
+    pub d_state_for: Option<Duration>,
+}
+
+impl DeviceHolder {
+    /// Whether the process is in uninterruptible sleep
+    pub fn is_d_state(&self) -> bool {
+        self.state == 'D'
+    }
+}
+
+/// Device-file holders found by one scan, by device number
+#[derive(Debug, Default)]
+pub struct ProcScan {
+    holders: HashMap<u32, Vec<DeviceHolder>>,
+}
+
+impl ProcScan {
+    /// Processes holding a device open
+    pub fn holders(&self, device: u32) -> &[DeviceHolder] {
+        self.holders.get(&device).map_or(&[], Vec::as_slice)
+    }
+
+    /// PIDs holding a device open while in D state
+    pub fn d_state_pids(&self, device: u32) -> Vec<u32> {
+        self.holders(device)
+            .iter()
+            .filter(|h| h.is_d_state())
+            .map(|h| h.pid)
+            .collect()
+    }
+
+    /// Holders of a device seen continuously in D state for at least `min`
+    pub fn stuck_holders(
+        &self,
+        device: u32,
+        min: Duration,
+    ) -> impl Iterator<Item = &DeviceHolder> + '_ {
+        self.holders(device)
+            .iter()
+            .filter(move |h| h.d_state_for.is_some_and(|d| d >= min))
+    }
+}
+
+/// Fields of /proc/<pid>/stat used by the scan
+struct ProcStat {
+    comm: String,
+    state: char,
+    start_time: u64,
+}
+
+/// Parse /proc/<pid>/stat; comm may contain spaces and parentheses
+fn parse_stat(stat: &str) -> Option<ProcStat> {
+    let open = stat.find('(')?;
+    let close = stat.rfind(')')?;
+    let comm = stat.get(open + 1..close)?.to_string();
+    let mut fields = stat.get(close + 1..)?.split_whitespace();
+    let state = fields.next()?.chars().next()?;
+    // starttime is field 22; state was field 3
+    let start_time = fields.nth(18)?.parse().ok()?;
+    Some(ProcStat {
+        comm,
+        state,
+        start_time,
+    })
+}
+
+/// Device number of a `/dev/<prefix>N` link target
+fn device_number(target: &Path, prefix: &str) -> Option<u32> {
+    let name = target.strip_prefix("/dev").ok()?.to_str()?;
+    let number = name.strip_prefix(prefix)?;
+    // Control nodes (nvidiactl, nvidia-uvm, davinci_manager) are not devices
+    if number.is_empty() || !number.bytes().all(|b| b.is_ascii_digit()) {
+        return None;
+    }
+    number.parse().ok()
+}
+
+/// Devices a process holds open, deduplicated
+fn held_devices(proc_dir: &Path, prefix: &str) -> Vec<u32> {
+    let Ok(fds) = std::fs::read_dir(proc_dir.join("fd")) else {
+        // Exited, or not ours to inspect
+        return Vec::new();
+    };
+    let mut devices: Vec<u32> = fds
+        .filter_map(|fd| std::fs::read_link(fd.ok()?.path()).ok())
+        .filter_map(|target| device_number(&target, prefix))
+        .collect();
+    devices.sort_unstable();
+    devices.dedup();
+    devices
+}
+
+/// Walk `root` once and collect holders of `/dev/<prefix>N`
+///
+/// `d_since` carries first-seen D-state times between scans and is pruned
+/// to the processes still in D state.
+fn scan_proc(
+    root: &Path,
+    prefix: &str,
+    d_since: &mut HashMap<(u32, u64), Instant>,
+) -> std::io::Result<ProcScan> {
+    let now = Instant::now();
+    let mut scan = ProcScan::default();
+    let mut still_d = HashMap::new();
+
+    for entry in std::fs::read_dir(root)? {
+        let Ok(entry) = entry else { continue };
+        let Some(pid) = entry
+            .file_name()
+            .to_str()
+            .and_then(|n| n.parse::<u32>().ok())
+        else {
+            continue;
+        };
+        let devices = held_devices(&entry.path(), prefix);
+        if devices.is_empty() {
+            continue;
+        }
+        let Some(stat) = std::fs::read_to_string(entry.path().join("stat"))
+            .ok()
+            .and_then(|s| parse_stat(&s))
+        else {
+            continue;
+        };
+
+        let d_state_for = (stat.state == 'D').then(|| {
+            let key = (pid, stat.start_time);
+            let since = d_since.get(&key).copied().unwrap_or(now);
+            still_d.insert(key, since);
+            now - since
+        });
+        let holder = DeviceHolder {
+            pid,
+            comm: stat.comm,
+            state: stat.state,
+            d_state_for,
+        };
+        for device in devices {
+            scan.holders.entry(device).or_default().push(holder.clone());
+        }
+    }
+
+    *d_since = still_d;
+    Ok(scan)
+}
+
+/// Walk `root` once without D-state time tracking
+pub fn scan_once(root: &Path, prefix: &str) -> std::io::Result<ProcScan> {
+    scan_proc(root, prefix, &mut HashMap::new())
+}
+
+/// Whether a process currently holds `/dev/<prefix><device>` open
+pub fn holds_device(root: &Path, pid: u32, prefix: &str, device: u32) -> bool {
+    held_devices(&root.join(pid.to_string()), prefix).contains(&device)
+}
+
+/// Shared /proc scanner for one device file prefix
+pub struct ProcScanner {
+    root: PathBuf,
+    prefix: &'static str,
+    cache: SnapshotCache<ProcScan>,
+    d_since: Arc<Mutex<HashMap<(u32, u64), Instant>>>,
+}
+
+impl ProcScanner {
+    /// Scanner for `/dev/<prefix>N` holders under a procfs root
+    pub fn new(root: impl Into<PathBuf>, prefix: &'static str) -> Self {
+        Self {
+            root: root.into(),
+            prefix,
+            cache: SnapshotCache::new(DEFAULT_SCAN_TTL),
+            d_since: Arc::new(Mutex::new(HashMap::new())),
+        }
+    }
+
+    /// Set how long one scan is reused (zero scans on every call)
+    pub fn with_ttl(mut self, ttl: Duration) -> Self {
+        self.cache = SnapshotCache::new(ttl);
+        self
+    }
+
+    /// Walk /proc now, bypassing the shared snapshot, from a blocking context
+    pub fn scan_blocking(&self) -> std::io::Result<ProcScan> {
+        let mut d_since = self.d_since.lock().unwrap_or_else(|e| e.into_inner());
+        scan_proc(&self.root, self.prefix, &mut d_since)
+    }
+
+    /// Latest scan, walking /proc at most once per TTL
+    pub async fn scan(&self) -> Result<Arc<ProcScan>, DeviceError> {
+        self.cache
+            .get_or_refresh(|| async {
+                let root = self.root.clone();
+                let prefix = self.prefix;
+                let d_since = Arc::clone(&self.d_since);
+                tokio::task::spawn_blocking(move || {
+                    let mut d_since = d_since.lock().unwrap_or_else(|e| e.into_inner());
+                    scan_proc(&root, prefix, &mut d_since)
+                })
+                .await
+                .map_err(|e| DeviceError::Other(format!("/proc scan panicked: {}", e)))?
+                .map_err(DeviceError::IoError)
+            })
+            .await
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// Build a fake /proc entry with device-file links
+    fn fake_process(root: &Path, pid: u32, comm: &str, state: char, fds: &[&str]) {
+        let dir = root.join(pid.to_string());
+        std::fs::create_dir_all(dir.join("fd")).unwrap();
+        std::fs::write(
+            dir.join("stat"),
+            format!(
+                "{} ({}) {} 1 1 1 0 -1 4194560 100 0 0 0 10 5 0 0 20 0 4 0 12345 \
+                 1000000 200 18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 3 0 0 0 0 0\n",
+                pid, comm, state
+            ),
+        )
+        .unwrap();
+        for (fd, target) in fds.iter().enumerate() {
+            std::os::unix::fs::symlink(target, dir.join("fd").join(fd.to_string())).unwrap();
+        }
+    }
+
+    #[test]
+    fn test_parse_stat_with_odd_comm() {
+        let stat = parse_stat("42 (my (weird) proc) D 1 1 1 0 -1 0 0 0 0 0 0 0 0 0 20 0 1 0 777 0")
+            .unwrap();
+        assert_eq!(stat.comm, "my (weird) proc");
+        assert_eq!(stat.state, 'D');
+        assert_eq!(stat.start_time, 777);
+    }
+
+    #[tokio::test]
+    async fn test_scan_attributes_holders() {
+        let root = std::env::temp_dir().join(format!("gdnd-procscan-{}", std::process::id()));
+        // Start clean: a failed earlier run may have left processes behind
+        let _ = std::fs::remove_dir_all(&root);
+        fake_process(
+            &root,
+            100,
+            "python",
+            'S',
+            &["/dev/nvidia0", "/dev/nvidiactl", "/dev/null"],
+        );
+        fake_process(
+            &root,
+            200,
+            "train job",
+            'D',
+            &["/dev/nvidia1", "/dev/nvidia1", "/dev/nvidia-uvm"],
+        );
+        fake_process(&root, 300, "bash", 'D', &["/dev/pts/0"]);
+        fake_process(
+            &root,
+            400,
+            "npu",
+            'D',
+            &["/dev/davinci1", "/dev/davinci_manager"],
+        );
+        std::fs::create_dir_all(root.join("self")).unwrap();
+
+        let scanner = ProcScanner::new(&root, "nvidia").with_ttl(Duration::ZERO);
+        let scan = scanner.scan().await.unwrap();
+        assert_eq!(scan.holders(0).len(), 1);
+        assert_eq!(scan.holders(0)[0].comm, "python");
+        assert!(scan.d_state_pids(0).is_empty());
+        // Opened twice, listed once; processes without device files are ignored
+        assert_eq!(scan.d_state_pids(1), vec![200]);
+        assert!(scan.holders(2).is_empty());
+
+        // D-state time accumulates across scans
+        let first = scan.holders(1)[0].d_state_for.unwrap();
+        let min = first + Duration::from_millis(20);
+        assert_eq!(scan.stuck_holders(1, min).count(), 0);
+        std::thread::sleep(Duration::from_millis(20));
+        let scan = scanner.scan().await.unwrap();
+        assert!(scan.holders(1)[0].d_state_for.unwrap() >= min);
+        // Only long waits count as stuck
+        assert_eq!(scan.stuck_holders(1, min).map(|h| h.pid).collect::<Vec<_>>(), [200]);
+        assert_eq!(scan.stuck_holders(0, Duration::ZERO).count(), 0);
+
+        let davinci = ProcScanner::new(&root, "davinci").scan().await.unwrap();
+        assert_eq!(davinci.d_state_pids(1), vec![400]);
+
+        std::fs::remove_dir_all(&root).unwrap();
+    }
+}
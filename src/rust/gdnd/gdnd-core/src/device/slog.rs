@@ -0,0 +1,517 @@
+//! Incremental Ascend device-os log tailer
+//!
+//! Follows `<slog>/device-os-<id>/` with inotify and reads only the bytes
+//! appended to each file since the last poll. Offsets are tracked per inode,
+//! so renamed (rotated) files continue where they left off and truncated
+//! files restart from the beginning. Without inotify every file in the
+//! directory is stat'ed instead, which is still incremental.
+//!
+//! New bytes are matched once against a precompiled `RegexSet`; only chunks
+//! containing a match are split into lines. Error timestamps come from the
+//! log line itself.
+
+use std::collections::{HashMap, HashSet};
+use std::ffi::CString;
+use std::fs::{self, File};
+use std::io::{self, Read, Seek, SeekFrom};
+use std::os::fd::{AsRawFd, FromRawFd, OwnedFd};
+use std::os::unix::ffi::OsStrExt;
+use std::os::unix::fs::MetadataExt;
+use std::path::{Path, PathBuf};
+use std::sync::Mutex;
+use std::time::{Duration, SystemTime};
+
+use chrono::{DateTime, Local, NaiveDateTime, TimeZone, Utc};
+use once_cell::sync::Lazy;
+use regex::{Regex, RegexSet};
+use tracing::{debug, trace, warn};
+
+use super::ascend::AscendErrorCode;
+use super::XidError;
+
+/// Error patterns and the code each one reports (0 = take it from `ErrCode=`)
+const LOG_PATTERNS: [(&str, u32); 7] = [
+    (r"\[ERROR\].*HBM.*error", 1001),
+    (r"\[ERROR\].*AICore.*hang", 1002),
+    (r"\[ERROR\].*temperature", 1003),
+    (r"\[ERROR\].*PCIe.*link", 1005),
+    (r"\[ERROR\].*device.*lost", 1007),
+    (r"\[ERROR\].*ECC.*uncorrectable", 1008),
+    (r"ErrCode=(\d+)", 0),
+];
+
+static PATTERN_SET: Lazy<RegexSet> =
+    Lazy::new(|| RegexSet::new(LOG_PATTERNS.iter().map(|(p, _)| p)).unwrap());
+
+/// Index of the `ErrCode=` pattern in `LOG_PATTERNS`
+const ERR_CODE_PATTERN: usize = 6;
+
+static ERR_CODE: Lazy<Regex> =
+    Lazy::new(|| Regex::new(LOG_PATTERNS[ERR_CODE_PATTERN].0).unwrap());
+
+/// slog timestamp, e.g. `2024-03-18-09:41:07.512.331` (local time)
+static TIMESTAMP: Lazy<Regex> =
+    Lazy::new(|| Regex::new(r"\d{4}-\d{2}-\d{2}-\d{2}:\d{2}:\d{2}\.\d{3}").unwrap());
+
+/// Files last modified before this are skipped when a directory is first seen
+const DEFAULT_LOOKBACK: Duration = Duration::from_secs(86400);
+
+/// Bytes read from a file per chunk
+const READ_CHUNK: usize = 1 << 20;
+
+/// Directory events that may mean new data to read
+const WATCH_MASK: u32 = libc::IN_MODIFY
+    | libc::IN_CREATE
+    | libc::IN_CLOSE_WRITE
+    | libc::IN_MOVED_TO
+    | libc::IN_MOVED_FROM
+    | libc::IN_DELETE;
+
+/// Read position within one log file
+#[derive(Debug, Default)]
+struct FileState {
+    offset: u64,
+    /// Trailing bytes of an incomplete line
+    partial: Vec<u8>,
+}
+
+/// Mutable tailer state
+struct TailerState {
+    inotify: Option<OwnedFd>,
+    /// Watch descriptor -> device index
+    watches: HashMap<i32, u32>,
+    /// Devices whose directory has been scanned
+    known: HashSet<u32>,
+    /// Current path -> inode
+    paths: HashMap<PathBuf, u64>,
+    /// Read positions by inode
+    files: HashMap<u64, FileState>,
+    /// Files with unread data
+    dirty: HashSet<PathBuf>,
+}
+
+/// Shared incremental reader for Ascend device-os logs
+pub struct SlogTailer {
+    root: PathBuf,
+    lookback: Duration,
+    state: Mutex<TailerState>,
+}
+
+impl SlogTailer {
+    /// Create a tailer for a slog root (e.g. `/var/log/npu/slog`)
+    pub fn new(root: PathBuf) -> Self {
+        Self {
+            root,
+            lookback: DEFAULT_LOOKBACK,
+            state: Mutex::new(TailerState {
+                inotify: init_inotify(),
+                watches: HashMap::new(),
+                known: HashSet::new(),
+                paths: HashMap::new(),
+                files: HashMap::new(),
+                dirty: HashSet::new(),
+            }),
+        }
+    }
+
+    /// Only read files modified within `lookback` when a directory is first seen
+    pub fn with_lookback(mut self, lookback: Duration) -> Self {
+        self.lookback = lookback;
+        self
+    }
+
+    /// Log directory for a device
+    pub fn device_dir(&self, device_index: u32) -> PathBuf {
+        self.root.join(format!("device-os-{}", device_index))
+    }
+
+    /// Collect errors logged for a device since the last poll
+    ///
+    /// Errors are deduplicated by code, keeping the earliest occurrence.
+    pub fn poll(&self, device_index: u32) -> Vec<XidError> {
+        let dir = self.device_dir(device_index);
+        let mut state = self.state.lock().unwrap_or_else(|e| e.into_inner());
+
+        if !state.known.contains(&device_index) {
+            if !dir.is_dir() {
+                debug!(path = ?dir, "Device log directory not found");
+                return Vec::new();
+            }
+            self.start_watching(&mut state, device_index, &dir);
+        } else if state.inotify.is_none() {
+            mark_dir_dirty(&mut state, &dir);
+        }
+        drain_events(&mut state, self);
+
+        let dirty: Vec<PathBuf> = state
+            .dirty
+            .iter()
+            .filter(|p| p.parent() == Some(dir.as_path()))
+            .cloned()
+            .collect();
+
+        let mut errors = Vec::new();
+        for path in dirty {
+            state.dirty.remove(&path);
+            if let Err(e) = read_new(&mut state, &path, device_index, &mut errors) {
+                debug!(path = ?path, error = %e, "Failed to read device log");
+            }
+        }
+
+        errors.sort_by_key(|e| (e.code, e.timestamp));
+        errors.dedup_by_key(|e| e.code);
+        trace!(
+            device_index = device_index,
+            count = errors.len(),
+            "Found Ascend errors in logs"
+        );
+        errors
+    }
+
+    /// Watch a device directory and queue its recent files for reading
+    fn start_watching(&self, state: &mut TailerState, device_index: u32, dir: &Path) {
+        if let Some(fd) = &state.inotify {
+            match add_watch(fd, dir) {
+                Ok(wd) => {
+                    state.watches.insert(wd, device_index);
+                }
+                Err(e) => warn!(path = ?dir, error = %e, "Failed to watch device log directory"),
+            }
+        }
+
+        let Ok(entries) = fs::read_dir(dir) else {
+            return;
+        };
+        let now = SystemTime::now();
+        for entry in entries.flatten() {
+            let path = entry.path();
+            let Ok(meta) = entry.metadata() else {
+                continue;
+            };
+            if !meta.is_file() {
+                continue;
+            }
+
+            let recent = meta
+                .modified()
+                .map(|m| now.duration_since(m).unwrap_or_default() <= self.lookback)
+                .unwrap_or(true);
+            if recent {
+                state.dirty.insert(path);
+            } else {
+                // Old files: only bytes appended from now on are of interest
+                state.paths.insert(path, meta.ino());
+                state.files.entry(meta.ino()).or_default().offset = meta.len();
+            }
+        }
+        state.known.insert(device_index);
+    }
+}
+
+/// Create a non-blocking inotify instance
+fn init_inotify() -> Option<OwnedFd> {
+    // SAFETY: plain syscall, the returned descriptor is owned below
+    let fd = unsafe { libc::inotify_init1(libc::IN_NONBLOCK | libc::IN_CLOEXEC) };
+    if fd < 0 {
+        debug!(
+            error = %io::Error::last_os_error(),
+            "inotify unavailable, device logs will be polled"
+        );
+        return None;
+    }
+    // SAFETY: fd is a freshly created descriptor nobody else owns
+    Some(unsafe { OwnedFd::from_raw_fd(fd) })
+}
+
+/// Add an inotify watch on a directory
+fn add_watch(fd: &OwnedFd, dir: &Path) -> io::Result<i32> {
+    let path = CString::new(dir.as_os_str().as_bytes())
+        .map_err(|e| io::Error::new(io::ErrorKind::InvalidInput, e))?;
+    // SAFETY: path is a valid NUL-terminated string for the duration of the call
+    let wd = unsafe { libc::inotify_add_watch(fd.as_raw_fd(), path.as_ptr(), WATCH_MASK) };
+    if wd < 0 {
+        return Err(io::Error::last_os_error());
+    }
+    Ok(wd)
+}
+
+/// Mark every regular file in a directory as possibly changed
+fn mark_dir_dirty(state: &mut TailerState, dir: &Path) {
+    if let Ok(entries) = fs::read_dir(dir) {
+        state.dirty.extend(entries.flatten().map(|e| e.path()));
+    }
+}
+
+/// Apply all pending inotify events
+fn drain_events(state: &mut TailerState, tailer: &SlogTailer) {
+    let Some(fd) = state.inotify.as_ref().map(|fd| fd.as_raw_fd()) else {
+        return;
+    };
+    const HEADER: usize = std::mem::size_of::<libc::inotify_event>();
+    let mut buf = [0u8; 64 * 1024];
+
+    loop {
+        // SAFETY: reads into a buffer we own, bounded by its length
+        let n = unsafe { libc::read(fd, buf.as_mut_ptr().cast(), buf.len()) };
+        if n <= 0 {
+            break;
+        }
+        let n = n as usize;
+
+        let mut offset = 0;
+        while offset + HEADER <= n {
+            // SAFETY: the kernel wrote a complete event header at this offset
+            let event: libc::inotify_event =
+                unsafe { std::ptr::read_unaligned(buf[offset..].as_ptr().cast()) };
+            let name_end = (offset + HEADER + event.len as usize).min(n);
+            let name = &buf[offset + HEADER..name_end];
+            let name = &name[..name.iter().position(|&b| b == 0).unwrap_or(name.len())];
+            offset = name_end;
+
+            if event.mask & libc::IN_Q_OVERFLOW != 0 {
+                // Events were lost; re-check everything we know about
+                let devices: Vec<u32> = state.known.iter().copied().collect();
+                for device in devices {
+                    mark_dir_dirty(state, &tailer.device_dir(device));
+                }
+                continue;
+            }
+            let Some(&device) = state.watches.get(&event.wd) else {
+                continue;
+            };
+            if event.mask & libc::IN_IGNORED != 0 {
+                // Directory removed; rescan when it reappears
+                state.watches.remove(&event.wd);
+                state.known.remove(&device);
+                continue;
+            }
+            if name.is_empty() {
+                continue;
+            }
+
+            let path = tailer
+                .device_dir(device)
+                .join(std::ffi::OsStr::from_bytes(name));
+            if event.mask & libc::IN_DELETE != 0 {
+                if let Some(inode) = state.paths.remove(&path) {
+                    state.files.remove(&inode);
+                }
+                state.dirty.remove(&path);
+            } else if event.mask & libc::IN_MOVED_FROM != 0 {
+                // Keep the inode's offset in case it reappears under a new name
+                state.paths.remove(&path);
+                state.dirty.remove(&path);
+            } else {
+                state.dirty.insert(path);
+            }
+        }
+    }
+}
+
+/// Read and match everything appended to a file since the last read
+fn read_new(
+    state: &mut TailerState,
+    path: &Path,
+    device_index: u32,
+    errors: &mut Vec<XidError>,
+) -> io::Result<()> {
+    let meta = fs::metadata(path)?;
+    if !meta.is_file() {
+        return Ok(());
+    }
+    let inode = meta.ino();
+    if let Some(previous) = state.paths.insert(path.to_path_buf(), inode) {
+        if previous != inode {
+            // Replaced by a new file under the same name
+            state.files.remove(&previous);
+        }
+    }
+
+    let file_state = state.files.entry(inode).or_default();
+    if meta.len() < file_state.offset {
+        debug!(path = ?path, "Device log truncated, reading from the start");
+        file_state.offset = 0;
+        file_state.partial.clear();
+    }
+    if meta.len() == file_state.offset {
+        return Ok(());
+    }
+
+    let mut file = File::open(path)?;
+    file.seek(SeekFrom::Start(file_state.offset))?;
+    let mut reader = file.take(meta.len() - file_state.offset);
+    let mut chunk = vec![0u8; READ_CHUNK];
+
+    loop {
+        let n = reader.read(&mut chunk)?;
+        if n == 0 {
+            break;
+        }
+        file_state.offset += n as u64;
+
+        let data = &chunk[..n];
+        let Some(end) = data.iter().rposition(|&b| b == b'\n') else {
+            file_state.partial.extend_from_slice(data);
+            continue;
+        };
+
+        if file_state.partial.is_empty() {
+            scan_text(&data[..=end], device_index, errors);
+        } else {
+            file_state.partial.extend_from_slice(&data[..=end]);
+            let lines = std::mem::take(&mut file_state.partial);
+            scan_text(&lines, device_index, errors);
+        }
+        file_state.partial.extend_from_slice(&data[end + 1..]);
+    }
+    Ok(())
+}
+
+/// Match a block of complete lines against the error patterns
+///
+/// Each line reports at most one error: its explicit `ErrCode=` if present,
+/// otherwise the first keyword pattern it matches.
+pub fn scan_text(bytes: &[u8], device_index: u32, errors: &mut Vec<XidError>) {
+    let text = String::from_utf8_lossy(bytes);
+    // Error lines are rare: reject whole chunks with a single pass
+    if !PATTERN_SET.is_match(&text) {
+        return;
+    }
+
+    for line in text.lines() {
+        let matches = PATTERN_SET.matches(line);
+        let code = if matches.matched(ERR_CODE_PATTERN) {
+            ERR_CODE
+                .captures(line)
+                .and_then(|cap| cap[1].parse().ok())
+                .unwrap_or(9999)
+        } else if let Some(index) = matches.iter().next() {
+            LOG_PATTERNS[index].1
+        } else {
+            continue;
+        };
+        errors.push(XidError {
+            code,
+            message: AscendErrorCode::from_code(code).description().to_string(),
+            timestamp: parse_timestamp(line).unwrap_or_else(Utc::now),
+            device_index,
+        });
+    }
+}
+
+/// Parse the slog timestamp of a line
+fn parse_timestamp(line: &str) -> Option<DateTime<Utc>> {
+    let found = TIMESTAMP.find(line)?;
+    let naive = NaiveDateTime::parse_from_str(found.as_str(), "%Y-%m-%d-%H:%M:%S%.3f").ok()?;
+    Local
+        .from_local_datetime(&naive)
+        .earliest()
+        .map(|t| t.with_timezone(&Utc))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::io::Write;
+
+    fn temp_root(name: &str) -> PathBuf {
+        let root = std::env::temp_dir().join(format!("gdnd-slog-{}-{}", name, std::process::id()));
+        let _ = fs::remove_dir_all(&root);
+        fs::create_dir_all(root.join("device-os-0")).unwrap();
+        root
+    }
+
+    fn append(path: &Path, text: &str) {
+        let mut file = fs::OpenOptions::new()
+            .create(true)
+            .append(true)
+            .open(path)
+            .unwrap();
+        file.write_all(text.as_bytes()).unwrap();
+    }
+
+    const HBM_LINE: &str =
+        "[ERROR] DRV(1234,hbm):2024-03-18-09:41:07.512.331 [hbm.c:88] HBM multi-bit error\n";
+    const INFO_LINE: &str =
+        "[INFO] DRV(1234,drv):2024-03-18-09:41:08.000.000 [drv.c:12] heartbeat ok\n";
+
+    #[test]
+    fn test_scan_text() {
+        let mut errors = Vec::new();
+        let text = format!(
+            "{}{}[ERROR] TSCH(1,ts):2024-03-18-09:42:00.000.000 ErrCode=1007 aborted\n{}",
+            INFO_LINE,
+            HBM_LINE,
+            // Matches both the ECC keyword and ErrCode=; reported once
+            "[ERROR] DRV(1,hbm):2024-03-18-09:43:00.000.000 ECC uncorrectable ErrCode=1001\n",
+        );
+        scan_text(text.as_bytes(), 3, &mut errors);
+
+        let codes: Vec<u32> = errors.iter().map(|e| e.code).collect();
+        assert_eq!(codes, vec![1001, 1007, 1001]);
+        assert!(errors.iter().all(|e| e.device_index == 3));
+        let expected = Local
+            .with_ymd_and_hms(2024, 3, 18, 9, 41, 7)
+            .unwrap()
+            .with_timezone(&Utc)
+            + chrono::Duration::milliseconds(512);
+        assert_eq!(errors[0].timestamp, expected);
+    }
+
+    #[test]
+    fn test_incremental_reads() {
+        let root = temp_root("incremental");
+        let log = root.join("device-os-0").join("device-os_1.log");
+        append(&log, INFO_LINE);
+        append(&log, HBM_LINE);
+
+        let tailer = SlogTailer::new(root.clone());
+        assert_eq!(tailer.poll(0).len(), 1);
+        // Nothing new: nothing reported
+        assert!(tailer.poll(0).is_empty());
+
+        // A line split across writes is matched once complete
+        append(&log, "[ERROR] DRV(1,x):2024-03-18-10:00:00.000.000 AICore ");
+        assert!(tailer.poll(0).is_empty());
+        append(&log, "hang detected\n");
+        let errors = tailer.poll(0);
+        assert_eq!(errors.len(), 1);
+        assert_eq!(errors[0].code, 1002);
+
+        fs::remove_dir_all(&root).unwrap();
+    }
+
+    #[test]
+    fn test_rotation_and_truncation() {
+        let root = temp_root("rotation");
+        let dir = root.join("device-os-0");
+        let log = dir.join("device-os_1.log");
+        append(&log, HBM_LINE);
+
+        let tailer = SlogTailer::new(root.clone());
+        assert_eq!(tailer.poll(0).len(), 1);
+
+        // Rotate: the old file keeps its offset, the new one starts at zero
+        fs::rename(&log, dir.join("device-os_1.log.1")).unwrap();
+        append(&log, HBM_LINE);
+        assert_eq!(tailer.poll(0).len(), 1);
+
+        // Truncate in place
+        fs::write(&log, "").unwrap();
+        append(
+            &log,
+            "[ERROR] x:2024-03-18-11:00:00.000.000 PCIe link down\n",
+        );
+        let errors = tailer.poll(0);
+        assert_eq!(errors.len(), 1);
+        assert_eq!(errors[0].code, 1005);
+
+        fs::remove_dir_all(&root).unwrap();
+    }
+
+    #[test]
+    fn test_missing_directory() {
+        let tailer = SlogTailer::new(PathBuf::from("/nonexistent/slog"));
+        assert!(tailer.poll(0).is_empty());
+    }
+}
@@ -0,0 +1,98 @@
+//! Short-lived cache for expensive device queries
+//!
+//! Tool-based backends (npu-smi) answer every per-device question from the
+//! same node-wide query. A `SnapshotCache` keeps the parsed result for a
+//! short TTL so one sweep over N devices runs each query once, and callers
+//! arriving while a refresh is in flight wait for it instead of starting
+//! their own. Failed refreshes are not cached.
+
+use std::future::Future;
+use std::sync::Arc;
+use std::time::{Duration, Instant};
+
+use tokio::sync::Mutex;
+
+use super::DeviceError;
+
+/// Single-flight TTL cache for one query result
+pub struct SnapshotCache<T> {
+    ttl: Duration,
+    slot: Mutex<Option<(Instant, Arc<T>)>>,
+}
+
+impl<T> SnapshotCache<T> {
+    /// Create an empty cache; a zero TTL refreshes on every call
+    pub fn new(ttl: Duration) -> Self {
+        Self {
+            ttl,
+            slot: Mutex::new(None),
+        }
+    }
+
+    /// Get the cached value, refreshing it if missing or older than the TTL
+    pub async fn get_or_refresh<F, Fut>(&self, refresh: F) -> Result<Arc<T>, DeviceError>
+    where
+        F: FnOnce() -> Fut,
+        Fut: Future<Output = Result<T, DeviceError>>,
+    {
+        // Holding the lock across the refresh makes concurrent callers share it
+        let mut slot = self.slot.lock().await;
+        if let Some((taken_at, value)) = slot.as_ref() {
+            if taken_at.elapsed() < self.ttl {
+                return Ok(Arc::clone(value));
+            }
+        }
+
+        let value = Arc::new(refresh().await?);
+        *slot = Some((Instant::now(), Arc::clone(&value)));
+        Ok(value)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::atomic::{AtomicU32, Ordering};
+
+    #[tokio::test]
+    async fn test_concurrent_callers_share_one_refresh() {
+        let cache = Arc::new(SnapshotCache::new(Duration::from_secs(60)));
+        let calls = Arc::new(AtomicU32::new(0));
+
+        let mut tasks = Vec::new();
+        for _ in 0..16 {
+            let cache = Arc::clone(&cache);
+            let calls = Arc::clone(&calls);
+            tasks.push(tokio::spawn(async move {
+                cache
+                    .get_or_refresh(|| async {
+                        tokio::time::sleep(Duration::from_millis(20)).await;
+                        Ok(calls.fetch_add(1, Ordering::SeqCst))
+                    })
+                    .await
+                    .unwrap()
+            }));
+        }
+        for task in tasks {
+            assert_eq!(*task.await.unwrap(), 0);
+        }
+        assert_eq!(calls.load(Ordering::SeqCst), 1);
+    }
+
+    #[tokio::test]
+    async fn test_expiry_and_errors() {
+        let cache = SnapshotCache::new(Duration::ZERO);
+        let first = cache.get_or_refresh(|| async { Ok(1) }).await.unwrap();
+        let second = cache.get_or_refresh(|| async { Ok(2) }).await.unwrap();
+        assert_eq!((*first, *second), (1, 2));
+
+        // Failures are not cached
+        let cache = SnapshotCache::new(Duration::from_secs(60));
+        let failed = cache
+            .get_or_refresh(|| async { Err::<u32, _>(DeviceError::Other("boom".to_string())) })
+            .await;
+        assert!(failed.is_err());
+        let value = cache.get_or_refresh(|| async { Ok(3) }).await.unwrap();
+        assert_eq!(*value, 3);
+    }
+}
@@ -0,0 +1,605 @@
+//! Device trace recording and replay
+//!
+//! `TraceRecorder` wraps a device interface and appends every response
+//! (device list, metrics, XIDs, zombie PIDs, check results, driver events)
+//! to a file, one JSON object per line with a millisecond timestamp.
+//! Entries are serialized and written by a dedicated thread, so recording
+//! never blocks a detection check on file I/O.
+//!
+//! `TraceReplay` serves such a trace back as a device interface. Its clock
+//! is tokio's, so under a paused runtime a week of trace plays out as fast
+//! as the pipeline can process it. Each query returns the latest response
+//! recorded at or before the current trace time; XIDs return everything
+//! recorded since the previous query so none are lost when the replayed
+//! cadence differs from the recorded one.
+//!
+//! Lines with `"call":"fault"` mark when a device actually failed. The
+//! recorder never writes them; they are added from incident records and
+//! serve as ground truth when scoring a replay.
+
+use std::collections::HashMap;
+use std::fs::{File, OpenOptions};
+use std::io::{self, BufRead, BufReader, BufWriter, Write};
+use std::path::Path;
+use std::sync::{mpsc as std_mpsc, Arc, Mutex};
+use std::thread::JoinHandle;
+use std::time::Duration;
+
+use async_trait::async_trait;
+use chrono::Utc;
+use serde::{Deserialize, Serialize};
+use tokio::sync::mpsc;
+use tokio::time::Instant;
+use tracing::warn;
+
+use super::{
+    CheckResult, DeviceError, DeviceEvent, DeviceId, DeviceInterface, DeviceMetrics, DeviceType,
+    ProcScanner, XidError,
+};
+
+/// Capacity of the replayed event channel
+const EVENT_CHANNEL_CAPACITY: usize = 64;
+
+/// A recorded response
+#[derive(Debug, Clone, Serialize, Deserialize)]
+#[serde(tag = "call", content = "r", rename_all = "snake_case")]
+pub enum TraceResponse {
+    /// Recording started
+    Start(DeviceType),
+    /// `list_devices`
+    Devices(Result<Vec<DeviceId>, String>),
+    /// `get_metrics`
+    Metrics(Result<DeviceMetrics, String>),
+    /// `get_xid_errors`
+    Xids(Result<Vec<XidError>, String>),
+    /// `check_zombie_processes`
+    Zombies(Result<Vec<u32>, String>),
+    /// `run_active_check`
+    ActiveCheck(Result<CheckResult, String>),
+    /// `run_active_check` cut off at its deadline
+    ActiveCheckTimeout(Duration),
+    /// `run_pcie_test`
+    PcieTest(Result<CheckResult, String>),
+    /// Driver event
+    Event(DeviceEvent),
+    /// Ground truth: the device failed at this point
+    Fault,
+}
+
+impl TraceResponse {
+    fn call(&self) -> &'static str {
+        match self {
+            TraceResponse::Start(_) => "start",
+            TraceResponse::Devices(_) => "devices",
+            TraceResponse::Metrics(_) => "metrics",
+            TraceResponse::Xids(_) => "xids",
+            TraceResponse::Zombies(_) => "zombies",
+            TraceResponse::ActiveCheck(_) | TraceResponse::ActiveCheckTimeout(_) => "active_check",
+            TraceResponse::PcieTest(_) => "pcie_test",
+            TraceResponse::Event(_) => "event",
+            TraceResponse::Fault => "fault",
+        }
+    }
+}
+
+/// One line of a trace
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct TraceEntry {
+    /// Milliseconds since the Unix epoch
+    pub t: i64,
+    /// Device index, for per-device calls
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    pub d: Option<u32>,
+    /// Recorded response
+    #[serde(flatten)]
+    pub response: TraceResponse,
+}
+
+/// A loaded trace, ordered by time
+#[derive(Debug, Clone, Default)]
+pub struct Trace {
+    entries: Vec<TraceEntry>,
+}
+
+impl Trace {
+    /// Build a trace from entries
+    pub fn new(mut entries: Vec<TraceEntry>) -> Self {
+        entries.sort_by_key(|e| e.t);
+        Self { entries }
+    }
+
+    /// Load a trace file, skipping lines that do not parse
+    pub fn load<P: AsRef<Path>>(path: P) -> io::Result<Self> {
+        let path = path.as_ref();
+        let mut entries = Vec::new();
+        for (number, line) in BufReader::new(File::open(path)?).lines().enumerate() {
+            let line = line?;
+            if line.trim().is_empty() {
+                continue;
+            }
+            match serde_json::from_str(&line) {
+                Ok(entry) => entries.push(entry),
+                Err(e) => warn!(path = ?path, line = number + 1, error = %e, "Skipping trace line"),
+            }
+        }
+        Ok(Self::new(entries))
+    }
+
+    /// Recorded entries
+    pub fn entries(&self) -> &[TraceEntry] {
+        &self.entries
+    }
+
+    /// Time of the first entry
+    pub fn origin(&self) -> i64 {
+        self.entries.first().map_or(0, |e| e.t)
+    }
+
+    /// Time covered by the trace
+    pub fn span(&self) -> Duration {
+        let end = self.entries.last().map_or(0, |e| e.t);
+        Duration::from_millis((end - self.origin()).max(0) as u64)
+    }
+
+    /// Marked device failures as (device index, offset from the origin)
+    pub fn faults(&self) -> Vec<(u32, Duration)> {
+        let origin = self.origin();
+        self.entries
+            .iter()
+            .filter(|e| matches!(e.response, TraceResponse::Fault))
+            .filter_map(|e| Some((e.d?, Duration::from_millis((e.t - origin) as u64))))
+            .collect()
+    }
+}
+
+/// Handle to the thread that writes a trace file
+struct TraceWriter {
+    tx: Option<std_mpsc::Sender<TraceEntry>>,
+    thread: Option<JoinHandle<()>>,
+}
+
+impl TraceWriter {
+    fn spawn(file: File) -> io::Result<Self> {
+        let (tx, rx) = std_mpsc::channel();
+        let thread = std::thread::Builder::new()
+            .name("gdnd-trace".to_string())
+            .spawn(move || run_writer(BufWriter::new(file), rx))?;
+        Ok(Self {
+            tx: Some(tx),
+            thread: Some(thread),
+        })
+    }
+
+    /// Queue one entry, timestamped now
+    fn write(&self, device: Option<u32>, response: TraceResponse) {
+        let entry = TraceEntry {
+            t: Utc::now().timestamp_millis(),
+            d: device,
+            response,
+        };
+        if let Some(tx) = &self.tx {
+            if tx.send(entry).is_err() {
+                warn!("Device trace writer stopped, entry dropped");
+            }
+        }
+    }
+}
+
+impl Drop for TraceWriter {
+    fn drop(&mut self) {
+        // Closing the channel ends the thread once the queue is written
+        drop(self.tx.take());
+        if let Some(thread) = self.thread.take() {
+            let _ = thread.join();
+        }
+    }
+}
+
+/// Writer thread: append queued entries, flushing whenever the queue drains
+fn run_writer(mut out: BufWriter<File>, rx: std_mpsc::Receiver<TraceEntry>) {
+    while let Ok(entry) = rx.recv() {
+        let written = std::iter::once(entry)
+            .chain(rx.try_iter())
+            .try_for_each(|entry| {
+                serde_json::to_writer(&mut out, &entry)?;
+                out.write_all(b"\n")
+            })
+            .and_then(|()| out.flush());
+        if let Err(e) = written {
+            warn!(error = %e, "Failed to write device trace");
+        }
+    }
+}
+
+/// Response as recorded: data cloned, errors as text
+fn recorded<T: Clone>(result: &Result<T, DeviceError>) -> Result<T, String> {
+    result.as_ref().map(T::clone).map_err(ToString::to_string)
+}
+
+/// Device interface decorator that records every response
+pub struct TraceRecorder {
+    inner: Arc<dyn DeviceInterface>,
+    sink: Arc<TraceWriter>,
+}
+
+impl TraceRecorder {
+    /// Wrap a device interface, appending its responses to `path`
+    pub fn create<P: AsRef<Path>>(inner: Arc<dyn DeviceInterface>, path: P) -> io::Result<Self> {
+        let file = OpenOptions::new().create(true).append(true).open(path)?;
+        let sink = Arc::new(TraceWriter::spawn(file)?);
+        sink.write(None, TraceResponse::Start(inner.device_type()));
+        Ok(Self { inner, sink })
+    }
+
+    fn record(&self, device: &DeviceId, response: TraceResponse) {
+        self.sink.write(Some(device.index), response);
+    }
+}
+
+#[async_trait]
+impl DeviceInterface for TraceRecorder {
+    async fn list_devices(&self) -> Result<Vec<DeviceId>, DeviceError> {
+        let result = self.inner.list_devices().await;
+        self.sink.write(None, TraceResponse::Devices(recorded(&result)));
+        result
+    }
+
+    async fn get_metrics(&self, device: &DeviceId) -> Result<DeviceMetrics, DeviceError> {
+        let result = self.inner.get_metrics(device).await;
+        self.record(device, TraceResponse::Metrics(recorded(&result)));
+        result
+    }
+
+    async fn get_xid_errors(&self, device: &DeviceId) -> Result<Vec<XidError>, DeviceError> {
+        let result = self.inner.get_xid_errors(device).await;
+        self.record(device, TraceResponse::Xids(recorded(&result)));
+        result
+    }
+
+    async fn check_zombie_processes(&self, device: &DeviceId) -> Result<Vec<u32>, DeviceError> {
+        let result = self.inner.check_zombie_processes(device).await;
+        self.record(device, TraceResponse::Zombies(recorded(&result)));
+        result
+    }
+
+    async fn run_active_check(
+        &self,
+        device: &DeviceId,
+        timeout: Duration,
+    ) -> Result<CheckResult, DeviceError> {
+        let result = self.inner.run_active_check(device, timeout).await;
+        let response = match &result {
+            Err(DeviceError::Timeout(timeout)) => TraceResponse::ActiveCheckTimeout(*timeout),
+            result => TraceResponse::ActiveCheck(recorded(result)),
+        };
+        self.record(device, response);
+        result
+    }
+
+    fn device_type(&self) -> DeviceType {
+        self.inner.device_type()
+    }
+
+    fn device_node(&self, device: &DeviceId) -> u32 {
+        self.inner.device_node(device)
+    }
+
+    fn proc_scanner(&self) -> Option<Arc<ProcScanner>> {
+        self.inner.proc_scanner()
+    }
+
+    fn supports_pcie_test(&self) -> bool {
+        self.inner.supports_pcie_test()
+    }
+
+    async fn run_pcie_test(&self, device: &DeviceId) -> Result<CheckResult, DeviceError> {
+        let result = self.inner.run_pcie_test(device).await;
+        self.record(device, TraceResponse::PcieTest(recorded(&result)));
+        result
+    }
+
+    async fn subscribe_events(&self) -> Option<mpsc::Receiver<DeviceEvent>> {
+        let mut events = self.inner.subscribe_events().await?;
+        let (tx, rx) = mpsc::channel(EVENT_CHANNEL_CAPACITY);
+        let sink = Arc::clone(&self.sink);
+        tokio::spawn(async move {
+            while let Some(event) = events.recv().await {
+                sink.write(
+                    Some(event.device_index()),
+                    TraceResponse::Event(event.clone()),
+                );
+                if tx.send(event).await.is_err() {
+                    break;
+                }
+            }
+        });
+        Some(rx)
+    }
+}
+
+/// Device interface serving a recorded trace on tokio's clock
+pub struct TraceReplay {
+    start: Instant,
+    origin: i64,
+    device_type: DeviceType,
+    devices: Vec<(i64, Result<Vec<DeviceId>, String>)>,
+    /// Responses by (device index, call), in time order
+    responses: HashMap<(u32, &'static str), Vec<(i64, TraceResponse)>>,
+    events: Mutex<Vec<(i64, DeviceEvent)>>,
+    /// Time of the last XID query per device
+    xid_cursor: Mutex<HashMap<u32, i64>>,
+}
+
+impl TraceReplay {
+    /// Replay a trace; trace time starts now
+    pub fn new(trace: &Trace) -> Self {
+        let mut replay = Self {
+            start: Instant::now(),
+            origin: trace.origin(),
+            device_type: DeviceType::Auto,
+            devices: Vec::new(),
+            responses: HashMap::new(),
+            events: Mutex::new(Vec::new()),
+            xid_cursor: Mutex::new(HashMap::new()),
+        };
+        let events = replay.events.get_mut().unwrap_or_else(|e| e.into_inner());
+        for entry in trace.entries() {
+            match (&entry.response, entry.d) {
+                (TraceResponse::Start(device_type), _) => replay.device_type = *device_type,
+                (TraceResponse::Devices(devices), _) => {
+                    replay.devices.push((entry.t, devices.clone()))
+                }
+                (TraceResponse::Event(event), _) => events.push((entry.t, event.clone())),
+                (TraceResponse::Fault, _) | (_, None) => {}
+                (response, Some(device)) => replay
+                    .responses
+                    .entry((device, response.call()))
+                    .or_default()
+                    .push((entry.t, response.clone())),
+            }
+        }
+        replay
+    }
+
+    /// Current trace time
+    fn now(&self) -> i64 {
+        self.origin + self.start.elapsed().as_millis() as i64
+    }
+
+    /// Latest response for a device call at or before the current time
+    fn latest(&self, device: &DeviceId, call: &'static str) -> Option<&TraceResponse> {
+        let responses = self.responses.get(&(device.index, call))?;
+        let now = self.now();
+        let recorded = responses.partition_point(|(t, _)| *t <= now);
+        responses[..recorded].last().map(|(_, response)| response)
+    }
+}
+
+fn replayed<T>(result: &Result<T, String>) -> Result<T, DeviceError>
+where
+    T: Clone,
+{
+    result.clone().map_err(DeviceError::Other)
+}
+
+fn not_recorded<T>(device: &DeviceId, call: &str) -> Result<T, DeviceError> {
+    Err(DeviceError::Other(format!(
+        "no {} recorded for {} yet",
+        call, device
+    )))
+}
+
+#[async_trait]
+impl DeviceInterface for TraceReplay {
+    async fn list_devices(&self) -> Result<Vec<DeviceId>, DeviceError> {
+        let now = self.now();
+        let recorded = self.devices.partition_point(|(t, _)| *t <= now);
+        // Before the first enumeration, the first one is the best guess
+        match self.devices[..recorded].last().or(self.devices.first()) {
+            Some((_, devices)) => replayed(devices),
+            None => Ok(Vec::new()),
+        }
+    }
+
+    async fn get_metrics(&self, device: &DeviceId) -> Result<DeviceMetrics, DeviceError> {
+        match self.latest(device, "metrics") {
+            Some(TraceResponse::Metrics(metrics)) => replayed(metrics),
+            _ => not_recorded(device, "metrics"),
+        }
+    }
+
+    async fn get_xid_errors(&self, device: &DeviceId) -> Result<Vec<XidError>, DeviceError> {
+        let Some(responses) = self.responses.get(&(device.index, "xids")) else {
+            return Ok(Vec::new());
+        };
+        let now = self.now();
+        let since = self
+            .xid_cursor
+            .lock()
+            .unwrap_or_else(|e| e.into_inner())
+            .insert(device.index, now)
+            .unwrap_or(i64::MIN);
+
+        let mut xids = Vec::new();
+        for (_, response) in responses.iter().filter(|(t, _)| *t > since && *t <= now) {
+            if let TraceResponse::Xids(recorded) = response {
+                xids.extend(replayed(recorded)?);
+            }
+        }
+        Ok(xids)
+    }
+
+    async fn check_zombie_processes(&self, device: &DeviceId) -> Result<Vec<u32>, DeviceError> {
+        match self.latest(device, "zombies") {
+            Some(TraceResponse::Zombies(pids)) => replayed(pids),
+            _ => Ok(Vec::new()),
+        }
+    }
+
+    async fn run_active_check(
+        &self,
+        device: &DeviceId,
+        _timeout: Duration,
+    ) -> Result<CheckResult, DeviceError> {
+        match self.latest(device, "active_check") {
+            Some(TraceResponse::ActiveCheck(result)) => replayed(result),
+            Some(TraceResponse::ActiveCheckTimeout(timeout)) => Err(DeviceError::Timeout(*timeout)),
+            _ => not_recorded(device, "active check"),
+        }
+    }
+
+    fn device_type(&self) -> DeviceType {
+        self.device_type
+    }
+
+    fn supports_pcie_test(&self) -> bool {
+        self.responses.keys().any(|(_, call)| *call == "pcie_test")
+    }
+
+    async fn run_pcie_test(&self, device: &DeviceId) -> Result<CheckResult, DeviceError> {
+        match self.latest(device, "pcie_test") {
+            Some(TraceResponse::PcieTest(result)) => replayed(result),
+            _ => not_recorded(device, "PCIe test"),
+        }
+    }
+
+    async fn subscribe_events(&self) -> Option<mpsc::Receiver<DeviceEvent>> {
+        let events = std::mem::take(&mut *self.events.lock().unwrap_or_else(|e| e.into_inner()));
+        if events.is_empty() {
+            return None;
+        }
+        let (tx, rx) = mpsc::channel(EVENT_CHANNEL_CAPACITY);
+        let start = self.start;
+        let origin = self.origin;
+        tokio::spawn(async move {
+            for (t, event) in events {
+                let due = start + Duration::from_millis((t - origin).max(0) as u64);
+                tokio::time::sleep_until(due).await;
+                if tx.send(event).await.is_err() {
+                    break;
+                }
+            }
+        });
+        Some(rx)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::device::MockDevice;
+
+    #[tokio::test]
+    async fn test_record_then_replay() {
+        let path = std::env::temp_dir().join(format!("gdnd-trace-{}.jsonl", std::process::id()));
+        let mock = Arc::new(MockDevice::with_device_count(2));
+        let recorder = TraceRecorder::create(mock.clone(), &path).unwrap();
+        let devices = recorder.list_devices().await.unwrap();
+        recorder.get_metrics(&devices[0]).await.unwrap();
+        mock.fail_active_check
+            .store(true, std::sync::atomic::Ordering::SeqCst);
+        recorder
+            .run_active_check(&devices[1], Duration::from_secs(1))
+            .await
+            .unwrap();
+        // The mock probe outlasts a zero deadline
+        assert!(recorder
+            .run_active_check(&devices[0], Duration::ZERO)
+            .await
+            .is_err());
+        drop(recorder);
+
+        let trace = Trace::load(&path).unwrap();
+        assert_eq!(trace.entries().len(), 5);
+        let replay = TraceReplay::new(&trace);
+        // Catch up with the recording
+        tokio::time::sleep(trace.span()).await;
+        assert_eq!(replay.list_devices().await.unwrap(), devices);
+        assert!(replay.get_metrics(&devices[0]).await.is_ok());
+        assert!(replay.get_metrics(&devices[1]).await.is_err());
+        let check = replay
+            .run_active_check(&devices[1], Duration::from_secs(1))
+            .await
+            .unwrap();
+        assert!(!check.passed);
+        let timeout = replay
+            .run_active_check(&devices[0], Duration::from_secs(1))
+            .await;
+        assert!(matches!(timeout, Err(DeviceError::Timeout(d)) if d.is_zero()));
+
+        std::fs::remove_file(&path).unwrap();
+    }
+
+    #[tokio::test(start_paused = true)]
+    async fn test_replay_follows_virtual_time() {
+        let device = DeviceId {
+            index: 0,
+            uuid: Some("GPU-0".to_string()),
+            name: "Test GPU".to_string(),
+        };
+        let xid = |t: i64, code: u32| TraceEntry {
+            t,
+            d: Some(0),
+            response: TraceResponse::Xids(Ok(vec![XidError {
+                code,
+                message: String::new(),
+                timestamp: Utc::now(),
+                device_index: 0,
+            }])),
+        };
+        let check = |t: i64, passed: bool| TraceEntry {
+            t,
+            d: Some(0),
+            response: TraceResponse::ActiveCheck(Ok(if passed {
+                CheckResult::success(Duration::from_millis(10))
+            } else {
+                CheckResult::failure(Duration::from_millis(10), "hang".to_string(), None)
+            })),
+        };
+        let trace = Trace::new(vec![
+            check(1_000, true),
+            xid(2_000, 13),
+            xid(3_000, 31),
+            check(3_600_000, false),
+            TraceEntry {
+                t: 3_500_000,
+                d: Some(0),
+                response: TraceResponse::Fault,
+            },
+        ]);
+        assert_eq!(trace.span(), Duration::from_millis(3_599_000));
+        assert_eq!(trace.faults(), vec![(0, Duration::from_millis(3_499_000))]);
+
+        let replay = TraceReplay::new(&trace);
+        let timeout = Duration::from_secs(1);
+        assert!(
+            replay
+                .run_active_check(&device, timeout)
+                .await
+                .unwrap()
+                .passed
+        );
+        assert!(replay.get_xid_errors(&device).await.unwrap().is_empty());
+
+        // XIDs recorded between two polls are all delivered, once
+        tokio::time::sleep(Duration::from_secs(5)).await;
+        let codes: Vec<u32> = replay
+            .get_xid_errors(&device)
+            .await
+            .unwrap()
+            .iter()
+            .map(|x| x.code)
+            .collect();
+        assert_eq!(codes, vec![13, 31]);
+        assert!(replay.get_xid_errors(&device).await.unwrap().is_empty());
+
+        tokio::time::sleep(Duration::from_secs(3600)).await;
+        assert!(
+            !replay
+                .run_active_check(&device, timeout)
+                .await
+                .unwrap()
+                .passed
+        );
+    }
+}
@@ -6,14 +6,32 @@
 //!
 //! WARNING: Healing operations may interrupt running workloads.
 //! Use with caution in production environments.
+//!
+//! Zombie cleanup only targets processes stuck in D state past the zombie
+//! threshold that hold the sick device's node open (found through /proc),
+//! signals them directly through pidfds and waits for them to exit, so jobs
+//! on other devices are never touched.
 
+use std::os::fd::{AsRawFd, FromRawFd, OwnedFd};
+use std::path::{Path, PathBuf};
 use std::process::Command;
-use std::time::Duration;
+use std::sync::Arc;
+use std::time::{Duration, Instant};
 
 use thiserror::Error;
-use tracing::{info, warn};
+use tracing::{debug, info, warn};
+
+use crate::device::{
+    device_node_prefix, holds_device, scan_once, DeviceId, DeviceInterface, DeviceType, ProcScan,
+    DEFAULT_PROC_ROOT, DEFAULT_ZOMBIE_THRESHOLD,
+};
+use crate::overhead;
 
-use crate::device::{DeviceId, DeviceType};
+/// Longest wait for signalled processes to exit
+const KILL_WAIT_TIMEOUT: Duration = Duration::from_secs(5);
+
+/// Poll interval when pidfds are unavailable (kernels before 5.3)
+const KILL_POLL_INTERVAL: Duration = Duration::from_millis(50);
 
 /// Healing strategy determines how aggressive the recovery attempts are
 #[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
@@ -126,10 +144,174 @@ impl Default for HealingConfig {
     }
 }
 
+/// Processes signalled by one kill, split by whether they exited in time
+#[derive(Debug, Default)]
+struct KillOutcome {
+    exited: Vec<u32>,
+    stuck: Vec<u32>,
+    failed: Vec<(u32, std::io::Error)>,
+}
+
+/// A signalled process and how to observe its exit
+struct Signalled {
+    pid: u32,
+    /// None when pidfds are unsupported and /proc is polled instead
+    pidfd: Option<OwnedFd>,
+}
+
+/// Open a pidfd for a process
+fn pidfd_open(pid: u32) -> std::io::Result<OwnedFd> {
+    // SAFETY: pidfd_open takes a pid and flags and returns a new fd or -1
+    let fd = unsafe { libc::syscall(libc::SYS_pidfd_open, pid as libc::pid_t, 0) };
+    if fd < 0 {
+        return Err(std::io::Error::last_os_error());
+    }
+    // SAFETY: the kernel just returned this fd and nothing else owns it
+    Ok(unsafe { OwnedFd::from_raw_fd(fd as i32) })
+}
+
+/// Send SIGKILL through a pidfd
+fn pidfd_kill(pidfd: &OwnedFd) -> std::io::Result<()> {
+    // SAFETY: a valid pidfd, a signal number, no siginfo and no flags
+    let ret = unsafe {
+        libc::syscall(
+            libc::SYS_pidfd_send_signal,
+            pidfd.as_raw_fd(),
+            libc::SIGKILL,
+            std::ptr::null::<libc::siginfo_t>(),
+            0,
+        )
+    };
+    if ret < 0 {
+        return Err(std::io::Error::last_os_error());
+    }
+    Ok(())
+}
+
+/// Whether a process has exited (gone, or a zombie awaiting its parent)
+fn has_exited(proc_root: &Path, pid: u32) -> bool {
+    match std::fs::read_to_string(proc_root.join(pid.to_string()).join("stat")) {
+        Ok(stat) => stat
+            .rfind(')')
+            .and_then(|i| stat[i + 1..].split_whitespace().next())
+            .map_or(true, |state| state == "Z" || state == "X"),
+        Err(_) => true,
+    }
+}
+
+/// SIGKILL processes and wait up to `timeout` for them to exit
+///
+/// `still_target` is checked after each pidfd is opened (right before
+/// kill(2) without pidfds), so a PID reused by an unrelated process since
+/// the scan is left alone.
+fn kill_and_wait(
+    proc_root: &Path,
+    pids: &[u32],
+    timeout: Duration,
+    still_target: impl Fn(u32) -> bool,
+) -> KillOutcome {
+    let mut outcome = KillOutcome::default();
+    let mut pending = Vec::new();
+
+    for &pid in pids {
+        let signalled = match pidfd_open(pid) {
+            Ok(pidfd) => {
+                if !still_target(pid) {
+                    debug!(pid = pid, "Process no longer holds the device, skipping");
+                    continue;
+                }
+                pidfd_kill(&pidfd).map(|()| Signalled {
+                    pid,
+                    pidfd: Some(pidfd),
+                })
+            }
+            // Already gone
+            Err(e) if e.raw_os_error() == Some(libc::ESRCH) => {
+                outcome.exited.push(pid);
+                continue;
+            }
+            Err(e) if e.raw_os_error() == Some(libc::ENOSYS) => {
+                if !still_target(pid) {
+                    debug!(pid = pid, "Process no longer holds the device, skipping");
+                    continue;
+                }
+                // SAFETY: kill takes a pid and a signal number
+                if unsafe { libc::kill(pid as libc::pid_t, libc::SIGKILL) } == 0 {
+                    Ok(Signalled { pid, pidfd: None })
+                } else {
+                    Err(std::io::Error::last_os_error())
+                }
+            }
+            Err(e) => Err(e),
+        };
+        match signalled {
+            Ok(signalled) => pending.push(signalled),
+            Err(e) => outcome.failed.push((pid, e)),
+        }
+    }
+
+    let deadline = Instant::now() + timeout;
+    while !pending.is_empty() {
+        let remaining = deadline.saturating_duration_since(Instant::now());
+
+        let mut fds: Vec<libc::pollfd> = pending
+            .iter()
+            .filter_map(|p| p.pidfd.as_ref())
+            .map(|fd| libc::pollfd {
+                fd: fd.as_raw_fd(),
+                events: libc::POLLIN,
+                revents: 0,
+            })
+            .collect();
+        let wait = if fds.len() == pending.len() {
+            remaining
+        } else {
+            remaining.min(KILL_POLL_INTERVAL)
+        };
+        if !fds.is_empty() {
+            // SAFETY: fds is a valid, initialized array of fds.len() entries
+            unsafe {
+                libc::poll(
+                    fds.as_mut_ptr(),
+                    fds.len() as libc::nfds_t,
+                    wait.as_millis() as i32,
+                )
+            };
+        } else {
+            std::thread::sleep(wait);
+        }
+
+        // A readable pidfd means the process exited
+        let mut readable = fds.iter().map(|fd| fd.revents & libc::POLLIN != 0);
+        pending.retain(|p| {
+            let exited = match p.pidfd {
+                Some(_) => readable.next().unwrap_or(false),
+                None => has_exited(proc_root, p.pid),
+            };
+            if exited {
+                outcome.exited.push(p.pid);
+            }
+            !exited
+        });
+
+        if remaining.is_zero() {
+            break;
+        }
+    }
+
+    outcome.stuck = pending.into_iter().map(|p| p.pid).collect();
+    outcome
+}
+
 /// Self-healer for GPU/NPU recovery
 pub struct SelfHealer {
     config: HealingConfig,
     device_type: DeviceType,
+    proc_root: PathBuf,
+    /// Backend that maps devices to their /dev nodes
+    device: Option<Arc<dyn DeviceInterface>>,
+    /// Time in D state before a device holder counts as a zombie
+    zombie_threshold: Duration,
 }
 
 impl SelfHealer {
@@ -138,9 +320,57 @@ impl SelfHealer {
         Self {
             config,
             device_type,
+            proc_root: PathBuf::from(DEFAULT_PROC_ROOT),
+            device: None,
+            zombie_threshold: DEFAULT_ZOMBIE_THRESHOLD,
         }
     }
 
+    /// Resolve device nodes through the device backend
+    ///
+    /// Without it, a device's node is assumed to be numbered by its index.
+    pub fn with_device(mut self, device: Arc<dyn DeviceInterface>) -> Self {
+        self.device = Some(device);
+        self
+    }
+
+    /// Number of a device's node under /dev
+    fn device_node(&self, device: &DeviceId) -> u32 {
+        self.device
+            .as_ref()
+            .map_or(device.index, |backend| backend.device_node(device))
+    }
+
+    /// Find device holders under a different procfs root
+    ///
+    /// Only used without a backend that scans /proc itself.
+    pub fn with_proc_root(mut self, proc_root: PathBuf) -> Self {
+        self.proc_root = proc_root;
+        self
+    }
+
+    /// Set how long a holder must stay in D state to be killed
+    pub fn with_zombie_threshold(mut self, threshold: Duration) -> Self {
+        self.zombie_threshold = threshold;
+        self
+    }
+
+    /// Scan device holders
+    ///
+    /// Uses the backend's scanner when it has one, so D-state times carry
+    /// over from the zombie check; a one-off scan has no history.
+    fn scan(&self, prefix: &str) -> std::io::Result<ProcScan> {
+        match self.device.as_ref().and_then(|d| d.proc_scanner()) {
+            Some(scanner) => scanner.scan_blocking(),
+            None => scan_once(&self.proc_root, prefix),
+        }
+    }
+
+    /// How long to wait for killed processes to exit
+    fn kill_timeout(&self) -> Duration {
+        self.config.timeout.min(KILL_WAIT_TIMEOUT)
+    }
+
     /// Check if healing is enabled
     pub fn is_enabled(&self) -> bool {
         self.config.enabled
@@ -214,38 +444,34 @@ impl SelfHealer {
         Ok(results)
     }
 
-    /// Kill zombie GPU processes
+    /// Kill processes stuck in D state on a device
+    ///
+    /// Only processes holding this device's node open and in D state for at
+    /// least the zombie threshold are signalled. The result fails if any of
+    /// them is still in D state after the timeout.
     pub fn kill_zombie_processes(&self, device: &DeviceId) -> Result<HealingResult, HealingError> {
         let action = HealingAction::KillZombieProcesses;
 
-        if self.config.dry_run {
-            info!(device = %device, "[DRY-RUN] Would kill zombie GPU processes");
-            return Ok(HealingResult::success_with_message(
-                action,
-                "Dry run - no processes killed".to_string(),
-            ));
-        }
+        let Some(prefix) = device_node_prefix(self.device_type) else {
+            return Err(HealingError::UnsupportedDevice(self.device_type));
+        };
 
-        info!(device = %device, "Attempting to kill zombie GPU processes");
+        // Resolve the node the same way the backend's zombie check does
+        // (NVML minor number, DCMI physical ID)
+        let node = self.device_node(device);
+        let scan = self.scan(prefix)?;
+        let zombies: Vec<_> = scan.stuck_holders(node, self.zombie_threshold).collect();
 
-        // Find GPU processes in D (uninterruptible sleep) state
-        let output = Command::new("sh")
-            .arg("-c")
-            .arg("ps aux | grep -E 'D.*nvidia|D.*cuda|D.*gpu' | grep -v grep | awk '{print $2}'")
-            .output()?;
+        let pids: Vec<u32> = zombies.iter().map(|h| h.pid).collect();
 
-        if !output.status.success() {
-            return Ok(HealingResult::failure(
+        if self.config.dry_run {
+            info!(device = %device, pids = ?pids, "[DRY-RUN] Would kill zombie processes");
+            return Ok(HealingResult::success_with_message(
                 action,
-                "Failed to list zombie processes".to_string(),
+                format!("Dry run - no processes killed ({} found)", pids.len()),
             ));
         }
 
-        let pids: Vec<u32> = String::from_utf8_lossy(&output.stdout)
-            .lines()
-            .filter_map(|line| line.trim().parse().ok())
-            .collect();
-
         if pids.is_empty() {
             return Ok(HealingResult::success_with_message(
                 action,
@@ -253,29 +479,45 @@ impl SelfHealer {
             ));
         }
 
-        let mut killed = 0;
-        for pid in &pids {
-            // Send SIGKILL to zombie processes
-            let kill_result = Command::new("kill").arg("-9").arg(pid.to_string()).output();
+        info!(device = %device, pids = ?pids, "Killing zombie processes");
+        let outcome = kill_and_wait(&self.proc_root, &pids, self.kill_timeout(), |pid| {
+            holds_device(&self.proc_root, pid, prefix, node)
+        });
 
-            match kill_result {
-                Ok(output) if output.status.success() => {
-                    info!(pid = pid, "Killed zombie process");
-                    killed += 1;
-                }
-                Ok(_) => {
-                    warn!(pid = pid, "Failed to kill process");
-                }
-                Err(e) => {
-                    warn!(pid = pid, error = %e, "Error killing process");
-                }
-            }
+        for pid in &outcome.exited {
+            info!(device = %device, pid = pid, "Killed zombie process");
+        }
+        for (pid, e) in &outcome.failed {
+            warn!(device = %device, pid = pid, error = %e, "Failed to kill process");
+        }
+        for pid in &outcome.stuck {
+            let comm = zombies
+                .iter()
+                .find(|h| h.pid == *pid)
+                .map_or("", |h| h.comm.as_str());
+            warn!(
+                device = %device,
+                pid = pid,
+                comm = comm,
+                "Process still in D state after SIGKILL"
+            );
         }
 
-        Ok(HealingResult::success_with_message(
-            action,
-            format!("Killed {}/{} zombie processes", killed, pids.len()),
-        ))
+        let message = format!(
+            "Killed {}/{} zombie processes{}",
+            outcome.exited.len(),
+            pids.len(),
+            if outcome.stuck.is_empty() {
+                String::new()
+            } else {
+                format!(", stuck in D state: {:?}", outcome.stuck)
+            }
+        );
+        if outcome.stuck.is_empty() && outcome.failed.is_empty() {
+            Ok(HealingResult::success_with_message(action, message))
+        } else {
+            Ok(HealingResult::failure(action, message))
+        }
     }
 
     /// Perform GPU soft reset using nvidia-smi
@@ -298,6 +540,7 @@ impl SelfHealer {
 
         warn!(device = %device, "Performing GPU soft reset - this may interrupt workloads");
 
+        overhead::record_spawn();
         let output = Command::new("nvidia-smi")
             .arg("-i")
             .arg(device.index.to_string())
@@ -339,6 +582,7 @@ impl SelfHealer {
         warn!("Reloading NVIDIA driver - THIS WILL INTERRUPT ALL GPU WORKLOADS");
 
         // First, try to unload the nvidia modules
+        overhead::record_spawn();
         let unload = Command::new("sh")
             .arg("-c")
             .arg("modprobe -r nvidia_uvm nvidia_drm nvidia_modeset nvidia 2>/dev/null || true")
@@ -350,6 +594,7 @@ impl SelfHealer {
         }
 
         // Reload the nvidia module
+        overhead::record_spawn();
         let reload = Command::new("modprobe").arg("nvidia").output()?;
 
         if reload.status.success() {
@@ -382,25 +627,33 @@ impl SelfHealer {
 
         info!(pid = pid, "Killing process");
 
-        let output = Command::new("kill").arg("-9").arg(pid.to_string()).output()?;
-
-        if output.status.success() {
-            info!(pid = pid, "Process killed successfully");
-            Ok(HealingResult::success(action))
-        } else {
-            let stderr = String::from_utf8_lossy(&output.stderr);
-            warn!(pid = pid, error = %stderr, "Failed to kill process");
-            Ok(HealingResult::failure(
+        let outcome = kill_and_wait(&self.proc_root, &[pid], self.kill_timeout(), |_| true);
+        if let Some((_, e)) = outcome.failed.first() {
+            warn!(pid = pid, error = %e, "Failed to kill process");
+            return Ok(HealingResult::failure(
                 action,
-                format!("Failed to kill process: {}", stderr),
-            ))
+                format!("Failed to kill process: {}", e),
+            ));
         }
+        if !outcome.stuck.is_empty() {
+            warn!(pid = pid, "Process did not exit after SIGKILL");
+            return Ok(HealingResult::failure(
+                action,
+                "Process did not exit after SIGKILL".to_string(),
+            ));
+        }
+
+        info!(pid = pid, "Process killed successfully");
+        Ok(HealingResult::success(action))
     }
 }
 
 #[cfg(test)]
 mod tests {
+    use std::process::Child;
+
     use super::*;
+    use crate::device::MockDevice;
 
     #[test]
     fn test_healing_disabled_by_default() {
@@ -505,4 +758,87 @@ mod tests {
         let result = healer.gpu_soft_reset(&device);
         assert!(matches!(result, Err(HealingError::UnsupportedDevice(_))));
     }
+
+    /// Fake /proc with each child in D state holding one device node
+    fn fake_proc(name: &str, holders: &[(&Child, &str)]) -> PathBuf {
+        let root = std::env::temp_dir().join(format!("gdnd-{}-{}", name, std::process::id()));
+        let _ = std::fs::remove_dir_all(&root);
+        for (child, node) in holders {
+            let dir = root.join(child.id().to_string());
+            std::fs::create_dir_all(dir.join("fd")).unwrap();
+            std::fs::write(
+                dir.join("stat"),
+                format!(
+                    "{} (train) D 1 1 1 0 -1 0 0 0 0 0 0 0 0 0 20 0 1 0 100 0\n",
+                    child.id()
+                ),
+            )
+            .unwrap();
+            std::os::unix::fs::symlink(node, dir.join("fd").join("3")).unwrap();
+        }
+        root
+    }
+
+    fn test_device(index: u32) -> DeviceId {
+        DeviceId {
+            index,
+            uuid: Some("GPU-TEST".to_string()),
+            name: "Test GPU".to_string(),
+        }
+    }
+
+    #[test]
+    fn test_kill_zombies_targets_only_stuck_holders_of_sick_device() {
+        // (name, GPU 0's node, GPU 1's node, zombie threshold, killed)
+        let cases = [
+            ("heal-proc", 0, 1, Duration::ZERO, true),
+            // GPU 0 is /dev/nvidia1 and GPU 1 is /dev/nvidia0
+            ("heal-node", 1, 0, Duration::ZERO, true),
+            // A one-off scan has no D-state history, so nothing is stuck yet
+            ("heal-fresh", 0, 1, DEFAULT_ZOMBIE_THRESHOLD, false),
+        ];
+
+        for (name, sick_node, healthy_node, threshold, killed) in cases {
+            let mut sick = Command::new("sleep").arg("30").spawn().unwrap();
+            let mut healthy = Command::new("sleep").arg("30").spawn().unwrap();
+            let sick_path = format!("/dev/nvidia{}", sick_node);
+            let healthy_path = format!("/dev/nvidia{}", healthy_node);
+            let root = fake_proc(
+                name,
+                &[
+                    (&sick, sick_path.as_str()),
+                    (&healthy, healthy_path.as_str()),
+                ],
+            );
+            let backend = Arc::new(MockDevice::new());
+            backend.set_device_node(0, sick_node);
+            backend.set_device_node(1, healthy_node);
+
+            let config = HealingConfig {
+                enabled: true,
+                ..Default::default()
+            };
+            let healer = SelfHealer::new(config, DeviceType::Nvidia)
+                .with_proc_root(root.clone())
+                .with_device(backend)
+                .with_zombie_threshold(threshold);
+
+            let result = healer.kill_zombie_processes(&test_device(0)).unwrap();
+            assert!(result.success, "{}: {:?}", name, result.message);
+            let expected = if killed {
+                "Killed 1/1 zombie processes"
+            } else {
+                "No zombie processes found"
+            };
+            assert_eq!(result.message.unwrap(), expected, "{}", name);
+            assert_eq!(sick.try_wait().unwrap().is_some(), killed, "{}", name);
+            assert!(healthy.try_wait().unwrap().is_none(), "{}", name);
+
+            for child in [&mut sick, &mut healthy] {
+                let _ = child.kill();
+                child.wait().unwrap();
+            }
+            std::fs::remove_dir_all(&root).unwrap();
+        }
+    }
 }
@@ -0,0 +1,516 @@
+//! Persistent Health Journal
+//!
+//! Keeps the health state machine's per-device records on disk so a daemon
+//! restart (rollout, OOM kill) resumes with the same states and counters
+//! instead of treating every device as freshly healthy.
+//!
+//! Two files live in the journal directory:
+//! - `health.snapshot`: every record at the time of the last compaction
+//! - `health.journal`: records appended since, one per persistent change
+//!
+//! Both start with a magic/version header followed by frames of
+//! `[len: u32][crc32: u32][JSON record]` (little endian). Replay applies
+//! the snapshot and then the journal in write order, the last record per
+//! device index winning (so a replaced board's new record supersedes the
+//! old one), and stops at the first torn or corrupt frame. Compaction writes a new
+//! snapshot next to the old one and renames it into place, so a crash at
+//! any point leaves a consistent pair.
+//!
+//! The daemon hands the journal to a [`JournalWriter`] thread, so appends,
+//! syncs and compactions never block the async runtime or hold a device's
+//! health record locked.
+
+use std::collections::BTreeMap;
+use std::fs::{self, File, OpenOptions};
+use std::io::{self, Write};
+use std::path::{Path, PathBuf};
+use std::sync::{mpsc, Mutex};
+use std::thread::JoinHandle;
+use std::time::Instant;
+
+use tracing::{debug, info, warn};
+
+use crate::state_machine::GpuHealth;
+
+/// File magic identifying a health journal or snapshot
+const MAGIC: &[u8; 8] = b"GDNDHLTH";
+/// On-disk format version
+const VERSION: u32 = 1;
+/// Header size in bytes
+const HEADER_SIZE: usize = 12;
+/// Frame header size in bytes (length + checksum)
+const FRAME_HEADER: usize = 8;
+/// Largest record accepted on replay
+const MAX_RECORD: usize = 1 << 20;
+
+const SNAPSHOT_FILE: &str = "health.snapshot";
+const JOURNAL_FILE: &str = "health.journal";
+
+/// Default number of appended records before compaction
+pub const DEFAULT_COMPACT_AFTER: usize = 1000;
+
+struct Log {
+    file: File,
+    /// Records appended since the last compaction
+    entries: usize,
+}
+
+/// Append-only journal of health records
+pub struct HealthJournal {
+    dir: PathBuf,
+    compact_after: usize,
+    log: Mutex<Log>,
+}
+
+impl HealthJournal {
+    /// Open (or create) the journal in `dir` and replay it
+    ///
+    /// Returns the journal together with the latest record per device.
+    pub fn open<P: AsRef<Path>>(dir: P) -> io::Result<(Self, Vec<GpuHealth>)> {
+        let dir = dir.as_ref();
+        fs::create_dir_all(dir)?;
+        let start = Instant::now();
+
+        let mut latest = BTreeMap::new();
+        let snapshot = replay_file(&dir.join(SNAPSHOT_FILE), &mut latest)?;
+        let journal_path = dir.join(JOURNAL_FILE);
+        let journal = replay_file(&journal_path, &mut latest)?;
+
+        let mut file = OpenOptions::new()
+            .read(true)
+            .append(true)
+            .create(true)
+            .open(&journal_path)?;
+        match journal {
+            // Drop a torn tail so new frames follow the last good one
+            Some((valid, _)) if valid < file.metadata()?.len() => {
+                warn!(path = ?journal_path, offset = valid, "Truncating torn health journal tail");
+                file.set_len(valid)?;
+            }
+            Some(_) => {}
+            None => {
+                file.set_len(0)?;
+                file.write_all(&header())?;
+            }
+        }
+
+        let records: Vec<GpuHealth> = latest.into_values().collect();
+        info!(
+            path = ?dir,
+            devices = records.len(),
+            snapshot = snapshot.map_or(0, |(_, n)| n),
+            journal = journal.map_or(0, |(_, n)| n),
+            elapsed = ?start.elapsed(),
+            "Replayed health journal"
+        );
+
+        let journal = Self {
+            dir: dir.to_path_buf(),
+            compact_after: DEFAULT_COMPACT_AFTER,
+            log: Mutex::new(Log {
+                file,
+                entries: journal.map_or(0, |(_, n)| n),
+            }),
+        };
+        Ok((journal, records))
+    }
+
+    /// Set how many appended records trigger compaction
+    pub fn with_compact_after(mut self, compact_after: usize) -> Self {
+        self.compact_after = compact_after.max(1);
+        self
+    }
+
+    /// Directory holding the journal files
+    pub fn dir(&self) -> &Path {
+        &self.dir
+    }
+
+    /// Append a record, syncing it to disk when `sync` is set
+    ///
+    /// Returns whether the journal is due for compaction.
+    pub fn append(&self, health: &GpuHealth, sync: bool) -> io::Result<bool> {
+        let frame = frame(health)?;
+        let mut log = self.lock();
+        // One write per frame, so a crash leaves at most a torn tail
+        log.file.write_all(&frame)?;
+        if sync {
+            log.file.sync_data()?;
+        }
+        log.entries += 1;
+        Ok(log.entries >= self.compact_after)
+    }
+
+    /// Fold the journal into a new snapshot
+    ///
+    /// `collect` must return the current record of every device. Records
+    /// appended while it runs are carried over into the new journal, so
+    /// nothing written concurrently is lost.
+    pub fn compact(&self, collect: impl FnOnce() -> Vec<GpuHealth>) -> io::Result<()> {
+        let mark = self.lock().file.metadata()?.len();
+        let records = collect();
+
+        let mut snapshot = header();
+        for health in &records {
+            snapshot.extend_from_slice(&frame(health)?);
+        }
+        write_atomic(&self.dir.join(SNAPSHOT_FILE), &snapshot)?;
+
+        let mut log = self.lock();
+        let journal_path = self.dir.join(JOURNAL_FILE);
+        let mut carried = header();
+        let contents = fs::read(&journal_path)?;
+        carried.extend_from_slice(contents.get(mark as usize..).unwrap_or_default());
+        write_atomic(&journal_path, &carried)?;
+
+        log.file = OpenOptions::new().append(true).open(&journal_path)?;
+        log.entries = 0;
+        debug!(records = records.len(), "Compacted health journal");
+        Ok(())
+    }
+
+    fn lock(&self) -> std::sync::MutexGuard<'_, Log> {
+        self.log.lock().unwrap_or_else(|e| e.into_inner())
+    }
+
+    /// Move the journal onto its own writer thread
+    ///
+    /// `records` are the current record of every device; the thread starts
+    /// by compacting them into a fresh snapshot.
+    pub fn spawn_writer(self, records: Vec<GpuHealth>) -> io::Result<JournalWriter> {
+        let (tx, rx) = mpsc::channel();
+        let dir = self.dir.clone();
+        let thread = std::thread::Builder::new()
+            .name("gdnd-journal".to_string())
+            .spawn(move || self.run_writer(records, rx))?;
+        Ok(JournalWriter {
+            dir,
+            tx: Some(tx),
+            thread: Some(thread),
+        })
+    }
+
+    /// Writer thread: append queued records, compacting when due
+    fn run_writer(self, records: Vec<GpuHealth>, rx: mpsc::Receiver<(GpuHealth, bool)>) {
+        // Latest record per device index, which is what a snapshot holds
+        let mut latest: BTreeMap<u32, GpuHealth> =
+            records.into_iter().map(|h| (h.device.index, h)).collect();
+        self.compact_logged(&latest);
+
+        for (health, sync) in rx {
+            let compact = self.append(&health, sync).unwrap_or_else(|e| {
+                warn!(device = %health.device, error = %e, "Failed to journal health state");
+                false
+            });
+            latest.insert(health.device.index, health);
+            if compact {
+                self.compact_logged(&latest);
+            }
+        }
+    }
+
+    fn compact_logged(&self, latest: &BTreeMap<u32, GpuHealth>) {
+        if let Err(e) = self.compact(|| latest.values().cloned().collect()) {
+            warn!(path = ?self.dir, error = %e, "Failed to compact health journal");
+        }
+    }
+}
+
+/// Handle to the thread that owns a health journal
+///
+/// Records are queued in order and written by the thread. Dropping the
+/// handle drains the queue and waits for the thread to finish.
+pub struct JournalWriter {
+    dir: PathBuf,
+    tx: Option<mpsc::Sender<(GpuHealth, bool)>>,
+    thread: Option<JoinHandle<()>>,
+}
+
+impl JournalWriter {
+    /// Queue a record, to be synced to disk when `sync` is set
+    pub fn append(&self, health: GpuHealth, sync: bool) {
+        let Some(tx) = &self.tx else {
+            return;
+        };
+        if tx.send((health, sync)).is_err() {
+            warn!(path = ?self.dir, "Health journal writer stopped, record dropped");
+        }
+    }
+
+    /// Directory holding the journal files
+    pub fn dir(&self) -> &Path {
+        &self.dir
+    }
+}
+
+impl Drop for JournalWriter {
+    fn drop(&mut self) {
+        // Closing the channel ends the thread once the queue is written
+        drop(self.tx.take());
+        if let Some(thread) = self.thread.take() {
+            let _ = thread.join();
+        }
+    }
+}
+
+fn header() -> Vec<u8> {
+    let mut header = Vec::with_capacity(HEADER_SIZE);
+    header.extend_from_slice(MAGIC);
+    header.extend_from_slice(&VERSION.to_le_bytes());
+    header
+}
+
+/// Encode a record as a checksummed frame
+fn frame(health: &GpuHealth) -> io::Result<Vec<u8>> {
+    let payload = serde_json::to_vec(health)?;
+    let mut frame = Vec::with_capacity(FRAME_HEADER + payload.len());
+    frame.extend_from_slice(&(payload.len() as u32).to_le_bytes());
+    frame.extend_from_slice(&crc32fast::hash(&payload).to_le_bytes());
+    frame.extend_from_slice(&payload);
+    Ok(frame)
+}
+
+/// Apply the frames of one file to `latest` in write order, by device index
+///
+/// Returns the length of the valid prefix and the number of records, or
+/// `None` when the file is missing or not a journal of this version.
+fn replay_file(
+    path: &Path,
+    latest: &mut BTreeMap<u32, GpuHealth>,
+) -> io::Result<Option<(u64, usize)>> {
+    let bytes = match fs::read(path) {
+        Ok(bytes) => bytes,
+        Err(e) if e.kind() == io::ErrorKind::NotFound => return Ok(None),
+        Err(e) => return Err(e),
+    };
+    if bytes.len() < HEADER_SIZE || bytes[..HEADER_SIZE] != header()[..] {
+        if !bytes.is_empty() {
+            warn!(path = ?path, "Unrecognized health journal file, ignoring it");
+        }
+        return Ok(None);
+    }
+
+    let mut offset = HEADER_SIZE;
+    let mut records = 0;
+    while let Some(health) = read_frame(&bytes[offset..]) {
+        let (health, len) = match health {
+            Ok(decoded) => decoded,
+            Err(e) => {
+                warn!(path = ?path, offset = offset, error = %e, "Corrupt health journal frame");
+                break;
+            }
+        };
+        latest.insert(health.device.index, health);
+        offset += len;
+        records += 1;
+    }
+    Ok(Some((offset as u64, records)))
+}
+
+/// Decode one frame; `None` at a clean end of file
+fn read_frame(bytes: &[u8]) -> Option<Result<(GpuHealth, usize), String>> {
+    if bytes.is_empty() {
+        return None;
+    }
+    if bytes.len() < FRAME_HEADER {
+        return Some(Err("truncated frame header".to_string()));
+    }
+    let len = u32::from_le_bytes(bytes[0..4].try_into().unwrap()) as usize;
+    let crc = u32::from_le_bytes(bytes[4..8].try_into().unwrap());
+    if len > MAX_RECORD {
+        return Some(Err(format!("frame length {} out of range", len)));
+    }
+    let Some(payload) = bytes.get(FRAME_HEADER..FRAME_HEADER + len) else {
+        return Some(Err("truncated frame".to_string()));
+    };
+    if crc32fast::hash(payload) != crc {
+        return Some(Err("checksum mismatch".to_string()));
+    }
+    Some(
+        serde_json::from_slice(payload)
+            .map(|health| (health, FRAME_HEADER + len))
+            .map_err(|e| e.to_string()),
+    )
+}
+
+/// Replace a file with new contents via a synced temporary file
+///
+/// The directory is synced after the rename, so the replacement itself
+/// survives a crash.
+fn write_atomic(path: &Path, contents: &[u8]) -> io::Result<()> {
+    let tmp = path.with_extension("tmp");
+    let mut file = File::create(&tmp)?;
+    file.write_all(contents)?;
+    file.sync_all()?;
+    fs::rename(&tmp, path)?;
+    let dir = path.parent().unwrap_or_else(|| Path::new("."));
+    File::open(dir)?.sync_all()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::device::DeviceId;
+    use crate::state_machine::HealthState;
+
+    fn temp_dir(name: &str) -> PathBuf {
+        std::env::temp_dir().join(format!("gdnd-journal-{}-{}", name, std::process::id()))
+    }
+
+    fn record(index: u32, state: HealthState, failure_count: u32) -> GpuHealth {
+        let mut health = GpuHealth::new(DeviceId {
+            index,
+            uuid: Some(format!("GPU-TEST-{}", index)),
+            name: "Test GPU".to_string(),
+        });
+        health.state = state;
+        health.failure_count = failure_count;
+        health
+    }
+
+    #[test]
+    fn test_replay_keeps_latest_record_per_device() {
+        let dir = temp_dir("replay");
+        let (journal, records) = HealthJournal::open(&dir).unwrap();
+        assert!(records.is_empty());
+
+        journal
+            .append(&record(0, HealthState::Suspected, 1), false)
+            .unwrap();
+        journal
+            .append(&record(1, HealthState::Suspected, 1), false)
+            .unwrap();
+        journal
+            .append(&record(0, HealthState::Suspected, 2), true)
+            .unwrap();
+        drop(journal);
+
+        let (_, records) = HealthJournal::open(&dir).unwrap();
+        assert_eq!(records.len(), 2);
+        assert_eq!(records[0].failure_count, 2);
+        assert_eq!(records[1].failure_count, 1);
+
+        fs::remove_dir_all(&dir).unwrap();
+    }
+
+    #[test]
+    fn test_replaced_board_resolved_by_write_order() {
+        let dir = temp_dir("replaced");
+        let (journal, _) = HealthJournal::open(&dir).unwrap();
+        let old = record(0, HealthState::Isolated, 3);
+        let mut new = record(0, HealthState::Suspected, 1);
+        new.device.uuid = Some("GPU-TEST-REPLACED".to_string());
+        journal.append(&old, false).unwrap();
+        journal.append(&new, false).unwrap();
+        journal.compact(|| vec![new.clone()]).unwrap();
+        // A late record of the old board, written after the snapshot
+        journal.append(&old, false).unwrap();
+        drop(journal);
+
+        let (_, records) = HealthJournal::open(&dir).unwrap();
+        assert_eq!(records.len(), 1);
+        assert_eq!(records[0].device.uuid, old.device.uuid);
+        assert_eq!(records[0].state, HealthState::Isolated);
+
+        fs::remove_dir_all(&dir).unwrap();
+    }
+
+    #[test]
+    fn test_torn_tail_is_dropped() {
+        let dir = temp_dir("torn");
+        let (journal, _) = HealthJournal::open(&dir).unwrap();
+        journal
+            .append(&record(0, HealthState::Suspected, 1), false)
+            .unwrap();
+        journal
+            .append(&record(0, HealthState::Suspected, 2), false)
+            .unwrap();
+        drop(journal);
+
+        // Crash halfway through the second frame
+        let path = dir.join(JOURNAL_FILE);
+        let mut bytes = fs::read(&path).unwrap();
+        bytes.truncate(bytes.len() - 10);
+        fs::write(&path, &bytes).unwrap();
+
+        let (journal, records) = HealthJournal::open(&dir).unwrap();
+        assert_eq!(records[0].failure_count, 1);
+        // Appends continue after the last good frame
+        journal
+            .append(&record(0, HealthState::Unhealthy, 3), false)
+            .unwrap();
+        drop(journal);
+        let (_, records) = HealthJournal::open(&dir).unwrap();
+        assert_eq!(records[0].state, HealthState::Unhealthy);
+
+        // A flipped bit fails the checksum
+        let mut bytes = fs::read(&path).unwrap();
+        let last = bytes.len() - 2;
+        bytes[last] ^= 0x01;
+        fs::write(&path, &bytes).unwrap();
+        let (_, records) = HealthJournal::open(&dir).unwrap();
+        assert_eq!(records[0].failure_count, 1);
+
+        fs::remove_dir_all(&dir).unwrap();
+    }
+
+    #[test]
+    fn test_compaction_carries_concurrent_appends() {
+        let dir = temp_dir("compact");
+        let (journal, _) = HealthJournal::open(&dir).unwrap();
+        let journal = journal.with_compact_after(3);
+        assert!(!journal
+            .append(&record(0, HealthState::Suspected, 1), false)
+            .unwrap());
+        assert!(!journal
+            .append(&record(0, HealthState::Suspected, 2), false)
+            .unwrap());
+        assert!(journal
+            .append(&record(1, HealthState::Suspected, 1), false)
+            .unwrap());
+
+        journal
+            .compact(|| {
+                // Lands in the journal after the snapshot was collected
+                journal
+                    .append(&record(1, HealthState::Suspected, 2), false)
+                    .unwrap();
+                vec![
+                    record(0, HealthState::Suspected, 2),
+                    record(1, HealthState::Suspected, 1),
+                ]
+            })
+            .unwrap();
+        drop(journal);
+
+        let (journal, records) = HealthJournal::open(&dir).unwrap();
+        assert_eq!(journal.lock().entries, 1);
+        assert_eq!(records[0].failure_count, 2);
+        assert_eq!(records[1].failure_count, 2);
+
+        fs::remove_dir_all(&dir).unwrap();
+    }
+
+    #[test]
+    fn test_writer_appends_and_compacts() {
+        let dir = temp_dir("writer");
+        let (journal, _) = HealthJournal::open(&dir).unwrap();
+        let writer = journal
+            .with_compact_after(2)
+            .spawn_writer(vec![record(0, HealthState::Suspected, 1)])
+            .unwrap();
+        writer.append(record(1, HealthState::Suspected, 1), false);
+        writer.append(record(0, HealthState::Suspected, 2), true);
+        writer.append(record(1, HealthState::Unhealthy, 3), true);
+        drop(writer);
+
+        let (journal, records) = HealthJournal::open(&dir).unwrap();
+        // The second append compacted, leaving only the third in the journal
+        assert_eq!(journal.lock().entries, 1);
+        assert_eq!(records.len(), 2);
+        assert_eq!(records[0].failure_count, 2);
+        assert_eq!(records[1].state, HealthState::Unhealthy);
+
+        fs::remove_dir_all(&dir).unwrap();
+    }
+}
@@ -3,14 +3,20 @@
 //! Core detection logic for GPU Dead Node Detector.
 //! This crate provides device abstraction, health detection, and state management.
 
+pub mod baseline;
 pub mod detection;
 pub mod device;
 pub mod healing;
+pub mod journal;
 pub mod metrics;
+pub mod overhead;
+#[cfg(any(test, feature = "replay"))]
+pub mod replay;
 pub mod scheduler;
 pub mod state_machine;
 
 // Re-export common types
+pub use baseline::{Baseline, BaselineConfig, BaselineStore, Regression};
 pub use device::{DeviceError, DeviceId, DeviceInterface, DeviceMetrics, DeviceType};
 pub use healing::{HealingAction, HealingConfig, HealingStrategy, SelfHealer};
 pub use state_machine::{GpuHealth, GpuHealthManager, HealthState, IsolationAction};
@@ -1,12 +1,19 @@
 //! Prometheus metrics for GDND
 
-use once_cell::sync::Lazy;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::RwLock;
+
+use once_cell::sync::{Lazy, OnceCell};
 use prometheus::{
-    opts, register_gauge_vec, register_histogram_vec, register_int_counter_vec, register_int_gauge,
-    GaugeVec, HistogramVec, IntCounterVec, IntGauge,
+    opts, register_counter, register_counter_vec, register_gauge_vec, register_histogram,
+    register_histogram_vec, register_int_counter, register_int_counter_vec, register_int_gauge,
+    Counter, CounterVec, Gauge, GaugeVec, Histogram, HistogramVec, IntCounter, IntCounterVec,
+    IntGauge,
 };
 
-use crate::device::DeviceId;
+use crate::detection::DetectionLevel;
+use crate::device::{DeviceId, DeviceMetrics};
+use crate::overhead::{CheckUsage, ProcessUsage};
 use crate::state_machine::HealthState;
 
 /// GPU status metric (0=healthy, 1=suspected, 2=unhealthy, 3=isolated)
@@ -27,6 +34,18 @@ static GPU_TEMPERATURE: Lazy<GaugeVec> = Lazy::new(|| {
     .expect("Failed to create gpu_temperature metric")
 });
 
+/// GPU memory (HBM) temperature metric
+static GPU_MEMORY_TEMPERATURE: Lazy<GaugeVec> = Lazy::new(|| {
+    register_gauge_vec!(
+        opts!(
+            "gdnd_gpu_memory_temperature_celsius",
+            "GPU memory temperature in Celsius"
+        ),
+        &["gpu"]
+    )
+    .expect("Failed to create gpu_memory_temperature metric")
+});
+
 /// GPU utilization metric
 static GPU_UTILIZATION: Lazy<GaugeVec> = Lazy::new(|| {
     register_gauge_vec!(
@@ -45,6 +64,78 @@ static GPU_MEMORY_USED: Lazy<GaugeVec> = Lazy::new(|| {
     .expect("Failed to create gpu_memory_used metric")
 });
 
+/// GPU memory utilization metric
+static GPU_MEMORY_UTILIZATION: Lazy<GaugeVec> = Lazy::new(|| {
+    register_gauge_vec!(
+        opts!(
+            "gdnd_gpu_memory_utilization_percent",
+            "GPU memory controller utilization percentage"
+        ),
+        &["gpu"]
+    )
+    .expect("Failed to create gpu_memory_utilization metric")
+});
+
+/// GPU total memory metric
+static GPU_MEMORY_TOTAL: Lazy<GaugeVec> = Lazy::new(|| {
+    register_gauge_vec!(
+        opts!("gdnd_gpu_memory_total_bytes", "GPU total memory in bytes"),
+        &["gpu"]
+    )
+    .expect("Failed to create gpu_memory_total metric")
+});
+
+/// GPU free memory metric
+static GPU_MEMORY_FREE: Lazy<GaugeVec> = Lazy::new(|| {
+    register_gauge_vec!(
+        opts!("gdnd_gpu_memory_free_bytes", "GPU free memory in bytes"),
+        &["gpu"]
+    )
+    .expect("Failed to create gpu_memory_free metric")
+});
+
+/// GPU power draw metric
+static GPU_POWER_USAGE: Lazy<GaugeVec> = Lazy::new(|| {
+    register_gauge_vec!(
+        opts!("gdnd_gpu_power_usage_watts", "GPU power draw in Watts"),
+        &["gpu"]
+    )
+    .expect("Failed to create gpu_power_usage metric")
+});
+
+/// GPU power limit metric
+static GPU_POWER_LIMIT: Lazy<GaugeVec> = Lazy::new(|| {
+    register_gauge_vec!(
+        opts!("gdnd_gpu_power_limit_watts", "GPU power limit in Watts"),
+        &["gpu"]
+    )
+    .expect("Failed to create gpu_power_limit metric")
+});
+
+/// GPU PCIe throughput metric
+static GPU_PCIE_THROUGHPUT: Lazy<GaugeVec> = Lazy::new(|| {
+    register_gauge_vec!(
+        opts!(
+            "gdnd_gpu_pcie_throughput_bytes_per_second",
+            "GPU PCIe throughput in bytes per second"
+        ),
+        &["gpu", "direction"]
+    )
+    .expect("Failed to create gpu_pcie_throughput metric")
+});
+
+/// GPU ECC error count metric, as reported by the driver
+static GPU_ECC_ERRORS: Lazy<GaugeVec> = Lazy::new(|| {
+    register_gauge_vec!(
+        opts!(
+            "gdnd_gpu_ecc_errors",
+            "GPU ECC error count since driver load (volatile) or over the device lifetime (aggregate)"
+        ),
+        &["gpu", "type", "scope"]
+    )
+    .expect("Failed to create gpu_ecc_errors metric")
+});
+
 /// Detection check duration histogram
 static CHECK_DURATION: Lazy<HistogramVec> = Lazy::new(|| {
     register_histogram_vec!(
@@ -65,6 +156,27 @@ static CHECK_FAILURES: Lazy<IntCounterVec> = Lazy::new(|| {
     .expect("Failed to create check_failures metric")
 });
 
+/// Advisory findings on passing checks
+static ADVISORY_FINDINGS: Lazy<IntCounterVec> = Lazy::new(|| {
+    register_int_counter_vec!(
+        opts!(
+            "gdnd_advisory_findings_total",
+            "Total number of advisory findings that did not affect health state"
+        ),
+        &["level", "gpu", "reason"]
+    )
+    .expect("Failed to create advisory_findings metric")
+});
+
+/// Driver error events received
+static DEVICE_EVENTS: Lazy<IntCounterVec> = Lazy::new(|| {
+    register_int_counter_vec!(
+        opts!("gdnd_device_events_total", "Total number of driver error events received"),
+        &["gpu", "type"]
+    )
+    .expect("Failed to create device_events metric")
+});
+
 /// Isolation action counter
 static ISOLATION_ACTIONS: Lazy<IntCounterVec> = Lazy::new(|| {
     register_int_counter_vec!(
@@ -74,6 +186,40 @@ static ISOLATION_ACTIONS: Lazy<IntCounterVec> = Lazy::new(|| {
     .expect("Failed to create isolation_actions metric")
 });
 
+/// Effective L2 probe deadline per device
+static L2_PROBE_DEADLINE: Lazy<GaugeVec> = Lazy::new(|| {
+    register_gauge_vec!(
+        opts!(
+            "gdnd_l2_probe_deadline_seconds",
+            "Effective L2 active check deadline"
+        ),
+        &["gpu"]
+    )
+    .expect("Failed to create l2_probe_deadline metric")
+});
+
+/// L2 probes skipped by workload-aware scheduling
+static L2_PROBES_SKIPPED: Lazy<IntCounterVec> = Lazy::new(|| {
+    register_int_counter_vec!(
+        opts!(
+            "gdnd_l2_probes_skipped_total",
+            "Total number of L2 probes skipped on busy devices"
+        ),
+        &["gpu", "reason"]
+    )
+    .expect("Failed to create l2_probes_skipped metric")
+});
+
+/// Time from first suspicion to completed isolation
+static TIME_TO_ISOLATION: Lazy<Histogram> = Lazy::new(|| {
+    register_histogram!(
+        "gdnd_time_to_isolation_seconds",
+        "Time from a device first leaving HEALTHY to isolation completing",
+        vec![1.0, 5.0, 15.0, 30.0, 60.0, 120.0, 300.0, 600.0, 900.0, 1800.0, 3600.0]
+    )
+    .expect("Failed to create time_to_isolation metric")
+});
+
 /// Number of GPUs detected
 static GPU_COUNT: Lazy<IntGauge> = Lazy::new(|| {
     register_int_gauge!(
@@ -82,27 +228,412 @@ static GPU_COUNT: Lazy<IntGauge> = Lazy::new(|| {
     .expect("Failed to create gpu_count metric")
 });
 
+/// CPU time spent polling detection checks
+static CHECK_CPU: Lazy<CounterVec> = Lazy::new(|| {
+    register_counter_vec!(
+        opts!(
+            "gdnd_check_cpu_seconds_total",
+            "CPU time gdnd spent running detection checks"
+        ),
+        &["level", "gpu"]
+    )
+    .expect("Failed to create check_cpu metric")
+});
+
+/// Wall time from a check's first poll to its completion
+static CHECK_WALL: Lazy<CounterVec> = Lazy::new(|| {
+    register_counter_vec!(
+        opts!(
+            "gdnd_check_wall_seconds_total",
+            "Wall time detection checks took to complete"
+        ),
+        &["level", "gpu"]
+    )
+    .expect("Failed to create check_wall metric")
+});
+
+/// Heap allocations made by detection checks
+static CHECK_ALLOCATIONS: Lazy<IntCounterVec> = Lazy::new(|| {
+    register_int_counter_vec!(
+        opts!(
+            "gdnd_check_allocations_total",
+            "Heap allocations made by detection checks"
+        ),
+        &["level", "gpu"]
+    )
+    .expect("Failed to create check_allocations metric")
+});
+
+/// Bytes allocated by detection checks
+static CHECK_ALLOCATED_BYTES: Lazy<IntCounterVec> = Lazy::new(|| {
+    register_int_counter_vec!(
+        opts!(
+            "gdnd_check_allocated_bytes_total",
+            "Bytes allocated by detection checks"
+        ),
+        &["level", "gpu"]
+    )
+    .expect("Failed to create check_allocated_bytes metric")
+});
+
+/// Child processes launched by detection checks
+static CHECK_CHILD_PROCESSES: Lazy<IntCounterVec> = Lazy::new(|| {
+    register_int_counter_vec!(
+        opts!(
+            "gdnd_check_child_processes_total",
+            "Child processes launched by detection checks"
+        ),
+        &["level", "gpu"]
+    )
+    .expect("Failed to create check_child_processes metric")
+});
+
+/// Longest single poll of each check
+static CHECK_LONGEST_POLL: Lazy<HistogramVec> = Lazy::new(|| {
+    register_histogram_vec!(
+        "gdnd_check_longest_poll_seconds",
+        "Longest single poll of a detection check, during which it held a runtime worker",
+        &["level"],
+        vec![0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0]
+    )
+    .expect("Failed to create check_longest_poll metric")
+});
+
+/// How late detection actors wake relative to their schedule
+static SCHEDULER_TICK_LAG: Lazy<HistogramVec> = Lazy::new(|| {
+    register_histogram_vec!(
+        "gdnd_scheduler_tick_lag_seconds",
+        "Delay between a scheduled detection and its actor waking up",
+        &["level"],
+        vec![0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0, 5.0, 30.0]
+    )
+    .expect("Failed to create scheduler_tick_lag metric")
+});
+
+/// Daemon CPU time
+static PROCESS_CPU: Lazy<Counter> = Lazy::new(|| {
+    register_counter!(opts!(
+        "gdnd_process_cpu_seconds_total",
+        "User and system CPU time of the gdnd process"
+    ))
+    .expect("Failed to create process_cpu metric")
+});
+
+/// CPU time of reaped child processes
+static CHILD_CPU: Lazy<Counter> = Lazy::new(|| {
+    register_counter!(opts!(
+        "gdnd_child_process_cpu_seconds_total",
+        "User and system CPU time of child processes gdnd has reaped"
+    ))
+    .expect("Failed to create child_cpu metric")
+});
+
+/// Child processes launched
+static CHILD_PROCESSES: Lazy<IntCounter> = Lazy::new(|| {
+    register_int_counter!(opts!(
+        "gdnd_child_processes_total",
+        "Total number of child processes gdnd launched"
+    ))
+    .expect("Failed to create child_processes metric")
+});
+
+/// Heap allocations
+static ALLOCATIONS: Lazy<IntCounter> = Lazy::new(|| {
+    register_int_counter!(opts!(
+        "gdnd_allocations_total",
+        "Total number of heap allocations"
+    ))
+    .expect("Failed to create allocations metric")
+});
+
+/// Bytes allocated
+static ALLOCATED_BYTES: Lazy<IntCounter> = Lazy::new(|| {
+    register_int_counter!(opts!(
+        "gdnd_allocated_bytes_total",
+        "Total number of bytes allocated"
+    ))
+    .expect("Failed to create allocated_bytes metric")
+});
+
+/// Bytes currently allocated
+static HEAP_BYTES: Lazy<IntGauge> = Lazy::new(|| {
+    register_int_gauge!(opts!("gdnd_heap_bytes", "Bytes currently allocated on the heap"))
+        .expect("Failed to create heap_bytes metric")
+});
+
+/// Tokio runtime worker threads
+static RUNTIME_WORKERS: Lazy<IntGauge> = Lazy::new(|| {
+    register_int_gauge!(opts!("gdnd_runtime_workers", "Tokio runtime worker threads"))
+        .expect("Failed to create runtime_workers metric")
+});
+
+/// Tokio tasks alive
+static RUNTIME_ALIVE_TASKS: Lazy<IntGauge> = Lazy::new(|| {
+    register_int_gauge!(opts!(
+        "gdnd_runtime_alive_tasks",
+        "Tokio tasks spawned and not yet finished"
+    ))
+    .expect("Failed to create runtime_alive_tasks metric")
+});
+
+/// Tokio global queue depth
+static RUNTIME_GLOBAL_QUEUE_DEPTH: Lazy<IntGauge> = Lazy::new(|| {
+    register_int_gauge!(opts!(
+        "gdnd_runtime_global_queue_depth",
+        "Tokio tasks waiting in the runtime's global queue"
+    ))
+    .expect("Failed to create runtime_global_queue_depth metric")
+});
+
+/// Tokio worker busy time
+static RUNTIME_BUSY: Lazy<Counter> = Lazy::new(|| {
+    register_counter!(opts!(
+        "gdnd_runtime_busy_seconds_total",
+        "Time tokio runtime workers spent polling tasks, summed over workers"
+    ))
+    .expect("Failed to create runtime_busy metric")
+});
+
+/// Bumped after every update, so scrapes can reuse an encoded body
+static GENERATION: AtomicU64 = AtomicU64::new(0);
+
+fn changed() {
+    GENERATION.fetch_add(1, Ordering::Release);
+}
+
+/// Label value for a detection level
+fn level_label(level: DetectionLevel) -> &'static str {
+    match level {
+        DetectionLevel::L1Passive => "L1",
+        DetectionLevel::L2Active => "L2",
+        DetectionLevel::L3Pcie => "L3",
+    }
+}
+
+/// Index of a detection level in per-level handle arrays
+fn level_slot(level: DetectionLevel) -> usize {
+    match level {
+        DetectionLevel::L1Passive => 0,
+        DetectionLevel::L2Active => 1,
+        DetectionLevel::L3Pcie => 2,
+    }
+}
+
+/// Advance a counter to a total sampled elsewhere
+fn advance(counter: &Counter, total: f64) {
+    let delta = total - counter.get();
+    if delta > 0.0 {
+        counter.inc_by(delta);
+    }
+}
+
+/// Advance an integer counter to a total sampled elsewhere
+fn advance_int(counter: &IntCounter, total: u64) {
+    counter.inc_by(total.saturating_sub(counter.get()));
+}
+
+/// Resource counters for one device at one detection level
+struct CheckCost {
+    cpu: Counter,
+    wall: Counter,
+    allocations: IntCounter,
+    allocated_bytes: IntCounter,
+    child_processes: IntCounter,
+}
+
+impl CheckCost {
+    fn bind(level: DetectionLevel, gpu: &str) -> Self {
+        let labels = [level_label(level), gpu];
+        Self {
+            cpu: CHECK_CPU.with_label_values(&labels),
+            wall: CHECK_WALL.with_label_values(&labels),
+            allocations: CHECK_ALLOCATIONS.with_label_values(&labels),
+            allocated_bytes: CHECK_ALLOCATED_BYTES.with_label_values(&labels),
+            child_processes: CHECK_CHILD_PROCESSES.with_label_values(&labels),
+        }
+    }
+}
+
+/// Metric handles bound to one device's labels
+///
+/// Resolved once per device so that updates skip label formatting and
+/// the label hash lookup.
+struct DeviceHandles {
+    /// UUID the handles were bound for; a different device at the same
+    /// index gets new handles
+    uuid: Option<String>,
+    name: String,
+    /// Index label, for metrics with per-update labels
+    gpu: String,
+    status: Gauge,
+    temperature: Gauge,
+    /// Bound on the first reported value, like the PCIe gauges
+    memory_temperature: OnceCell<Gauge>,
+    utilization: Gauge,
+    memory_utilization: Gauge,
+    memory_used: Gauge,
+    memory_total: Gauge,
+    memory_free: Gauge,
+    power_usage: Gauge,
+    power_limit: Gauge,
+    /// Bound on the first reported value, so devices whose backend has no
+    /// PCIe throughput source export no series instead of a constant 0
+    pcie_tx: OnceCell<Gauge>,
+    pcie_rx: OnceCell<Gauge>,
+    /// Single-bit volatile, double-bit volatile, single-bit aggregate,
+    /// double-bit aggregate
+    ecc: [Gauge; 4],
+    /// Indexed by detection level
+    check_duration: [Histogram; 3],
+    /// Indexed by detection level
+    check_cost: [CheckCost; 3],
+    l2_probe_deadline: Gauge,
+}
+
+impl DeviceHandles {
+    fn bind(device: &DeviceId) -> Self {
+        let gpu = device.index.to_string();
+        let uuid = device.uuid.as_deref().unwrap_or("");
+        let per_gpu = |vec: &GaugeVec| vec.with_label_values(&[&gpu]);
+        let ecc = |kind: &str, scope: &str| GPU_ECC_ERRORS.with_label_values(&[&gpu, kind, scope]);
+        let duration = |level| CHECK_DURATION.with_label_values(&[level_label(level), &gpu]);
+        Self {
+            uuid: device.uuid.clone(),
+            name: device.name.clone(),
+            status: GPU_STATUS.with_label_values(&[&gpu, uuid, &device.name]),
+            temperature: per_gpu(&GPU_TEMPERATURE),
+            memory_temperature: OnceCell::new(),
+            utilization: per_gpu(&GPU_UTILIZATION),
+            memory_utilization: per_gpu(&GPU_MEMORY_UTILIZATION),
+            memory_used: per_gpu(&GPU_MEMORY_USED),
+            memory_total: per_gpu(&GPU_MEMORY_TOTAL),
+            memory_free: per_gpu(&GPU_MEMORY_FREE),
+            power_usage: per_gpu(&GPU_POWER_USAGE),
+            power_limit: per_gpu(&GPU_POWER_LIMIT),
+            pcie_tx: OnceCell::new(),
+            pcie_rx: OnceCell::new(),
+            ecc: [
+                ecc("single_bit", "volatile"),
+                ecc("double_bit", "volatile"),
+                ecc("single_bit", "aggregate"),
+                ecc("double_bit", "aggregate"),
+            ],
+            check_duration: [
+                duration(DetectionLevel::L1Passive),
+                duration(DetectionLevel::L2Active),
+                duration(DetectionLevel::L3Pcie),
+            ],
+            check_cost: [
+                CheckCost::bind(DetectionLevel::L1Passive, &gpu),
+                CheckCost::bind(DetectionLevel::L2Active, &gpu),
+                CheckCost::bind(DetectionLevel::L3Pcie, &gpu),
+            ],
+            l2_probe_deadline: per_gpu(&L2_PROBE_DEADLINE),
+            gpu,
+        }
+    }
+}
+
 /// Metrics registry wrapper
-pub struct MetricsRegistry;
+pub struct MetricsRegistry {
+    /// Bound handles per device index
+    devices: RwLock<Vec<Option<DeviceHandles>>>,
+}
 
 impl MetricsRegistry {
+    /// Current update generation; changes whenever any metric is updated
+    pub fn generation() -> u64 {
+        GENERATION.load(Ordering::Acquire)
+    }
+
     /// Create a new metrics registry
     pub fn new() -> Self {
         // Force initialization of lazy statics
         let _ = &*GPU_STATUS;
         let _ = &*GPU_TEMPERATURE;
+        let _ = &*GPU_MEMORY_TEMPERATURE;
         let _ = &*GPU_UTILIZATION;
         let _ = &*GPU_MEMORY_USED;
+        let _ = &*GPU_MEMORY_UTILIZATION;
+        let _ = &*GPU_MEMORY_TOTAL;
+        let _ = &*GPU_MEMORY_FREE;
+        let _ = &*GPU_POWER_USAGE;
+        let _ = &*GPU_POWER_LIMIT;
+        let _ = &*GPU_PCIE_THROUGHPUT;
+        let _ = &*GPU_ECC_ERRORS;
         let _ = &*CHECK_DURATION;
         let _ = &*CHECK_FAILURES;
+        let _ = &*ADVISORY_FINDINGS;
+        let _ = &*DEVICE_EVENTS;
         let _ = &*ISOLATION_ACTIONS;
+        let _ = &*L2_PROBE_DEADLINE;
+        let _ = &*L2_PROBES_SKIPPED;
+        let _ = &*TIME_TO_ISOLATION;
         let _ = &*GPU_COUNT;
-        Self
+        let _ = &*CHECK_CPU;
+        let _ = &*CHECK_WALL;
+        let _ = &*CHECK_ALLOCATIONS;
+        let _ = &*CHECK_ALLOCATED_BYTES;
+        let _ = &*CHECK_CHILD_PROCESSES;
+        let _ = &*CHECK_LONGEST_POLL;
+        let _ = &*SCHEDULER_TICK_LAG;
+        let _ = &*PROCESS_CPU;
+        let _ = &*CHILD_CPU;
+        let _ = &*CHILD_PROCESSES;
+        let _ = &*ALLOCATIONS;
+        let _ = &*ALLOCATED_BYTES;
+        let _ = &*HEAP_BYTES;
+        let _ = &*RUNTIME_WORKERS;
+        let _ = &*RUNTIME_ALIVE_TASKS;
+        let _ = &*RUNTIME_GLOBAL_QUEUE_DEPTH;
+        let _ = &*RUNTIME_BUSY;
+        Self {
+            devices: RwLock::new(Vec::new()),
+        }
+    }
+
+    /// Bind metric handles for devices up front
+    ///
+    /// Devices seen later are bound on their first update.
+    pub fn register_devices(&self, devices: &[DeviceId]) {
+        for device in devices {
+            self.with_device(device, |_| ());
+        }
+    }
+
+    /// Run `f` with the handles bound for `device`, binding them if needed
+    fn with_device<R>(&self, device: &DeviceId, f: impl FnOnce(&DeviceHandles) -> R) -> R {
+        let index = device.index as usize;
+        {
+            let devices = self.devices.read().unwrap_or_else(|e| e.into_inner());
+            if let Some(Some(handles)) = devices.get(index) {
+                if handles.uuid == device.uuid {
+                    return f(handles);
+                }
+            }
+        }
+
+        let mut devices = self.devices.write().unwrap_or_else(|e| e.into_inner());
+        if devices.len() <= index {
+            devices.resize_with(index + 1, || None);
+        }
+        let slot = &mut devices[index];
+        if !slot.as_ref().is_some_and(|h| h.uuid == device.uuid) {
+            // Drop the replaced device's status series rather than leave
+            // its last state exported forever
+            if let Some(old) = slot.take() {
+                let uuid = old.uuid.as_deref().unwrap_or("");
+                let _ = GPU_STATUS.remove_label_values(&[&old.gpu, uuid, &old.name]);
+            }
+            *slot = Some(DeviceHandles::bind(device));
+        }
+        f(slot.as_ref().expect("handles bound above"))
     }
 
     /// Set GPU count
     pub fn set_gpu_count(&self, count: i64) {
         GPU_COUNT.set(count);
+        changed();
     }
 
     /// Set GPU status
@@ -113,53 +644,176 @@ impl MetricsRegistry {
             HealthState::Unhealthy => 2.0,
             HealthState::Isolated => 3.0,
         };
-        GPU_STATUS
-            .with_label_values(&[
-                &device.index.to_string(),
-                device.uuid.as_deref().unwrap_or(""),
-                &device.name,
-            ])
-            .set(status);
+        self.with_device(device, |h| h.status.set(status));
+        changed();
+    }
+
+    /// Export the telemetry collected by an L1 sweep
+    pub fn observe_device_metrics(&self, device: &DeviceId, metrics: &DeviceMetrics) {
+        self.with_device(device, |h| {
+            h.temperature.set(metrics.temperature as f64);
+            if let Some(temp) = metrics.memory_temperature {
+                h.memory_temperature
+                    .get_or_init(|| GPU_MEMORY_TEMPERATURE.with_label_values(&[&h.gpu]))
+                    .set(temp as f64);
+            }
+            h.utilization.set(metrics.gpu_utilization as f64);
+            h.memory_utilization.set(metrics.memory_utilization as f64);
+            h.memory_used.set(metrics.memory_used as f64);
+            h.memory_total.set(metrics.memory_total as f64);
+            h.memory_free.set(metrics.memory_free as f64);
+            h.power_usage.set(metrics.power_usage as f64);
+            h.power_limit.set(metrics.power_limit as f64);
+            // Reported in KB/s
+            let pcie = |gauge: &OnceCell<Gauge>, direction: &str, kbps: u32| {
+                gauge
+                    .get_or_init(|| GPU_PCIE_THROUGHPUT.with_label_values(&[&h.gpu, direction]))
+                    .set(kbps as f64 * 1024.0)
+            };
+            if let Some(tx) = metrics.pcie_tx {
+                pcie(&h.pcie_tx, "tx", tx);
+            }
+            if let Some(rx) = metrics.pcie_rx {
+                pcie(&h.pcie_rx, "rx", rx);
+            }
+            let ecc = &metrics.ecc_errors;
+            h.ecc[0].set(ecc.single_bit as f64);
+            h.ecc[1].set(ecc.double_bit as f64);
+            h.ecc[2].set(ecc.single_bit_aggregate as f64);
+            h.ecc[3].set(ecc.double_bit_aggregate as f64);
+        });
+        changed();
     }
 
     /// Set GPU temperature
     pub fn set_gpu_temperature(&self, device: &DeviceId, temp: f64) {
-        GPU_TEMPERATURE
-            .with_label_values(&[&device.index.to_string()])
-            .set(temp);
+        self.with_device(device, |h| h.temperature.set(temp));
+        changed();
     }
 
     /// Set GPU utilization
     pub fn set_gpu_utilization(&self, device: &DeviceId, util: f64) {
-        GPU_UTILIZATION
-            .with_label_values(&[&device.index.to_string()])
-            .set(util);
+        self.with_device(device, |h| h.utilization.set(util));
+        changed();
     }
 
     /// Set GPU memory used
     pub fn set_gpu_memory_used(&self, device: &DeviceId, bytes: f64) {
-        GPU_MEMORY_USED
-            .with_label_values(&[&device.index.to_string()])
-            .set(bytes);
+        self.with_device(device, |h| h.memory_used.set(bytes));
+        changed();
     }
 
     /// Record check duration
-    pub fn observe_check_duration(&self, level: &str, device: &DeviceId, duration_secs: f64) {
-        CHECK_DURATION
-            .with_label_values(&[level, &device.index.to_string()])
-            .observe(duration_secs);
+    pub fn observe_check_duration(
+        &self,
+        level: DetectionLevel,
+        device: &DeviceId,
+        duration_secs: f64,
+    ) {
+        let slot = level_slot(level);
+        self.with_device(device, |h| h.check_duration[slot].observe(duration_secs));
+        changed();
+    }
+
+    /// Record the resources one check consumed
+    pub fn observe_check_usage(
+        &self,
+        level: DetectionLevel,
+        device: &DeviceId,
+        usage: &CheckUsage,
+    ) {
+        let slot = level_slot(level);
+        self.with_device(device, |h| {
+            let cost = &h.check_cost[slot];
+            cost.cpu.inc_by(usage.cpu.as_secs_f64());
+            cost.wall.inc_by(usage.wall.as_secs_f64());
+            cost.allocations.inc_by(usage.allocations);
+            cost.allocated_bytes.inc_by(usage.allocated_bytes);
+            cost.child_processes.inc_by(usage.child_processes);
+        });
+        CHECK_LONGEST_POLL
+            .with_label_values(&[level_label(level)])
+            .observe(usage.longest_poll.as_secs_f64());
+        changed();
+    }
+
+    /// Record how late a detection actor woke
+    pub fn observe_tick_lag(&self, level: DetectionLevel, seconds: f64) {
+        SCHEDULER_TICK_LAG
+            .with_label_values(&[level_label(level)])
+            .observe(seconds);
+        changed();
+    }
+
+    /// Export a sample of process-wide resource usage
+    pub fn observe_process_usage(&self, usage: &ProcessUsage) {
+        advance(&PROCESS_CPU, usage.cpu.as_secs_f64());
+        advance(&CHILD_CPU, usage.child_cpu.as_secs_f64());
+        advance_int(&CHILD_PROCESSES, usage.child_processes);
+        advance_int(&ALLOCATIONS, usage.allocations);
+        advance_int(&ALLOCATED_BYTES, usage.allocated_bytes);
+        HEAP_BYTES.set(usage.heap_bytes as i64);
+        if let Some(runtime) = &usage.runtime {
+            RUNTIME_WORKERS.set(runtime.workers as i64);
+            RUNTIME_ALIVE_TASKS.set(runtime.alive_tasks as i64);
+            RUNTIME_GLOBAL_QUEUE_DEPTH.set(runtime.global_queue_depth as i64);
+            advance(&RUNTIME_BUSY, runtime.busy.as_secs_f64());
+        }
+        changed();
     }
 
     /// Increment check failure counter
-    pub fn inc_check_failure(&self, level: &str, device: &DeviceId, reason: &str) {
-        CHECK_FAILURES
-            .with_label_values(&[level, &device.index.to_string(), reason])
-            .inc();
+    pub fn inc_check_failure(&self, level: DetectionLevel, device: &DeviceId, reason: &str) {
+        self.with_device(device, |h| {
+            CHECK_FAILURES
+                .with_label_values(&[level_label(level), &h.gpu, reason])
+                .inc()
+        });
+        changed();
+    }
+
+    /// Increment the advisory finding counter
+    pub fn inc_advisory_finding(&self, level: DetectionLevel, device: &DeviceId, reason: &str) {
+        self.with_device(device, |h| {
+            ADVISORY_FINDINGS
+                .with_label_values(&[level_label(level), &h.gpu, reason])
+                .inc()
+        });
+        changed();
+    }
+
+    /// Increment the driver event counter
+    pub fn inc_device_event(&self, device: &DeviceId, kind: &str) {
+        self.with_device(device, |h| {
+            DEVICE_EVENTS.with_label_values(&[&h.gpu, kind]).inc()
+        });
+        changed();
+    }
+
+    /// Set the effective L2 probe deadline
+    pub fn set_l2_probe_deadline(&self, device: &DeviceId, seconds: f64) {
+        self.with_device(device, |h| h.l2_probe_deadline.set(seconds));
+        changed();
+    }
+
+    /// Increment the skipped L2 probe counter
+    pub fn inc_l2_probe_skipped(&self, device: &DeviceId, reason: &str) {
+        self.with_device(device, |h| {
+            L2_PROBES_SKIPPED.with_label_values(&[&h.gpu, reason]).inc()
+        });
+        changed();
+    }
+
+    /// Record time from first suspicion to completed isolation
+    pub fn observe_time_to_isolation(&self, seconds: f64) {
+        TIME_TO_ISOLATION.observe(seconds);
+        changed();
     }
 
     /// Increment isolation action counter
     pub fn inc_isolation_action(&self, action: &str) {
         ISOLATION_ACTIONS.with_label_values(&[action]).inc();
+        changed();
     }
 }
 
@@ -187,8 +841,109 @@ mod tests {
         registry.set_gpu_temperature(&device, 45.0);
         registry.set_gpu_utilization(&device, 75.0);
         registry.set_gpu_memory_used(&device, 8_000_000_000.0);
-        registry.observe_check_duration("L1", &device, 0.025);
-        registry.inc_check_failure("L2", &device, "timeout");
+        registry.observe_check_duration(DetectionLevel::L1Passive, &device, 0.025);
+        registry.inc_check_failure(DetectionLevel::L2Active, &device, "timeout");
+        registry.inc_advisory_finding(DetectionLevel::L3Pcie, &device, "PerformanceRegression");
+        registry.inc_device_event(&device, "xid");
+        registry.set_l2_probe_deadline(&device, 5.0);
+        registry.inc_l2_probe_skipped(&device, "compute_busy");
+        registry.observe_time_to_isolation(42.0);
         registry.inc_isolation_action("cordon");
     }
+
+    #[test]
+    fn test_device_metrics_exported() {
+        let registry = MetricsRegistry::new();
+        let device = DeviceId {
+            // Out of the way of mock devices in concurrently running tests
+            index: 200,
+            uuid: Some("GPU-EXPORT".to_string()),
+            name: "Test GPU".to_string(),
+        };
+        registry.register_devices(std::slice::from_ref(&device));
+
+        let metrics = DeviceMetrics {
+            temperature: 61,
+            memory_temperature: Some(55),
+            gpu_utilization: 90,
+            memory_utilization: 40,
+            power_usage: 280,
+            power_limit: 400,
+            memory_total: 80 << 30,
+            memory_used: 60 << 30,
+            memory_free: 20 << 30,
+            pcie_tx: Some(2048),
+            pcie_rx: None,
+            ecc_errors: crate::device::EccErrors {
+                single_bit: 3,
+                ..Default::default()
+            },
+            timestamp: chrono::Utc::now(),
+        };
+        registry.observe_device_metrics(&device, &metrics);
+
+        let gauge = |vec: &GaugeVec, labels: &[&str]| vec.with_label_values(labels).get();
+        assert_eq!(gauge(&GPU_TEMPERATURE, &["200"]), 61.0);
+        assert_eq!(gauge(&GPU_MEMORY_TEMPERATURE, &["200"]), 55.0);
+        assert_eq!(gauge(&GPU_POWER_USAGE, &["200"]), 280.0);
+        assert_eq!(gauge(&GPU_MEMORY_FREE, &["200"]), (20u64 << 30) as f64);
+        assert_eq!(gauge(&GPU_PCIE_THROUGHPUT, &["200", "tx"]), 2048.0 * 1024.0);
+        // No RX value was reported, so no RX series was created
+        assert!(GPU_PCIE_THROUGHPUT.remove_label_values(&["200", "rx"]).is_err());
+        assert_eq!(gauge(&GPU_ECC_ERRORS, &["200", "single_bit", "volatile"]), 3.0);
+
+        // A replacement device at the same index gets its own status series
+        let replacement = DeviceId {
+            uuid: Some("GPU-REPLACED".to_string()),
+            ..device.clone()
+        };
+        registry.set_gpu_status(&replacement, HealthState::Suspected);
+        let status = GPU_STATUS.with_label_values(&["200", "GPU-REPLACED", "Test GPU"]);
+        assert_eq!(status.get(), 1.0);
+    }
+
+    #[test]
+    fn test_check_usage_exported() {
+        let registry = MetricsRegistry::new();
+        let device = DeviceId {
+            index: 201,
+            uuid: Some("GPU-USAGE".to_string()),
+            name: "Test GPU".to_string(),
+        };
+        let usage = CheckUsage {
+            cpu: std::time::Duration::from_millis(3),
+            wall: std::time::Duration::from_millis(40),
+            polls: 2,
+            longest_poll: std::time::Duration::from_millis(2),
+            allocations: 12,
+            allocated_bytes: 4096,
+            child_processes: 1,
+        };
+        registry.observe_check_usage(DetectionLevel::L2Active, &device, &usage);
+        registry.observe_check_usage(DetectionLevel::L2Active, &device, &usage);
+
+        let labels = ["L2", "201"];
+        assert!((CHECK_CPU.with_label_values(&labels).get() - 0.006).abs() < 1e-9);
+        assert_eq!(CHECK_ALLOCATIONS.with_label_values(&labels).get(), 24);
+        assert_eq!(CHECK_CHILD_PROCESSES.with_label_values(&labels).get(), 2);
+
+        // Sampled totals only ever move process counters forward
+        let sample = ProcessUsage {
+            allocations: 100,
+            ..Default::default()
+        };
+        registry.observe_process_usage(&sample);
+        let seen = ALLOCATIONS.get();
+        registry.observe_process_usage(&ProcessUsage::default());
+        assert_eq!(ALLOCATIONS.get(), seen);
+        assert!(seen >= 100);
+    }
+
+    #[test]
+    fn test_updates_bump_generation() {
+        let registry = MetricsRegistry::new();
+        let before = MetricsRegistry::generation();
+        registry.set_gpu_count(4);
+        assert!(MetricsRegistry::generation() > before);
+    }
 }
@@ -0,0 +1,332 @@
+//! Daemon self-observability
+//!
+//! Measures what gdnd itself costs the node it watches:
+//! - per-check CPU time, wall time, allocations and child processes,
+//!   attributed by measuring every poll of the check future
+//!   ([`measure`]), so the figures stay correct while tasks migrate
+//!   between runtime workers
+//! - process-wide CPU time (own and reaped children), heap usage and
+//!   tokio runtime load, sampled periodically ([`sample`])
+//!
+//! Allocation figures need [`CountingAllocator`] installed as the global
+//! allocator; without it they read zero. Work a check hands off to a
+//! blocking thread is not attributed to it, and child process CPU only
+//! shows up process-wide once the child has been reaped.
+
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::cell::Cell;
+use std::future::Future;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Arc;
+use std::time::{Duration, Instant};
+
+use tokio::sync::watch;
+
+use crate::metrics::MetricsRegistry;
+
+/// How often [`sample`] refreshes the process-wide metrics by default
+pub const SAMPLE_INTERVAL: Duration = Duration::from_secs(15);
+
+static ALLOCATIONS: AtomicU64 = AtomicU64::new(0);
+static ALLOCATED_BYTES: AtomicU64 = AtomicU64::new(0);
+static FREED_BYTES: AtomicU64 = AtomicU64::new(0);
+static CHILD_PROCESSES: AtomicU64 = AtomicU64::new(0);
+
+/// Per-thread counters, read around each poll to attribute costs to a check
+struct ThreadCounters {
+    allocations: Cell<u64>,
+    allocated_bytes: Cell<u64>,
+    child_processes: Cell<u64>,
+}
+
+thread_local! {
+    // Const-initialized and without a destructor, so safe to touch from
+    // inside the allocator
+    static THREAD: ThreadCounters = const {
+        ThreadCounters {
+            allocations: Cell::new(0),
+            allocated_bytes: Cell::new(0),
+            child_processes: Cell::new(0),
+        }
+    };
+}
+
+fn count_allocation(size: usize) {
+    ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+    ALLOCATED_BYTES.fetch_add(size as u64, Ordering::Relaxed);
+    // Fails only while the thread is being torn down
+    let _ = THREAD.try_with(|t| {
+        t.allocations.set(t.allocations.get() + 1);
+        t.allocated_bytes.set(t.allocated_bytes.get() + size as u64);
+    });
+}
+
+fn count_free(size: usize) {
+    FREED_BYTES.fetch_add(size as u64, Ordering::Relaxed);
+}
+
+/// System allocator that counts allocations for the overhead metrics
+///
+/// Install it in the binary with `#[global_allocator]`.
+pub struct CountingAllocator;
+
+// SAFETY: every call is forwarded unchanged to the system allocator; the
+// bookkeeping neither allocates nor touches the memory.
+unsafe impl GlobalAlloc for CountingAllocator {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        count_allocation(layout.size());
+        System.alloc(layout)
+    }
+
+    unsafe fn alloc_zeroed(&self, layout: Layout) -> *mut u8 {
+        count_allocation(layout.size());
+        System.alloc_zeroed(layout)
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        count_free(layout.size());
+        System.dealloc(ptr, layout)
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        count_free(layout.size());
+        count_allocation(new_size);
+        System.realloc(ptr, layout, new_size)
+    }
+}
+
+/// Record that a child process is being launched
+///
+/// Called at every spawn site, so the process count is attributed to the
+/// check that launched it.
+pub fn record_spawn() {
+    CHILD_PROCESSES.fetch_add(1, Ordering::Relaxed);
+    let _ = THREAD.try_with(|t| t.child_processes.set(t.child_processes.get() + 1));
+}
+
+/// CPU time consumed by the calling thread
+fn thread_cpu_time() -> Duration {
+    let mut ts = libc::timespec {
+        tv_sec: 0,
+        tv_nsec: 0,
+    };
+    // SAFETY: plain syscall writing into a local timespec
+    if unsafe { libc::clock_gettime(libc::CLOCK_THREAD_CPUTIME_ID, &mut ts) } != 0 {
+        return Duration::ZERO;
+    }
+    Duration::new(ts.tv_sec as u64, ts.tv_nsec as u32)
+}
+
+/// Resources one check consumed
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+pub struct CheckUsage {
+    /// CPU time spent polling the check
+    pub cpu: Duration,
+    /// Time from first poll to completion
+    pub wall: Duration,
+    /// Number of times the check was polled
+    pub polls: u64,
+    /// Longest single poll; a long poll stalls its runtime worker
+    pub longest_poll: Duration,
+    /// Heap allocations made while polling
+    pub allocations: u64,
+    /// Bytes allocated while polling
+    pub allocated_bytes: u64,
+    /// Child processes launched
+    pub child_processes: u64,
+}
+
+/// Counters of the current thread at the start of a poll
+struct PollStart {
+    at: Instant,
+    cpu: Duration,
+    allocations: u64,
+    allocated_bytes: u64,
+    child_processes: u64,
+}
+
+impl PollStart {
+    fn now() -> Self {
+        let (allocations, allocated_bytes, child_processes) = THREAD
+            .try_with(|t| {
+                (
+                    t.allocations.get(),
+                    t.allocated_bytes.get(),
+                    t.child_processes.get(),
+                )
+            })
+            .unwrap_or_default();
+        Self {
+            at: Instant::now(),
+            cpu: thread_cpu_time(),
+            allocations,
+            allocated_bytes,
+            child_processes,
+        }
+    }
+
+    /// Add what the thread consumed since this poll started
+    fn finish(self, usage: &mut CheckUsage) {
+        let end = Self::now();
+        let elapsed = end.at - self.at;
+        usage.polls += 1;
+        usage.longest_poll = usage.longest_poll.max(elapsed);
+        usage.cpu += end.cpu.saturating_sub(self.cpu);
+        usage.allocations += end.allocations - self.allocations;
+        usage.allocated_bytes += end.allocated_bytes - self.allocated_bytes;
+        usage.child_processes += end.child_processes - self.child_processes;
+    }
+}
+
+/// Run a future, measuring the resources it consumes
+pub async fn measure<F: Future>(future: F) -> (F::Output, CheckUsage) {
+    futures::pin_mut!(future);
+    let start = Instant::now();
+    let mut usage = CheckUsage::default();
+    let output = std::future::poll_fn(|cx| {
+        let poll_start = PollStart::now();
+        let poll = future.as_mut().poll(cx);
+        poll_start.finish(&mut usage);
+        poll
+    })
+    .await;
+    usage.wall = start.elapsed();
+    (output, usage)
+}
+
+/// Process-wide resource usage
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+pub struct ProcessUsage {
+    /// User and system CPU time of the daemon
+    pub cpu: Duration,
+    /// User and system CPU time of reaped child processes
+    pub child_cpu: Duration,
+    /// Child processes launched
+    pub child_processes: u64,
+    /// Heap allocations made
+    pub allocations: u64,
+    /// Bytes allocated
+    pub allocated_bytes: u64,
+    /// Bytes currently allocated
+    pub heap_bytes: u64,
+    /// Load of the tokio runtime the sample was taken on
+    pub runtime: Option<RuntimeUsage>,
+}
+
+/// Tokio runtime load
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+pub struct RuntimeUsage {
+    /// Worker threads
+    pub workers: usize,
+    /// Tasks spawned and not yet finished
+    pub alive_tasks: usize,
+    /// Tasks waiting in the global queue
+    pub global_queue_depth: usize,
+    /// Time workers spent polling tasks, summed over workers
+    pub busy: Duration,
+}
+
+impl RuntimeUsage {
+    /// Sample the runtime the caller is running on, if any
+    fn current() -> Option<Self> {
+        let metrics = tokio::runtime::Handle::try_current().ok()?.metrics();
+        let workers = metrics.num_workers();
+        Some(Self {
+            workers,
+            alive_tasks: metrics.num_alive_tasks(),
+            global_queue_depth: metrics.global_queue_depth(),
+            busy: (0..workers)
+                .map(|worker| metrics.worker_total_busy_duration(worker))
+                .sum(),
+        })
+    }
+}
+
+/// CPU time of `who` from getrusage
+fn rusage_cpu(who: libc::c_int) -> Duration {
+    // SAFETY: rusage is plain old data
+    let mut usage: libc::rusage = unsafe { std::mem::zeroed() };
+    // SAFETY: plain syscall writing into a local rusage
+    if unsafe { libc::getrusage(who, &mut usage) } != 0 {
+        return Duration::ZERO;
+    }
+    let time = |tv: libc::timeval| {
+        Duration::new(tv.tv_sec as u64, 0) + Duration::from_micros(tv.tv_usec as u64)
+    };
+    time(usage.ru_utime) + time(usage.ru_stime)
+}
+
+impl ProcessUsage {
+    /// Sample the process totals so far
+    pub fn now() -> Self {
+        let allocated_bytes = ALLOCATED_BYTES.load(Ordering::Relaxed);
+        let freed_bytes = FREED_BYTES.load(Ordering::Relaxed);
+        Self {
+            cpu: rusage_cpu(libc::RUSAGE_SELF),
+            child_cpu: rusage_cpu(libc::RUSAGE_CHILDREN),
+            child_processes: CHILD_PROCESSES.load(Ordering::Relaxed),
+            allocations: ALLOCATIONS.load(Ordering::Relaxed),
+            allocated_bytes,
+            heap_bytes: allocated_bytes.saturating_sub(freed_bytes),
+            runtime: RuntimeUsage::current(),
+        }
+    }
+}
+
+/// Periodically export process-wide usage until shutdown
+pub async fn sample(
+    metrics: Arc<MetricsRegistry>,
+    interval: Duration,
+    mut shutdown: watch::Receiver<bool>,
+) {
+    let mut ticker = tokio::time::interval(interval);
+    ticker.set_missed_tick_behavior(tokio::time::MissedTickBehavior::Delay);
+    loop {
+        tokio::select! {
+            _ = ticker.tick() => metrics.observe_process_usage(&ProcessUsage::now()),
+            changed = shutdown.changed() => {
+                if changed.is_err() || *shutdown.borrow() {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[tokio::test]
+    async fn test_measure_attributes_polls() {
+        let (value, usage) = measure(async {
+            tokio::task::yield_now().await;
+            record_spawn();
+            // Burn some CPU so the thread clock moves
+            let mut x = 0u64;
+            for i in 0..200_000u64 {
+                x = std::hint::black_box(x.wrapping_add(i * i));
+            }
+            x
+        })
+        .await;
+
+        assert!(value > 0);
+        assert_eq!(usage.polls, 2);
+        assert_eq!(usage.child_processes, 1);
+        assert!(usage.cpu > Duration::ZERO);
+        assert!(usage.wall >= usage.longest_poll);
+    }
+
+    #[tokio::test]
+    async fn test_process_usage_sample() {
+        let before = ProcessUsage::now();
+        record_spawn();
+        let after = ProcessUsage::now();
+
+        assert!(after.child_processes > before.child_processes);
+        assert!(after.cpu >= before.cpu);
+        let runtime = after.runtime.expect("sampled on a runtime");
+        assert!(runtime.workers >= 1);
+    }
+}
@@ -0,0 +1,440 @@
+//! Trace Replay Harness
+//!
+//! Pushes a recorded device trace through a complete detection pipeline on
+//! a virtual clock and scores the outcome, so threshold and interval
+//! changes can be evaluated against past production behavior instead of
+//! waiting for new failures.
+//!
+//! The scheduler runs unmodified on a paused tokio runtime: whenever every
+//! task is waiting, time jumps to the next timer, so a week of trace takes
+//! seconds. As in the daemon, the replayed device sits behind an inventory
+//! cache, so devices that drop out of a recorded enumeration are reported
+//! as fallen off the bus. Isolations are compared with the trace's fault marks:
+//! - an isolation after a fault on the same device is a detection, with
+//!   the delay reported as time-to-detect
+//! - an isolation without a preceding fault is a false isolation
+//! - a fault that is never followed by an isolation is missed
+
+use std::collections::HashMap;
+use std::fmt;
+use std::io;
+use std::sync::{Arc, Mutex};
+use std::time::Duration;
+
+use anyhow::Result;
+use tokio::sync::watch;
+
+use crate::device::{DeviceInterface, InventoryCache, Trace, TraceReplay};
+use crate::scheduler::{DetectionScheduler, IsolationExecutor};
+use crate::state_machine::{HealthState, StateTransition};
+
+/// Isolation executor that only counts what it would have done
+#[derive(Debug, Default)]
+pub struct ReplayExecutor {
+    executed: Mutex<usize>,
+}
+
+impl ReplayExecutor {
+    /// Number of transitions executed
+    pub fn executed(&self) -> usize {
+        *self.executed.lock().unwrap_or_else(|e| e.into_inner())
+    }
+}
+
+#[async_trait::async_trait]
+impl IsolationExecutor for ReplayExecutor {
+    async fn execute(&self, _transition: &StateTransition) -> Result<()> {
+        *self.executed.lock().unwrap_or_else(|e| e.into_inner()) += 1;
+        Ok(())
+    }
+}
+
+/// A fault that was caught
+#[derive(Debug, Clone, PartialEq)]
+pub struct Detection {
+    /// Device index
+    pub device: u32,
+    /// When the fault was marked, from the trace start
+    pub fault_at: Duration,
+    /// Delay until the device was isolated
+    pub time_to_detect: Duration,
+}
+
+/// Outcome of a replay
+#[derive(Debug, Clone, Default)]
+pub struct ReplayReport {
+    /// Trace time replayed
+    pub span: Duration,
+    /// Devices in the trace
+    pub devices: usize,
+    /// Faults followed by an isolation
+    pub detections: Vec<Detection>,
+    /// Isolations without a preceding fault, as (device, time)
+    pub false_isolations: Vec<(u32, Duration)>,
+    /// Faults never followed by an isolation, as (device, time)
+    pub missed: Vec<(u32, Duration)>,
+}
+
+impl ReplayReport {
+    /// Mean time-to-detect over all detections
+    pub fn mean_time_to_detect(&self) -> Option<Duration> {
+        let count = self.detections.len() as u32;
+        (count > 0).then(|| {
+            self.detections
+                .iter()
+                .map(|d| d.time_to_detect)
+                .sum::<Duration>()
+                / count
+        })
+    }
+
+    /// Worst time-to-detect over all detections
+    pub fn max_time_to_detect(&self) -> Option<Duration> {
+        self.detections.iter().map(|d| d.time_to_detect).max()
+    }
+}
+
+impl fmt::Display for ReplayReport {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        writeln!(
+            f,
+            "replayed {} of trace over {} devices",
+            humantime::format_duration(self.span),
+            self.devices
+        )?;
+        writeln!(
+            f,
+            "detected {} of {} faults, {} false isolations",
+            self.detections.len(),
+            self.detections.len() + self.missed.len(),
+            self.false_isolations.len()
+        )?;
+        if let (Some(mean), Some(max)) = (self.mean_time_to_detect(), self.max_time_to_detect()) {
+            writeln!(
+                f,
+                "time to detect: mean {}, max {}",
+                humantime::format_duration(truncate(mean)),
+                humantime::format_duration(truncate(max))
+            )?;
+        }
+        for d in &self.detections {
+            writeln!(
+                f,
+                "  GPU{}: fault at +{}, detected after {}",
+                d.device,
+                humantime::format_duration(truncate(d.fault_at)),
+                humantime::format_duration(truncate(d.time_to_detect))
+            )?;
+        }
+        for (device, at) in &self.false_isolations {
+            writeln!(
+                f,
+                "  GPU{}: false isolation at +{}",
+                device,
+                humantime::format_duration(truncate(*at))
+            )?;
+        }
+        for (device, at) in &self.missed {
+            writeln!(
+                f,
+                "  GPU{}: fault at +{} missed",
+                device,
+                humantime::format_duration(truncate(*at))
+            )?;
+        }
+        Ok(())
+    }
+}
+
+/// Whole seconds keep the report readable
+fn truncate(duration: Duration) -> Duration {
+    Duration::from_secs(duration.as_secs())
+}
+
+/// Replay a trace through the scheduler built by `build`
+///
+/// `build` receives the replayed device and must not attach anything that
+/// acts on the host (self-healing, persistent stores). The inventory is
+/// attached to the scheduler it returns. Runs on its own
+/// paused runtime, so it must not be called from within a tokio runtime.
+pub fn replay<E, F>(trace: &Trace, build: F) -> io::Result<ReplayReport>
+where
+    E: IsolationExecutor + 'static,
+    F: FnOnce(Arc<dyn DeviceInterface>) -> DetectionScheduler<E>,
+{
+    let runtime = tokio::runtime::Builder::new_current_thread()
+        .enable_time()
+        .start_paused(true)
+        .build()?;
+    runtime.block_on(run(trace, build))
+}
+
+async fn run<E, F>(trace: &Trace, build: F) -> io::Result<ReplayReport>
+where
+    E: IsolationExecutor + 'static,
+    F: FnOnce(Arc<dyn DeviceInterface>) -> DetectionScheduler<E>,
+{
+    let start = tokio::time::Instant::now();
+    // No sysfs to watch; the recorded enumerations are picked up by age
+    let inventory = Arc::new(InventoryCache::new(
+        Arc::new(TraceReplay::new(trace)),
+        Vec::new(),
+    ));
+    let device: Arc<dyn DeviceInterface> = inventory.clone();
+    let devices = device.list_devices().await.unwrap_or_default();
+    let scheduler = Arc::new(build(Arc::clone(&device)).with_inventory(inventory));
+
+    // Every isolation as (device, time), in the order they happened
+    let isolations = Arc::new(Mutex::new(Vec::new()));
+    for d in &devices {
+        let mut state = scheduler.watch_state(d);
+        let isolations = Arc::clone(&isolations);
+        let index = d.index;
+        tokio::spawn(async move {
+            let mut isolated = false;
+            while state.changed().await.is_ok() {
+                let now = matches!(
+                    *state.borrow_and_update(),
+                    HealthState::Unhealthy | HealthState::Isolated
+                );
+                if now && !isolated {
+                    isolations
+                        .lock()
+                        .unwrap_or_else(|e| e.into_inner())
+                        .push((index, start.elapsed()));
+                }
+                isolated = now;
+            }
+        });
+    }
+
+    let (shutdown_tx, shutdown_rx) = watch::channel(false);
+    let pipeline = tokio::spawn(Arc::clone(&scheduler).run(shutdown_rx));
+    tokio::time::sleep(trace.span()).await;
+    let _ = shutdown_tx.send(true);
+    match pipeline.await {
+        Ok(Ok(())) => {}
+        Ok(Err(e)) => return Err(io::Error::new(io::ErrorKind::Other, e.to_string())),
+        Err(e) => return Err(io::Error::new(io::ErrorKind::Other, e)),
+    }
+
+    let isolations = std::mem::take(&mut *isolations.lock().unwrap_or_else(|e| e.into_inner()));
+    Ok(score(trace, devices.len(), isolations))
+}
+
+/// Match isolations against fault marks
+fn score(trace: &Trace, devices: usize, isolations: Vec<(u32, Duration)>) -> ReplayReport {
+    let mut faults: HashMap<u32, Vec<Duration>> = HashMap::new();
+    for (device, at) in trace.faults() {
+        faults.entry(device).or_default().push(at);
+    }
+
+    let mut report = ReplayReport {
+        span: trace.span(),
+        devices,
+        ..ReplayReport::default()
+    };
+    for (device, at) in isolations {
+        // The earliest outstanding fault is the one being caught
+        let pending = faults.get_mut(&device);
+        match pending.filter(|p| p.first().is_some_and(|fault| *fault <= at)) {
+            Some(pending) => {
+                let fault_at = pending.remove(0);
+                // Later faults before this isolation are the same incident
+                pending.retain(|fault| *fault > at);
+                report.detections.push(Detection {
+                    device,
+                    fault_at,
+                    time_to_detect: at - fault_at,
+                });
+            }
+            None => report.false_isolations.push((device, at)),
+        }
+    }
+    report.missed = faults
+        .into_iter()
+        .flat_map(|(device, pending)| pending.into_iter().map(move |at| (device, at)))
+        .collect();
+    report.missed.sort();
+    report
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::detection::{L1PassiveDetector, L2ActiveDetector, WorkloadConfig, WorkloadTracker};
+    use crate::device::{
+        CheckResult, DeviceId, DeviceMetrics, EccErrors, TraceEntry, TraceResponse,
+    };
+    use crate::metrics::MetricsRegistry;
+    use crate::scheduler::SchedulePolicy;
+    use crate::state_machine::GpuHealthManager;
+
+    const HOUR: i64 = 3_600_000;
+
+    fn entries() -> Vec<TraceEntry> {
+        let devices: Vec<DeviceId> = (0..2)
+            .map(|index| DeviceId {
+                index,
+                uuid: Some(format!("GPU-REPLAY-{}", index)),
+                name: "Replay GPU".to_string(),
+            })
+            .collect();
+        let mut entries = vec![TraceEntry {
+            t: 0,
+            d: None,
+            response: TraceResponse::Devices(Ok(devices)),
+        }];
+        let mut check = |t: i64, device: u32, passed: bool| {
+            let result = if passed {
+                CheckResult::success(Duration::from_millis(50))
+            } else {
+                CheckResult::failure(Duration::from_millis(50), "hang".to_string(), None)
+            };
+            entries.push(TraceEntry {
+                t,
+                d: Some(device),
+                response: TraceResponse::ActiveCheck(Ok(result)),
+            });
+        };
+        // GPU0 hangs for good after 2 hours; GPU1 has one 10-minute blip
+        check(0, 0, true);
+        check(2 * HOUR, 0, false);
+        check(0, 1, true);
+        check(5 * HOUR, 1, false);
+        check(5 * HOUR + 600_000, 1, true);
+        check(24 * HOUR, 1, true);
+        entries.push(TraceEntry {
+            t: 2 * HOUR,
+            d: Some(0),
+            response: TraceResponse::Fault,
+        });
+        entries
+    }
+
+    fn trace() -> Trace {
+        Trace::new(entries())
+    }
+
+    /// Metrics of a device running flat out
+    fn busy(device: u32) -> TraceEntry {
+        TraceEntry {
+            t: 0,
+            d: Some(device),
+            response: TraceResponse::Metrics(Ok(DeviceMetrics {
+                temperature: 60,
+                memory_temperature: None,
+                gpu_utilization: 100,
+                memory_utilization: 70,
+                power_usage: 600,
+                power_limit: 700,
+                memory_total: 80 << 30,
+                memory_used: 70 << 30,
+                memory_free: 10 << 30,
+                pcie_tx: None,
+                pcie_rx: None,
+                ecc_errors: EccErrors::default(),
+                timestamp: chrono::Utc::now(),
+            })),
+        }
+    }
+
+    fn pipeline(
+        device: Arc<dyn DeviceInterface>,
+        l2: Duration,
+    ) -> DetectionScheduler<ReplayExecutor> {
+        DetectionScheduler::new(
+            L1PassiveDetector::new(Arc::clone(&device), 85, vec![31, 43, 48, 79]),
+            L2ActiveDetector::new(device, "/nonexistent".to_string(), Duration::from_secs(30)),
+            Arc::new(GpuHealthManager::new(3, vec![31, 43, 48, 79])),
+            Arc::new(ReplayExecutor::default()),
+            Arc::new(MetricsRegistry::new()),
+            Duration::from_secs(60),
+            l2,
+        )
+        .with_schedule(SchedulePolicy {
+            jitter: 0.0,
+            ..SchedulePolicy::default()
+        })
+    }
+
+    #[test]
+    fn test_replay_scores_interval_choices() {
+        let trace = trace();
+        let started = std::time::Instant::now();
+
+        // Probing every 5 minutes catches the hang and sits out the blip
+        let report = replay(&trace, |device| pipeline(device, Duration::from_secs(300))).unwrap();
+        assert_eq!(report.span, Duration::from_secs(24 * 3600));
+        assert_eq!(report.devices, 2);
+        assert!(report.false_isolations.is_empty(), "{}", report);
+        assert!(report.missed.is_empty(), "{}", report);
+        let ttd = report.detections[0].time_to_detect;
+        assert!(ttd <= Duration::from_secs(15 * 60), "{}", report);
+
+        // Probing every minute isolates GPU1 during the blip
+        let report = replay(&trace, |device| pipeline(device, Duration::from_secs(60))).unwrap();
+        assert_eq!(report.detections.len(), 1, "{}", report);
+        assert_eq!(report.false_isolations.len(), 1, "{}", report);
+        assert_eq!(report.false_isolations[0].0, 1);
+
+        assert!(started.elapsed() < Duration::from_secs(30));
+    }
+
+    #[test]
+    fn test_replay_defers_probes_on_busy_devices() {
+        let mut entries = entries();
+        entries.extend([busy(0), busy(1)]);
+        let trace = Trace::new(entries);
+        let workload = WorkloadConfig {
+            max_deferral: Duration::from_secs(35 * 60),
+            ..WorkloadConfig::default()
+        };
+
+        // Busy devices are probed once per deferral on the replay clock, which
+        // steps over GPU1's blip and still catches GPU0's hang
+        let report = replay(&trace, |device| {
+            pipeline(device, Duration::from_secs(60))
+                .with_workload(Arc::new(WorkloadTracker::new(workload)))
+        })
+        .unwrap();
+        assert!(report.false_isolations.is_empty(), "{}", report);
+        assert!(report.missed.is_empty(), "{}", report);
+        let ttd = report.detections[0].time_to_detect;
+        assert!(ttd > Duration::from_secs(5 * 60), "{}", report);
+        assert!(ttd <= Duration::from_secs(40 * 60), "{}", report);
+    }
+
+    #[test]
+    fn test_replay_reports_devices_fallen_off_the_bus() {
+        let mut entries = entries();
+        // GPU0 drops out of the enumeration at 3 hours
+        entries.push(TraceEntry {
+            t: 3 * HOUR,
+            d: None,
+            response: TraceResponse::Devices(Ok(vec![DeviceId {
+                index: 1,
+                uuid: Some("GPU-REPLAY-1".to_string()),
+                name: "Replay GPU".to_string(),
+            }])),
+        });
+        entries.push(TraceEntry {
+            t: 3 * HOUR,
+            d: Some(0),
+            response: TraceResponse::Fault,
+        });
+        let trace = Trace::new(entries);
+
+        // Probing hourly leaves the hang to the inventory to catch
+        let report = replay(&trace, |device| pipeline(device, Duration::from_secs(3600))).unwrap();
+        assert_eq!(report.detections.len(), 1, "{}", report);
+        let detection = &report.detections[0];
+        assert_eq!(detection.device, 0);
+        assert_eq!(detection.fault_at, Duration::from_secs(2 * 3600));
+        assert!(
+            detection.time_to_detect <= Duration::from_secs(3600 + 6 * 60),
+            "{}",
+            report
+        );
+    }
+}
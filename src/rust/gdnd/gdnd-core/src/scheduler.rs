@@ -1,17 +1,42 @@
 //! Detection Scheduler
 //!
-//! Coordinates L1 and L2 detection loops and handles state transitions.
+//! Coordinates L1, L2 and L3 detection and handles state transitions.
+//!
+//! Each device gets one lightweight actor task per detection level, with its
+//! own interval, startup jitter and missed-tick handling. Actors only
+//! coordinate through the health manager, so a slow check on one device or
+//! level never delays detection anywhere else.
+//!
+//! Intervals can differ per health state (e.g. aggressive re-probing while
+//! SUSPECTED, backing off once ISOLATED); state transitions reschedule a
+//! device's actors immediately.
+//!
+//! Driver error events (XID, ECC), where the device provides them, are
+//! applied as soon as they arrive and trigger an out-of-cycle L2 probe.
+//!
+//! With workload-aware probing enabled, scheduled L2 probes are skipped on
+//! busy healthy devices and run early on allocated devices that have gone
+//! silent.
 
-use std::sync::Arc;
+use std::collections::HashMap;
+use std::hash::{BuildHasher, Hasher};
+use std::sync::{Arc, Mutex};
 use std::time::{Duration, Instant};
 
 use anyhow::Result;
-use tokio::sync::{watch, RwLock};
+use futures::{Stream, StreamExt};
+use tokio::sync::{mpsc, watch, Notify, Semaphore, SemaphorePermit};
+use tokio::task::JoinSet;
 use tracing::{debug, error, info, warn};
 
-use crate::detection::{DetectionLevel, DetectionResult, L1PassiveDetector, L2ActiveDetector, L3PcieDetector};
+use crate::detection::{
+    DetectionLevel, DetectionResult, L1PassiveDetector, L2ActiveDetector, L3PcieDetector,
+    PeerAnalyzer, ProbeDecision, SkipReason, SweepItem, WorkloadTracker,
+};
+use crate::device::{DeviceEvent, DeviceId, InventoryCache};
 use crate::healing::SelfHealer;
 use crate::metrics::MetricsRegistry;
+use crate::overhead;
 use crate::state_machine::{GpuHealthManager, HealthEvent, HealthState, StateTransition};
 
 /// Trait for executing isolation actions
@@ -21,18 +46,104 @@ pub trait IsolationExecutor: Send + Sync {
     async fn execute(&self, transition: &StateTransition) -> Result<()>;
 }
 
+/// Behavior when a check overruns one or more scheduled ticks
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum MissedTickPolicy {
+    /// Run missed checks back-to-back until caught up
+    Burst,
+    /// Schedule the next check one interval after the late one finished
+    Delay,
+    /// Drop missed ticks and stay aligned to the original cadence
+    #[default]
+    Skip,
+}
+
+impl MissedTickPolicy {
+    /// Next deadline for a check scheduled at `scheduled` that finished at `now`
+    pub fn next_deadline(
+        self,
+        scheduled: tokio::time::Instant,
+        now: tokio::time::Instant,
+        interval: Duration,
+    ) -> tokio::time::Instant {
+        let next = scheduled + interval;
+        if next > now || interval.is_zero() {
+            return next;
+        }
+
+        match self {
+            MissedTickPolicy::Burst => next,
+            MissedTickPolicy::Delay => now + interval,
+            MissedTickPolicy::Skip => {
+                let missed = (now - scheduled).as_nanos() / interval.as_nanos();
+                let ticks = u32::try_from(missed + 1).unwrap_or(u32::MAX);
+                scheduled + interval.saturating_mul(ticks)
+            }
+        }
+    }
+}
+
+/// Scheduling policy applied to every device actor
+#[derive(Debug, Clone)]
+pub struct SchedulePolicy {
+    /// Maximum random startup delay, as a fraction of the level interval
+    pub jitter: f64,
+    /// Behavior when a check overruns its next tick
+    pub missed_tick: MissedTickPolicy,
+}
+
+impl Default for SchedulePolicy {
+    fn default() -> Self {
+        Self {
+            jitter: 0.1,
+            missed_tick: MissedTickPolicy::default(),
+        }
+    }
+}
+
+/// Interval overrides for one health state (None = level default)
+#[derive(Debug, Clone, Copy, Default)]
+pub struct StateIntervals {
+    /// L1 passive detection interval
+    pub l1: Option<Duration>,
+    /// L2 active detection interval
+    pub l2: Option<Duration>,
+    /// L3 PCIe detection interval
+    pub l3: Option<Duration>,
+}
+
+impl StateIntervals {
+    /// Override for a detection level
+    pub fn get(&self, level: DetectionLevel) -> Option<Duration> {
+        match level {
+            DetectionLevel::L1Passive => self.l1,
+            DetectionLevel::L2Active => self.l2,
+            DetectionLevel::L3Pcie => self.l3,
+        }
+    }
+}
+
 /// Detection scheduler
 pub struct DetectionScheduler<E: IsolationExecutor> {
     l1_detector: L1PassiveDetector,
     l2_detector: L2ActiveDetector,
     l3_detector: Option<L3PcieDetector>,
-    health_manager: Arc<RwLock<GpuHealthManager>>,
+    health_manager: Arc<GpuHealthManager>,
     isolation_executor: Arc<E>,
     healer: Option<Arc<SelfHealer>>,
+    peer_analyzer: Option<PeerAnalyzer>,
+    workload: Option<Arc<WorkloadTracker>>,
+    inventory: Option<Arc<InventoryCache>>,
     metrics: Arc<MetricsRegistry>,
     l1_interval: Duration,
     l2_interval: Duration,
     l3_interval: Option<Duration>,
+    schedule: SchedulePolicy,
+    state_intervals: HashMap<HealthState, StateIntervals>,
+    /// Health state broadcast per device index, used to reschedule actors
+    state_watchers: Mutex<HashMap<u32, watch::Sender<HealthState>>>,
+    /// Out-of-cycle L2 probe requests per device index
+    probe_requests: Mutex<HashMap<u32, Arc<Notify>>>,
 }
 
 impl<E: IsolationExecutor + 'static> DetectionScheduler<E> {
@@ -40,23 +151,30 @@ impl<E: IsolationExecutor + 'static> DetectionScheduler<E> {
     pub fn new(
         l1_detector: L1PassiveDetector,
         l2_detector: L2ActiveDetector,
-        health_manager: Arc<RwLock<GpuHealthManager>>,
+        health_manager: Arc<GpuHealthManager>,
         isolation_executor: Arc<E>,
         metrics: Arc<MetricsRegistry>,
         l1_interval: Duration,
         l2_interval: Duration,
     ) -> Self {
         Self {
-            l1_detector,
+            l1_detector: l1_detector.with_metrics(Arc::clone(&metrics)),
             l2_detector,
             l3_detector: None,
             health_manager,
             isolation_executor,
             healer: None,
+            peer_analyzer: None,
+            workload: None,
+            inventory: None,
             metrics,
             l1_interval,
             l2_interval,
             l3_interval: None,
+            schedule: SchedulePolicy::default(),
+            state_intervals: HashMap::new(),
+            state_watchers: Mutex::new(HashMap::new()),
+            probe_requests: Mutex::new(HashMap::new()),
         }
     }
 
@@ -66,6 +184,35 @@ impl<E: IsolationExecutor + 'static> DetectionScheduler<E> {
         self
     }
 
+    /// Compare devices against their peers after every check
+    pub fn with_peer_analysis(mut self, mut analyzer: PeerAnalyzer) -> Self {
+        if let Some(ref workload) = self.workload {
+            analyzer = analyzer.with_workload(Arc::clone(workload));
+        }
+        self.peer_analyzer = Some(analyzer);
+        self
+    }
+
+    /// Gate L2 probes on device load sampled by L1
+    ///
+    /// Peer analysis also uses it to leave loaded devices out.
+    pub fn with_workload(mut self, workload: Arc<WorkloadTracker>) -> Self {
+        self.l1_detector = self.l1_detector.with_workload(Arc::clone(&workload));
+        self.peer_analyzer = self
+            .peer_analyzer
+            .take()
+            .map(|analyzer| analyzer.with_workload(Arc::clone(&workload)));
+        self.workload = Some(workload);
+        self
+    }
+
+    /// Report devices missing from the inventory, and refresh it after healing
+    pub fn with_inventory(mut self, inventory: Arc<InventoryCache>) -> Self {
+        self.l1_detector = self.l1_detector.with_inventory(Arc::clone(&inventory));
+        self.inventory = Some(inventory);
+        self
+    }
+
     /// Set the L3 PCIe detector for bandwidth testing
     pub fn with_l3(mut self, detector: L3PcieDetector, interval: Duration) -> Self {
         self.l3_detector = Some(detector);
@@ -73,75 +220,411 @@ impl<E: IsolationExecutor + 'static> DetectionScheduler<E> {
         self
     }
 
-    /// Run the detection loop
-    pub async fn run(&self, mut shutdown: watch::Receiver<bool>) -> Result<()> {
+    /// Set the actor scheduling policy (jitter, missed ticks)
+    pub fn with_schedule(mut self, schedule: SchedulePolicy) -> Self {
+        self.schedule = schedule;
+        self
+    }
+
+    /// Override detection intervals while a device is in `state`
+    pub fn with_state_intervals(mut self, state: HealthState, intervals: StateIntervals) -> Self {
+        self.state_intervals.insert(state, intervals);
+        self
+    }
+
+    /// Effective interval for a level given a device's health state
+    pub fn interval_for(&self, level: DetectionLevel, state: HealthState) -> Duration {
+        let default = match level {
+            DetectionLevel::L1Passive => self.l1_interval,
+            DetectionLevel::L2Active => self.l2_interval,
+            DetectionLevel::L3Pcie => self.l3_interval.unwrap_or(self.l2_interval),
+        };
+        self.state_intervals
+            .get(&state)
+            .and_then(|intervals| intervals.get(level))
+            .unwrap_or(default)
+    }
+
+    /// Run the detection actors until shutdown
+    ///
+    /// The device list is re-read every L1 interval: actors are started for
+    /// devices that appear and stopped for devices no longer listed.
+    pub async fn run(self: Arc<Self>, mut shutdown: watch::Receiver<bool>) -> Result<()> {
+        let devices = self.l1_detector.list_devices().await?;
+
         info!(
+            devices = devices.len(),
             l1_interval = ?self.l1_interval,
             l2_interval = ?self.l2_interval,
             l3_interval = ?self.l3_interval,
             l3_enabled = self.l3_detector.is_some(),
+            jitter = self.schedule.jitter,
+            missed_tick = ?self.schedule.missed_tick,
             "Starting detection scheduler"
         );
 
-        let mut l1_ticker = tokio::time::interval(self.l1_interval);
-        let mut l2_ticker = tokio::time::interval(self.l2_interval);
+        // Concurrency limits are per level so a long L3 test never starves L1/L2
+        let mut levels = vec![
+            (
+                DetectionLevel::L1Passive,
+                Arc::new(Semaphore::new(self.l1_detector.concurrency())),
+            ),
+            (
+                DetectionLevel::L2Active,
+                Arc::new(Semaphore::new(self.l2_detector.concurrency())),
+            ),
+        ];
+        if let Some(detector) = &self.l3_detector {
+            if detector.skips_all() {
+                debug!("PCIe test not supported, no L3 actors started");
+            } else {
+                levels.push((
+                    DetectionLevel::L3Pcie,
+                    Arc::new(Semaphore::new(detector.concurrency())),
+                ));
+            }
+        }
 
-        // Skip immediate first tick
-        l1_ticker.tick().await;
-        l2_ticker.tick().await;
+        let mut actors = JoinSet::new();
+        let mut running = HashMap::new();
+        self.reconcile(&devices, &levels, &mut running, &mut actors);
 
-        // L3 ticker only if enabled
-        let mut l3_ticker = self.l3_interval.map(tokio::time::interval);
-        if let Some(ref mut ticker) = l3_ticker {
-            ticker.tick().await;
+        // Driver events bypass the L1 cadence entirely
+        if let Some(events) = self.l1_detector.subscribe_events().await {
+            actors.spawn(Arc::clone(&self).event_listener(events, shutdown.clone()));
         }
+        debug!(actors = actors.len(), "Detection actors started");
 
+        let mut inventory = tokio::time::interval(self.l1_interval);
+        inventory.set_missed_tick_behavior(tokio::time::MissedTickBehavior::Delay);
+        inventory.tick().await;
         loop {
             tokio::select! {
-                _ = l1_ticker.tick() => {
-                    if let Err(e) = self.run_l1_detection().await {
-                        error!(error = %e, "L1 detection failed");
+                _ = inventory.tick() => match self.l1_detector.list_devices().await {
+                    Ok(devices) => self.reconcile(&devices, &levels, &mut running, &mut actors),
+                    Err(e) => warn!(error = %e, "Failed to list devices, keeping current actors"),
+                },
+                Some(joined) = actors.join_next() => {
+                    if let Err(e) = joined {
+                        error!(error = %e, "Detection actor panicked");
                     }
                 }
-                _ = l2_ticker.tick() => {
-                    if let Err(e) = self.run_l2_detection().await {
-                        error!(error = %e, "L2 detection failed");
+                changed = shutdown.changed() => {
+                    if changed.is_err() || *shutdown.borrow() {
+                        break;
                     }
                 }
-                _ = async {
-                    if let Some(ref mut ticker) = l3_ticker {
-                        ticker.tick().await
-                    } else {
-                        std::future::pending::<tokio::time::Instant>().await
+            }
+        }
+
+        for stop in running.values() {
+            let _ = stop.send(true);
+        }
+        while let Some(joined) = actors.join_next().await {
+            if let Err(e) = joined {
+                error!(error = %e, "Detection actor panicked");
+            }
+        }
+
+        info!("Shutdown signal received, detection scheduler stopped");
+        Ok(())
+    }
+
+    /// Start actors for newly listed devices and stop those of devices gone
+    ///
+    /// Devices are keyed by index and UUID, so a board replaced in the same
+    /// slot gets fresh actors.
+    fn reconcile(
+        self: &Arc<Self>,
+        devices: &[DeviceId],
+        levels: &[(DetectionLevel, Arc<Semaphore>)],
+        running: &mut HashMap<(u32, Option<String>), watch::Sender<bool>>,
+        actors: &mut JoinSet<()>,
+    ) {
+        let before = running.len();
+        running.retain(|(index, uuid), stop| {
+            let listed = devices.iter().any(|d| d.index == *index && d.uuid == *uuid);
+            if !listed {
+                info!(device = index, "Device no longer listed, stopping detection");
+                let _ = stop.send(true);
+            }
+            listed
+        });
+        if running.len() < before {
+            if let Some(analyzer) = &self.peer_analyzer {
+                analyzer.retain_devices(devices);
+            }
+        }
+
+        let added: Vec<DeviceId> = devices
+            .iter()
+            .filter(|d| !running.contains_key(&(d.index, d.uuid.clone())))
+            .cloned()
+            .collect();
+        if added.is_empty() {
+            return;
+        }
+        self.health_manager.register(&added);
+        self.metrics.register_devices(&added);
+
+        for device in added {
+            debug!(device = %device, "Starting detection actors");
+            let (stop_tx, stop_rx) = watch::channel(false);
+            let state_rx = self.watch_state(&device);
+            for (level, permits) in levels {
+                actors.spawn(Arc::clone(self).device_actor(
+                    *level,
+                    device.clone(),
+                    Arc::clone(permits),
+                    stop_rx.clone(),
+                    state_rx.clone(),
+                ));
+            }
+            running.insert((device.index, device.uuid.clone()), stop_tx);
+        }
+    }
+
+    /// Subscribe to a device's health state
+    pub fn watch_state(&self, device: &DeviceId) -> watch::Receiver<HealthState> {
+        let state = self
+            .health_manager
+            .state(device)
+            .unwrap_or(HealthState::Healthy);
+
+        let mut watchers = self.state_watchers.lock().unwrap_or_else(|e| e.into_inner());
+        watchers
+            .entry(device.index)
+            .or_insert_with(|| watch::channel(state).0)
+            .subscribe()
+    }
+
+    /// Notify a device's actors of its current health state
+    fn publish_state(&self, device: &DeviceId, state: HealthState) {
+        let watchers = self.state_watchers.lock().unwrap_or_else(|e| e.into_inner());
+        if let Some(tx) = watchers.get(&device.index) {
+            tx.send_if_modified(|current| {
+                let changed = *current != state;
+                *current = state;
+                changed
+            });
+        }
+    }
+
+    /// Wake-up signal for out-of-cycle L2 probes on a device
+    fn probe_signal(&self, device: &DeviceId) -> Arc<Notify> {
+        let mut requests = self.probe_requests.lock().unwrap_or_else(|e| e.into_inner());
+        Arc::clone(requests.entry(device.index).or_default())
+    }
+
+    /// Run an L2 probe on a device as soon as possible
+    ///
+    /// Requests made while a probe is already pending are coalesced.
+    pub fn request_probe(&self, device: &DeviceId) {
+        self.probe_signal(device).notify_one();
+    }
+
+    /// Reason to skip a scheduled L2 probe, if any
+    ///
+    /// Only healthy devices are gated: suspicion must always be confirmed.
+    fn probe_deferral(&self, device: &DeviceId, state: HealthState) -> Option<SkipReason> {
+        let workload = self.workload.as_ref()?;
+        if state != HealthState::Healthy {
+            return None;
+        }
+        match workload.decide(device) {
+            ProbeDecision::Run => None,
+            ProbeDecision::Skip(reason) => Some(reason),
+        }
+    }
+
+    /// Apply driver error events as they arrive
+    ///
+    /// Each event is processed as a failed L1 check and triggers an
+    /// out-of-cycle L2 probe on its device.
+    async fn event_listener(
+        self: Arc<Self>,
+        mut events: mpsc::Receiver<DeviceEvent>,
+        mut shutdown: watch::Receiver<bool>,
+    ) {
+        loop {
+            let event = tokio::select! {
+                event = events.recv() => match event {
+                    Some(event) => event,
+                    None => {
+                        warn!("Device event stream ended, relying on L1 polling");
+                        break;
                     }
-                } => {
-                    if let Err(e) = self.run_l3_detection().await {
-                        error!(error = %e, "L3 detection failed");
+                },
+                changed = shutdown.changed() => {
+                    if changed.is_err() || *shutdown.borrow() {
+                        break;
                     }
+                    continue;
                 }
-                _ = shutdown.changed() => {
-                    if *shutdown.borrow() {
-                        info!("Shutdown signal received, stopping scheduler");
+            };
+
+            // Resolved per event so devices added since startup are covered
+            let devices = self.l1_detector.list_devices().await.unwrap_or_default();
+            let Some(device) = devices.iter().find(|d| d.index == event.device_index()) else {
+                debug!(device = event.device_index(), "Event for unknown device");
+                continue;
+            };
+            self.metrics.inc_device_event(device, event.kind());
+
+            let result = self.l1_detector.event_result(device.clone(), &event);
+            if let Err(e) = self.process_result(&result).await {
+                error!(device = %device, error = %e, "Failed to process device event");
+            }
+            self.request_probe(device);
+        }
+    }
+
+    /// Detection loop for a single device at a single level
+    async fn device_actor(
+        self: Arc<Self>,
+        level: DetectionLevel,
+        device: DeviceId,
+        permits: Arc<Semaphore>,
+        mut shutdown: watch::Receiver<bool>,
+        mut state_rx: watch::Receiver<HealthState>,
+    ) {
+        let mut interval = self.interval_for(level, *state_rx.borrow_and_update());
+        let jitter = interval
+            .mul_f64(self.schedule.jitter.clamp(0.0, 1.0) * random_fraction(&device, level));
+        let mut last_run = tokio::time::Instant::now();
+        let mut scheduled = last_run + interval + jitter;
+        let probe_signal = self.probe_signal(&device);
+        debug!(device = %device, level = %level, jitter = ?jitter, "Detection actor started");
+
+        loop {
+            let mut requested = false;
+            tokio::select! {
+                _ = tokio::time::sleep_until(scheduled) => {
+                    let lag = tokio::time::Instant::now().saturating_duration_since(scheduled);
+                    self.metrics.observe_tick_lag(level, lag.as_secs_f64());
+                }
+                _ = probe_signal.notified(), if level == DetectionLevel::L2Active => {
+                    // Restart the cadence from this out-of-cycle probe
+                    requested = true;
+                    scheduled = tokio::time::Instant::now();
+                }
+                changed = state_rx.changed() => {
+                    if changed.is_err() {
+                        break;
+                    }
+                    // Reschedule relative to the last check at the new state's cadence
+                    let state = *state_rx.borrow_and_update();
+                    let new_interval = self.interval_for(level, state);
+                    if new_interval != interval {
+                        interval = new_interval;
+                        scheduled = (last_run + interval).max(tokio::time::Instant::now());
+                        debug!(
+                            device = %device,
+                            level = %level,
+                            state = %state,
+                            interval = ?interval,
+                            "Rescheduled after state change"
+                        );
+                    }
+                    continue;
+                }
+                changed = shutdown.changed() => {
+                    if changed.is_err() || *shutdown.borrow() {
                         break;
                     }
+                    continue;
+                }
+            }
+
+            let deferral = if level == DetectionLevel::L2Active && !requested {
+                self.probe_deferral(&device, *state_rx.borrow())
+            } else {
+                None
+            };
+            if let Some(reason) = deferral {
+                debug!(device = %device, reason = %reason, "Skipping L2 probe on busy device");
+                self.metrics.inc_l2_probe_skipped(&device, reason.as_str());
+            } else {
+                let Ok(permit) = permits.acquire().await else {
+                    break;
+                };
+                last_run = tokio::time::Instant::now();
+                if let Err(e) = self.check_device(level, &device, permit).await {
+                    error!(device = %device, level = %level, error = %e, "Detection failed");
                 }
             }
+
+            interval = self.interval_for(level, *state_rx.borrow_and_update());
+            let now = tokio::time::Instant::now();
+            scheduled = self
+                .schedule
+                .missed_tick
+                .next_deadline(scheduled, now, interval);
         }
 
+        debug!(device = %device, level = %level, "Detection actor stopped");
+    }
+
+    /// Run one check on one device and act on the result
+    ///
+    /// The level's concurrency permit only covers the check itself, so acting
+    /// on the result (isolation, healing) never holds up other devices.
+    async fn check_device(
+        &self,
+        level: DetectionLevel,
+        device: &DeviceId,
+        permit: SemaphorePermit<'_>,
+    ) -> Result<()> {
+        let start = Instant::now();
+
+        let check = async {
+            match level {
+                DetectionLevel::L1Passive => self.l1_detector.detect(device).await.map(Some),
+                DetectionLevel::L2Active => self.l2_detector.detect(device).await.map(Some),
+                DetectionLevel::L3Pcie => match &self.l3_detector {
+                    Some(detector) => detector.detect(device).await.map(Some),
+                    None => Ok(None),
+                },
+            }
+        };
+        let (result, usage) = overhead::measure(check).await;
+        drop(permit);
+        self.metrics.observe_check_usage(level, device, &usage);
+        let Some(mut result) = result? else {
+            return Ok(());
+        };
+
+        if let Some(ref workload) = self.workload {
+            match level {
+                DetectionLevel::L1Passive if workload.is_silent(device) => {
+                    info!(device = %device, "Device allocated but idle, probing early");
+                    self.request_probe(device);
+                }
+                DetectionLevel::L2Active => workload.record_probe(device),
+                _ => {}
+            }
+        }
+
+        self.compare_with_peers(&mut result);
+        self.process_result(&result).await?;
+        self.update_metrics(&result, start.elapsed());
         Ok(())
     }
 
+    /// Compare a result against the latest values of peer devices
+    fn compare_with_peers(&self, result: &mut DetectionResult) {
+        if let Some(analyzer) = &self.peer_analyzer {
+            analyzer.compare_latest(result);
+        }
+    }
+
     /// Run L1 passive detection on all devices
     async fn run_l1_detection(&self) -> Result<()> {
         debug!("Running L1 passive detection");
         let start = Instant::now();
 
-        let results = self.l1_detector.detect_all().await?;
-
-        for result in results {
-            self.process_result(&result).await?;
-            self.update_metrics(&result, start.elapsed());
-        }
+        let sweep = self.l1_detector.sweep().await?;
+        self.process_sweep(DetectionLevel::L1Passive, sweep).await?;
 
         debug!(duration = ?start.elapsed(), "L1 detection complete");
         Ok(())
@@ -152,12 +635,8 @@ impl<E: IsolationExecutor + 'static> DetectionScheduler<E> {
         debug!("Running L2 active detection");
         let start = Instant::now();
 
-        let results = self.l2_detector.detect_all().await?;
-
-        for result in results {
-            self.process_result(&result).await?;
-            self.update_metrics(&result, start.elapsed());
-        }
+        let sweep = self.l2_detector.sweep().await?;
+        self.process_sweep(DetectionLevel::L2Active, sweep).await?;
 
         debug!(duration = ?start.elapsed(), "L2 detection complete");
         Ok(())
@@ -172,28 +651,86 @@ impl<E: IsolationExecutor + 'static> DetectionScheduler<E> {
         debug!("Running L3 PCIe detection");
         let start = Instant::now();
 
-        let results = detector.detect_all().await?;
+        let sweep = detector.sweep().await?;
+        self.process_sweep(DetectionLevel::L3Pcie, sweep).await?;
 
-        for result in results {
-            self.process_result(&result).await?;
-            self.update_metrics(&result, start.elapsed());
+        debug!(duration = ?start.elapsed(), "L3 detection complete");
+        Ok(())
+    }
+
+    /// Consume a concurrent sweep, processing results as they complete
+    ///
+    /// Failing results are acted on immediately. With peer analysis enabled,
+    /// passing results are held until the sweep finishes so they can be
+    /// compared against the rest of the node first.
+    async fn process_sweep(
+        &self,
+        level: DetectionLevel,
+        sweep: impl Stream<Item = SweepItem>,
+    ) -> Result<()> {
+        futures::pin_mut!(sweep);
+        let start = Instant::now();
+
+        let mut results = Vec::new();
+        let mut deferred = Vec::new();
+
+        while let Some((device, result, usage)) = sweep.next().await {
+            self.metrics.observe_check_usage(level, &device, &usage);
+            let result = match result {
+                Ok(result) => result,
+                Err(e) => {
+                    warn!(device = %device, level = %level, error = %e, "Detection failed");
+                    continue;
+                }
+            };
+            let elapsed = start.elapsed();
+
+            let compared = self.peer_analyzer.as_ref().is_some_and(|a| a.covers(level));
+            if compared && result.passed {
+                deferred.push((results.len(), elapsed));
+            } else {
+                self.process_result(&result).await?;
+                self.update_metrics(&result, elapsed);
+            }
+            results.push(result);
+        }
+
+        if let Some(analyzer) = &self.peer_analyzer {
+            let outliers = analyzer.analyze(&mut results);
+            if outliers > 0 {
+                debug!(level = %level, outliers = outliers, "Peer analysis flagged outliers");
+            }
+
+            let transitions = self
+                .health_manager
+                .process_batch(deferred.iter().map(|(index, _)| &results[*index]));
+            for ((index, elapsed), transition) in deferred.into_iter().zip(transitions) {
+                self.handle_transition(&results[index], transition).await?;
+                self.update_metrics(&results[index], elapsed);
+            }
         }
 
-        debug!(duration = ?start.elapsed(), "L3 detection complete");
         Ok(())
     }
 
     /// Process a detection result
     async fn process_result(&self, result: &DetectionResult) -> Result<()> {
-        let mut manager = self.health_manager.write().await;
-        let transition = manager.process_result(result);
+        let transition = self.health_manager.process_result(result);
+        self.handle_transition(result, transition).await
+    }
 
+    /// Act on the state transition caused by a detection result
+    async fn handle_transition(
+        &self,
+        result: &DetectionResult,
+        transition: StateTransition,
+    ) -> Result<()> {
         // Update health status metric
-        if let Some(health) = manager.get(&result.device) {
-            self.metrics.set_gpu_status(&result.device, health.state);
-        }
+        self.metrics.set_gpu_status(&result.device, transition.to);
 
-        drop(manager); // Release lock before executing actions
+        if transition.changed {
+            self.publish_state(&result.device, transition.to);
+        }
 
         // Execute isolation actions if state changed to UNHEALTHY
         if transition.changed && transition.to == HealthState::Unhealthy {
@@ -244,6 +781,11 @@ impl<E: IsolationExecutor + 'static> DetectionScheduler<E> {
                             error!(device = %result.device, error = %e, "Healing task panicked");
                         }
                     }
+
+                    // Resets and driver reloads can re-enumerate devices
+                    if let Some(inventory) = &self.inventory {
+                        inventory.invalidate();
+                    }
                 }
             }
 
@@ -256,8 +798,23 @@ impl<E: IsolationExecutor + 'static> DetectionScheduler<E> {
             }
 
             // Mark isolation as completed
-            let mut manager = self.health_manager.write().await;
-            manager.transition(&result.device, HealthEvent::IsolationCompleted);
+            let isolated = self
+                .health_manager
+                .transition(&result.device, HealthEvent::IsolationCompleted);
+            let suspected_for = self.health_manager.suspected_for(&result.device);
+
+            if isolated.changed {
+                self.metrics.set_gpu_status(&result.device, isolated.to);
+                self.publish_state(&result.device, isolated.to);
+                if let Some(elapsed) = suspected_for {
+                    info!(
+                        device = %result.device,
+                        time_to_isolation = ?elapsed,
+                        "Device isolated"
+                    );
+                    self.metrics.observe_time_to_isolation(elapsed.as_secs_f64());
+                }
+            }
         }
 
         Ok(())
@@ -265,21 +822,26 @@ impl<E: IsolationExecutor + 'static> DetectionScheduler<E> {
 
     /// Update metrics for a detection result
     fn update_metrics(&self, result: &DetectionResult, duration: Duration) {
-        let level = match result.level {
-            DetectionLevel::L1Passive => "L1",
-            DetectionLevel::L2Active => "L2",
-            DetectionLevel::L3Pcie => "L3",
-        };
-
         self.metrics
-            .observe_check_duration(level, &result.device, duration.as_secs_f64());
+            .observe_check_duration(result.level, &result.device, duration.as_secs_f64());
 
-        if !result.passed {
-            for finding in &result.findings {
-                let reason = format!("{:?}", finding.finding_type);
-                self.metrics.inc_check_failure(level, &result.device, &reason);
+        for finding in &result.findings {
+            let reason = format!("{:?}", finding.finding_type);
+            if result.passed {
+                self.metrics
+                    .inc_advisory_finding(result.level, &result.device, &reason);
+            } else {
+                self.metrics
+                    .inc_check_failure(result.level, &result.device, &reason);
             }
         }
+
+        if result.level == DetectionLevel::L2Active {
+            self.metrics.set_l2_probe_deadline(
+                &result.device,
+                self.l2_detector.timeout_for(&result.device).as_secs_f64(),
+            );
+        }
     }
 
     /// Run a single detection pass (for --once mode)
@@ -295,10 +857,20 @@ impl<E: IsolationExecutor + 'static> DetectionScheduler<E> {
     }
 }
 
+/// Random fraction in [0, 1) used to spread actor start times
+fn random_fraction(device: &DeviceId, level: DetectionLevel) -> f64 {
+    // RandomState is randomly keyed per instance, which is plenty for jitter
+    let mut hasher = std::collections::hash_map::RandomState::new().build_hasher();
+    hasher.write_u32(device.index);
+    hasher.write(level.to_string().as_bytes());
+    (hasher.finish() >> 11) as f64 / (1u64 << 53) as f64
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
-    use crate::device::MockDevice;
+    use crate::detection::{Finding, WorkloadConfig};
+    use crate::device::{DeviceInterface, MockDevice};
     use std::sync::atomic::{AtomicU32, Ordering};
 
     struct MockExecutor {
@@ -332,10 +904,7 @@ mod tests {
             Duration::from_secs(5),
         );
 
-        let health_manager = Arc::new(RwLock::new(GpuHealthManager::new(
-            3,
-            vec![31, 43, 48, 79],
-        )));
+        let health_manager = Arc::new(GpuHealthManager::new(3, vec![31, 43, 48, 79]));
 
         let executor = Arc::new(MockExecutor::new());
         let metrics = Arc::new(MetricsRegistry::new());
@@ -352,4 +921,326 @@ mod tests {
 
         scheduler.run_once().await.unwrap();
     }
+
+    #[tokio::test]
+    async fn test_scheduler_concurrent_sweep_updates_state() {
+        let device = Arc::new(MockDevice::with_device_count(16));
+        device.set_fail_active_check(true);
+        let l1_detector = L1PassiveDetector::new(device.clone(), 85, vec![31, 43, 48, 79]);
+        let l2_detector = L2ActiveDetector::new(
+            device.clone(),
+            "/usr/local/bin/gpu-check".to_string(),
+            Duration::from_secs(5),
+        )
+        .with_concurrency(4);
+
+        let health_manager = Arc::new(GpuHealthManager::new(3, vec![31, 43, 48, 79]));
+
+        let scheduler = DetectionScheduler::new(
+            l1_detector,
+            l2_detector,
+            health_manager.clone(),
+            Arc::new(MockExecutor::new()),
+            Arc::new(MetricsRegistry::new()),
+            Duration::from_secs(30),
+            Duration::from_secs(300),
+        )
+        .with_peer_analysis(PeerAnalyzer::default());
+
+        scheduler.run_l2_detection().await.unwrap();
+
+        let manager = &health_manager;
+        assert_eq!(manager.all().len(), 16);
+        assert!(manager.all().iter().all(|h| h.state == HealthState::Suspected));
+    }
+
+    #[test]
+    fn test_missed_tick_policy() {
+        let start = tokio::time::Instant::now();
+        let interval = Duration::from_secs(10);
+
+        // On time: every policy keeps the cadence
+        let now = start + Duration::from_secs(3);
+        for policy in [MissedTickPolicy::Burst, MissedTickPolicy::Delay, MissedTickPolicy::Skip] {
+            assert_eq!(policy.next_deadline(start, now, interval), start + interval);
+        }
+
+        // Overran by 2.5 intervals
+        let now = start + Duration::from_secs(25);
+        assert_eq!(
+            MissedTickPolicy::Burst.next_deadline(start, now, interval),
+            start + interval
+        );
+        assert_eq!(
+            MissedTickPolicy::Delay.next_deadline(start, now, interval),
+            now + interval
+        );
+        assert_eq!(
+            MissedTickPolicy::Skip.next_deadline(start, now, interval),
+            start + Duration::from_secs(30)
+        );
+    }
+
+    #[tokio::test]
+    async fn test_scheduler_actors_run_until_shutdown() {
+        let device = Arc::new(MockDevice::with_device_count(4));
+        device.set_fail_active_check(true);
+        let l1_detector = L1PassiveDetector::new(device.clone(), 85, vec![31, 43, 48, 79]);
+        let l2_detector = L2ActiveDetector::new(
+            device.clone(),
+            "/usr/local/bin/gpu-check".to_string(),
+            Duration::from_secs(5),
+        );
+
+        let health_manager = Arc::new(GpuHealthManager::new(3, vec![31, 43, 48, 79]));
+        let executor = Arc::new(MockExecutor::new());
+
+        let scheduler = Arc::new(
+            DetectionScheduler::new(
+                l1_detector,
+                l2_detector,
+                health_manager.clone(),
+                executor.clone(),
+                Arc::new(MetricsRegistry::new()),
+                Duration::from_secs(60),
+                Duration::from_millis(20),
+            )
+            // Slow L3 actors must not hold up L2
+            .with_l3(L3PcieDetector::new(device.clone()), Duration::from_millis(20)),
+        );
+
+        let (shutdown_tx, shutdown_rx) = watch::channel(false);
+        let handle = tokio::spawn(scheduler.run(shutdown_rx));
+
+        tokio::time::sleep(Duration::from_millis(400)).await;
+        shutdown_tx.send(true).unwrap();
+        tokio::time::timeout(Duration::from_secs(2), handle)
+            .await
+            .expect("scheduler should stop on shutdown")
+            .unwrap()
+            .unwrap();
+
+        // Every device failed L2 repeatedly and was isolated independently
+        let manager = &health_manager;
+        assert_eq!(manager.all().len(), 4);
+        assert!(manager.all().iter().all(|h| h.state == HealthState::Isolated));
+        assert_eq!(executor.call_count.load(Ordering::SeqCst), 4);
+    }
+
+    #[tokio::test(start_paused = true)]
+    async fn test_scheduler_starts_actors_for_devices_listed_later() {
+        let device = Arc::new(MockDevice::with_device_count(4));
+        device.set_fail_active_check(true);
+        device.detach_device(3).await;
+        let l1_detector = L1PassiveDetector::new(device.clone(), 85, vec![31, 43, 48, 79]);
+        let l2_detector = L2ActiveDetector::new(
+            device.clone(),
+            "/usr/local/bin/gpu-check".to_string(),
+            Duration::from_secs(5),
+        );
+
+        let health_manager = Arc::new(GpuHealthManager::new(3, vec![31, 43, 48, 79]));
+        let scheduler = Arc::new(DetectionScheduler::new(
+            l1_detector,
+            l2_detector,
+            health_manager.clone(),
+            Arc::new(MockExecutor::new()),
+            Arc::new(MetricsRegistry::new()),
+            Duration::from_secs(1),
+            Duration::from_secs(1),
+        ));
+
+        let (shutdown_tx, shutdown_rx) = watch::channel(false);
+        let handle = tokio::spawn(scheduler.run(shutdown_rx));
+
+        let late = DeviceId {
+            index: 3,
+            uuid: Some("GPU-MOCK-0003".to_string()),
+            name: "Mock GPU".to_string(),
+        };
+        tokio::time::sleep(Duration::from_secs(30)).await;
+        assert_eq!(health_manager.all().len(), 3);
+        assert_eq!(health_manager.state(&late), None);
+
+        device.attach_device(3).await;
+        tokio::time::sleep(Duration::from_secs(30)).await;
+        assert_eq!(health_manager.state(&late), Some(HealthState::Isolated));
+
+        shutdown_tx.send(true).unwrap();
+        handle.await.unwrap().unwrap();
+    }
+
+    #[tokio::test]
+    async fn test_suspected_device_reprobed_quickly() {
+        let device = Arc::new(MockDevice::new());
+        device.set_fail_active_check(true);
+        let l1_detector = L1PassiveDetector::new(device.clone(), 85, vec![31, 43, 48, 79]);
+        let l2_detector = L2ActiveDetector::new(
+            device.clone(),
+            "/usr/local/bin/gpu-check".to_string(),
+            Duration::from_secs(5),
+        );
+
+        // Both devices start out SUSPECTED
+        let health_manager = Arc::new(GpuHealthManager::new(3, vec![31, 43, 48, 79]));
+        for gpu in device.list_devices().await.unwrap() {
+            let result = DetectionResult::fail(
+                gpu,
+                DetectionLevel::L2Active,
+                vec![Finding::high_temperature(90, 85)],
+            );
+            health_manager.process_result(&result);
+        }
+        let executor = Arc::new(MockExecutor::new());
+
+        let scheduler = DetectionScheduler::new(
+            l1_detector,
+            l2_detector,
+            health_manager.clone(),
+            executor.clone(),
+            Arc::new(MetricsRegistry::new()),
+            Duration::from_secs(60),
+            Duration::from_secs(60),
+        )
+        .with_state_intervals(
+            HealthState::Suspected,
+            StateIntervals {
+                l2: Some(Duration::from_millis(20)),
+                ..Default::default()
+            },
+        );
+        assert_eq!(
+            scheduler.interval_for(DetectionLevel::L2Active, HealthState::Suspected),
+            Duration::from_millis(20)
+        );
+        assert_eq!(
+            scheduler.interval_for(DetectionLevel::L2Active, HealthState::Healthy),
+            Duration::from_secs(60)
+        );
+
+        let (shutdown_tx, shutdown_rx) = watch::channel(false);
+        let handle = tokio::spawn(Arc::new(scheduler).run(shutdown_rx));
+
+        tokio::time::sleep(Duration::from_millis(400)).await;
+        shutdown_tx.send(true).unwrap();
+        tokio::time::timeout(Duration::from_secs(2), handle)
+            .await
+            .expect("scheduler should stop on shutdown")
+            .unwrap()
+            .unwrap();
+
+        // Confirmed well before the 60s default interval would have re-probed
+        let manager = &health_manager;
+        assert!(manager.all().iter().all(|h| h.state == HealthState::Isolated));
+        assert!(manager.all().iter().all(|h| h.suspected_at.is_some()));
+        assert_eq!(executor.call_count.load(Ordering::SeqCst), 2);
+    }
+
+    async fn run_workload_scheduler(
+        device: Arc<MockDevice>,
+        workload: WorkloadConfig,
+        l2_interval: Duration,
+    ) {
+        let l1_detector = L1PassiveDetector::new(device.clone(), 85, vec![31, 43, 48, 79]);
+        let l2_detector = L2ActiveDetector::new(
+            device.clone(),
+            "/usr/local/bin/gpu-check".to_string(),
+            Duration::from_secs(5),
+        );
+        let scheduler = DetectionScheduler::new(
+            l1_detector,
+            l2_detector,
+            Arc::new(GpuHealthManager::new(3, vec![31, 43, 48, 79])),
+            Arc::new(MockExecutor::new()),
+            Arc::new(MetricsRegistry::new()),
+            Duration::from_millis(10),
+            l2_interval,
+        )
+        .with_workload(Arc::new(WorkloadTracker::new(workload)));
+
+        let (shutdown_tx, shutdown_rx) = watch::channel(false);
+        let handle = tokio::spawn(Arc::new(scheduler).run(shutdown_rx));
+        tokio::time::sleep(Duration::from_millis(300)).await;
+        shutdown_tx.send(true).unwrap();
+        handle.await.unwrap().unwrap();
+    }
+
+    #[tokio::test]
+    async fn test_busy_devices_skip_l2_probes() {
+        let device = Arc::new(MockDevice::new());
+        device.set_gpu_utilization(100);
+
+        let interval = Duration::from_millis(30);
+        run_workload_scheduler(device.clone(), WorkloadConfig::default(), interval).await;
+
+        // Only the initial probe per device ran; the rest were deferred
+        assert_eq!(device.active_check_count.load(Ordering::SeqCst), 2);
+    }
+
+    #[tokio::test]
+    async fn test_silent_devices_probed_early() {
+        let device = Arc::new(MockDevice::new());
+        device.set_gpu_utilization(0);
+        let workload = WorkloadConfig {
+            silent_after: Duration::from_millis(50),
+            ..Default::default()
+        };
+
+        // The regular L2 interval never elapses during the test
+        run_workload_scheduler(device.clone(), workload, Duration::from_secs(60)).await;
+
+        assert!(device.active_check_count.load(Ordering::SeqCst) >= 2);
+    }
+
+    #[tokio::test]
+    async fn test_xid_event_isolates_without_waiting_for_l1() {
+        let device = Arc::new(MockDevice::new());
+        let events = device.enable_events();
+        let l1_detector = L1PassiveDetector::new(device.clone(), 85, vec![31, 43, 48, 79]);
+        let l2_detector = L2ActiveDetector::new(
+            device.clone(),
+            "/usr/local/bin/gpu-check".to_string(),
+            Duration::from_secs(5),
+        );
+        let health_manager = Arc::new(GpuHealthManager::new(3, vec![31, 43, 48, 79]));
+        let executor = Arc::new(MockExecutor::new());
+
+        // Neither L1 nor L2 would run on their own during the test
+        let scheduler = DetectionScheduler::new(
+            l1_detector,
+            l2_detector,
+            health_manager.clone(),
+            executor.clone(),
+            Arc::new(MetricsRegistry::new()),
+            Duration::from_secs(60),
+            Duration::from_secs(60),
+        );
+        let (shutdown_tx, shutdown_rx) = watch::channel(false);
+        let handle = tokio::spawn(Arc::new(scheduler).run(shutdown_rx));
+
+        tokio::time::sleep(Duration::from_millis(20)).await;
+        events
+            .send(DeviceEvent::Xid(crate::device::XidError {
+                code: 79,
+                message: "GPU has fallen off the bus".to_string(),
+                timestamp: chrono::Utc::now(),
+                device_index: 1,
+            }))
+            .await
+            .unwrap();
+        tokio::time::sleep(Duration::from_millis(100)).await;
+
+        shutdown_tx.send(true).unwrap();
+        handle.await.unwrap().unwrap();
+
+        let manager = &health_manager;
+        let devices = device.list_devices().await.unwrap();
+        assert_eq!(manager.get(&devices[1]).unwrap().state, HealthState::Isolated);
+        assert!(manager
+            .get(&devices[0])
+            .map_or(true, |h| h.state == HealthState::Healthy));
+        assert_eq!(executor.call_count.load(Ordering::SeqCst), 1);
+        // The event also triggered an out-of-cycle L2 probe
+        assert_eq!(device.active_check_count.load(Ordering::SeqCst), 1);
+    }
 }
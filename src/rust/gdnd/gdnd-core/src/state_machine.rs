@@ -10,17 +10,19 @@
 //! - UNHEALTHY → ISOLATED: Isolation actions completed
 //! - ISOLATED → HEALTHY: recovery_threshold consecutive passes (optional recovery)
 
-use std::collections::HashMap;
+use std::sync::{Arc, Mutex, MutexGuard, RwLock};
+use std::time::Duration;
 
 use chrono::{DateTime, Utc};
 use serde::{Deserialize, Serialize};
 use tracing::{debug, info, warn};
 
-use crate::detection::{DetectionResult, Finding};
+use crate::detection::{DetectionLevel, DetectionResult, Finding};
 use crate::device::DeviceId;
+use crate::journal::{HealthJournal, JournalWriter};
 
 /// Health states for a GPU
-#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash, Serialize, Deserialize)]
 pub enum HealthState {
     /// GPU is healthy and functioning normally
     Healthy,
@@ -83,6 +85,16 @@ pub struct GpuHealth {
     pub state_changed_at: DateTime<Utc>,
     /// Last findings that caused state change
     pub last_findings: Vec<Finding>,
+    /// When the device first left HEALTHY in the current episode
+    #[serde(default)]
+    pub suspected_at: Option<DateTime<Utc>>,
+    /// Monotonic start of the suspicion episode, unset for episodes resumed
+    /// from the journal
+    #[serde(skip)]
+    pub(crate) suspected_since: Option<tokio::time::Instant>,
+    /// Detection levels whose latest check failed
+    #[serde(default)]
+    pub failing_levels: Vec<DetectionLevel>,
 }
 
 impl GpuHealth {
@@ -97,6 +109,9 @@ impl GpuHealth {
             last_check: now,
             state_changed_at: now,
             last_findings: Vec::new(),
+            suspected_at: None,
+            suspected_since: None,
+            failing_levels: Vec::new(),
         }
     }
 }
@@ -147,12 +162,66 @@ impl StateTransition {
     }
 }
 
+/// Fields of a health record worth journaling
+///
+/// A bare `last_check` update on every passing check is not.
+#[derive(PartialEq)]
+struct Persisted {
+    state: HealthState,
+    failure_count: u32,
+    recovery_count: u32,
+    suspected_at: Option<DateTime<Utc>>,
+    failing_levels: u8,
+}
+
+impl Persisted {
+    fn of(health: &GpuHealth) -> Self {
+        Self {
+            state: health.state,
+            failure_count: health.failure_count,
+            recovery_count: health.recovery_count,
+            suspected_at: health.suspected_at,
+            failing_levels: health
+                .failing_levels
+                .iter()
+                .fold(0, |mask, level| mask | 1 << *level as u8),
+        }
+    }
+}
+
+/// Borrowed form of `HealthEvent`, so findings are only cloned when stored
+#[derive(Clone, Copy)]
+enum Event<'a> {
+    Passed,
+    Failed(&'a [Finding]),
+    Fatal(&'a [Finding]),
+    IsolationCompleted,
+}
+
+impl<'a> From<&'a HealthEvent> for Event<'a> {
+    fn from(event: &'a HealthEvent) -> Self {
+        match event {
+            HealthEvent::CheckPassed => Event::Passed,
+            HealthEvent::CheckFailed { findings } => Event::Failed(findings),
+            HealthEvent::FatalError { findings } => Event::Fatal(findings),
+            HealthEvent::IsolationCompleted => Event::IsolationCompleted,
+        }
+    }
+}
+
 /// GPU Health Manager
 ///
 /// Tracks health state for all GPUs and handles state transitions.
+///
+/// Each device index has its own slot with its own lock, created on first
+/// use (or up front by `register`), so results for different devices never
+/// contend and a lookup neither hashes nor allocates. The slot table grows
+/// to the highest index seen; indices are dense enumeration positions, so
+/// it stays as long as the device list. A slot is reset when a different
+/// device (by UUID) shows up at its index.
 pub struct GpuHealthManager {
-    /// Health records per device
-    health: HashMap<String, GpuHealth>,
+    /// Health record per device index
+    slots: RwLock<Vec<Option<Arc<Mutex<GpuHealth>>>>>,
     /// Failure threshold for SUSPECTED → UNHEALTHY transition
     failure_threshold: u32,
     /// Recovery threshold for ISOLATED → HEALTHY transition (0 = disabled)
@@ -162,28 +231,29 @@ pub struct GpuHealthManager {
     /// Fatal XID codes (unused but kept for reference)
     #[allow(dead_code)]
     fatal_xids: Vec<u32>,
+    /// Writer of the on-disk journal of record changes, if persistent
+    journal: Option<JournalWriter>,
 }
 
 impl GpuHealthManager {
     /// Create a new health manager
     pub fn new(failure_threshold: u32, fatal_xids: Vec<u32>) -> Self {
         Self {
-            health: HashMap::new(),
+            slots: RwLock::new(Vec::new()),
             failure_threshold,
             recovery_threshold: 0,
             recovery_enabled: false,
             fatal_xids,
+            journal: None,
         }
     }
 
     /// Create a new health manager with recovery enabled
     pub fn with_recovery(failure_threshold: u32, recovery_threshold: u32, fatal_xids: Vec<u32>) -> Self {
         Self {
-            health: HashMap::new(),
-            failure_threshold,
             recovery_threshold,
             recovery_enabled: recovery_threshold > 0,
-            fatal_xids,
+            ..Self::new(failure_threshold, fatal_xids)
         }
     }
 
@@ -198,39 +268,195 @@ impl GpuHealthManager {
         self.recovery_enabled
     }
 
-    /// Get or create health record for a device
-    fn get_or_create_mut(&mut self, device: &DeviceId) -> &mut GpuHealth {
-        let key = device_key(device);
-        self.health
-            .entry(key)
-            .or_insert_with(|| GpuHealth::new(device.clone()))
+    /// Persist health records to a journal, resuming from the ones it replayed
+    ///
+    /// A device that was UNHEALTHY when the daemon stopped may not have been
+    /// isolated yet, so it resumes SUSPECTED one failure short of the
+    /// threshold and the next failure isolates it.
+    pub fn with_journal(mut self, journal: HealthJournal, records: Vec<GpuHealth>) -> Self {
+        let slots = self.slots.get_mut().unwrap_or_else(|e| e.into_inner());
+        for mut health in records {
+            if health.state == HealthState::Unhealthy {
+                health.state = HealthState::Suspected;
+                health.failure_count = self.failure_threshold.saturating_sub(1);
+            }
+            info!(device = %health.device, state = %health.state, "Restored health state");
+            let index = health.device.index as usize;
+            if slots.len() <= index {
+                slots.resize(index + 1, None);
+            }
+            slots[index] = Some(Arc::new(Mutex::new(health)));
+        }
+        // The writer starts from a fresh snapshot, dropping the replayed journal
+        match journal.spawn_writer(self.all()) {
+            Ok(writer) => self.journal = Some(writer),
+            Err(e) => warn!(error = %e, "Failed to start health journal writer, not persisting"),
+        }
+        self
+    }
+
+    /// Create health slots for newly listed devices
+    ///
+    /// Sizes the slot table for the whole device list in one go.
+    pub fn register(&self, devices: &[DeviceId]) {
+        if let Some(last) = devices.iter().map(|d| d.index as usize).max() {
+            let mut slots = self.slots.write().unwrap_or_else(|e| e.into_inner());
+            if slots.len() <= last {
+                slots.resize(last + 1, None);
+            }
+        }
+        for device in devices {
+            let slot = self.slot_or_create(device);
+            drop(Self::claim(&slot, device));
+        }
+    }
+
+    /// A device index's slot, if one was created
+    fn slot(&self, index: u32) -> Option<Arc<Mutex<GpuHealth>>> {
+        let slots = self.slots.read().unwrap_or_else(|e| e.into_inner());
+        slots.get(index as usize)?.clone()
+    }
+
+    /// A device's slot, growing the table to its index as needed
+    fn slot_or_create(&self, device: &DeviceId) -> Arc<Mutex<GpuHealth>> {
+        if let Some(slot) = self.slot(device.index) {
+            return slot;
+        }
+        let mut slots = self.slots.write().unwrap_or_else(|e| e.into_inner());
+        let index = device.index as usize;
+        if slots.len() <= index {
+            slots.resize(index + 1, None);
+        }
+        let slot = slots[index]
+            .get_or_insert_with(|| Arc::new(Mutex::new(GpuHealth::new(device.clone()))));
+        Arc::clone(slot)
+    }
+
+    /// Lock a slot for a device, resetting it if another device held it
+    fn claim<'a>(slot: &'a Mutex<GpuHealth>, device: &DeviceId) -> MutexGuard<'a, GpuHealth> {
+        let mut health = slot.lock().unwrap_or_else(|e| e.into_inner());
+        if health.device.uuid != device.uuid {
+            info!(device = %device, "New device at this index, resetting health");
+            *health = GpuHealth::new(device.clone());
+        }
+        health
+    }
+
+    /// Read a device's record if its slot still belongs to this device
+    fn read<T>(&self, device: &DeviceId, f: impl FnOnce(&GpuHealth) -> T) -> Option<T> {
+        let slot = self.slot(device.index)?;
+        let health = slot.lock().unwrap_or_else(|e| e.into_inner());
+        (health.device.uuid == device.uuid).then(|| f(&health))
+    }
+
+    /// Get a copy of the health record for a device
+    pub fn get(&self, device: &DeviceId) -> Option<GpuHealth> {
+        self.read(device, GpuHealth::clone)
+    }
+
+    /// Current health state of a device
+    pub fn state(&self, device: &DeviceId) -> Option<HealthState> {
+        self.read(device, |h| h.state)
     }
 
-    /// Get health record for a device
-    pub fn get(&self, device: &DeviceId) -> Option<&GpuHealth> {
-        self.health.get(&device_key(device))
+    /// How long the device's current suspicion episode has lasted
+    ///
+    /// Measured on tokio's monotonic clock; only an episode resumed from the
+    /// journal falls back to the wall-clock start.
+    pub fn suspected_for(&self, device: &DeviceId) -> Option<Duration> {
+        self.read(device, |h| match (h.suspected_since, h.suspected_at) {
+            (Some(since), _) => Some(since.elapsed()),
+            (None, Some(at)) => Some((Utc::now() - at).to_std().unwrap_or_default()),
+            (None, None) => None,
+        })?
     }
 
-    /// Get all health records
-    pub fn all(&self) -> impl Iterator<Item = &GpuHealth> {
-        self.health.values()
+    /// Get copies of all health records
+    pub fn all(&self) -> Vec<GpuHealth> {
+        let slots: Vec<_> = self
+            .slots
+            .read()
+            .unwrap_or_else(|e| e.into_inner())
+            .iter()
+            .flatten()
+            .cloned()
+            .collect();
+        slots
+            .iter()
+            .map(|h| h.lock().unwrap_or_else(|e| e.into_inner()).clone())
+            .collect()
     }
 
     /// Process detection result and update state
-    pub fn process_result(&mut self, result: &DetectionResult) -> StateTransition {
+    ///
+    /// While SUSPECTED, a passing check only clears the suspicion once every
+    /// level that failed has passed again, so a cheap L1 pass cannot mask a
+    /// failing L2 probe.
+    pub fn process_result(&self, result: &DetectionResult) -> StateTransition {
+        let slot = self.slot_or_create(&result.device);
+        let mut health = Self::claim(&slot, &result.device);
+        let before = Persisted::of(&health);
+        let transition = self.apply_result(&mut health, result);
+        self.persist(health, before, transition)
+    }
+
+    /// Process all results of a sweep, one transition per result in order
+    ///
+    /// The slots are looked up under a single read of the slot table, then
+    /// each device is locked only while its own result is applied.
+    pub fn process_batch<'a>(
+        &self,
+        results: impl IntoIterator<Item = &'a DetectionResult>,
+    ) -> Vec<StateTransition> {
+        let batch: Vec<_> = {
+            let slots = self.slots.read().unwrap_or_else(|e| e.into_inner());
+            results
+                .into_iter()
+                .map(|result| {
+                    let slot = slots.get(result.device.index as usize).cloned().flatten();
+                    (result, slot)
+                })
+                .collect()
+        };
+        batch
+            .into_iter()
+            .map(|(result, slot)| {
+                let slot = slot.unwrap_or_else(|| self.slot_or_create(&result.device));
+                let mut health = Self::claim(&slot, &result.device);
+                let before = Persisted::of(&health);
+                let transition = self.apply_result(&mut health, result);
+                self.persist(health, before, transition)
+            })
+            .collect()
+    }
+
+    /// Apply a detection result to a locked health record
+    fn apply_result(&self, health: &mut GpuHealth, result: &DetectionResult) -> StateTransition {
+        if result.passed {
+            health.failing_levels.retain(|level| *level != result.level);
+            if health.state == HealthState::Suspected && !health.failing_levels.is_empty() {
+                health.last_check = Utc::now();
+                debug!(
+                    device = %result.device,
+                    level = %result.level,
+                    failing = ?health.failing_levels,
+                    "Check passed, other levels still failing"
+                );
+                return StateTransition::no_change(HealthState::Suspected);
+            }
+        } else if !health.failing_levels.contains(&result.level) {
+            health.failing_levels.push(result.level);
+        }
+
         let event = if result.passed {
-            HealthEvent::CheckPassed
+            Event::Passed
         } else if result.has_fatal_finding() {
-            HealthEvent::FatalError {
-                findings: result.findings.clone(),
-            }
+            Event::Fatal(&result.findings)
         } else {
-            HealthEvent::CheckFailed {
-                findings: result.findings.clone(),
-            }
+            Event::Failed(&result.findings)
         };
 
-        self.transition(&result.device, event)
+        self.apply(health, &result.device, event)
     }
 
     /// Generate isolation actions for unhealthy GPU
@@ -283,27 +509,55 @@ impl GpuHealthManager {
     }
 
     /// Perform state transition
-    pub fn transition(&mut self, device: &DeviceId, event: HealthEvent) -> StateTransition {
-        // Copy thresholds before mutable borrow
-        let failure_threshold = self.failure_threshold;
-        let recovery_threshold = self.recovery_threshold;
-        let recovery_enabled = self.recovery_enabled;
+    pub fn transition(&self, device: &DeviceId, event: HealthEvent) -> StateTransition {
+        let slot = self.slot_or_create(device);
+        let mut health = Self::claim(&slot, device);
+        let before = Persisted::of(&health);
+        let transition = self.apply(&mut health, device, Event::from(&event));
+        self.persist(health, before, transition)
+    }
+
+    /// Queue a record whose persistent fields changed, then release it
+    ///
+    /// The journal thread syncs state changes to disk; counter updates are
+    /// only written, which survives a daemon crash but not a node crash.
+    fn persist(
+        &self,
+        health: MutexGuard<'_, GpuHealth>,
+        before: Persisted,
+        transition: StateTransition,
+    ) -> StateTransition {
+        let Some(journal) = &self.journal else {
+            return transition;
+        };
+        if Persisted::of(&health) != before {
+            // Queueing under the record lock keeps each device's entries in order
+            journal.append(health.clone(), transition.changed);
+        }
+        transition
+    }
 
-        let health = self.get_or_create_mut(device);
+    /// Apply an event to a locked health record
+    fn apply(
+        &self,
+        health: &mut GpuHealth,
+        device: &DeviceId,
+        event: Event<'_>,
+    ) -> StateTransition {
         let old_state = health.state;
         health.last_check = Utc::now();
 
-        match (&health.state, event) {
+        let transition = match (&health.state, event) {
             // HEALTHY state transitions
-            (HealthState::Healthy, HealthEvent::CheckPassed) => {
+            (HealthState::Healthy, Event::Passed) => {
                 health.failure_count = 0;
                 StateTransition::no_change(HealthState::Healthy)
             }
-            (HealthState::Healthy, HealthEvent::CheckFailed { findings }) => {
+            (HealthState::Healthy, Event::Failed(findings)) => {
                 health.failure_count = 1;
                 health.state = HealthState::Suspected;
                 health.state_changed_at = Utc::now();
-                health.last_findings = findings;
+                health.last_findings = findings.to_vec();
                 info!(
                     device = %device,
                     from = %old_state,
@@ -312,12 +566,12 @@ impl GpuHealthManager {
                 );
                 StateTransition::transition(old_state, HealthState::Suspected, Vec::new())
             }
-            (HealthState::Healthy, HealthEvent::FatalError { findings }) => {
+            (HealthState::Healthy, Event::Fatal(findings)) => {
                 // Fatal error: skip SUSPECTED, go straight to UNHEALTHY
-                health.failure_count = failure_threshold;
+                health.failure_count = self.failure_threshold;
                 health.state = HealthState::Unhealthy;
                 health.state_changed_at = Utc::now();
-                health.last_findings = findings.clone();
+                health.last_findings = findings.to_vec();
                 warn!(
                     device = %device,
                     from = %old_state,
@@ -327,12 +581,12 @@ impl GpuHealthManager {
                 StateTransition::transition(
                     old_state,
                     HealthState::Unhealthy,
-                    Self::isolation_actions(device, &findings),
+                    Self::isolation_actions(device, findings),
                 )
             }
 
             // SUSPECTED state transitions
-            (HealthState::Suspected, HealthEvent::CheckPassed) => {
+            (HealthState::Suspected, Event::Passed) => {
                 health.failure_count = 0;
                 health.state = HealthState::Healthy;
                 health.state_changed_at = Utc::now();
@@ -345,12 +599,12 @@ impl GpuHealthManager {
                 );
                 StateTransition::transition(old_state, HealthState::Healthy, Vec::new())
             }
-            (HealthState::Suspected, HealthEvent::CheckFailed { findings }) => {
+            (HealthState::Suspected, Event::Failed(findings)) => {
                 health.failure_count += 1;
                 let failure_count = health.failure_count;
-                health.last_findings = findings.clone();
+                health.last_findings = findings.to_vec();
 
-                if failure_count >= failure_threshold {
+                if failure_count >= self.failure_threshold {
                     health.state = HealthState::Unhealthy;
                     health.state_changed_at = Utc::now();
                     warn!(
@@ -363,23 +617,23 @@ impl GpuHealthManager {
                     StateTransition::transition(
                         old_state,
                         HealthState::Unhealthy,
-                        Self::isolation_actions(device, &findings),
+                        Self::isolation_actions(device, findings),
                     )
                 } else {
                     debug!(
                         device = %device,
                         failures = failure_count,
-                        threshold = failure_threshold,
+                        threshold = self.failure_threshold,
                         "GPU check failed, still suspected"
                     );
                     StateTransition::no_change(HealthState::Suspected)
                 }
             }
-            (HealthState::Suspected, HealthEvent::FatalError { findings }) => {
-                health.failure_count = failure_threshold;
+            (HealthState::Suspected, Event::Fatal(findings)) => {
+                health.failure_count = self.failure_threshold;
                 health.state = HealthState::Unhealthy;
                 health.state_changed_at = Utc::now();
-                health.last_findings = findings.clone();
+                health.last_findings = findings.to_vec();
                 warn!(
                     device = %device,
                     from = %old_state,
@@ -389,12 +643,12 @@ impl GpuHealthManager {
                 StateTransition::transition(
                     old_state,
                     HealthState::Unhealthy,
-                    Self::isolation_actions(device, &findings),
+                    Self::isolation_actions(device, findings),
                 )
             }
 
             // UNHEALTHY state transitions
-            (HealthState::Unhealthy, HealthEvent::IsolationCompleted) => {
+            (HealthState::Unhealthy, Event::IsolationCompleted) => {
                 health.state = HealthState::Isolated;
                 health.state_changed_at = Utc::now();
                 info!(
@@ -412,12 +666,12 @@ impl GpuHealthManager {
 
             // ISOLATED state transitions
             // Recovery is optional and controlled by recovery_enabled
-            (HealthState::Isolated, HealthEvent::CheckPassed) => {
-                if recovery_enabled {
+            (HealthState::Isolated, Event::Passed) => {
+                if self.recovery_enabled {
                     health.recovery_count += 1;
                     let recovery_count = health.recovery_count;
 
-                    if recovery_count >= recovery_threshold {
+                    if recovery_count >= self.recovery_threshold {
                         // Recovery threshold reached, restore to healthy
                         health.state = HealthState::Healthy;
                         health.state_changed_at = Utc::now();
@@ -440,7 +694,7 @@ impl GpuHealthManager {
                         debug!(
                             device = %device,
                             recovery_count = recovery_count,
-                            threshold = recovery_threshold,
+                            threshold = self.recovery_threshold,
                             "GPU check passed, still isolated (recovery in progress)"
                         );
                         StateTransition::no_change(HealthState::Isolated)
@@ -450,52 +704,56 @@ impl GpuHealthManager {
                     StateTransition::no_change(HealthState::Isolated)
                 }
             }
-            (HealthState::Isolated, HealthEvent::CheckFailed { .. }) => {
+            (HealthState::Isolated, Event::Failed(_)) => {
                 // Reset recovery counter on any failure
                 health.recovery_count = 0;
                 StateTransition::no_change(HealthState::Isolated)
             }
-            (HealthState::Isolated, HealthEvent::FatalError { .. }) => {
+            (HealthState::Isolated, Event::Fatal(_)) => {
                 // Reset recovery counter on fatal error
                 health.recovery_count = 0;
                 StateTransition::no_change(HealthState::Isolated)
             }
-            (HealthState::Isolated, HealthEvent::IsolationCompleted) => {
+            (HealthState::Isolated, Event::IsolationCompleted) => {
                 // Already isolated, no change
                 StateTransition::no_change(HealthState::Isolated)
             }
 
             // IsolationCompleted for non-UNHEALTHY states - should not happen, but handle gracefully
-            (_, HealthEvent::IsolationCompleted) => {
+            (_, Event::IsolationCompleted) => {
                 StateTransition::no_change(health.state)
             }
+        };
+
+        // Track the suspicion episode for time-to-isolation
+        if transition.changed {
+            if transition.to == HealthState::Healthy {
+                health.suspected_at = None;
+                health.suspected_since = None;
+                health.failing_levels.clear();
+            } else if transition.from == HealthState::Healthy {
+                health.suspected_at = Some(health.state_changed_at);
+                health.suspected_since = Some(tokio::time::Instant::now());
+            }
         }
+
+        transition
     }
 
     /// Check if any GPU is unhealthy
     pub fn has_unhealthy(&self) -> bool {
-        self.health
-            .values()
-            .any(|h| h.state == HealthState::Unhealthy)
+        self.all().iter().any(|h| h.state == HealthState::Unhealthy)
     }
 
     /// Get all unhealthy GPUs
-    pub fn unhealthy_gpus(&self) -> Vec<&GpuHealth> {
-        self.health
-            .values()
+    pub fn unhealthy_gpus(&self) -> Vec<GpuHealth> {
+        self.all()
+            .into_iter()
             .filter(|h| h.state == HealthState::Unhealthy)
             .collect()
     }
 }
 
-/// Generate unique key for device
-fn device_key(device: &DeviceId) -> String {
-    device
-        .uuid
-        .clone()
-        .unwrap_or_else(|| format!("gpu-{}", device.index))
-}
-
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -510,7 +768,7 @@ mod tests {
 
     #[test]
     fn test_healthy_to_suspected() {
-        let mut manager = GpuHealthManager::new(3, vec![31, 43, 48, 79]);
+        let manager = GpuHealthManager::new(3, vec![31, 43, 48, 79]);
         let device = test_device(0);
 
         let findings = vec![Finding::high_temperature(90, 85)];
@@ -533,7 +791,7 @@ mod tests {
 
     #[test]
     fn test_suspected_to_healthy() {
-        let mut manager = GpuHealthManager::new(3, vec![31, 43, 48, 79]);
+        let manager = GpuHealthManager::new(3, vec![31, 43, 48, 79]);
         let device = test_device(0);
 
         // First failure
@@ -558,7 +816,7 @@ mod tests {
 
     #[test]
     fn test_suspected_to_unhealthy_threshold() {
-        let mut manager = GpuHealthManager::new(3, vec![31, 43, 48, 79]);
+        let manager = GpuHealthManager::new(3, vec![31, 43, 48, 79]);
         let device = test_device(0);
         let findings = vec![Finding::high_temperature(90, 85)];
 
@@ -594,7 +852,7 @@ mod tests {
 
     #[test]
     fn test_fatal_error_immediate_unhealthy() {
-        let mut manager = GpuHealthManager::new(3, vec![31, 43, 48, 79]);
+        let manager = GpuHealthManager::new(3, vec![31, 43, 48, 79]);
         let device = test_device(0);
 
         let findings = vec![Finding::fatal_xid(31, "GPU memory page fault")];
@@ -613,7 +871,7 @@ mod tests {
 
     #[test]
     fn test_unhealthy_to_isolated() {
-        let mut manager = GpuHealthManager::new(3, vec![31, 43, 48, 79]);
+        let manager = GpuHealthManager::new(3, vec![31, 43, 48, 79]);
         let device = test_device(0);
 
         // Make unhealthy
@@ -634,7 +892,7 @@ mod tests {
 
     #[test]
     fn test_isolated_no_transition() {
-        let mut manager = GpuHealthManager::new(3, vec![31, 43, 48, 79]);
+        let manager = GpuHealthManager::new(3, vec![31, 43, 48, 79]);
         let device = test_device(0);
 
         // Make isolated
@@ -664,7 +922,7 @@ mod tests {
     #[test]
     fn test_isolated_recovery_enabled() {
         // Create manager with recovery enabled (threshold = 3)
-        let mut manager = GpuHealthManager::with_recovery(3, 3, vec![31, 43, 48, 79]);
+        let manager = GpuHealthManager::with_recovery(3, 3, vec![31, 43, 48, 79]);
         let device = test_device(0);
 
         // Make isolated
@@ -707,7 +965,7 @@ mod tests {
 
     #[test]
     fn test_isolated_recovery_reset_on_failure() {
-        let mut manager = GpuHealthManager::with_recovery(3, 3, vec![31, 43, 48, 79]);
+        let manager = GpuHealthManager::with_recovery(3, 3, vec![31, 43, 48, 79]);
         let device = test_device(0);
 
         // Make isolated
@@ -734,4 +992,162 @@ mod tests {
         assert_eq!(manager.get(&device).unwrap().recovery_count, 0);
         assert_eq!(manager.get(&device).unwrap().state, HealthState::Isolated);
     }
+
+    #[tokio::test(start_paused = true)]
+    async fn test_suspicion_measured_on_monotonic_clock() {
+        let manager = GpuHealthManager::new(3, vec![31, 43, 48, 79]);
+        let device = test_device(0);
+        assert_eq!(manager.suspected_for(&device), None);
+
+        manager.transition(
+            &device,
+            HealthEvent::CheckFailed {
+                findings: vec![Finding::high_temperature(90, 85)],
+            },
+        );
+        tokio::time::advance(Duration::from_secs(90)).await;
+        assert_eq!(manager.suspected_for(&device), Some(Duration::from_secs(90)));
+
+        manager.transition(&device, HealthEvent::CheckPassed);
+        assert_eq!(manager.suspected_for(&device), None);
+    }
+
+    #[test]
+    fn test_pass_at_other_level_keeps_suspicion() {
+        use crate::detection::DetectionLevel;
+
+        let manager = GpuHealthManager::new(3, vec![31, 43, 48, 79]);
+        let device = test_device(0);
+        let l2_fail = DetectionResult::fail(
+            device.clone(),
+            DetectionLevel::L2Active,
+            vec![Finding::active_check_failure("hang")],
+        );
+        let l1_pass = DetectionResult::pass(device.clone(), DetectionLevel::L1Passive);
+
+        manager.process_result(&l2_fail);
+        assert!(manager.get(&device).unwrap().suspected_at.is_some());
+
+        // L1 passing does not clear an L2 failure
+        let transition = manager.process_result(&l1_pass);
+        assert!(!transition.changed);
+        assert_eq!(manager.get(&device).unwrap().state, HealthState::Suspected);
+
+        // Consecutive L2 failures still escalate
+        manager.process_result(&l2_fail);
+        let transition = manager.process_result(&l2_fail);
+        assert_eq!(transition.to, HealthState::Unhealthy);
+        assert!(manager.get(&device).unwrap().suspected_at.is_some());
+
+        // A fresh device recovers once the failing level passes again
+        let other = test_device(1);
+        manager.process_result(&DetectionResult::fail(
+            other.clone(),
+            DetectionLevel::L2Active,
+            vec![Finding::active_check_failure("hang")],
+        ));
+        let transition =
+            manager.process_result(&DetectionResult::pass(other.clone(), DetectionLevel::L2Active));
+        assert_eq!(transition.to, HealthState::Healthy);
+        assert!(manager.get(&other).unwrap().suspected_at.is_none());
+    }
+
+    #[test]
+    fn test_replaced_device_starts_healthy() {
+        let manager = GpuHealthManager::new(3, vec![31, 43, 48, 79]);
+        let device = test_device(0);
+        manager.register(&[device.clone(), test_device(1)]);
+        assert_eq!(manager.all().len(), 2);
+
+        manager.transition(
+            &device,
+            HealthEvent::CheckFailed {
+                findings: vec![Finding::active_check_failure("hang")],
+            },
+        );
+        assert_eq!(manager.state(&device), Some(HealthState::Suspected));
+
+        // A swapped board at the same index does not inherit the old state
+        let replacement = DeviceId {
+            uuid: Some("GPU-replacement".to_string()),
+            ..device.clone()
+        };
+        assert_eq!(manager.state(&replacement), None);
+        manager.register(&[replacement.clone()]);
+        assert_eq!(manager.state(&replacement), Some(HealthState::Healthy));
+        assert_eq!(manager.state(&device), None);
+
+        // The slot table grows for indices beyond the registered devices
+        let late = test_device(300);
+        let transition = manager.process_result(&DetectionResult::fail(
+            late.clone(),
+            crate::detection::DetectionLevel::L1Passive,
+            vec![Finding::active_check_failure("hang")],
+        ));
+        assert!(transition.changed);
+        assert_eq!(manager.state(&late), Some(HealthState::Suspected));
+        assert_eq!(manager.all().len(), 3);
+    }
+
+    #[test]
+    fn test_process_batch_applies_results_in_order() {
+        let manager = GpuHealthManager::new(2, vec![31, 43, 48, 79]);
+        let device = test_device(0);
+        manager.register(&[device.clone()]);
+        let fail = || {
+            DetectionResult::fail(
+                device.clone(),
+                DetectionLevel::L2Active,
+                vec![Finding::active_check_failure("hang")],
+            )
+        };
+        let late = DetectionResult::pass(test_device(5), DetectionLevel::L2Active);
+        let results = [fail(), late, fail()];
+
+        let transitions = manager.process_batch(&results);
+        let states: Vec<_> = transitions.iter().map(|t| t.to).collect();
+        let expected = [HealthState::Suspected, HealthState::Healthy, HealthState::Unhealthy];
+        assert_eq!(states, expected);
+        assert_eq!(manager.state(&test_device(5)), Some(HealthState::Healthy));
+    }
+
+    #[test]
+    fn test_journal_resumes_after_restart() {
+        let dir = std::env::temp_dir().join(format!("gdnd-health-journal-{}", std::process::id()));
+        let failed = HealthEvent::CheckFailed {
+            findings: vec![Finding::active_check_failure("hang")],
+        };
+        let open = || {
+            let (journal, records) = HealthJournal::open(&dir).unwrap();
+            GpuHealthManager::new(3, vec![31, 43, 48, 79]).with_journal(journal, records)
+        };
+
+        let manager = open();
+        let suspect = test_device(0);
+        let sick = test_device(1);
+        manager.transition(&suspect, failed.clone());
+        manager.transition(&suspect, failed.clone());
+        manager.transition(
+            &sick,
+            HealthEvent::FatalError {
+                findings: vec![Finding::active_check_failure("fatal")],
+            },
+        );
+        drop(manager);
+
+        let manager = open();
+        let health = manager.get(&suspect).unwrap();
+        assert_eq!(health.state, HealthState::Suspected);
+        assert_eq!(health.failure_count, 2);
+        assert!(health.suspected_at.is_some());
+
+        // Isolation may not have happened, so one more failure redoes it
+        assert_eq!(manager.state(&sick), Some(HealthState::Suspected));
+        let transition = manager.transition(&sick, failed);
+        assert_eq!(transition.to, HealthState::Unhealthy);
+        assert!(!transition.actions.is_empty());
+        drop(manager);
+
+        std::fs::remove_dir_all(&dir).unwrap();
+    }
 }
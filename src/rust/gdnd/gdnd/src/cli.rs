@@ -36,6 +36,14 @@ pub struct Cli {
     /// Enable debug endpoints
     #[arg(long, default_value = "false")]
     pub debug: bool,
+
+    /// Record every device response to this file for later replay
+    #[arg(long, value_name = "PATH")]
+    pub record_trace: Option<PathBuf>,
+
+    /// Replay a recorded trace on a virtual clock, print the report and exit
+    #[arg(long, value_name = "TRACE", conflicts_with_all = ["once", "record_trace"])]
+    pub replay: Option<PathBuf>,
 }
 
 impl Cli {
@@ -70,4 +78,11 @@ mod tests {
         let cli = Cli::try_parse_from(["gdnd", "--dry-run"]).unwrap();
         assert!(cli.dry_run);
     }
+
+    #[test]
+    fn test_cli_replay() {
+        let cli = Cli::try_parse_from(["gdnd", "--replay", "/tmp/gdnd.trace"]).unwrap();
+        assert_eq!(cli.replay.unwrap().to_str().unwrap(), "/tmp/gdnd.trace");
+        assert!(Cli::try_parse_from(["gdnd", "--replay", "a", "--record-trace", "b"]).is_err());
+    }
 }
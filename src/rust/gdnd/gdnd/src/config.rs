@@ -2,7 +2,7 @@
 //!
 //! Handles loading and validating configuration from YAML files and environment variables.
 
-use std::path::Path;
+use std::path::{Path, PathBuf};
 use std::time::Duration;
 
 use anyhow::{Context, Result};
@@ -21,6 +21,71 @@ pub enum DeviceType {
     Ascend,
 }
 
+/// Behavior when a check overruns its next scheduled tick
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize, Default)]
+#[serde(rename_all = "lowercase")]
+pub enum MissedTickPolicy {
+    /// Run missed checks back-to-back until caught up
+    Burst,
+    /// Schedule the next check one interval after the late one finished
+    Delay,
+    /// Drop missed ticks and keep the original cadence
+    #[default]
+    Skip,
+}
+
+/// Per-device actor scheduling configuration
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct SchedulingConfig {
+    /// Maximum random startup delay, as a fraction of each level's interval
+    #[serde(default = "default_scheduling_jitter")]
+    pub jitter: f64,
+
+    /// Behavior when a check overruns its next tick
+    #[serde(default)]
+    pub missed_tick: MissedTickPolicy,
+
+    /// Intervals while a device is SUSPECTED (re-probe quickly to confirm)
+    #[serde(default = "default_suspected_intervals")]
+    pub suspected: LevelIntervals,
+
+    /// Intervals while a device is UNHEALTHY
+    #[serde(default)]
+    pub unhealthy: LevelIntervals,
+
+    /// Intervals while a device is ISOLATED (back off, watch for recovery)
+    #[serde(default = "default_isolated_intervals")]
+    pub isolated: LevelIntervals,
+}
+
+impl Default for SchedulingConfig {
+    fn default() -> Self {
+        Self {
+            jitter: default_scheduling_jitter(),
+            missed_tick: MissedTickPolicy::default(),
+            suspected: default_suspected_intervals(),
+            unhealthy: LevelIntervals::default(),
+            isolated: default_isolated_intervals(),
+        }
+    }
+}
+
+/// Per-level interval overrides for one health state (unset = level default)
+#[derive(Debug, Clone, Default, Serialize, Deserialize)]
+pub struct LevelIntervals {
+    /// L1 passive detection interval
+    #[serde(with = "humantime_serde", default)]
+    pub l1: Option<Duration>,
+
+    /// L2 active detection interval
+    #[serde(with = "humantime_serde", default)]
+    pub l2: Option<Duration>,
+
+    /// L3 PCIe detection interval
+    #[serde(with = "humantime_serde", default)]
+    pub l3: Option<Duration>,
+}
+
 /// Health check configuration
 #[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct HealthConfig {
@@ -36,9 +101,20 @@ pub struct HealthConfig {
     #[serde(default = "default_temperature_threshold")]
     pub temperature_threshold: u32,
 
+    /// How long a process holding the device open must stay in D state
+    /// before it is reported as a zombie
+    #[serde(with = "humantime_serde", default = "default_zombie_threshold")]
+    pub zombie_threshold: Duration,
+
     /// Timeout for active check operations
+    /// With adaptive timeouts enabled, this applies until a device's
+    /// latency baseline is established
     #[serde(with = "humantime_serde", default = "default_active_check_timeout")]
     pub active_check_timeout: Duration,
+
+    /// Adaptive per-device active check timeouts
+    #[serde(default)]
+    pub adaptive_timeout: AdaptiveTimeoutConfig,
 }
 
 impl Default for HealthConfig {
@@ -47,7 +123,41 @@ impl Default for HealthConfig {
             failure_threshold: default_failure_threshold(),
             fatal_xids: default_fatal_xids(),
             temperature_threshold: default_temperature_threshold(),
+            zombie_threshold: default_zombie_threshold(),
             active_check_timeout: default_active_check_timeout(),
+            adaptive_timeout: AdaptiveTimeoutConfig::default(),
+        }
+    }
+}
+
+/// Adaptive active check timeout configuration
+/// Deadline = observed p99 probe latency * multiplier, clamped to [floor, ceiling]
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct AdaptiveTimeoutConfig {
+    /// Enable adaptive timeouts (requires baseline.enabled)
+    #[serde(default = "default_true")]
+    pub enabled: bool,
+
+    /// Minimum deadline
+    #[serde(with = "humantime_serde", default = "default_adaptive_timeout_floor")]
+    pub floor: Duration,
+
+    /// Maximum deadline
+    #[serde(with = "humantime_serde", default = "default_adaptive_timeout_ceiling")]
+    pub ceiling: Duration,
+
+    /// Multiplier applied to the p99 latency
+    #[serde(default = "default_adaptive_timeout_multiplier")]
+    pub multiplier: f64,
+}
+
+impl Default for AdaptiveTimeoutConfig {
+    fn default() -> Self {
+        Self {
+            enabled: true,
+            floor: default_adaptive_timeout_floor(),
+            ceiling: default_adaptive_timeout_ceiling(),
+            multiplier: default_adaptive_timeout_multiplier(),
         }
     }
 }
@@ -187,6 +297,160 @@ impl Default for RecoveryConfig {
     }
 }
 
+/// Performance baseline configuration
+/// Tracks per-device probe timings/bandwidth and flags regressions
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct BaselineConfig {
+    /// Enable performance baselines
+    #[serde(default = "default_true")]
+    pub enabled: bool,
+
+    /// Path of the memory-mapped baseline store (should be on a hostPath)
+    #[serde(default = "default_baseline_path")]
+    pub path: PathBuf,
+
+    /// EWMA smoothing factor (0 < alpha <= 1)
+    #[serde(default = "default_baseline_ewma_alpha")]
+    pub ewma_alpha: f64,
+
+    /// Samples required before regressions are reported
+    #[serde(default = "default_baseline_min_samples")]
+    pub min_samples: u32,
+
+    /// Deviation (in standard deviations) for a sudden regression
+    #[serde(default = "default_baseline_z_threshold")]
+    pub z_threshold: f64,
+
+    /// Minimum relative change for a sudden regression (0.25 = 25%)
+    #[serde(default = "default_baseline_min_change")]
+    pub min_change: f64,
+
+    /// Degradation factor versus the established reference for drift
+    #[serde(default = "default_baseline_drift_ratio")]
+    pub drift_ratio: f64,
+}
+
+impl Default for BaselineConfig {
+    fn default() -> Self {
+        Self {
+            enabled: true,
+            path: default_baseline_path(),
+            ewma_alpha: default_baseline_ewma_alpha(),
+            min_samples: default_baseline_min_samples(),
+            z_threshold: default_baseline_z_threshold(),
+            min_change: default_baseline_min_change(),
+            drift_ratio: default_baseline_drift_ratio(),
+        }
+    }
+}
+
+/// Health state journal configuration
+/// Persists per-device health states and counters across daemon restarts
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct JournalConfig {
+    /// Enable the health journal
+    #[serde(default = "default_true")]
+    pub enabled: bool,
+
+    /// Directory of the journal and snapshot files (should be on a hostPath)
+    #[serde(default = "default_journal_path")]
+    pub path: PathBuf,
+
+    /// Journal records appended before compacting into a snapshot
+    #[serde(default = "default_journal_compact_after")]
+    pub compact_after: usize,
+}
+
+impl Default for JournalConfig {
+    fn default() -> Self {
+        Self {
+            enabled: true,
+            path: default_journal_path(),
+            compact_after: default_journal_compact_after(),
+        }
+    }
+}
+
+/// Peer-relative outlier detection configuration
+/// Compares identical devices on the node against each other after every sweep
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct PeerAnalysisConfig {
+    /// Enable peer analysis
+    #[serde(default = "default_true")]
+    pub enabled: bool,
+
+    /// Minimum number of identical devices needed for a comparison
+    #[serde(default = "default_peer_min_peers")]
+    pub min_peers: usize,
+
+    /// Robust z-score (median/MAD) above which a device is an outlier
+    #[serde(default = "default_peer_z_threshold")]
+    pub z_threshold: f64,
+
+    /// Minimum relative deviation from the node median (0.2 = 20%)
+    #[serde(default = "default_peer_min_deviation")]
+    pub min_deviation: f64,
+
+    /// GPU or memory utilization (%) at or above which a device is left out
+    /// of the comparison; needs workload-aware probing for the samples
+    #[serde(default = "default_peer_busy_utilization")]
+    pub busy_utilization: u32,
+}
+
+impl Default for PeerAnalysisConfig {
+    fn default() -> Self {
+        Self {
+            enabled: true,
+            min_peers: default_peer_min_peers(),
+            z_threshold: default_peer_z_threshold(),
+            min_deviation: default_peer_min_deviation(),
+            busy_utilization: default_peer_busy_utilization(),
+        }
+    }
+}
+
+/// Workload-aware L2 probing configuration
+/// Skips probes on busy healthy devices and probes silent allocated devices early
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct WorkloadConfig {
+    /// Enable workload-aware probing
+    #[serde(default = "default_true")]
+    pub enabled: bool,
+
+    /// GPU utilization (%) at or above which a device counts as busy
+    #[serde(default = "default_busy_utilization")]
+    pub busy_utilization: u32,
+
+    /// Memory controller utilization (%) at or above which a device counts as busy
+    #[serde(default = "default_busy_utilization")]
+    pub busy_memory_utilization: u32,
+
+    /// Longest a busy device may go without an L2 probe
+    #[serde(with = "humantime_serde", default = "default_max_probe_deferral")]
+    pub max_deferral: Duration,
+
+    /// Allocated devices idle for this long are probed early
+    #[serde(with = "humantime_serde", default = "default_silent_after")]
+    pub silent_after: Duration,
+
+    /// Fraction of device memory in use for a device to count as allocated
+    #[serde(default = "default_allocated_memory_fraction")]
+    pub allocated_memory_fraction: f64,
+}
+
+impl Default for WorkloadConfig {
+    fn default() -> Self {
+        Self {
+            enabled: true,
+            busy_utilization: default_busy_utilization(),
+            busy_memory_utilization: default_busy_utilization(),
+            max_deferral: default_max_probe_deferral(),
+            silent_after: default_silent_after(),
+            allocated_memory_fraction: default_allocated_memory_fraction(),
+        }
+    }
+}
+
 /// Main configuration structure
 #[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct Config {
@@ -214,6 +478,19 @@ pub struct Config {
     #[serde(default)]
     pub l3_enabled: bool,
 
+    /// Maximum number of devices checked concurrently per level
+    #[serde(default = "default_detection_concurrency")]
+    pub detection_concurrency: usize,
+
+    /// Maximum number of devices running the L3 bandwidth test at once;
+    /// concurrent tests contend for the same PCIe root complexes
+    #[serde(default = "default_l3_concurrency")]
+    pub l3_concurrency: usize,
+
+    /// Per-device actor scheduling (jitter, missed ticks)
+    #[serde(default)]
+    pub scheduling: SchedulingConfig,
+
     /// Path to gpu-check binary
     #[serde(default = "default_gpu_check_path")]
     pub gpu_check_path: String,
@@ -238,6 +515,22 @@ pub struct Config {
     #[serde(default)]
     pub recovery: RecoveryConfig,
 
+    /// Performance baseline configuration
+    #[serde(default)]
+    pub baseline: BaselineConfig,
+
+    /// Health state journal configuration
+    #[serde(default)]
+    pub journal: JournalConfig,
+
+    /// Peer-relative outlier detection configuration
+    #[serde(default)]
+    pub peer_analysis: PeerAnalysisConfig,
+
+    /// Workload-aware L2 probing configuration
+    #[serde(default)]
+    pub workload: WorkloadConfig,
+
     /// Dry run mode - log actions but don't execute
     #[serde(default)]
     pub dry_run: bool,
@@ -252,12 +545,19 @@ impl Default for Config {
             l2_interval: default_l2_interval(),
             l3_interval: default_l3_interval(),
             l3_enabled: false,
+            detection_concurrency: default_detection_concurrency(),
+            l3_concurrency: default_l3_concurrency(),
+            scheduling: SchedulingConfig::default(),
             gpu_check_path: default_gpu_check_path(),
             health: HealthConfig::default(),
             isolation: IsolationConfig::default(),
             metrics: MetricsConfig::default(),
             healing: HealingConfig::default(),
             recovery: RecoveryConfig::default(),
+            baseline: BaselineConfig::default(),
+            journal: JournalConfig::default(),
+            peer_analysis: PeerAnalysisConfig::default(),
+            workload: WorkloadConfig::default(),
             dry_run: false,
         }
     }
@@ -290,9 +590,50 @@ impl Config {
         if self.l2_interval.is_zero() {
             anyhow::bail!("l2_interval must be > 0");
         }
+        if self.detection_concurrency == 0 {
+            anyhow::bail!("detection_concurrency must be > 0");
+        }
+        if self.l3_concurrency == 0 {
+            anyhow::bail!("l3_concurrency must be > 0");
+        }
+        if !(0.0..=1.0).contains(&self.scheduling.jitter) {
+            anyhow::bail!("scheduling.jitter must be between 0 and 1");
+        }
         if self.metrics.enabled && self.metrics.port == 0 {
             anyhow::bail!("metrics.port must be > 0 when metrics are enabled");
         }
+        if self.health.adaptive_timeout.enabled {
+            let adaptive = &self.health.adaptive_timeout;
+            if adaptive.floor.is_zero() || adaptive.floor > adaptive.ceiling {
+                anyhow::bail!("health.adaptive_timeout requires 0 < floor <= ceiling");
+            }
+            if adaptive.multiplier < 1.0 {
+                anyhow::bail!("health.adaptive_timeout.multiplier must be >= 1");
+            }
+        }
+        if self.peer_analysis.enabled && self.peer_analysis.z_threshold <= 0.0 {
+            anyhow::bail!("peer_analysis.z_threshold must be > 0");
+        }
+        if self.peer_analysis.enabled && self.peer_analysis.busy_utilization > 100 {
+            anyhow::bail!("peer_analysis.busy_utilization must be between 0 and 100");
+        }
+        if self.workload.enabled && self.workload.busy_utilization > 100 {
+            anyhow::bail!("workload.busy_utilization must be between 0 and 100");
+        }
+        if self.journal.enabled && self.journal.compact_after == 0 {
+            anyhow::bail!("journal.compact_after must be > 0");
+        }
+        if self.baseline.enabled {
+            if !(self.baseline.ewma_alpha > 0.0 && self.baseline.ewma_alpha <= 1.0) {
+                anyhow::bail!("baseline.ewma_alpha must be in (0, 1]");
+            }
+            if self.baseline.z_threshold <= 0.0 {
+                anyhow::bail!("baseline.z_threshold must be > 0");
+            }
+            if self.baseline.drift_ratio <= 1.0 {
+                anyhow::bail!("baseline.drift_ratio must be > 1");
+            }
+        }
         Ok(())
     }
 
@@ -318,10 +659,26 @@ fn default_temperature_threshold() -> u32 {
     85
 }
 
+fn default_zombie_threshold() -> Duration {
+    Duration::from_secs(60)
+}
+
 fn default_active_check_timeout() -> Duration {
     Duration::from_secs(5)
 }
 
+fn default_adaptive_timeout_floor() -> Duration {
+    Duration::from_secs(5)
+}
+
+fn default_adaptive_timeout_ceiling() -> Duration {
+    Duration::from_secs(30)
+}
+
+fn default_adaptive_timeout_multiplier() -> f64 {
+    3.0
+}
+
 fn default_l1_interval() -> Duration {
     Duration::from_secs(30)
 }
@@ -334,6 +691,34 @@ fn default_l3_interval() -> Duration {
     Duration::from_secs(86400) // 24 hours
 }
 
+fn default_detection_concurrency() -> usize {
+    8
+}
+
+fn default_l3_concurrency() -> usize {
+    1
+}
+
+fn default_scheduling_jitter() -> f64 {
+    0.1
+}
+
+fn default_suspected_intervals() -> LevelIntervals {
+    LevelIntervals {
+        l1: Some(Duration::from_secs(10)),
+        l2: Some(Duration::from_secs(30)),
+        l3: None,
+    }
+}
+
+fn default_isolated_intervals() -> LevelIntervals {
+    LevelIntervals {
+        l1: None,
+        l2: Some(Duration::from_secs(1800)), // 30 minutes
+        l3: None,
+    }
+}
+
 fn default_gpu_check_path() -> String {
     "/usr/local/bin/gpu-check".to_string()
 }
@@ -374,6 +759,70 @@ fn default_recovery_interval() -> Duration {
     Duration::from_secs(300) // 5 minutes
 }
 
+fn default_busy_utilization() -> u32 {
+    90
+}
+
+fn default_max_probe_deferral() -> Duration {
+    Duration::from_secs(600) // 10 minutes
+}
+
+fn default_silent_after() -> Duration {
+    Duration::from_secs(600) // 10 minutes
+}
+
+fn default_allocated_memory_fraction() -> f64 {
+    0.05
+}
+
+fn default_peer_min_peers() -> usize {
+    4
+}
+
+fn default_peer_z_threshold() -> f64 {
+    3.5
+}
+
+fn default_peer_min_deviation() -> f64 {
+    0.2
+}
+
+fn default_peer_busy_utilization() -> u32 {
+    10
+}
+
+fn default_baseline_path() -> PathBuf {
+    PathBuf::from("/var/lib/gdnd/baseline.bin")
+}
+
+fn default_journal_path() -> PathBuf {
+    PathBuf::from("/var/lib/gdnd/health")
+}
+
+fn default_journal_compact_after() -> usize {
+    1000
+}
+
+fn default_baseline_ewma_alpha() -> f64 {
+    0.1
+}
+
+fn default_baseline_min_samples() -> u32 {
+    10
+}
+
+fn default_baseline_z_threshold() -> f64 {
+    4.0
+}
+
+fn default_baseline_min_change() -> f64 {
+    0.25
+}
+
+fn default_baseline_drift_ratio() -> f64 {
+    2.0
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
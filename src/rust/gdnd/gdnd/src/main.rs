@@ -6,26 +6,48 @@
 
 mod cli;
 mod config;
+mod metrics_server;
 
+use std::path::PathBuf;
 use std::sync::Arc;
 
 use anyhow::{Context, Result};
 use tokio::signal;
-use tokio::sync::{watch, RwLock};
+use tokio::sync::watch;
 use tracing::{error, info, warn};
 use tracing_subscriber::{fmt, prelude::*, EnvFilter};
 
 use cli::Cli;
-use config::{Config, HealingStrategy as ConfigHealingStrategy};
-use gdnd_core::detection::{L1PassiveDetector, L2ActiveDetector, L3PcieDetector};
-use gdnd_core::device::{create_device_interface, DeviceType as CoreDeviceType};
+use config::{Config, HealingStrategy as ConfigHealingStrategy, LevelIntervals, MissedTickPolicy};
+use gdnd_core::baseline::{BaselineConfig as CoreBaselineConfig, BaselineStore};
+use gdnd_core::detection::{
+    AdaptiveTimeoutConfig, L1PassiveDetector, L2ActiveDetector, L3PcieDetector,
+    PeerAnalysisConfig, PeerAnalyzer, WorkloadConfig as CoreWorkloadConfig, WorkloadTracker,
+};
+use gdnd_core::device::{
+    create_device_interface, default_watch_paths, DeviceInterface, DeviceType as CoreDeviceType,
+    InventoryCache, TraceRecorder,
+};
+#[cfg(feature = "replay")]
+use gdnd_core::device::Trace;
 use gdnd_core::healing::{HealingConfig as CoreHealingConfig, HealingStrategy as CoreHealingStrategy, SelfHealer};
+use gdnd_core::journal::HealthJournal;
 use gdnd_core::metrics::MetricsRegistry;
-use gdnd_core::scheduler::{DetectionScheduler, IsolationExecutor};
-use gdnd_core::state_machine::{GpuHealthManager, StateTransition};
+use gdnd_core::overhead::{self, CountingAllocator};
+#[cfg(feature = "replay")]
+use gdnd_core::replay::{self, ReplayExecutor, ReplayReport};
+use gdnd_core::scheduler::{
+    DetectionScheduler, IsolationExecutor, MissedTickPolicy as CoreMissedTickPolicy, SchedulePolicy,
+    StateIntervals,
+};
+use gdnd_core::state_machine::{GpuHealthManager, HealthState, StateTransition};
 use gdnd_k8s::client::K8sClient;
 use gdnd_k8s::node_ops::{IsolationConfig, NodeOperator};
 
+/// Counts allocations for the daemon's overhead metrics
+#[global_allocator]
+static ALLOCATOR: CountingAllocator = CountingAllocator;
+
 /// Initialize the tracing/logging subsystem
 fn init_logging(log_level: &str, json_format: bool) {
     let filter =
@@ -73,100 +95,169 @@ fn to_core_healing_strategy(strategy: ConfigHealingStrategy) -> CoreHealingStrat
     }
 }
 
-/// Node operator wrapper implementing IsolationExecutor
-struct NodeOperatorExecutor {
-    operator: NodeOperator,
+/// Convert config baseline settings to core baseline config
+fn to_core_baseline_config(config: &config::BaselineConfig) -> CoreBaselineConfig {
+    CoreBaselineConfig {
+        ewma_alpha: config.ewma_alpha,
+        min_samples: config.min_samples,
+        z_threshold: config.z_threshold,
+        min_change: config.min_change,
+        drift_ratio: config.drift_ratio,
+    }
 }
 
-impl NodeOperatorExecutor {
-    fn new(operator: NodeOperator) -> Self {
-        Self { operator }
+/// Open the performance baseline store, if enabled
+///
+/// Failure to open the store is not fatal: detection simply runs without
+/// baselines.
+fn open_baseline_store(config: &config::BaselineConfig) -> Option<Arc<BaselineStore>> {
+    if !config.enabled {
+        return None;
     }
-}
 
-#[async_trait::async_trait]
-impl IsolationExecutor for NodeOperatorExecutor {
-    async fn execute(&self, transition: &StateTransition) -> Result<()> {
-        self.operator.execute_actions(&transition.actions).await
+    match BaselineStore::open(&config.path, to_core_baseline_config(config)) {
+        Ok(store) => Some(Arc::new(store)),
+        Err(e) => {
+            warn!(path = ?config.path, error = %e, "Failed to open baseline store, baselines disabled");
+            None
+        }
     }
 }
 
-/// Run the main detection loop
-async fn run(config: Config, shutdown_rx: watch::Receiver<bool>) -> Result<()> {
-    let node_name = config
-        .node_name
-        .clone()
-        .context("Node name must be specified via config, --node-name, or NODE_NAME env")?;
-
-    info!(node = %node_name, "Starting GDND on node");
-
-    // Create device interface based on device type
-    let device = create_device_interface(to_core_device_type(config.device_type))
-        .await
-        .context("Failed to create device interface")?;
-
-    // List available devices
-    let devices = device.list_devices().await?;
-    info!(count = devices.len(), "Discovered GPU devices");
+/// Attach the health state journal to the manager, if enabled
+///
+/// Failure to open the journal is not fatal: health state is then kept in
+/// memory only.
+fn open_health_journal(
+    manager: GpuHealthManager,
+    config: &config::JournalConfig,
+) -> GpuHealthManager {
+    if !config.enabled {
+        return manager;
+    }
 
-    if devices.is_empty() {
-        warn!("No GPU devices found on this node");
+    match HealthJournal::open(&config.path) {
+        Ok((journal, records)) => {
+            manager.with_journal(journal.with_compact_after(config.compact_after), records)
+        }
+        Err(e) => {
+            warn!(path = ?config.path, error = %e, "Failed to open health journal, state not persisted");
+            manager
+        }
     }
+}
 
-    // Initialize metrics registry
-    let metrics = Arc::new(MetricsRegistry::new());
-    metrics.set_gpu_count(devices.len() as i64);
+/// Convert config per-state intervals to core state intervals
+fn to_core_state_intervals(intervals: &LevelIntervals) -> StateIntervals {
+    StateIntervals {
+        l1: intervals.l1,
+        l2: intervals.l2,
+        l3: intervals.l3,
+    }
+}
 
-    // Initialize K8s client and node operator
-    let k8s_client = K8sClient::new().await?;
-    let node_operator = NodeOperator::new(
-        k8s_client,
-        node_name.clone(),
-        to_k8s_isolation_config(&config.isolation),
-        config.dry_run,
-    );
-    let executor = Arc::new(NodeOperatorExecutor::new(node_operator));
+/// Convert config missed tick policy to core missed tick policy
+fn to_core_missed_tick_policy(policy: MissedTickPolicy) -> CoreMissedTickPolicy {
+    match policy {
+        MissedTickPolicy::Burst => CoreMissedTickPolicy::Burst,
+        MissedTickPolicy::Delay => CoreMissedTickPolicy::Delay,
+        MissedTickPolicy::Skip => CoreMissedTickPolicy::Skip,
+    }
+}
 
-    // Initialize health state manager
-    let health_manager = if config.recovery.enabled {
+/// Build the health state manager from config, without persistence
+fn build_health_manager(config: &Config) -> GpuHealthManager {
+    if config.recovery.enabled {
         info!(
             threshold = config.recovery.threshold,
             "Recovery detection enabled"
         );
-        Arc::new(RwLock::new(GpuHealthManager::with_recovery(
+        GpuHealthManager::with_recovery(
             config.health.failure_threshold,
             config.recovery.threshold,
             config.health.fatal_xids.clone(),
-        )))
+        )
     } else {
-        Arc::new(RwLock::new(GpuHealthManager::new(
+        GpuHealthManager::new(
             config.health.failure_threshold,
             config.health.fatal_xids.clone(),
-        )))
-    };
+        )
+    }
+}
 
+/// Assemble the detection pipeline described by config
+///
+/// Shared by the daemon and trace replay, so a replay exercises exactly the
+/// detectors, intervals and policies the daemon would run.
+fn build_scheduler<E: IsolationExecutor + 'static>(
+    config: &Config,
+    device: Arc<dyn DeviceInterface>,
+    health_manager: Arc<GpuHealthManager>,
+    executor: Arc<E>,
+    metrics: Arc<MetricsRegistry>,
+    baseline: Option<Arc<BaselineStore>>,
+) -> DetectionScheduler<E> {
     // Initialize detectors
     let l1_detector = L1PassiveDetector::new(
         device.clone(),
         config.health.temperature_threshold,
         config.health.fatal_xids.clone(),
-    );
+    )
+    .with_concurrency(config.detection_concurrency);
 
-    let l2_detector = L2ActiveDetector::new(
+    let mut l2_detector = L2ActiveDetector::new(
         device.clone(),
         config.gpu_check_path.clone(),
         config.health.active_check_timeout,
-    );
+    )
+    .with_concurrency(config.detection_concurrency);
+    if let Some(ref store) = baseline {
+        l2_detector = l2_detector.with_baseline(store.clone());
+    }
+    if config.health.adaptive_timeout.enabled {
+        if baseline.is_some() {
+            let adaptive = &config.health.adaptive_timeout;
+            info!(
+                floor = ?adaptive.floor,
+                ceiling = ?adaptive.ceiling,
+                multiplier = adaptive.multiplier,
+                "Adaptive L2 timeouts enabled"
+            );
+            l2_detector = l2_detector.with_adaptive_timeout(AdaptiveTimeoutConfig {
+                floor: adaptive.floor,
+                ceiling: adaptive.ceiling,
+                multiplier: adaptive.multiplier,
+            });
+        } else {
+            warn!("Adaptive L2 timeouts require a baseline store, using static timeout");
+        }
+    }
 
     // Create scheduler
     let mut scheduler = DetectionScheduler::new(
         l1_detector,
         l2_detector,
-        health_manager.clone(),
+        health_manager,
         executor,
-        metrics.clone(),
+        metrics,
         config.l1_interval,
         config.l2_interval,
+    )
+    .with_schedule(SchedulePolicy {
+        jitter: config.scheduling.jitter,
+        missed_tick: to_core_missed_tick_policy(config.scheduling.missed_tick),
+    })
+    .with_state_intervals(
+        HealthState::Suspected,
+        to_core_state_intervals(&config.scheduling.suspected),
+    )
+    .with_state_intervals(
+        HealthState::Unhealthy,
+        to_core_state_intervals(&config.scheduling.unhealthy),
+    )
+    .with_state_intervals(
+        HealthState::Isolated,
+        to_core_state_intervals(&config.scheduling.isolated),
     );
 
     // Attach self-healer if healing is enabled
@@ -185,10 +276,49 @@ async fn run(config: Config, shutdown_rx: watch::Receiver<bool>) -> Result<()> {
             dry_run: config.healing.dry_run,
         };
 
-        let healer = SelfHealer::new(healing_config, core_device_type);
+        let healer = SelfHealer::new(healing_config, core_device_type)
+            .with_device(device.clone())
+            .with_zombie_threshold(config.health.zombie_threshold);
         scheduler = scheduler.with_healer(healer);
     }
 
+    // Attach peer analysis if enabled
+    if config.peer_analysis.enabled {
+        info!(
+            min_peers = config.peer_analysis.min_peers,
+            z_threshold = config.peer_analysis.z_threshold,
+            "Peer outlier detection enabled"
+        );
+
+        let analyzer = PeerAnalyzer::new(PeerAnalysisConfig {
+            min_peers: config.peer_analysis.min_peers,
+            z_threshold: config.peer_analysis.z_threshold,
+            min_deviation: config.peer_analysis.min_deviation,
+            busy_utilization: config.peer_analysis.busy_utilization,
+        });
+        scheduler = scheduler.with_peer_analysis(analyzer);
+    }
+
+    // Attach workload-aware probing if enabled
+    if config.workload.enabled {
+        info!(
+            busy_utilization = config.workload.busy_utilization,
+            max_deferral = ?config.workload.max_deferral,
+            "Workload-aware L2 probing enabled"
+        );
+
+        let tracker = WorkloadTracker::new(CoreWorkloadConfig {
+            busy_utilization: config.workload.busy_utilization,
+            busy_memory_utilization: config.workload.busy_memory_utilization,
+            max_deferral: config.workload.max_deferral,
+            // Samples older than a few L1 ticks no longer describe the load
+            max_sample_age: config.l1_interval * 3,
+            silent_after: config.workload.silent_after,
+            allocated_memory_fraction: config.workload.allocated_memory_fraction,
+        });
+        scheduler = scheduler.with_workload(Arc::new(tracker));
+    }
+
     // Attach L3 PCIe detector if enabled
     if config.l3_enabled {
         info!(
@@ -196,57 +326,165 @@ async fn run(config: Config, shutdown_rx: watch::Receiver<bool>) -> Result<()> {
             "L3 PCIe detection enabled"
         );
 
-        let l3_detector = L3PcieDetector::new(device.clone());
+        let mut l3_detector =
+            L3PcieDetector::new(device.clone()).with_concurrency(config.l3_concurrency);
+        if let Some(ref store) = baseline {
+            l3_detector = l3_detector.with_baseline(store.clone());
+        }
         scheduler = scheduler.with_l3(l3_detector, config.l3_interval);
     }
 
+    scheduler
+}
+
+/// Node operator wrapper implementing IsolationExecutor
+struct NodeOperatorExecutor {
+    operator: NodeOperator,
+}
+
+impl NodeOperatorExecutor {
+    fn new(operator: NodeOperator) -> Self {
+        Self { operator }
+    }
+}
+
+#[async_trait::async_trait]
+impl IsolationExecutor for NodeOperatorExecutor {
+    async fn execute(&self, transition: &StateTransition) -> Result<()> {
+        self.operator.execute_actions(&transition.actions).await
+    }
+}
+
+/// Run the main detection loop
+async fn run(
+    config: Config,
+    record_trace: Option<PathBuf>,
+    shutdown_rx: watch::Receiver<bool>,
+) -> Result<()> {
+    let node_name = config
+        .node_name
+        .clone()
+        .context("Node name must be specified via config, --node-name, or NODE_NAME env")?;
+
+    info!(node = %node_name, "Starting GDND on node");
+
+    // Create device interface based on device type
+    let device = create_device_interface(
+        to_core_device_type(config.device_type),
+        config.health.zombie_threshold,
+    )
+    .await
+    .context("Failed to create device interface")?;
+
+    // Record raw device responses below the cache, so a replay sees what
+    // the hardware reported
+    let device = match record_trace {
+        Some(path) => {
+            info!(path = ?path, "Recording device trace");
+            let recorder = TraceRecorder::create(device, &path)
+                .with_context(|| format!("Failed to create trace file {:?}", path))?;
+            Arc::new(recorder) as Arc<dyn DeviceInterface>
+        }
+        None => device,
+    };
+
+    // Enumerate once; sysfs hotplug/driver changes and healing refresh it
+    let inventory = Arc::new(InventoryCache::new(
+        device.clone(),
+        default_watch_paths(device.device_type()),
+    ));
+    let device: Arc<dyn DeviceInterface> = inventory.clone();
+
+    // List available devices
+    let devices = device.list_devices().await?;
+    info!(count = devices.len(), "Discovered GPU devices");
+
+    if devices.is_empty() {
+        warn!("No GPU devices found on this node");
+    }
+
+    // Initialize metrics registry
+    let metrics = Arc::new(MetricsRegistry::new());
+    metrics.set_gpu_count(devices.len() as i64);
+
+    // Initialize K8s client and node operator
+    let k8s_client = K8sClient::new().await?;
+    let node_operator = NodeOperator::new(
+        k8s_client,
+        node_name.clone(),
+        to_k8s_isolation_config(&config.isolation),
+        config.dry_run,
+    );
+    let executor = Arc::new(NodeOperatorExecutor::new(node_operator));
+
+    // Initialize health state manager
+    let health_manager = Arc::new(open_health_journal(
+        build_health_manager(&config),
+        &config.journal,
+    ));
+    let baseline = open_baseline_store(&config.baseline);
+
+    let scheduler = build_scheduler(
+        &config,
+        device,
+        health_manager,
+        executor,
+        metrics.clone(),
+        baseline,
+    )
+    .with_inventory(inventory);
+
     // Start metrics server if enabled
     if config.metrics.enabled {
         let port = config.metrics.port;
+        let shutdown = shutdown_rx.clone();
         tokio::spawn(async move {
-            if let Err(e) = start_metrics_server(port).await {
+            if let Err(e) = metrics_server::serve(port, shutdown).await {
                 error!(error = %e, "Metrics server failed");
             }
         });
+        tokio::spawn(overhead::sample(
+            metrics,
+            overhead::SAMPLE_INTERVAL,
+            shutdown_rx.clone(),
+        ));
     }
 
     // Run the main detection loop
-    scheduler.run(shutdown_rx).await?;
+    Arc::new(scheduler).run(shutdown_rx).await?;
 
     info!("GDND shutdown complete");
     Ok(())
 }
 
-/// Start the Prometheus metrics HTTP server
-async fn start_metrics_server(port: u16) -> Result<()> {
-    use std::net::SocketAddr;
-    use tokio::io::{AsyncReadExt, AsyncWriteExt};
-    use tokio::net::TcpListener;
-
-    let addr = SocketAddr::from(([0, 0, 0, 0], port));
-    let listener = TcpListener::bind(addr).await?;
-    info!(port = port, "Metrics server listening");
-
-    loop {
-        let (mut socket, _) = listener.accept().await?;
-
-        tokio::spawn(async move {
-            let mut buf = [0; 1024];
-            let _ = socket.read(&mut buf).await;
-
-            let metrics_output = prometheus::TextEncoder::new()
-                .encode_to_string(&prometheus::gather())
-                .unwrap_or_default();
-
-            let response = format!(
-                "HTTP/1.1 200 OK\r\nContent-Type: text/plain; charset=utf-8\r\nContent-Length: {}\r\n\r\n{}",
-                metrics_output.len(),
-                metrics_output
-            );
+/// Replay a recorded trace through the configured pipeline on a virtual clock
+///
+/// Nothing acts on the host: isolations are only counted, healing is off,
+/// and baselines and health state stay in memory.
+#[cfg(feature = "replay")]
+fn replay_trace(config: &Config, path: &std::path::Path) -> Result<ReplayReport> {
+    let trace =
+        Trace::load(path).with_context(|| format!("Failed to load trace from {:?}", path))?;
+
+    let mut config = config.clone();
+    config.healing.enabled = false;
+    let baseline = config.baseline.enabled.then(|| {
+        Arc::new(BaselineStore::in_memory(to_core_baseline_config(
+            &config.baseline,
+        )))
+    });
 
-            let _ = socket.write_all(response.as_bytes()).await;
-        });
-    }
+    let report = replay::replay(&trace, |device| {
+        build_scheduler(
+            &config,
+            device,
+            Arc::new(build_health_manager(&config)),
+            Arc::new(ReplayExecutor::default()),
+            Arc::new(MetricsRegistry::new()),
+            baseline,
+        )
+    })?;
+    Ok(report)
 }
 
 #[tokio::main]
@@ -321,9 +559,12 @@ async fn main() -> Result<()> {
     if cli.once {
         info!("Running single detection pass (--once mode)");
         // Create minimal setup for single pass
-        let device = create_device_interface(to_core_device_type(config.device_type))
-            .await
-            .context("Failed to create device interface")?;
+        let device = create_device_interface(
+            to_core_device_type(config.device_type),
+            config.health.zombie_threshold,
+        )
+        .await
+        .context("Failed to create device interface")?;
 
         let l1_detector = L1PassiveDetector::new(
             device.clone(),
@@ -347,6 +588,24 @@ async fn main() -> Result<()> {
         return Ok(());
     }
 
+    // Replay a recorded trace instead of watching devices
+    if let Some(path) = cli.replay {
+        #[cfg(feature = "replay")]
+        {
+            info!(path = ?path, "Replaying device trace");
+            let report = tokio::task::spawn_blocking(move || replay_trace(&config, &path))
+                .await
+                .context("Trace replay panicked")??;
+            println!("{}", report);
+            return Ok(());
+        }
+        #[cfg(not(feature = "replay"))]
+        anyhow::bail!(
+            "Cannot replay {:?}: gdnd was built without the `replay` feature",
+            path
+        );
+    }
+
     // Run main loop
-    run(config, shutdown_rx).await
+    run(config, cli.record_trace, shutdown_rx).await
 }
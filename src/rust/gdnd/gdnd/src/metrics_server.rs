@@ -0,0 +1,577 @@
+//! Prometheus metrics HTTP endpoint
+//!
+//! Serves `/metrics` over HTTP/1.1 with keep-alive. The exposition format is
+//! negotiated from the `Accept` header (Prometheus text, OpenMetrics text or
+//! delimited protobuf) and the body is gzip-compressed for scrapers that
+//! accept it. Encoded bodies are cached per format and encoding until a
+//! metric is updated, so scrapes between detection updates cost no encoding.
+
+use std::convert::Infallible;
+use std::fmt::Write as _;
+use std::io::Write as _;
+use std::net::SocketAddr;
+use std::sync::{Arc, Mutex};
+use std::time::Duration;
+
+use anyhow::{Context, Result};
+use bytes::Bytes;
+use flate2::write::GzEncoder;
+use flate2::Compression;
+use http_body_util::Full;
+use hyper::body::Incoming;
+use hyper::header::{self, HeaderMap, HeaderValue};
+use hyper::server::conn::http1;
+use hyper::service::service_fn;
+use hyper::{Method, Request, Response, StatusCode};
+use hyper_util::rt::{TokioIo, TokioTimer};
+use prometheus::proto::{LabelPair, MetricFamily, MetricType};
+use prometheus::{Encoder, ProtobufEncoder, TextEncoder};
+use tokio::net::TcpListener;
+use tokio::sync::watch;
+use tracing::{debug, info, warn};
+
+use gdnd_core::metrics::MetricsRegistry;
+
+/// Connections that do not send a complete request header in time are closed
+const HEADER_READ_TIMEOUT: Duration = Duration::from_secs(10);
+
+/// Pause after a failed accept (e.g. out of file descriptors)
+const ACCEPT_BACKOFF: Duration = Duration::from_millis(100);
+
+const TEXT_CONTENT_TYPE: &str = "text/plain; version=0.0.4; charset=utf-8";
+const OPENMETRICS_CONTENT_TYPE: &str = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+/// Exposition format
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum Format {
+    Text,
+    OpenMetrics,
+    Protobuf,
+}
+
+impl Format {
+    fn content_type(self) -> &'static str {
+        match self {
+            Format::Text => TEXT_CONTENT_TYPE,
+            Format::OpenMetrics => OPENMETRICS_CONTENT_TYPE,
+            Format::Protobuf => prometheus::PROTOBUF_FORMAT,
+        }
+    }
+
+    /// The supported format the client ranks highest in `Accept`
+    ///
+    /// Ties go to the range listed first; no match falls back to text.
+    fn negotiate(accept: Option<&str>) -> Self {
+        let mut best: Option<(Format, f32)> = None;
+        for (range, q) in accept.into_iter().flat_map(media_ranges) {
+            let format = match range.split(';').next().unwrap_or("").trim() {
+                "application/openmetrics-text" => Format::OpenMetrics,
+                "application/vnd.google.protobuf"
+                    if range.contains("proto=io.prometheus.client.MetricFamily")
+                        && range.contains("encoding=delimited") =>
+                {
+                    Format::Protobuf
+                }
+                "text/plain" => Format::Text,
+                _ => continue,
+            };
+            if best.map_or(true, |(_, best_q)| q > best_q) {
+                best = Some((format, q));
+            }
+        }
+        best.map_or(Format::Text, |(format, _)| format)
+    }
+}
+
+/// Split a header list into (range, q) pairs, dropping refused ones (q=0)
+fn media_ranges(header: &str) -> impl Iterator<Item = (&str, f32)> {
+    header.split(',').filter_map(|range| {
+        let q = range
+            .split(';')
+            .filter_map(|param| param.trim().strip_prefix("q="))
+            .next()
+            .map_or(1.0, |q| q.trim().parse().unwrap_or(0.0));
+        (q > 0.0).then_some((range.trim(), q))
+    })
+}
+
+fn accepts_gzip(accept_encoding: Option<&str>) -> bool {
+    accept_encoding
+        .into_iter()
+        .flat_map(media_ranges)
+        .any(|(coding, _)| coding.split(';').next().unwrap_or("").trim() == "gzip")
+}
+
+/// An encoded body and the metrics generation it was encoded at
+struct Cached {
+    generation: u64,
+    body: Bytes,
+}
+
+/// Encoded bodies per (format, gzip), reused until a metric changes
+#[derive(Default)]
+struct Exposition {
+    slots: [Mutex<Option<Cached>>; 6],
+}
+
+impl Exposition {
+    /// Return the current body, encoding it only if metrics changed since
+    ///
+    /// Scrapes that race for a stale slot wait for the first to encode.
+    fn body(&self, format: Format, gzip: bool) -> Result<Bytes> {
+        let generation = MetricsRegistry::generation();
+        let mut slot = self.slots[format as usize * 2 + gzip as usize]
+            .lock()
+            .unwrap_or_else(|e| e.into_inner());
+        if let Some(cached) = slot.as_ref().filter(|c| c.generation == generation) {
+            return Ok(cached.body.clone());
+        }
+
+        let body = if gzip {
+            let plain = self.body(format, false)?;
+            let mut encoder =
+                GzEncoder::new(Vec::with_capacity(plain.len() / 4), Compression::fast());
+            encoder.write_all(&plain)?;
+            Bytes::from(encoder.finish()?)
+        } else {
+            Bytes::from(encode(format, &prometheus::gather())?)
+        };
+        *slot = Some(Cached {
+            generation,
+            body: body.clone(),
+        });
+        Ok(body)
+    }
+}
+
+fn encode(format: Format, families: &[MetricFamily]) -> Result<Vec<u8>> {
+    let mut buf = Vec::new();
+    match format {
+        Format::Text => TextEncoder::new().encode(families, &mut buf)?,
+        Format::Protobuf => ProtobufEncoder::new().encode(families, &mut buf)?,
+        Format::OpenMetrics => buf = encode_openmetrics(families).into_bytes(),
+    }
+    Ok(buf)
+}
+
+/// Encode metric families in the OpenMetrics 1.0 text format
+///
+/// Differs from the Prometheus text format in counter naming (the family
+/// drops `_total`, samples keep it), `unknown` for untyped metrics,
+/// escaped quotes in help text and the closing `# EOF`.
+fn encode_openmetrics(families: &[MetricFamily]) -> String {
+    let mut out = String::new();
+    for family in families {
+        let full_name = family.get_name();
+        let (kind, name) = match family.get_field_type() {
+            MetricType::COUNTER => (
+                "counter",
+                full_name.strip_suffix("_total").unwrap_or(full_name),
+            ),
+            MetricType::GAUGE => ("gauge", full_name),
+            MetricType::HISTOGRAM => ("histogram", full_name),
+            MetricType::SUMMARY => ("summary", full_name),
+            MetricType::UNTYPED => ("unknown", full_name),
+        };
+        let _ = writeln!(out, "# TYPE {} {}", name, kind);
+        if !family.get_help().is_empty() {
+            let _ = writeln!(out, "# HELP {} {}", name, escape(family.get_help()));
+        }
+
+        for metric in family.get_metric() {
+            let labels = metric.get_label();
+            match family.get_field_type() {
+                MetricType::COUNTER => sample(
+                    &mut out,
+                    name,
+                    "_total",
+                    labels,
+                    None,
+                    metric.get_counter().get_value(),
+                ),
+                MetricType::GAUGE => sample(
+                    &mut out,
+                    name,
+                    "",
+                    labels,
+                    None,
+                    metric.get_gauge().get_value(),
+                ),
+                MetricType::UNTYPED => sample(
+                    &mut out,
+                    name,
+                    "",
+                    labels,
+                    None,
+                    metric.get_untyped().get_value(),
+                ),
+                MetricType::HISTOGRAM => {
+                    let histogram = metric.get_histogram();
+                    let mut has_inf = false;
+                    for bucket in histogram.get_bucket() {
+                        has_inf |= bucket.get_upper_bound() == f64::INFINITY;
+                        sample(
+                            &mut out,
+                            name,
+                            "_bucket",
+                            labels,
+                            Some(("le", bucket.get_upper_bound())),
+                            bucket.get_cumulative_count() as f64,
+                        );
+                    }
+                    if !has_inf {
+                        sample(
+                            &mut out,
+                            name,
+                            "_bucket",
+                            labels,
+                            Some(("le", f64::INFINITY)),
+                            histogram.get_sample_count() as f64,
+                        );
+                    }
+                    sample(
+                        &mut out,
+                        name,
+                        "_sum",
+                        labels,
+                        None,
+                        histogram.get_sample_sum(),
+                    );
+                    sample(
+                        &mut out,
+                        name,
+                        "_count",
+                        labels,
+                        None,
+                        histogram.get_sample_count() as f64,
+                    );
+                }
+                MetricType::SUMMARY => {
+                    let summary = metric.get_summary();
+                    for quantile in summary.get_quantile() {
+                        sample(
+                            &mut out,
+                            name,
+                            "",
+                            labels,
+                            Some(("quantile", quantile.get_quantile())),
+                            quantile.get_value(),
+                        );
+                    }
+                    sample(
+                        &mut out,
+                        name,
+                        "_sum",
+                        labels,
+                        None,
+                        summary.get_sample_sum(),
+                    );
+                    sample(
+                        &mut out,
+                        name,
+                        "_count",
+                        labels,
+                        None,
+                        summary.get_sample_count() as f64,
+                    );
+                }
+            }
+        }
+    }
+    out.push_str("# EOF\n");
+    out
+}
+
+/// Write one sample line, with an optional extra label such as `le`
+fn sample(
+    out: &mut String,
+    name: &str,
+    suffix: &str,
+    labels: &[LabelPair],
+    extra: Option<(&str, f64)>,
+    value: f64,
+) {
+    out.push_str(name);
+    out.push_str(suffix);
+    if !labels.is_empty() || extra.is_some() {
+        out.push('{');
+        let mut first = true;
+        for label in labels {
+            if !first {
+                out.push(',');
+            }
+            first = false;
+            let _ = write!(
+                out,
+                "{}=\"{}\"",
+                label.get_name(),
+                escape(label.get_value())
+            );
+        }
+        if let Some((label, bound)) = extra {
+            if !first {
+                out.push(',');
+            }
+            let _ = write!(out, "{}=\"{}\"", label, float(bound));
+        }
+        out.push('}');
+    }
+    out.push(' ');
+    out.push_str(&float(value));
+    out.push('\n');
+}
+
+fn float(value: f64) -> String {
+    if value.is_nan() {
+        "NaN".to_string()
+    } else if value.is_infinite() {
+        if value > 0.0 { "+Inf" } else { "-Inf" }.to_string()
+    } else {
+        // Debug keeps the fraction ("1.0"), the canonical form for bounds
+        format!("{:?}", value)
+    }
+}
+
+fn escape(s: &str) -> String {
+    s.replace('\\', r"\\")
+        .replace('"', "\\\"")
+        .replace('\n', r"\n")
+}
+
+fn header<'a>(headers: &'a HeaderMap, name: header::HeaderName) -> Option<&'a str> {
+    headers.get(name).and_then(|v| v.to_str().ok())
+}
+
+fn status(code: StatusCode) -> Response<Full<Bytes>> {
+    let mut response = Response::new(Full::new(Bytes::new()));
+    *response.status_mut() = code;
+    response
+}
+
+async fn handle(
+    exposition: Arc<Exposition>,
+    request: Request<Incoming>,
+) -> Result<Response<Full<Bytes>>, Infallible> {
+    if request.uri().path() != "/metrics" {
+        return Ok(status(StatusCode::NOT_FOUND));
+    }
+    if request.method() != Method::GET && request.method() != Method::HEAD {
+        let mut response = status(StatusCode::METHOD_NOT_ALLOWED);
+        response
+            .headers_mut()
+            .insert(header::ALLOW, HeaderValue::from_static("GET, HEAD"));
+        return Ok(response);
+    }
+
+    let format = Format::negotiate(header(request.headers(), header::ACCEPT));
+    let gzip = accepts_gzip(header(request.headers(), header::ACCEPT_ENCODING));
+    let body = match exposition.body(format, gzip) {
+        Ok(body) => body,
+        Err(e) => {
+            warn!(error = %e, "Failed to encode metrics");
+            return Ok(status(StatusCode::INTERNAL_SERVER_ERROR));
+        }
+    };
+
+    let length = body.len();
+    let mut response = Response::new(Full::new(if request.method() == Method::HEAD {
+        Bytes::new()
+    } else {
+        body
+    }));
+    let headers = response.headers_mut();
+    headers.insert(
+        header::CONTENT_TYPE,
+        HeaderValue::from_static(format.content_type()),
+    );
+    headers.insert(header::CONTENT_LENGTH, HeaderValue::from(length));
+    headers.insert(
+        header::VARY,
+        HeaderValue::from_static("Accept, Accept-Encoding"),
+    );
+    if gzip {
+        headers.insert(header::CONTENT_ENCODING, HeaderValue::from_static("gzip"));
+    }
+    Ok(response)
+}
+
+/// Serve metrics on `port` until shutdown
+pub async fn serve(port: u16, shutdown: watch::Receiver<bool>) -> Result<()> {
+    let addr = SocketAddr::from(([0, 0, 0, 0], port));
+    let listener = TcpListener::bind(addr)
+        .await
+        .with_context(|| format!("Failed to bind metrics port {}", port))?;
+    info!(port = port, "Metrics server listening");
+    serve_listener(listener, shutdown).await;
+    Ok(())
+}
+
+async fn serve_listener(listener: TcpListener, mut shutdown: watch::Receiver<bool>) {
+    let exposition = Arc::new(Exposition::default());
+
+    loop {
+        let (stream, peer) = tokio::select! {
+            accepted = listener.accept() => match accepted {
+                Ok(accepted) => accepted,
+                Err(e) => {
+                    warn!(error = %e, "Failed to accept metrics connection");
+                    tokio::time::sleep(ACCEPT_BACKOFF).await;
+                    continue;
+                }
+            },
+            _ = shutdown.changed() => return,
+        };
+
+        let exposition = Arc::clone(&exposition);
+        tokio::spawn(async move {
+            let service = service_fn(move |request| handle(Arc::clone(&exposition), request));
+            let connection = http1::Builder::new()
+                .timer(TokioTimer::new())
+                .header_read_timeout(HEADER_READ_TIMEOUT)
+                .keep_alive(true)
+                .serve_connection(TokioIo::new(stream), service)
+                .await;
+            if let Err(e) = connection {
+                debug!(peer = %peer, error = %e, "Metrics connection closed");
+            }
+        });
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use prometheus::proto::{Bucket, Metric};
+    use tokio::io::{AsyncReadExt, AsyncWriteExt};
+
+    #[test]
+    fn test_negotiate_format() {
+        assert_eq!(Format::negotiate(None), Format::Text);
+        assert_eq!(Format::negotiate(Some("*/*")), Format::Text);
+        // What Prometheus 2.x sends by default
+        assert_eq!(
+            Format::negotiate(Some(
+                "application/openmetrics-text;version=1.0.0,application/openmetrics-text;version=0.0.1;q=0.75,text/plain;version=0.0.4;q=0.5,*/*;q=0.1"
+            )),
+            Format::OpenMetrics
+        );
+        assert_eq!(
+            Format::negotiate(Some(
+                "application/vnd.google.protobuf;proto=io.prometheus.client.MetricFamily;encoding=delimited;q=0.7,text/plain;version=0.0.4;q=0.3"
+            )),
+            Format::Protobuf
+        );
+        assert_eq!(
+            Format::negotiate(Some("application/openmetrics-text;q=0,text/plain")),
+            Format::Text
+        );
+    }
+
+    #[test]
+    fn test_accepts_gzip() {
+        assert!(accepts_gzip(Some("gzip")));
+        assert!(accepts_gzip(Some("deflate, gzip;q=0.5")));
+        assert!(!accepts_gzip(Some("gzip;q=0")));
+        assert!(!accepts_gzip(Some("identity")));
+        assert!(!accepts_gzip(None));
+    }
+
+    fn label(name: &str, value: &str) -> LabelPair {
+        let mut label = LabelPair::new();
+        label.set_name(name.to_string());
+        label.set_value(value.to_string());
+        label
+    }
+
+    #[test]
+    fn test_openmetrics_encoding() {
+        let mut counter = MetricFamily::new();
+        counter.set_name("gdnd_isolation_actions_total".to_string());
+        counter.set_help("Total \"isolation\" actions".to_string());
+        counter.set_field_type(MetricType::COUNTER);
+        let mut metric = Metric::new();
+        metric.mut_label().push(label("action", "cordon"));
+        metric.mut_counter().set_value(2.0);
+        counter.mut_metric().push(metric);
+
+        let mut histogram = MetricFamily::new();
+        histogram.set_name("gdnd_time_to_isolation_seconds".to_string());
+        histogram.set_field_type(MetricType::HISTOGRAM);
+        let mut metric = Metric::new();
+        let mut bucket = Bucket::new();
+        bucket.set_upper_bound(1.0);
+        bucket.set_cumulative_count(1);
+        metric.mut_histogram().mut_bucket().push(bucket);
+        metric.mut_histogram().set_sample_count(3);
+        metric.mut_histogram().set_sample_sum(42.5);
+        histogram.mut_metric().push(metric);
+
+        assert_eq!(
+            encode_openmetrics(&[counter, histogram]),
+            "# TYPE gdnd_isolation_actions counter\n\
+             # HELP gdnd_isolation_actions Total \\\"isolation\\\" actions\n\
+             gdnd_isolation_actions_total{action=\"cordon\"} 2.0\n\
+             # TYPE gdnd_time_to_isolation_seconds histogram\n\
+             gdnd_time_to_isolation_seconds_bucket{le=\"1.0\"} 1.0\n\
+             gdnd_time_to_isolation_seconds_bucket{le=\"+Inf\"} 3.0\n\
+             gdnd_time_to_isolation_seconds_sum 42.5\n\
+             gdnd_time_to_isolation_seconds_count 3.0\n\
+             # EOF\n"
+        );
+    }
+
+    #[test]
+    fn test_body_cached_until_metrics_change() {
+        let metrics = MetricsRegistry::new();
+        let exposition = Exposition::default();
+        let first = exposition.body(Format::Text, false).unwrap();
+        let second = exposition.body(Format::Text, false).unwrap();
+        assert_eq!(first.as_ptr(), second.as_ptr());
+
+        metrics.set_gpu_count(8);
+        let third = exposition.body(Format::Text, false).unwrap();
+        assert_ne!(first.as_ptr(), third.as_ptr());
+
+        let compressed = exposition.body(Format::Text, true).unwrap();
+        let mut plain = Vec::new();
+        std::io::Read::read_to_end(
+            &mut flate2::read::GzDecoder::new(&compressed[..]),
+            &mut plain,
+        )
+        .unwrap();
+        assert_eq!(plain, exposition.body(Format::Text, false).unwrap());
+    }
+
+    #[tokio::test]
+    async fn test_keep_alive_and_routing() {
+        let listener = TcpListener::bind("127.0.0.1:0").await.unwrap();
+        let addr = listener.local_addr().unwrap();
+        let (_shutdown_tx, shutdown_rx) = watch::channel(false);
+        tokio::spawn(serve_listener(listener, shutdown_rx));
+
+        let mut stream = tokio::net::TcpStream::connect(addr).await.unwrap();
+
+        // Two requests on one connection: the first must not close it
+        stream
+            .write_all(b"GET /metrics HTTP/1.1\r\nHost: test\r\n\r\n")
+            .await
+            .unwrap();
+        let mut buf = vec![0; 65536];
+        let n = stream.read(&mut buf).await.unwrap();
+        let response = String::from_utf8_lossy(&buf[..n]);
+        assert!(response.starts_with("HTTP/1.1 200 OK"), "{}", response);
+        assert!(response.contains("content-type: text/plain; version=0.0.4"));
+
+        stream
+            .write_all(b"GET /other HTTP/1.1\r\nHost: test\r\n\r\n")
+            .await
+            .unwrap();
+        let n = stream.read(&mut buf).await.unwrap();
+        let response = String::from_utf8_lossy(&buf[..n]);
+        assert!(
+            response.starts_with("HTTP/1.1 404 Not Found"),
+            "{}",
+            response
+        );
+    }
+}
@@ -7,6 +7,9 @@
  * - Detect driver deadlocks that nvidia-smi cannot see
  * - Have minimal memory footprint
  *
+ * With -m, per-phase timings are printed to stdout as machine-readable
+ * "GDND_METRIC <name> <value>" lines so the daemon can track baselines.
+ *
  * Exit codes:
  *   0 - GPU is healthy
  *   1 - CUDA error occurred
@@ -19,6 +22,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <time.h>
 #include <unistd.h>
 
 #define MATRIX_SIZE 128
@@ -32,6 +36,18 @@ void timeout_handler(int sig) {
     timeout_flag = 1;
 }
 
+// Monotonic clock in milliseconds for phase timing
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// Emit a machine-readable measurement line for the daemon
+static void emit_metric(const char* name, double value) {
+    printf("GDND_METRIC %s %.3f\n", name, value);
+}
+
 // Check CUDA error and exit on failure
 #define CUDA_CHECK(call) \
     do { \
@@ -78,10 +94,11 @@ int verify_result(float* C, int N, float expected) {
 }
 
 void print_usage(const char* prog) {
-    printf("Usage: %s [-d device_id] [-t timeout_seconds] [-v] [-h]\n", prog);
+    printf("Usage: %s [-d device_id] [-t timeout_seconds] [-m] [-v] [-h]\n", prog);
     printf("\nOptions:\n");
     printf("  -d  Device ID to test (default: 0)\n");
     printf("  -t  Timeout in seconds (default: 5)\n");
+    printf("  -m  Print phase timings as GDND_METRIC lines\n");
     printf("  -v  Verbose output\n");
     printf("  -h  Show this help\n");
 }
@@ -90,6 +107,7 @@ int main(int argc, char** argv) {
     int device_id = 0;
     int timeout_sec = DEFAULT_TIMEOUT;
     int verbose = 0;
+    int metrics = 0;
 
     // Parse arguments
     for (int i = 1; i < argc; i++) {
@@ -97,6 +115,8 @@ int main(int argc, char** argv) {
             device_id = atoi(argv[++i]);
         } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
             timeout_sec = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-m") == 0) {
+            metrics = 1;
         } else if (strcmp(argv[i], "-v") == 0) {
             verbose = 1;
         } else if (strcmp(argv[i], "-h") == 0) {
@@ -113,6 +133,8 @@ int main(int argc, char** argv) {
         printf("GPU Check: Testing device %d with %ds timeout\n", device_id, timeout_sec);
     }
 
+    double t_start = now_ms();
+
     // Get device count
     int device_count;
     CUDA_CHECK(cudaGetDeviceCount(&device_count));
@@ -141,6 +163,8 @@ int main(int argc, char** argv) {
         return 3;
     }
 
+    double t_init = now_ms();
+
     // Allocate host memory
     size_t matrix_bytes = MATRIX_SIZE * MATRIX_SIZE * sizeof(float);
     float* h_A = (float*)malloc(matrix_bytes);
@@ -165,10 +189,12 @@ int main(int argc, char** argv) {
     }
 
     // Allocate device memory
+    double t_alloc_start = now_ms();
     float *d_A, *d_B, *d_C;
     CUDA_CHECK(cudaMalloc(&d_A, matrix_bytes));
     CUDA_CHECK(cudaMalloc(&d_B, matrix_bytes));
     CUDA_CHECK(cudaMalloc(&d_C, matrix_bytes));
+    double t_alloc = now_ms();
 
     // Check for timeout
     if (timeout_flag) {
@@ -181,6 +207,7 @@ int main(int argc, char** argv) {
     // Copy data to device
     CUDA_CHECK(cudaMemcpy(d_A, h_A, matrix_bytes, cudaMemcpyHostToDevice));
     CUDA_CHECK(cudaMemcpy(d_B, h_B, matrix_bytes, cudaMemcpyHostToDevice));
+    double t_h2d = now_ms();
 
     // Check for timeout
     if (timeout_flag) {
@@ -205,6 +232,7 @@ int main(int argc, char** argv) {
 
     // Synchronize and check for errors
     CUDA_CHECK(cudaDeviceSynchronize());
+    double t_kernel = now_ms();
 
     // Check for timeout
     if (timeout_flag) {
@@ -216,6 +244,7 @@ int main(int argc, char** argv) {
 
     // Copy result back
     CUDA_CHECK(cudaMemcpy(h_C, d_C, matrix_bytes, cudaMemcpyDeviceToHost));
+    double t_d2h = now_ms();
 
     // Verify result
     // For 128x128 matrix of 1.0f, each element should be 128.0f
@@ -238,6 +267,15 @@ int main(int argc, char** argv) {
     // Cancel alarm
     alarm(0);
 
+    if (metrics) {
+        emit_metric("init_ms", t_init - t_start);
+        emit_metric("alloc_ms", t_alloc - t_alloc_start);
+        emit_metric("h2d_ms", t_h2d - t_alloc);
+        emit_metric("kernel_ms", t_kernel - t_h2d);
+        emit_metric("d2h_ms", t_d2h - t_kernel);
+        emit_metric("total_ms", now_ms() - t_start);
+    }
+
     if (verbose) {
         printf("GPU check passed successfully\n");
     }
@@ -1,14 +1,17 @@
 #!/bin/bash
 #
-# Build script for npu-check AscendCL micro-benchmark
+# Build script for npu-check AscendCL micro-benchmark and npu-collect
+# DCMI telemetry collector
 #
 # Prerequisites:
 # - CANN Toolkit installed (provides AscendCL)
+# - Ascend driver DCMI library (provides libdcmi, for npu-collect)
 # - Environment variables set: ASCEND_HOME, LD_LIBRARY_PATH
 #
 # Usage:
 #   ./build.sh           # Build with default settings
 #   ./build.sh --debug   # Build with debug symbols
+#   ./build.sh --stub    # Build npu-collect against stub/ libdcmi and test it
 #   ./build.sh --clean   # Clean build artifacts
 
 set -e
@@ -16,11 +19,13 @@ set -e
 SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 BUILD_DIR="${SCRIPT_DIR}/build"
 OUTPUT_BIN="npu-check"
+COLLECT_BIN="npu-collect"
 
 # Default CANN paths
 ASCEND_HOME="${ASCEND_HOME:-/usr/local/Ascend/ascend-toolkit/latest}"
 ASCEND_AICPU_PATH="${ASCEND_HOME}"
 ASCEND_OPP_PATH="${ASCEND_HOME}/opp"
+DCMI_HOME="${DCMI_HOME:-/usr/local/dcmi}"
 
 # Compiler settings
 CXX="${CXX:-g++}"
@@ -31,6 +36,7 @@ RELEASE_FLAGS="-O2 -DNDEBUG"
 # Parse arguments
 BUILD_TYPE="release"
 CLEAN=0
+STUB=0
 
 while [[ $# -gt 0 ]]; do
     case $1 in
@@ -42,16 +48,22 @@ while [[ $# -gt 0 ]]; do
             CLEAN=1
             shift
             ;;
+        --stub)
+            STUB=1
+            shift
+            ;;
         --help|-h)
-            echo "Usage: $0 [--debug] [--clean] [--help]"
+            echo "Usage: $0 [--debug] [--stub] [--clean] [--help]"
             echo ""
             echo "Options:"
             echo "  --debug    Build with debug symbols"
+            echo "  --stub     Build npu-collect against the stub libdcmi and test it"
             echo "  --clean    Clean build artifacts"
             echo "  --help     Show this help"
             echo ""
             echo "Environment variables:"
             echo "  ASCEND_HOME    Path to CANN toolkit (default: /usr/local/Ascend/ascend-toolkit/latest)"
+            echo "  DCMI_HOME      Path to DCMI header and library (default: /usr/local/dcmi)"
             echo "  CXX            C++ compiler (default: g++)"
             exit 0
             ;;
@@ -66,11 +78,65 @@ done
 if [[ $CLEAN -eq 1 ]]; then
     echo "Cleaning build artifacts..."
     rm -rf "${BUILD_DIR}"
-    rm -f "${SCRIPT_DIR}/${OUTPUT_BIN}"
+    rm -f "${SCRIPT_DIR}/${OUTPUT_BIN}" "${SCRIPT_DIR}/${COLLECT_BIN}"
     echo "Clean complete."
     exit 0
 fi
 
+# Set compiler flags based on build type
+if [[ "${BUILD_TYPE}" == "debug" ]]; then
+    CXXFLAGS="${CXXFLAGS} ${DEBUG_FLAGS}"
+    echo "Building in debug mode..."
+else
+    CXXFLAGS="${CXXFLAGS} ${RELEASE_FLAGS}"
+    echo "Building in release mode..."
+fi
+
+# Create build directory
+mkdir -p "${BUILD_DIR}"
+
+# Build npu-collect against a DCMI include/library directory
+build_collect() {
+    local dcmi_include="$1"
+    local dcmi_lib="$2"
+    echo "Compiling npu_collect.cpp..."
+    ${CXX} ${CXXFLAGS} \
+        -I"${dcmi_include}" \
+        -L"${dcmi_lib}" \
+        -o "${BUILD_DIR}/${COLLECT_BIN}" \
+        "${SCRIPT_DIR}/npu_collect.cpp" \
+        -ldcmi \
+        -Wl,-rpath,"${dcmi_lib}"
+}
+
+# Stub build: no Ascend software needed
+if [[ $STUB -eq 1 ]]; then
+    STUB_DIR="${BUILD_DIR}/stub"
+    mkdir -p "${STUB_DIR}"
+    echo "Compiling stub libdcmi..."
+    ${CXX} ${CXXFLAGS} -shared -fPIC \
+        -I"${SCRIPT_DIR}/stub" \
+        -o "${STUB_DIR}/libdcmi.so" \
+        "${SCRIPT_DIR}/stub/dcmi_stub.cpp"
+    build_collect "${SCRIPT_DIR}/stub" "${STUB_DIR}"
+
+    echo "Testing npu-collect against the stub..."
+    frame_size=$(GDND_DCMI_STUB_CARDS=4 "${BUILD_DIR}/${COLLECT_BIN}" | wc -c)
+    if [[ "${frame_size}" -ne $((16 + 4 * 72)) ]]; then
+        echo "Error: unexpected frame size ${frame_size}"
+        exit 1
+    fi
+    if GDND_DCMI_STUB_FAIL_INIT=1 "${BUILD_DIR}/${COLLECT_BIN}" 2>/dev/null; then
+        echo "Error: npu-collect succeeded although dcmi_init failed"
+        exit 1
+    fi
+    GDND_DCMI_STUB_FAULTY=1 "${BUILD_DIR}/${COLLECT_BIN}" -v
+
+    echo ""
+    echo "Stub build complete: ${BUILD_DIR}/${COLLECT_BIN}"
+    exit 0
+fi
+
 # Check for CANN toolkit
 if [[ ! -d "${ASCEND_HOME}" ]]; then
     echo "Error: CANN toolkit not found at ${ASCEND_HOME}"
@@ -96,18 +162,6 @@ if [[ ! -f "${ACL_LIB}/libascendcl.so" ]]; then
     fi
 fi
 
-# Create build directory
-mkdir -p "${BUILD_DIR}"
-
-# Set compiler flags based on build type
-if [[ "${BUILD_TYPE}" == "debug" ]]; then
-    CXXFLAGS="${CXXFLAGS} ${DEBUG_FLAGS}"
-    echo "Building in debug mode..."
-else
-    CXXFLAGS="${CXXFLAGS} ${RELEASE_FLAGS}"
-    echo "Building in release mode..."
-fi
-
 # Compile
 echo "Compiling npu_check.cpp..."
 ${CXX} ${CXXFLAGS} \
@@ -122,11 +176,19 @@ ${CXX} ${CXXFLAGS} \
 # Copy to script directory
 cp "${BUILD_DIR}/${OUTPUT_BIN}" "${SCRIPT_DIR}/${OUTPUT_BIN}"
 
+# npu-collect is optional: without DCMI the daemon falls back to npu-smi
+if [[ -f "${DCMI_HOME}/dcmi_interface_api.h" && -f "${DCMI_HOME}/libdcmi.so" ]]; then
+    build_collect "${DCMI_HOME}" "${DCMI_HOME}"
+    cp "${BUILD_DIR}/${COLLECT_BIN}" "${SCRIPT_DIR}/${COLLECT_BIN}"
+else
+    echo "Warning: DCMI not found at ${DCMI_HOME}, skipping npu-collect"
+fi
+
 echo ""
 echo "Build complete: ${SCRIPT_DIR}/${OUTPUT_BIN}"
 echo ""
 echo "To install:"
-echo "  sudo cp ${SCRIPT_DIR}/${OUTPUT_BIN} /usr/local/bin/"
+echo "  sudo cp ${SCRIPT_DIR}/${OUTPUT_BIN} ${SCRIPT_DIR}/${COLLECT_BIN} /usr/local/bin/"
 echo ""
 echo "To test:"
 echo "  ./${OUTPUT_BIN} -v"
@@ -7,6 +7,10 @@
  * - Detect driver deadlocks that npu-smi cannot see
  * - Have minimal memory footprint
  *
+ * With -m, per-phase timings (and PCIe bandwidth with --pcie-test) are
+ * printed to stdout as machine-readable "GDND_METRIC <name> <value>" lines
+ * so the daemon can track baselines.
+ *
  * Exit codes:
  *   0 - NPU is healthy
  *   1 - AscendCL error occurred
@@ -21,6 +25,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <time.h>
 #include <unistd.h>
 #include <math.h>
 
@@ -35,6 +40,18 @@ void timeout_handler(int sig) {
     timeout_flag = 1;
 }
 
+// Monotonic clock in milliseconds for phase timing
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// Emit a machine-readable measurement line for the daemon
+static void emit_metric(const char* name, double value) {
+    printf("GDND_METRIC %s %.3f\n", name, value);
+}
+
 // Check ACL error and exit on failure
 #define ACL_CHECK(call) \
     do { \
@@ -68,16 +85,17 @@ int verify_result(float* C, int N, float expected) {
 }
 
 void print_usage(const char* prog) {
-    printf("Usage: %s [-d device_id] [-t timeout_seconds] [-v] [-h] [--pcie-test]\n", prog);
+    printf("Usage: %s [-d device_id] [-t timeout_seconds] [-m] [-v] [-h] [--pcie-test]\n", prog);
     printf("\nOptions:\n");
     printf("  -d           Device ID to test (default: 0)\n");
     printf("  -t           Timeout in seconds (default: 5)\n");
+    printf("  -m           Print timings/bandwidth as GDND_METRIC lines\n");
     printf("  -v           Verbose output\n");
     printf("  -h           Show this help\n");
     printf("  --pcie-test  Run PCIe bandwidth test\n");
 }
 
-int run_pcie_test(int device_id, int verbose) {
+int run_pcie_test(int device_id, int verbose, int metrics) {
     // Simple PCIe bandwidth test using memory copy
     size_t test_size = 64 * 1024 * 1024; // 64MB
     void* h_data = nullptr;
@@ -115,6 +133,11 @@ int run_pcie_test(int device_id, int verbose) {
     double d2h_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
     double d2h_bandwidth = (test_size / (1024.0 * 1024.0 * 1024.0)) / d2h_time;
 
+    if (metrics) {
+        emit_metric("h2d_gbps", h2d_bandwidth);
+        emit_metric("d2h_gbps", d2h_bandwidth);
+    }
+
     if (verbose) {
         printf("PCIe Bandwidth Test Results:\n");
         printf("  Host to Device: %.2f GB/s\n", h2d_bandwidth);
@@ -139,6 +162,7 @@ int main(int argc, char** argv) {
     int timeout_sec = DEFAULT_TIMEOUT;
     int verbose = 0;
     int pcie_test = 0;
+    int metrics = 0;
 
     // Parse arguments
     for (int i = 1; i < argc; i++) {
@@ -146,6 +170,8 @@ int main(int argc, char** argv) {
             device_id = atoi(argv[++i]);
         } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
             timeout_sec = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-m") == 0) {
+            metrics = 1;
         } else if (strcmp(argv[i], "-v") == 0) {
             verbose = 1;
         } else if (strcmp(argv[i], "-h") == 0) {
@@ -164,6 +190,8 @@ int main(int argc, char** argv) {
         printf("NPU Check: Testing device %d with %ds timeout\n", device_id, timeout_sec);
     }
 
+    double t_start = now_ms();
+
     // Initialize AscendCL
     aclError ret = aclInit(nullptr);
     if (ret != ACL_SUCCESS) {
@@ -215,9 +243,11 @@ int main(int argc, char** argv) {
         return 3;
     }
 
+    double t_init = now_ms();
+
     // Run PCIe test if requested
     if (pcie_test) {
-        int pcie_result = run_pcie_test(device_id, verbose);
+        int pcie_result = run_pcie_test(device_id, verbose, metrics);
         aclrtDestroyContext(context);
         aclrtResetDevice(device_id);
         aclFinalize();
@@ -253,11 +283,13 @@ int main(int argc, char** argv) {
     }
 
     // Allocate device memory
+    double t_alloc_start = now_ms();
     void* d_A = nullptr;
     void* d_B = nullptr;
 
     ACL_CHECK(aclrtMalloc(&d_A, matrix_bytes, ACL_MEM_MALLOC_HUGE_FIRST));
     ACL_CHECK(aclrtMalloc(&d_B, matrix_bytes, ACL_MEM_MALLOC_HUGE_FIRST));
+    double t_alloc = now_ms();
 
     // Check for timeout
     if (timeout_flag) {
@@ -284,6 +316,7 @@ int main(int argc, char** argv) {
 
     // Synchronize stream
     ACL_CHECK(aclrtSynchronizeStream(stream));
+    double t_device = now_ms();
 
     // Check for timeout
     if (timeout_flag) {
@@ -303,6 +336,7 @@ int main(int argc, char** argv) {
     ACL_CHECK(aclrtMemcpyAsync(h_B, matrix_bytes, d_B, matrix_bytes,
                                ACL_MEMCPY_DEVICE_TO_HOST, stream));
     ACL_CHECK(aclrtSynchronizeStream(stream));
+    double t_d2h = now_ms();
 
     // Verify result - h_B should equal h_A after copy
     if (!verify_result(h_B, MATRIX_SIZE, 1.0f)) {
@@ -333,6 +367,14 @@ int main(int argc, char** argv) {
     // Finalize AscendCL
     aclFinalize();
 
+    if (metrics) {
+        emit_metric("init_ms", t_init - t_start);
+        emit_metric("alloc_ms", t_alloc - t_alloc_start);
+        emit_metric("device_ms", t_device - t_alloc);
+        emit_metric("d2h_ms", t_d2h - t_device);
+        emit_metric("total_ms", now_ms() - t_start);
+    }
+
     if (verbose) {
         printf("NPU check passed successfully\n");
     }
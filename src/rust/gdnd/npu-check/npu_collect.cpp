@@ -0,0 +1,308 @@
+/**
+ * NPU Collect - DCMI telemetry collector for GDND
+ *
+ * Reads health, temperature, power, AI Core utilization, HBM usage and
+ * temperature, and HBM ECC counters for every NPU chip in one pass through
+ * the DCMI C API, instead of scraping human-formatted npu-smi tables.
+ *
+ * Each pass is written to stdout as one binary frame (little-endian):
+ *   header, 16 bytes:  u32 magic "GDNC", u16 version, u16 record count,
+ *                      u64 unix time in milliseconds
+ *   record, 72 bytes:  one per chip, layout in write_record()
+ *
+ * With -i the collector stays resident and writes a frame every interval
+ * until stdout is closed. With -v a readable table is printed instead.
+ *
+ * Exit codes:
+ *   0 - Success (or reader went away)
+ *   1 - DCMI initialization or device enumeration failed
+ *
+ * Requires: Ascend driver DCMI library (libdcmi), or stub/ for testing
+ */
+
+#include <dcmi_interface_api.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_CARDS 64
+#define MAX_CHIPS 256
+
+#define FRAME_MAGIC 0x434E4447u  // "GDNC" little-endian
+#define FRAME_VERSION 2
+#define HEADER_SIZE 16
+#define RECORD_SIZE 72
+
+// DCMI utilization input types
+#define UTIL_AICORE 2
+#define UTIL_HBM_BANDWIDTH 10
+
+// Record validity flags, one per field group that DCMI may fail to report
+#define VALID_HEALTH (1u << 0)
+#define VALID_TEMPERATURE (1u << 1)
+#define VALID_POWER (1u << 2)
+#define VALID_AICORE (1u << 3)
+#define VALID_HBM (1u << 4)
+#define VALID_ECC (1u << 5)
+#define VALID_PHY_ID (1u << 6)
+
+// Telemetry for one NPU chip
+struct ChipRecord {
+    uint32_t logic_id;
+    uint16_t card_id;
+    uint16_t chip_id;
+    uint32_t valid;
+    uint32_t health;          // 0 ok, 1 minor, 2 major, 3 critical
+    int32_t temperature;      // Celsius
+    int32_t hbm_temperature;  // Celsius
+    uint32_t power_mw;
+    uint32_t aicore_util;     // percent
+    uint64_t hbm_total;       // bytes
+    uint64_t hbm_used;        // bytes
+    uint32_t ecc_single;      // HBM single-bit errors since driver load
+    uint32_t ecc_double;      // HBM double-bit errors since driver load
+    uint32_t ecc_double_total;  // HBM double-bit errors, lifetime
+    uint32_t ecc_single_total;  // HBM single-bit errors, lifetime
+    uint32_t hbm_bandwidth_util;  // percent
+    uint32_t phy_id;          // N in /dev/davinciN
+};
+
+struct ChipAddress {
+    int card_id;
+    int chip_id;
+    int logic_id;
+};
+
+static void put_u16(unsigned char* p, uint16_t v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+}
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (v >> (8 * i)) & 0xff;
+}
+
+static void put_u64(unsigned char* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (v >> (8 * i)) & 0xff;
+}
+
+static uint64_t unix_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Enumerate every chip once; logic IDs are what npu-smi and AscendCL use
+static int enumerate_chips(ChipAddress* chips, int max_chips) {
+    int card_list[MAX_CARDS];
+    int card_num = 0;
+    int ret = dcmi_get_card_num_list(&card_num, card_list, MAX_CARDS);
+    if (ret != 0) {
+        fprintf(stderr, "dcmi_get_card_num_list failed: %d\n", ret);
+        return -1;
+    }
+
+    int count = 0;
+    for (int c = 0; c < card_num; c++) {
+        int chip_num = 0;
+        ret = dcmi_get_device_num_in_card(card_list[c], &chip_num);
+        if (ret != 0) {
+            fprintf(stderr, "dcmi_get_device_num_in_card(%d) failed: %d\n", card_list[c], ret);
+            continue;
+        }
+        for (int chip = 0; chip < chip_num && count < max_chips; chip++) {
+            int logic_id = -1;
+            if (dcmi_get_device_logic_id(&logic_id, card_list[c], chip) != 0 || logic_id < 0) {
+                continue;
+            }
+            chips[count].card_id = card_list[c];
+            chips[count].chip_id = chip;
+            chips[count].logic_id = logic_id;
+            count++;
+        }
+    }
+    return count;
+}
+
+// Query one chip; fields whose query fails are left zero and not flagged valid
+static void collect_chip(const ChipAddress& chip, ChipRecord* record) {
+    memset(record, 0, sizeof(*record));
+    record->logic_id = (uint32_t)chip.logic_id;
+    record->card_id = (uint16_t)chip.card_id;
+    record->chip_id = (uint16_t)chip.chip_id;
+
+    // Device nodes are numbered by physical ID, not logic ID
+    unsigned int phy_id = 0;
+    if (dcmi_get_device_phyid_from_logicid((unsigned int)chip.logic_id, &phy_id) == 0) {
+        record->phy_id = phy_id;
+        record->valid |= VALID_PHY_ID;
+    }
+
+    unsigned int health = 0;
+    if (dcmi_get_device_health(chip.card_id, chip.chip_id, &health) == 0) {
+        record->health = health;
+        record->valid |= VALID_HEALTH;
+    }
+
+    int temperature = 0;
+    if (dcmi_get_device_temperature(chip.card_id, chip.chip_id, &temperature) == 0) {
+        record->temperature = temperature;
+        record->valid |= VALID_TEMPERATURE;
+    }
+
+    int power = 0;  // 0.1 W units
+    if (dcmi_get_device_power_info(chip.card_id, chip.chip_id, &power) == 0 && power >= 0) {
+        record->power_mw = (uint32_t)power * 100;
+        record->valid |= VALID_POWER;
+    }
+
+    unsigned int util = 0;
+    if (dcmi_get_device_utilization_rate(chip.card_id, chip.chip_id, UTIL_AICORE, &util) == 0) {
+        record->aicore_util = util;
+        record->valid |= VALID_AICORE;
+    }
+
+    struct dcmi_hbm_info hbm;
+    memset(&hbm, 0, sizeof(hbm));
+    if (dcmi_get_device_hbm_info(chip.card_id, chip.chip_id, &hbm) == 0) {
+        record->hbm_total = (uint64_t)hbm.memory_size * 1024 * 1024;
+        record->hbm_used = (uint64_t)hbm.memory_usage * 1024 * 1024;
+        record->hbm_temperature = hbm.temp;
+        if (dcmi_get_device_utilization_rate(chip.card_id, chip.chip_id, UTIL_HBM_BANDWIDTH,
+                                             &util) == 0) {
+            record->hbm_bandwidth_util = util;
+        }
+        record->valid |= VALID_HBM;
+    }
+
+    struct dcmi_ecc_info ecc;
+    memset(&ecc, 0, sizeof(ecc));
+    if (dcmi_get_device_ecc_info(chip.card_id, chip.chip_id, DCMI_DEVICE_TYPE_HBM, &ecc) == 0 &&
+        ecc.enable_flag) {
+        record->ecc_single = ecc.single_bit_error_cnt;
+        record->ecc_double = ecc.double_bit_error_cnt;
+        record->ecc_double_total = ecc.total_double_bit_error_cnt;
+        record->ecc_single_total = ecc.total_single_bit_error_cnt;
+        record->valid |= VALID_ECC;
+    }
+}
+
+static void write_record(unsigned char* p, const ChipRecord& r) {
+    put_u32(p + 0, r.logic_id);
+    put_u16(p + 4, r.card_id);
+    put_u16(p + 6, r.chip_id);
+    put_u32(p + 8, r.valid);
+    put_u32(p + 12, r.health);
+    put_u32(p + 16, (uint32_t)r.temperature);
+    put_u32(p + 20, (uint32_t)r.hbm_temperature);
+    put_u32(p + 24, r.power_mw);
+    put_u32(p + 28, r.aicore_util);
+    put_u64(p + 32, r.hbm_total);
+    put_u64(p + 40, r.hbm_used);
+    put_u32(p + 48, r.ecc_single);
+    put_u32(p + 52, r.ecc_double);
+    put_u32(p + 56, r.ecc_double_total);
+    put_u32(p + 60, r.hbm_bandwidth_util);
+    put_u32(p + 64, r.phy_id);
+    put_u32(p + 68, r.ecc_single_total);
+}
+
+// Write one frame; returns 0 on success, -1 if stdout is gone
+static int write_frame(const ChipRecord* records, int count) {
+    static unsigned char buf[HEADER_SIZE + MAX_CHIPS * RECORD_SIZE];
+    put_u32(buf, FRAME_MAGIC);
+    put_u16(buf + 4, FRAME_VERSION);
+    put_u16(buf + 6, (uint16_t)count);
+    put_u64(buf + 8, unix_ms());
+    for (int i = 0; i < count; i++) {
+        write_record(buf + HEADER_SIZE + i * RECORD_SIZE, records[i]);
+    }
+
+    size_t len = HEADER_SIZE + (size_t)count * RECORD_SIZE;
+    if (fwrite(buf, 1, len, stdout) != len || fflush(stdout) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static void print_table(const ChipRecord* records, int count) {
+    printf("%-6s %-5s %-5s %-5s %-7s %-6s %-8s %-9s %-7s %-15s %-8s %-8s\n", "NPU", "Card",
+           "Chip", "Phy", "Health", "Temp", "HBMTemp", "Power(W)", "AICore", "HBM(MB)", "ECC-SB",
+           "ECC-DB");
+    for (int i = 0; i < count; i++) {
+        const ChipRecord& r = records[i];
+        printf("%-6u %-5u %-5u %-5u %-7u %-6d %-8d %-9.1f %-7u %7llu/%-7llu %-8u %-8u\n",
+               r.logic_id, r.card_id, r.chip_id, r.phy_id, r.health, r.temperature,
+               r.hbm_temperature, r.power_mw / 1000.0, r.aicore_util,
+               (unsigned long long)(r.hbm_used >> 20), (unsigned long long)(r.hbm_total >> 20),
+               r.ecc_single, r.ecc_double);
+    }
+}
+
+static void print_usage(const char* prog) {
+    printf("Usage: %s [-i interval_ms] [-v] [-h]\n", prog);
+    printf("\nOptions:\n");
+    printf("  -i           Stay resident, writing a frame every interval_ms\n");
+    printf("  -v           Print a readable table instead of binary frames\n");
+    printf("  -h           Show this help\n");
+}
+
+int main(int argc, char** argv) {
+    long interval_ms = 0;
+    int verbose = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            interval_ms = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-v") == 0) {
+            verbose = 1;
+        } else if (strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+    }
+
+    // A closed pipe should end the loop, not kill us mid-write
+    signal(SIGPIPE, SIG_IGN);
+
+    int ret = dcmi_init();
+    if (ret != 0) {
+        fprintf(stderr, "Failed to initialize DCMI: %d\n", ret);
+        return 1;
+    }
+
+    static ChipAddress chips[MAX_CHIPS];
+    int count = enumerate_chips(chips, MAX_CHIPS);
+    if (count < 0) {
+        return 1;
+    }
+
+    static ChipRecord records[MAX_CHIPS];
+    for (;;) {
+        for (int i = 0; i < count; i++) {
+            collect_chip(chips[i], &records[i]);
+        }
+
+        if (verbose) {
+            print_table(records, count);
+            fflush(stdout);
+        } else if (write_frame(records, count) != 0) {
+            return 0;
+        }
+
+        if (interval_ms <= 0) {
+            break;
+        }
+        struct timespec delay;
+        delay.tv_sec = interval_ms / 1000;
+        delay.tv_nsec = (interval_ms % 1000) * 1000000L;
+        while (nanosleep(&delay, &delay) != 0 && errno == EINTR) {
+        }
+    }
+
+    return 0;
+}
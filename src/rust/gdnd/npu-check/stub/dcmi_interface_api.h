@@ -0,0 +1,59 @@
+/**
+ * Minimal DCMI declarations for building npu-collect against the stub
+ *
+ * Mirrors the subset of the Ascend driver's dcmi_interface_api.h used by
+ * npu_collect.cpp. Real builds use the header shipped with the driver.
+ */
+
+#ifndef GDND_DCMI_INTERFACE_API_H
+#define GDND_DCMI_INTERFACE_API_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum dcmi_device_type {
+    DCMI_DEVICE_TYPE_DDR,
+    DCMI_DEVICE_TYPE_SRAM,
+    DCMI_DEVICE_TYPE_HBM,
+    DCMI_DEVICE_TYPE_NPU,
+    DCMI_DEVICE_TYPE_NONE = 0xff
+};
+
+struct dcmi_hbm_info {
+    unsigned long long memory_size;   /* MB */
+    unsigned int freq;
+    unsigned long long memory_usage;  /* MB */
+    int temp;
+    unsigned int bandwith_util_rate;
+};
+
+struct dcmi_ecc_info {
+    int enable_flag;
+    unsigned int single_bit_error_cnt;
+    unsigned int double_bit_error_cnt;
+    unsigned int total_single_bit_error_cnt;
+    unsigned int total_double_bit_error_cnt;
+    unsigned int single_bit_isolated_pages_cnt;
+    unsigned int double_bit_isolated_pages_cnt;
+};
+
+int dcmi_init(void);
+int dcmi_get_card_num_list(int *card_num, int *card_list, int list_len);
+int dcmi_get_device_num_in_card(int card_id, int *device_num);
+int dcmi_get_device_logic_id(int *device_logic_id, int card_id, int device_id);
+int dcmi_get_device_phyid_from_logicid(unsigned int logicid, unsigned int *phyid);
+int dcmi_get_device_health(int card_id, int device_id, unsigned int *health);
+int dcmi_get_device_temperature(int card_id, int device_id, int *temperature);
+int dcmi_get_device_power_info(int card_id, int device_id, int *power);
+int dcmi_get_device_utilization_rate(int card_id, int device_id, int input_type,
+                                     unsigned int *utilization_rate);
+int dcmi_get_device_hbm_info(int card_id, int device_id, struct dcmi_hbm_info *hbm_info);
+int dcmi_get_device_ecc_info(int card_id, int device_id, enum dcmi_device_type input_type,
+                             struct dcmi_ecc_info *device_ecc_info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GDND_DCMI_INTERFACE_API_H */
@@ -0,0 +1,121 @@
+/**
+ * Stub libdcmi for testing npu-collect without Ascend hardware
+ *
+ * Reports GDND_DCMI_STUB_CARDS cards (default 8) with one chip each and
+ * deterministic telemetry derived from the logic ID. Physical IDs run in
+ * reverse card order, so logic and physical numbering differ. Setting
+ * GDND_DCMI_STUB_FAULTY=<logic id> makes that chip report critical health
+ * and double-bit HBM ECC errors; GDND_DCMI_STUB_FAIL_INIT=1 fails dcmi_init.
+ */
+
+#include "dcmi_interface_api.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define STUB_MAX_CARDS 64
+#define STUB_ERR_INVALID -8001
+
+static int env_int(const char* name, int fallback) {
+    const char* value = getenv(name);
+    return value ? atoi(value) : fallback;
+}
+
+static int card_count(void) {
+    int cards = env_int("GDND_DCMI_STUB_CARDS", 8);
+    if (cards < 0) return 0;
+    return cards > STUB_MAX_CARDS ? STUB_MAX_CARDS : cards;
+}
+
+static int valid(int card_id, int device_id) {
+    return card_id >= 0 && card_id < card_count() && device_id == 0;
+}
+
+static int faulty(int card_id) {
+    return env_int("GDND_DCMI_STUB_FAULTY", -1) == card_id;
+}
+
+extern "C" {
+
+int dcmi_init(void) {
+    return env_int("GDND_DCMI_STUB_FAIL_INIT", 0) ? STUB_ERR_INVALID : 0;
+}
+
+int dcmi_get_card_num_list(int *card_num, int *card_list, int list_len) {
+    int cards = card_count();
+    if (cards > list_len) return STUB_ERR_INVALID;
+    for (int i = 0; i < cards; i++) card_list[i] = i;
+    *card_num = cards;
+    return 0;
+}
+
+int dcmi_get_device_num_in_card(int card_id, int *device_num) {
+    if (!valid(card_id, 0)) return STUB_ERR_INVALID;
+    *device_num = 1;
+    return 0;
+}
+
+int dcmi_get_device_logic_id(int *device_logic_id, int card_id, int device_id) {
+    if (!valid(card_id, device_id)) return STUB_ERR_INVALID;
+    *device_logic_id = card_id;
+    return 0;
+}
+
+int dcmi_get_device_phyid_from_logicid(unsigned int logicid, unsigned int *phyid) {
+    if (!valid((int)logicid, 0)) return STUB_ERR_INVALID;
+    *phyid = (unsigned int)card_count() - 1 - logicid;
+    return 0;
+}
+
+int dcmi_get_device_health(int card_id, int device_id, unsigned int *health) {
+    if (!valid(card_id, device_id)) return STUB_ERR_INVALID;
+    *health = faulty(card_id) ? 3 : 0;
+    return 0;
+}
+
+int dcmi_get_device_temperature(int card_id, int device_id, int *temperature) {
+    if (!valid(card_id, device_id)) return STUB_ERR_INVALID;
+    *temperature = 40 + card_id;
+    return 0;
+}
+
+int dcmi_get_device_power_info(int card_id, int device_id, int *power) {
+    if (!valid(card_id, device_id)) return STUB_ERR_INVALID;
+    *power = 1000 + card_id * 15;  // 0.1 W units
+    return 0;
+}
+
+int dcmi_get_device_utilization_rate(int card_id, int device_id, int input_type,
+                                     unsigned int *utilization_rate) {
+    if (!valid(card_id, device_id)) return STUB_ERR_INVALID;
+    *utilization_rate = (unsigned int)(input_type * 10 + card_id) % 101;
+    return 0;
+}
+
+int dcmi_get_device_hbm_info(int card_id, int device_id, struct dcmi_hbm_info *hbm_info) {
+    if (!valid(card_id, device_id)) return STUB_ERR_INVALID;
+    memset(hbm_info, 0, sizeof(*hbm_info));
+    hbm_info->memory_size = 65536;
+    hbm_info->memory_usage = 20000 + card_id * 1000;
+    hbm_info->temp = 45 + card_id;
+    hbm_info->freq = 1600;
+    return 0;
+}
+
+int dcmi_get_device_ecc_info(int card_id, int device_id, enum dcmi_device_type input_type,
+                             struct dcmi_ecc_info *device_ecc_info) {
+    if (!valid(card_id, device_id) || input_type != DCMI_DEVICE_TYPE_HBM) {
+        return STUB_ERR_INVALID;
+    }
+    memset(device_ecc_info, 0, sizeof(*device_ecc_info));
+    device_ecc_info->enable_flag = 1;
+    device_ecc_info->single_bit_error_cnt = (unsigned int)card_id;
+    device_ecc_info->total_single_bit_error_cnt = (unsigned int)card_id * 3;
+    if (faulty(card_id)) {
+        device_ecc_info->double_bit_error_cnt = 2;
+        device_ecc_info->total_double_bit_error_cnt = 5;
+    }
+    return 0;
+}
+
+}  // extern "C"